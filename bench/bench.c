@@ -0,0 +1,347 @@
+#include "bench.h"
+#include "hardware/hal_interface.h"
+#include "mocks/mock_hal.h"
+#include "mocks/mock_neopixel.h"
+
+#include <stdbool.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+
+/**
+ * @file bench.c
+ * @brief Benchmark harness
+ *
+ * Each benchmark is calibrated to a batch size that takes at least
+ * --min-ms, then timed over --reps batches; the median batch gives
+ * ns/op. Counts come from one more batch of COUNT_BATCH operations,
+ * with the mock HAL counting calls (see hal_stats.h; each operation is
+ * a tick): setup resets all state, so they are the same on every
+ * machine. Timed batches run with counting off.
+ *
+ * The JSON report has one benchmark object per line with fixed keys, so
+ * a baseline can be read back line by line and diffs stay readable.
+ */
+
+#define DEFAULT_MIN_MS      20
+#define DEFAULT_REPS        5
+#define MAX_REPS            31
+#define MIN_BATCH           1000
+#define MAX_BATCH           (1u << 24)
+#define COUNT_BATCH         120000
+#define JSON_FORMAT         2
+
+// =============================================================================
+// Allocation Counting
+// =============================================================================
+//
+// Linked with -Wl,--wrap=malloc,--wrap=calloc,--wrap=realloc: calls from
+// the core (and this harness) land here; libc's own don't.
+
+static bool counting_allocs;
+static uint64_t allocs;
+
+void *__real_malloc(size_t size);
+void *__real_calloc(size_t n, size_t size);
+void *__real_realloc(void *ptr, size_t size);
+
+void *__wrap_malloc(size_t size) {
+    if (counting_allocs) allocs++;
+    return __real_malloc(size);
+}
+
+void *__wrap_calloc(size_t n, size_t size) {
+    if (counting_allocs) allocs++;
+    return __real_calloc(n, size);
+}
+
+void *__wrap_realloc(void *ptr, size_t size) {
+    if (counting_allocs) allocs++;
+    return __real_realloc(ptr, size);
+}
+
+// =============================================================================
+// Timing
+// =============================================================================
+
+typedef struct {
+    const char *name;
+    uint32_t batch;             // Operations per timed batch
+    double ns_per_op;           // Median over batches
+    double hal_per_op;
+    double hal_call_per_op[HAL_FN_COUNT];
+    uint32_t hal_max_per_op;    // Worst single operation
+    double allocs_per_op;
+    double flushes_per_op;      // NeoPixel flushes
+} BenchResult;
+
+static uint64_t now_ns(void) {
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return (uint64_t)ts.tv_sec * 1000000000ull + (uint64_t)ts.tv_nsec;
+}
+
+static HalStats hal_stats;
+static int batch_flushes;
+
+static uint64_t run_batch(const BenchCase *bc, uint32_t n) {
+    bc->setup();
+    uint64_t start = now_ns();
+    for (uint32_t i = 0; i < n; i++) {
+        bc->run(i);
+    }
+    return now_ns() - start;
+}
+
+// Untimed batch with HAL, allocation and flush counting
+static void count_batch(const BenchCase *bc, uint32_t n) {
+    bc->setup();
+    hal_stats_init(&hal_stats);
+    mock_hal_set_stats(&hal_stats);
+    allocs = 0;
+    int flushes = mock_neopixel_get_flush_count();
+    counting_allocs = true;
+
+    for (uint32_t i = 0; i < n; i++) {
+        bc->run(i);
+        hal_stats_end_tick(&hal_stats);
+    }
+
+    counting_allocs = false;
+    mock_hal_set_stats(NULL);
+    batch_flushes = mock_neopixel_get_flush_count() - flushes;
+}
+
+static int compare_u64(const void *a, const void *b) {
+    uint64_t x = *(const uint64_t*)a;
+    uint64_t y = *(const uint64_t*)b;
+    return (x > y) - (x < y);
+}
+
+static BenchResult bench_one(const BenchCase *bc, uint32_t min_ms, int reps) {
+    BenchResult r = { .name = bc->name };
+    uint64_t min_ns = (uint64_t)min_ms * 1000000ull;
+
+    // Calibrate: double the batch until it runs long enough
+    uint32_t n = MIN_BATCH;
+    while (n < MAX_BATCH && run_batch(bc, n) < min_ns) {
+        n *= 2;
+    }
+    r.batch = n;
+
+    uint64_t times[MAX_REPS];
+    for (int i = 0; i < reps; i++) {
+        times[i] = run_batch(bc, n);
+    }
+    qsort(times, reps, sizeof(uint64_t), compare_u64);
+    r.ns_per_op = (double)times[reps / 2] / n;
+
+    // Counts over a fixed batch
+    n = COUNT_BATCH;
+    count_batch(bc, n);
+    uint64_t total = 0;
+    for (int fn = 0; fn < HAL_FN_COUNT; fn++) {
+        uint64_t calls = hal_stats_calls(&hal_stats, (HalFn)fn);
+        r.hal_call_per_op[fn] = (double)calls / n;
+        total += calls;
+    }
+    r.hal_per_op = (double)total / n;
+    r.hal_max_per_op = hal_stats.max_tick_total;
+    r.allocs_per_op = (double)allocs / n;
+    r.flushes_per_op = (double)batch_flushes / n;
+    return r;
+}
+
+// =============================================================================
+// Report
+// =============================================================================
+
+typedef struct {
+    bool found;
+    double ns_per_op;
+    double hal_per_op;
+    double allocs_per_op;
+} Baseline;
+
+static Baseline baseline_lookup(FILE *baseline, const char *name) {
+    Baseline b = { 0 };
+    rewind(baseline);
+    char line[1024];
+    while (fgets(line, sizeof(line), baseline)) {
+        char n[64];
+        unsigned long batch;
+        if (sscanf(line, " {\"name\":\"%63[^\"]\",\"batch\":%lu,\"ns_per_op\":%lf,"
+                   "\"hal_calls_per_op\":%lf,\"allocs_per_op\":%lf",
+                   n, &batch, &b.ns_per_op, &b.hal_per_op, &b.allocs_per_op) == 5 &&
+            strcmp(n, name) == 0) {
+            b.found = true;
+            return b;
+        }
+    }
+    return b;
+}
+
+// Print one result; with a baseline, return true if it regressed
+static bool report(const BenchResult *r, FILE *baseline, double max_regress) {
+    printf("%-22s %9lu %10.1f %8.2f %8.2f %8.3f", r->name, (unsigned long)r->batch,
+           r->ns_per_op, r->hal_per_op, r->allocs_per_op, r->flushes_per_op);
+    if (!baseline) {
+        printf("\n");
+        return false;
+    }
+
+    Baseline b = baseline_lookup(baseline, r->name);
+    if (!b.found) {
+        printf("  %9s\n", "new");
+        return false;
+    }
+    double delta = (b.ns_per_op > 0) ? 100.0 * (r->ns_per_op - b.ns_per_op) / b.ns_per_op : 0;
+    printf("  %+8.1f%%", delta);
+
+    // Counts are exact: any increase is a regression
+    bool regressed = false;
+    if (r->hal_per_op > b.hal_per_op + 1e-6) {
+        printf("  HAL calls %.2f -> %.2f", b.hal_per_op, r->hal_per_op);
+        regressed = true;
+    }
+    if (r->allocs_per_op > b.allocs_per_op + 1e-6) {
+        printf("  allocs %.2f -> %.2f", b.allocs_per_op, r->allocs_per_op);
+        regressed = true;
+    }
+    if (max_regress >= 0 && delta > max_regress) {
+        printf("  SLOW");
+        regressed = true;
+    }
+    printf("\n");
+    return regressed;
+}
+
+static void write_result(FILE *f, const BenchResult *r, bool last) {
+    fprintf(f, "  {\"name\":\"%s\",\"batch\":%lu,\"ns_per_op\":%.2f,"
+            "\"hal_calls_per_op\":%.4f,\"allocs_per_op\":%.4f,"
+            "\"neopixel_flushes_per_op\":%.4f,\"hal_max_per_op\":%lu,\"hal\":{",
+            r->name, (unsigned long)r->batch, r->ns_per_op, r->hal_per_op,
+            r->allocs_per_op, r->flushes_per_op, (unsigned long)r->hal_max_per_op);
+    for (int fn = 0; fn < HAL_FN_COUNT; fn++) {
+        fprintf(f, "%s\"%s\":%.4f", fn ? "," : "", hal_fn_name((HalFn)fn),
+                r->hal_call_per_op[fn]);
+    }
+    fprintf(f, "}}%s\n", last ? "" : ",");
+}
+
+// =============================================================================
+// Main
+// =============================================================================
+
+static void print_usage(const char *progname) {
+    printf("Gatekeeper core microbenchmarks (mock HAL)\n\n");
+    printf("Usage: %s [options]\n\n", progname);
+    printf("Options:\n");
+    printf("  --filter <text>        Run benchmarks whose name contains text\n");
+    printf("  --min-ms <n>           Shortest timed batch (default: %d)\n", DEFAULT_MIN_MS);
+    printf("  --reps <n>             Timed batches per benchmark, median taken\n");
+    printf("                         (default: %d, max %d)\n", DEFAULT_REPS, MAX_REPS);
+    printf("  --json <file>          Write results as JSON\n");
+    printf("  --baseline <file>      JSON from an earlier run: fail if HAL calls or\n");
+    printf("                         allocations per op went up, show ns/op deltas\n");
+    printf("  --max-regress <pct>    Also fail if ns/op grew by more than pct\n");
+    printf("  --sites <n>            Also list the top n HAL call sites per benchmark\n");
+    printf("  --list                 List benchmark names\n");
+    printf("  --help                 Show this help message\n");
+}
+
+int main(int argc, char **argv) {
+    const char *filter = NULL;
+    const char *json_path = NULL;
+    const char *baseline_path = NULL;
+    uint32_t min_ms = DEFAULT_MIN_MS;
+    int reps = DEFAULT_REPS;
+    double max_regress = -1;
+    int sites = 0;
+
+    for (int i = 1; i < argc; i++) {
+        bool has_arg = i + 1 < argc;
+        if (strcmp(argv[i], "--filter") == 0 && has_arg) {
+            filter = argv[++i];
+        } else if (strcmp(argv[i], "--min-ms") == 0 && has_arg) {
+            min_ms = (uint32_t)strtoul(argv[++i], NULL, 10);
+        } else if (strcmp(argv[i], "--reps") == 0 && has_arg) {
+            reps = atoi(argv[++i]);
+        } else if (strcmp(argv[i], "--json") == 0 && has_arg) {
+            json_path = argv[++i];
+        } else if (strcmp(argv[i], "--baseline") == 0 && has_arg) {
+            baseline_path = argv[++i];
+        } else if (strcmp(argv[i], "--max-regress") == 0 && has_arg) {
+            max_regress = atof(argv[++i]);
+        } else if (strcmp(argv[i], "--sites") == 0 && has_arg) {
+            sites = atoi(argv[++i]);
+        } else if (strcmp(argv[i], "--list") == 0) {
+            for (int b = 0; b < core_bench_count; b++) {
+                printf("%s\n", core_benches[b].name);
+            }
+            return 0;
+        } else if (strcmp(argv[i], "--help") == 0 || strcmp(argv[i], "-h") == 0) {
+            print_usage(argv[0]);
+            return 0;
+        } else {
+            fprintf(stderr, "Unknown option: %s\n", argv[i]);
+            print_usage(argv[0]);
+            return 1;
+        }
+    }
+    if (reps < 1 || reps > MAX_REPS) {
+        print_usage(argv[0]);
+        return 1;
+    }
+
+    FILE *baseline = NULL;
+    if (baseline_path && !(baseline = fopen(baseline_path, "r"))) {
+        perror(baseline_path);
+        return 1;
+    }
+
+    use_mock_hal();
+
+    static BenchResult results[64];
+    int n = 0;
+    bool regressed = false;
+    printf("%-22s %9s %10s %8s %8s %8s%s\n", "benchmark", "batch", "ns/op", "hal/op",
+           "alloc/op", "flush/op", baseline ? "   ns delta" : "");
+    for (int b = 0; b < core_bench_count && n < 64; b++) {
+        if (filter && !strstr(core_benches[b].name, filter)) continue;
+        results[n] = bench_one(&core_benches[b], min_ms, reps);
+        regressed |= report(&results[n], baseline, max_regress);
+        if (sites > 0) {
+            hal_stats_report(&hal_stats, &core_benches[b].name, 1, sites, stdout);
+            printf("\n");
+        }
+        n++;
+    }
+    if (baseline) fclose(baseline);
+
+    if (json_path) {
+        FILE *f = fopen(json_path, "w");
+        if (!f) {
+            perror(json_path);
+            return 1;
+        }
+        fprintf(f, "{\"format\":%d,\"min_ms\":%lu,\"reps\":%d,\"benchmarks\":[\n",
+                JSON_FORMAT, (unsigned long)min_ms, reps);
+        for (int i = 0; i < n; i++) {
+            write_result(f, &results[i], i == n - 1);
+        }
+        fprintf(f, "]}\n");
+        if (fclose(f) != 0) {
+            perror(json_path);
+            return 1;
+        }
+    }
+
+    fflush(stdout);
+    if (regressed) {
+        fprintf(stderr, "FAIL: regression against %s\n", baseline_path);
+        return 1;
+    }
+    return 0;
+}
@@ -0,0 +1,30 @@
+#ifndef GK_BENCH_BENCH_H
+#define GK_BENCH_BENCH_H
+
+#include <stdint.h>
+
+/**
+ * @file bench.h
+ * @brief Host microbenchmarks for the firmware core
+ *
+ * Each benchmark times one core operation against the mock HAL. The
+ * harness has the mock HAL count calls (hal_stats.h), so besides
+ * host time per operation it reports HAL calls, NeoPixel flushes and
+ * heap allocations per operation. Those counts are exact and
+ * machine-independent, unlike the timings.
+ */
+
+/**
+ * One benchmark.
+ */
+typedef struct {
+    const char *name;
+    void (*setup)(void);        // Reset state before each timed batch
+    void (*run)(uint32_t i);    // One operation; i counts from 0 per batch
+} BenchCase;
+
+// Benchmarks in core_bench.c
+extern const BenchCase core_benches[];
+extern const int core_bench_count;
+
+#endif /* GK_BENCH_BENCH_H */
@@ -0,0 +1,185 @@
+#include "bench.h"
+#include "app_init.h"
+#include "core/coordinator.h"
+#include "events/events.h"
+#include "fsm/fsm.h"
+#include "input/cv_input.h"
+#include "output/led_feedback.h"
+#include "mocks/mock_hal.h"
+#include "mocks/mock_neopixel.h"
+
+#include <string.h>
+
+/**
+ * @file core_bench.c
+ * @brief Core benchmarks
+ *
+ * Every operation advances mock time by 1 ms where time matters, so a
+ * batch of N operations covers N ms of firmware time, and input patterns
+ * are functions of the operation index: each batch sees the same inputs.
+ */
+
+static Coordinator coord;
+static AppSettings settings;
+static EventProcessor events;
+static CVInput cv;
+static LEDFeedbackController leds;
+
+static void setup_coordinator(void) {
+    mock_hal_init();
+    mock_eeprom_clear();
+    mock_neopixel_reset();
+    app_init_get_defaults(&settings);
+    coordinator_init(&coord, &settings);
+    coordinator_start(&coord);
+}
+
+// =============================================================================
+// FSM dispatch
+// =============================================================================
+//
+// Outside coordinator_update() the coordinator's actions return early,
+// so these time the table lookup and state change alone.
+
+static const uint8_t top_events[] = {
+    EVT_MENU_TOGGLE, EVT_A_TAP, EVT_MENU_TOGGLE, EVT_B_PRESS, EVT_MENU_TOGGLE, EVT_TIMEOUT
+};
+static const uint8_t mode_events[] = {
+    EVT_MODE_NEXT, EVT_B_PRESS, EVT_CV_RISE, EVT_A_TAP
+};
+static const uint8_t menu_events[] = {
+    EVT_A_TAP, EVT_B_TAP, EVT_B_HOLD, EVT_TIMEOUT
+};
+
+#define COUNT_OF(a) (sizeof(a) / sizeof((a)[0]))
+
+static void run_fsm_top(uint32_t i) {
+    fsm_process_event(&coord.top_fsm, top_events[i % COUNT_OF(top_events)]);
+}
+
+static void run_fsm_mode(uint32_t i) {
+    fsm_process_event(&coord.mode_fsm, mode_events[i % COUNT_OF(mode_events)]);
+}
+
+static void run_fsm_menu(uint32_t i) {
+    fsm_process_event(&coord.menu_fsm, menu_events[i % COUNT_OF(menu_events)]);
+}
+
+// =============================================================================
+// Event processor
+// =============================================================================
+
+static void setup_events(void) {
+    event_processor_init(&events);
+}
+
+// 2.4 s gesture cycle: menu toggle (A then B held), mode change (B then
+// A held), an A tap and a B tap; CV toggling every 7 ms throughout
+static void run_events(uint32_t i) {
+    uint32_t t = i % 2400;
+    EventInput input = {
+        .button_a = t < 1150 || (t >= 1500 && t < 2100) || (t >= 2200 && t < 2250),
+        .button_b = (t >= 600 && t < 1150) || (t >= 1300 && t < 2100) ||
+                    (t >= 2300 && t < 2340),
+        .cv_in = (i / 7) & 1,
+        .current_time = i
+    };
+    event_processor_update(&events, &input);
+}
+
+// =============================================================================
+// Coordinator
+// =============================================================================
+
+// Button B pulses (11 of every 37 ms), CV square wave (5 ms half period)
+static void run_coordinator(uint32_t i) {
+    advance_mock_time(1);
+    if (i % 37 < 11) {
+        mock_clear_pin(p_hal->button_b_pin);
+    } else {
+        mock_set_pin(p_hal->button_b_pin);
+    }
+    mock_adc_set_value(CV_ADC_CHANNEL, ((i / 5) & 1) ? 200 : 20);
+    coordinator_update(&coord);
+}
+
+#define COORDINATOR_SETUP(name, mode)               \
+    static void setup_##name(void) {                \
+        setup_coordinator();                        \
+        coordinator_set_mode(&coord, mode);         \
+    }
+
+COORDINATOR_SETUP(gate, MODE_GATE)
+COORDINATOR_SETUP(trigger, MODE_TRIGGER)
+COORDINATOR_SETUP(toggle, MODE_TOGGLE)
+COORDINATOR_SETUP(divide, MODE_DIVIDE)
+COORDINATOR_SETUP(cycle, MODE_CYCLE)
+
+// =============================================================================
+// LED feedback
+// =============================================================================
+
+static void setup_leds(void) {
+    mock_neopixel_reset();
+    led_feedback_init(&leds);
+}
+
+// Activity LED blinking every 10 ms; menu shown for 0.5 s of every 3 s
+static void run_leds(uint32_t i) {
+    LEDFeedback feedback;
+    memset(&feedback, 0, sizeof(feedback));
+    feedback.mode_r = 255;
+    feedback.activity_r = 255;
+    feedback.activity_brightness = (i % 20 < 10) ? 255 : 0;
+    feedback.current_mode = MODE_GATE;
+    feedback.in_menu = i % 3000 >= 2500;
+    feedback.current_page = (i / 100) % 3;
+    led_feedback_update(&leds, &feedback, i);
+}
+
+// =============================================================================
+// CV input
+// =============================================================================
+
+static void setup_cv(void) {
+    cv_input_init(&cv);
+}
+
+// Triangle sweep over the full ADC range, crossing both thresholds
+static void run_cv(uint32_t i) {
+    uint32_t v = i & 511;
+    cv_input_update(&cv, (uint8_t)(v < 256 ? v : 511 - v));
+}
+
+// =============================================================================
+// Settings save
+// =============================================================================
+
+static void setup_save(void) {
+    mock_hal_init();
+    mock_eeprom_clear();
+    app_init_get_defaults(&settings);
+}
+
+static void run_save(uint32_t i) {
+    settings.mode = (uint8_t)(i % MODE_COUNT);
+    settings.trigger_pulse_idx = (uint8_t)(i % 4);
+    app_init_save_settings(&settings);
+}
+
+const BenchCase core_benches[] = {
+    { "fsm_top",            setup_coordinator,  run_fsm_top },
+    { "fsm_mode",           setup_coordinator,  run_fsm_mode },
+    { "fsm_menu",           setup_coordinator,  run_fsm_menu },
+    { "events_gestures",    setup_events,       run_events },
+    { "coordinator_gate",   setup_gate,         run_coordinator },
+    { "coordinator_trigger", setup_trigger,     run_coordinator },
+    { "coordinator_toggle", setup_toggle,       run_coordinator },
+    { "coordinator_divide", setup_divide,       run_coordinator },
+    { "coordinator_cycle",  setup_cycle,        run_coordinator },
+    { "led_feedback",       setup_leds,         run_leds },
+    { "cv_input",           setup_cv,           run_cv },
+    { "save_settings",      setup_save,         run_save },
+};
+
+const int core_bench_count = COUNT_OF(core_benches);
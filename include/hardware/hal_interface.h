@@ -62,8 +62,17 @@ typedef struct HalInterface {
     void     (*wdt_disable)(void);  // Disable watchdog (use sparingly)
 } HalInterface;
 
+// Host builds that run several simulated devices in one process (one per
+// thread) define GK_HAL_PER_THREAD, giving every thread its own HAL binding.
+// Firmware and unit tests keep a plain global.
+#ifdef GK_HAL_PER_THREAD
+#define GK_THREAD_LOCAL _Thread_local
+#else
+#define GK_THREAD_LOCAL
+#endif
+
 // Global pointer to the current HAL implementation.
 // This pointer defaults to the production HAL, but tests can replace it with a mock.
-extern HalInterface *p_hal;
+extern GK_THREAD_LOCAL HalInterface *p_hal;
 
 #endif /* GK_HARDWARE_HAL_INTERFACE_H */
\ No newline at end of file
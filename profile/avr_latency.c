@@ -0,0 +1,582 @@
+#include "avr_target.h"
+
+#include <stdbool.h>
+#include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+/**
+ * @file avr_latency.c
+ * @brief Input-to-output latency bench on simavr
+ *
+ * Runs the real firmware ELF on a simulated ATtiny85, drives the perform
+ * input with randomly timed edges and timestamps the resulting edges on
+ * PB1 (signal output) to the cycle. Edge times are uniform at cycle
+ * resolution, so they land anywhere in the main loop; the spread of the
+ * measured latencies is the loop's sampling jitter.
+ *
+ * Which output edge answers an input edge depends on the mode:
+ *
+ *   gate     rise and fall   -> output edge in the same direction
+ *   trigger  rise            -> output rise
+ *   toggle   rise            -> either output edge
+ *   divide   rise            -> output rise (only every Nth rise answers)
+ *   cycle    (input ignored) -> pulse widths only
+ *
+ * An input edge not answered before the next one, or within
+ * ANSWER_TIMEOUT_MS, counts as unanswered. Output pulse width jitter is
+ * the output width minus the input interval that defined it (gate,
+ * toggle), or the deviation from the median width for timed pulses
+ * (trigger, divide, cycle).
+ *
+ * Samples are grouped by mode, by LED activity (PB0 toggled between the
+ * input edge and its answer, i.e. a NeoPixel flush with interrupts off)
+ * and by menu state (edges in the window right after leaving the menu,
+ * with its settings save and LED change; while the menu is open the
+ * output is held and nothing can be measured).
+ */
+
+#define DEFAULT_EDGES           300         // Edge pairs per mode
+#define DEFAULT_MIN_MS          8           // Input high/low time range
+#define DEFAULT_MAX_MS          20
+#define DEFAULT_MENU_ROUNDS     8
+#define MENU_EDGES              8           // Edge pairs after each menu exit
+#define SETTLE_MS               300         // Boot before the first edge
+#define ANSWER_TIMEOUT_MS       50
+#define MAX_SAMPLES             4096        // Per group
+#define MIN_REGRESS_SAMPLES     20          // Smaller groups don't fail a run
+
+// Menu toggle gesture: A pressed, B held for EP_HOLD_THRESHOLD_MS
+#define GESTURE_B_MS            100
+#define GESTURE_RELEASE_MS      800
+#define GESTURE_GAP_MS          1000
+
+#define CYCLES_US(c)            ((double)(c) / (AVR_TARGET_HZ / 1000000u))
+
+typedef enum {
+    INPUT_B,                                // Button B (perform input)
+    INPUT_CV                                // CV input, 0 V / 5 V
+} InputKind;
+
+typedef struct {
+    uint64_t at;                            // Cycle
+    uint8_t pin;                            // AVR_PIN_*
+    bool level;                             // Pressed / CV high
+    bool sample;                            // Measured edge
+    bool menu;                              // In a post-menu window
+} Edge;
+
+typedef struct {
+    uint32_t latency[MAX_SAMPLES];          // Cycles
+    uint32_t jitter[MAX_SAMPLES];           // |width error|, cycles
+    uint32_t widths[MAX_SAMPLES];           // Timed pulse widths (median pass)
+    int samples;
+    int jitter_samples;
+    int num_widths;
+    uint32_t unanswered;
+} Group;
+
+typedef struct {
+    AvrTarget target;
+    ModeState mode;
+    Group (*groups)[2];                     // [menu][led] for this mode
+
+    // Input side
+    bool window;                            // Current edges are measured
+    bool menu;
+    bool pending;                           // Input edge awaiting its answer
+    bool pending_rise;
+    uint64_t pending_at;
+    bool pending_led;
+
+    // Output side
+    bool out;
+    uint64_t rise_at;                       // Output rise in a window, or 0
+    uint64_t rise_cause;                    // Input edge it answered, or 0
+    bool rise_menu;
+    bool pulse_led;
+} Bench;
+
+static Group groups[MODE_COUNT][2][2];
+
+static int compare_u32(const void *x, const void *y) {
+    uint32_t a = *(const uint32_t*)x;
+    uint32_t b = *(const uint32_t*)y;
+    return (a > b) - (a < b);
+}
+
+// =============================================================================
+// Stimulus
+// =============================================================================
+
+static uint64_t rng_state;
+
+static uint64_t rng_next(void) {
+    rng_state ^= rng_state << 13;
+    rng_state ^= rng_state >> 7;
+    rng_state ^= rng_state << 17;
+    return rng_state;
+}
+
+static uint64_t random_cycles(uint32_t min_ms, uint32_t max_ms) {
+    uint64_t lo = (uint64_t)min_ms * AVR_TARGET_CYCLES_MS;
+    uint64_t span = (uint64_t)(max_ms - min_ms) * AVR_TARGET_CYCLES_MS + 1;
+    return lo + rng_next() % span;
+}
+
+static int add_pulses(Edge *edges, int n, uint64_t *t, uint8_t pin, int pairs, bool menu,
+                      uint32_t min_ms, uint32_t max_ms) {
+    for (int i = 0; i < pairs; i++) {
+        edges[n++] = (Edge){ .at = *t, .pin = pin, .level = true, .sample = true, .menu = menu };
+        *t += random_cycles(min_ms, max_ms);
+        edges[n++] = (Edge){ .at = *t, .pin = pin, .level = false, .sample = true, .menu = menu };
+        *t += random_cycles(min_ms, max_ms);
+    }
+    return n;
+}
+
+static int add_menu_toggle(Edge *edges, int n, uint64_t *t) {
+    uint64_t ms = AVR_TARGET_CYCLES_MS;
+    edges[n++] = (Edge){ .at = *t, .pin = AVR_PIN_BUTTON_A, .level = true };
+    edges[n++] = (Edge){ .at = *t + GESTURE_B_MS * ms, .pin = AVR_PIN_BUTTON_B, .level = true };
+    edges[n++] = (Edge){ .at = *t + GESTURE_RELEASE_MS * ms, .pin = AVR_PIN_BUTTON_A };
+    edges[n++] = (Edge){ .at = *t + GESTURE_RELEASE_MS * ms, .pin = AVR_PIN_BUTTON_B };
+    *t += GESTURE_GAP_MS * ms;
+    return n;
+}
+
+// =============================================================================
+// Measurement
+// =============================================================================
+
+static bool triggers(ModeState mode, bool rise) {
+    switch (mode) {
+        case MODE_GATE:     return true;
+        case MODE_CYCLE:    return false;
+        default:            return rise;
+    }
+}
+
+static bool answers(ModeState mode, bool pending_rise, bool out_rise) {
+    switch (mode) {
+        case MODE_GATE:     return out_rise == pending_rise;
+        case MODE_TOGGLE:   return true;
+        default:            return out_rise;
+    }
+}
+
+static void unanswered(Bench *b) {
+    b->groups[b->menu][b->pending_led].unanswered++;
+    b->pending = false;
+}
+
+static void on_output(struct avr_irq_t *irq, uint32_t value, void *param) {
+    (void)irq;
+    Bench *b = param;
+    uint64_t now = b->target.avr->cycle;
+    bool high = value != 0;
+    if (high == b->out) return;
+    b->out = high;
+
+    uint64_t cause = 0;
+    if (b->pending && answers(b->mode, b->pending_rise, high)) {
+        Group *g = &b->groups[b->menu][b->pending_led];
+        if (g->samples < MAX_SAMPLES) {
+            g->latency[g->samples++] = (uint32_t)(now - b->pending_at);
+        }
+        cause = b->pending_at;
+        b->pending = false;
+    }
+    if (!b->window) return;
+
+    if (high) {
+        b->rise_at = now;
+        b->rise_cause = cause;
+        b->rise_menu = b->menu;
+        b->pulse_led = false;
+        return;
+    }
+    if (!b->rise_at) return;
+
+    Group *g = &b->groups[b->rise_menu][b->pulse_led];
+    uint32_t width = (uint32_t)(now - b->rise_at);
+    if (cause && b->rise_cause) {
+        uint32_t in_width = (uint32_t)(cause - b->rise_cause);
+        if (g->jitter_samples < MAX_SAMPLES) {
+            g->jitter[g->jitter_samples++] = (width > in_width) ? width - in_width : in_width - width;
+        }
+    } else if (g->num_widths < MAX_SAMPLES) {
+        g->widths[g->num_widths++] = width;
+    }
+    b->rise_at = 0;
+}
+
+static void on_neopixel(struct avr_irq_t *irq, uint32_t value, void *param) {
+    (void)irq;
+    (void)value;
+    Bench *b = param;
+    if (b->pending) b->pending_led = true;
+    if (b->rise_at) b->pulse_led = true;
+}
+
+static void apply_edge(Bench *b, const Edge *ev) {
+    if (ev->sample) {
+        if (triggers(b->mode, ev->level)) {
+            if (b->pending) unanswered(b);
+            b->pending = true;
+            b->pending_rise = ev->level;
+            b->pending_at = b->target.avr->cycle;
+            b->pending_led = false;
+        }
+    } else {
+        // Gesture edges are not measured, nor is any pulse they overlap
+        b->pending = false;
+        b->rise_at = 0;
+    }
+    b->window = ev->sample;
+    b->menu = ev->menu;
+
+    if (ev->pin == AVR_PIN_CV) {
+        avr_target_cv(&b->target, ev->level ? 5000 : 0);
+    } else {
+        avr_target_button(&b->target, ev->pin, ev->level);
+    }
+}
+
+// Run one boot into mode through the edge schedule
+static bool bench_mode(elf_firmware_t *fw, ModeState mode, const Edge *edges, int num_edges) {
+    static Bench b;
+    memset(&b, 0, sizeof(b));
+    b.mode = mode;
+    b.groups = groups[mode];
+    if (!avr_target_boot(&b.target, fw, mode)) {
+        return false;
+    }
+    avr_t *avr = b.target.avr;
+    avr_irq_register_notify(b.target.pin[AVR_PIN_SIG_OUT], on_output, &b);
+    avr_irq_register_notify(b.target.pin[AVR_PIN_NEOPIXEL], on_neopixel, &b);
+
+    uint64_t timeout = (uint64_t)ANSWER_TIMEOUT_MS * AVR_TARGET_CYCLES_MS;
+    uint64_t end = edges[num_edges - 1].at + timeout;
+    int next = 0;
+    while (avr->cycle < end) {
+        while (next < num_edges && edges[next].at <= avr->cycle) {
+            apply_edge(&b, &edges[next++]);
+        }
+        if (b.pending && avr->cycle - b.pending_at > timeout) {
+            unanswered(&b);
+        }
+        if (!avr_target_step(&b.target)) {
+            avr_target_close(&b.target);
+            return false;
+        }
+    }
+    if (b.pending) unanswered(&b);
+
+    // Timed pulses: deviation from this mode's median width
+    static uint32_t all[2 * 2 * MAX_SAMPLES];
+    int n = 0;
+    for (int m = 0; m < 2; m++) {
+        for (int l = 0; l < 2; l++) {
+            memcpy(&all[n], b.groups[m][l].widths, b.groups[m][l].num_widths * sizeof(uint32_t));
+            n += b.groups[m][l].num_widths;
+        }
+    }
+    if (n > 0) {
+        qsort(all, n, sizeof(uint32_t), compare_u32);
+        uint32_t median = all[n / 2];
+        for (int m = 0; m < 2; m++) {
+            for (int l = 0; l < 2; l++) {
+                Group *g = &b.groups[m][l];
+                for (int i = 0; i < g->num_widths && g->jitter_samples < MAX_SAMPLES; i++) {
+                    uint32_t w = g->widths[i];
+                    g->jitter[g->jitter_samples++] = (w > median) ? w - median : median - w;
+                }
+            }
+        }
+    }
+
+    avr_target_close(&b.target);
+    return true;
+}
+
+// =============================================================================
+// Report
+// =============================================================================
+
+typedef struct {
+    double min, p50, p90, p99, max;         // Microseconds
+} Percentiles;
+
+// Nearest-rank percentiles; sorts values in place
+static Percentiles percentiles(uint32_t *values, int n) {
+    Percentiles p = { 0 };
+    if (n == 0) return p;
+    qsort(values, n, sizeof(uint32_t), compare_u32);
+    p.min = CYCLES_US(values[0]);
+    p.p50 = CYCLES_US(values[(50 * n + 99) / 100 - 1]);
+    p.p90 = CYCLES_US(values[(90 * n + 99) / 100 - 1]);
+    p.p99 = CYCLES_US(values[(99 * n + 99) / 100 - 1]);
+    p.max = CYCLES_US(values[n - 1]);
+    return p;
+}
+
+typedef struct {
+    Percentiles latency;
+    Percentiles jitter;
+} GroupSummary;
+
+static GroupSummary summaries[MODE_COUNT][2][2];
+
+static const char* flag(bool value) {
+    return value ? "true" : "false";
+}
+
+// p50/p99 latency of a group in a baseline report; false if absent
+static bool baseline_group(FILE *baseline, const char *mode, bool menu, bool led,
+                           double *p50, double *p99) {
+    rewind(baseline);
+    char line[512];
+    while (fgets(line, sizeof(line), baseline)) {
+        char m[16], menu_s[8], led_s[8];
+        unsigned long samples, missed;
+        double min, p90, max;
+        if (sscanf(line, " {\"mode\":\"%15[^\"]\",\"menu\":%7[a-z],\"led\":%7[a-z],"
+                   "\"samples\":%lu,\"unanswered\":%lu,"
+                   "\"latency_us\":{\"min\":%lf,\"p50\":%lf,\"p90\":%lf,\"p99\":%lf,\"max\":%lf",
+                   m, menu_s, led_s, &samples, &missed, &min, p50, &p90, p99, &max) == 10 &&
+            strcmp(m, mode) == 0 && strcmp(menu_s, flag(menu)) == 0 &&
+            strcmp(led_s, flag(led)) == 0 && samples > 0) {
+            return true;
+        }
+    }
+    return false;
+}
+
+// Print groups; with a baseline, return the worst p99 regression in %
+static double report(bool modes[MODE_COUNT], FILE *baseline) {
+    double worst = 0;
+    printf("\n%-8s %-5s %-4s %7s %6s %9s %9s %9s %9s %9s %9s%s\n", "mode", "menu", "led",
+           "samples", "unans", "p50 us", "p90 us", "p99 us", "max us", "jit p50", "jit p99",
+           baseline ? "   p50 delta   p99 delta" : "");
+
+    for (int m = 0; m < MODE_COUNT; m++) {
+        if (!modes[m]) continue;
+        for (int menu = 0; menu < 2; menu++) {
+            for (int led = 0; led < 2; led++) {
+                Group *g = &groups[m][menu][led];
+                if (g->samples == 0 && g->jitter_samples == 0 && g->unanswered == 0) continue;
+                GroupSummary *s = &summaries[m][menu][led];
+                s->latency = percentiles(g->latency, g->samples);
+                s->jitter = percentiles(g->jitter, g->jitter_samples);
+
+                const char *name = avr_target_mode_name((ModeState)m);
+                printf("%-8s %-5s %-4s %7d %6lu %9.1f %9.1f %9.1f %9.1f %9.1f %9.1f", name,
+                       menu ? "after" : "-", led ? "busy" : "-", g->samples,
+                       (unsigned long)g->unanswered, s->latency.p50, s->latency.p90,
+                       s->latency.p99, s->latency.max, s->jitter.p50, s->jitter.p99);
+
+                double base50, base99;
+                if (baseline && g->samples > 0 &&
+                    baseline_group(baseline, name, menu, led, &base50, &base99)) {
+                    double d50 = (base50 > 0) ? 100.0 * (s->latency.p50 - base50) / base50 : 0;
+                    double d99 = (base99 > 0) ? 100.0 * (s->latency.p99 - base99) / base99 : 0;
+                    printf("  %+9.1f%%  %+9.1f%%", d50, d99);
+                    if (g->samples >= MIN_REGRESS_SAMPLES && d99 > worst) worst = d99;
+                } else if (baseline && g->samples > 0) {
+                    printf("  %10s", "new");
+                }
+                printf("\n");
+            }
+        }
+    }
+    return worst;
+}
+
+static void print_percentiles(FILE *f, const char *key, int samples, const Percentiles *p) {
+    fprintf(f, "\"%s\":{\"samples\":%d,\"min\":%.1f,\"p50\":%.1f,\"p90\":%.1f,\"p99\":%.1f,"
+            "\"max\":%.1f}", key, samples, p->min, p->p50, p->p90, p->p99, p->max);
+}
+
+// One group object per line, so baselines can be read back line by line
+static bool write_json(bool modes[MODE_COUNT], const char *path, const char *input,
+                       uint64_t seed, int edges, uint32_t min_ms, uint32_t max_ms) {
+    FILE *f = fopen(path, "w");
+    if (!f) {
+        perror(path);
+        return false;
+    }
+    fprintf(f, "{\"input\":\"%s\",\"seed\":%llu,\"edges\":%d,\"min_ms\":%lu,\"max_ms\":%lu,"
+            "\"groups\":[\n", input, (unsigned long long)seed, edges,
+            (unsigned long)min_ms, (unsigned long)max_ms);
+    bool first = true;
+    for (int m = 0; m < MODE_COUNT; m++) {
+        if (!modes[m]) continue;
+        for (int menu = 0; menu < 2; menu++) {
+            for (int led = 0; led < 2; led++) {
+                const Group *g = &groups[m][menu][led];
+                if (g->samples == 0 && g->jitter_samples == 0 && g->unanswered == 0) continue;
+                const GroupSummary *s = &summaries[m][menu][led];
+                fprintf(f, "%s  {\"mode\":\"%s\",\"menu\":%s,\"led\":%s,\"samples\":%d,"
+                        "\"unanswered\":%lu,\"latency_us\":{\"min\":%.1f,\"p50\":%.1f,"
+                        "\"p90\":%.1f,\"p99\":%.1f,\"max\":%.1f},",
+                        first ? "" : ",\n", avr_target_mode_name((ModeState)m), flag(menu),
+                        flag(led), g->samples, (unsigned long)g->unanswered, s->latency.min,
+                        s->latency.p50, s->latency.p90, s->latency.p99, s->latency.max);
+                print_percentiles(f, "width_jitter_us", g->jitter_samples, &s->jitter);
+                fprintf(f, "}");
+                first = false;
+            }
+        }
+    }
+    fprintf(f, "\n]}\n");
+    return fclose(f) == 0;
+}
+
+// =============================================================================
+// Main
+// =============================================================================
+
+static void print_usage(const char *progname) {
+    printf("Gatekeeper input-to-output latency bench (simavr)\n\n");
+    printf("Usage: %s [options] <firmware.elf>\n\n", progname);
+    printf("Options:\n");
+    printf("  --mode <name>          Bench one mode: gate, trigger, toggle, divide,\n");
+    printf("                         cycle (default: each in turn)\n");
+    printf("  --input <b|cv>         Edges on button B (default) or the CV input\n");
+    printf("  --edges <n>            Input pulses per mode (default: %d)\n", DEFAULT_EDGES);
+    printf("  --min-ms <n>           Shortest input high/low time (default: %d)\n",
+           DEFAULT_MIN_MS);
+    printf("  --max-ms <n>           Longest input high/low time (default: %d)\n",
+           DEFAULT_MAX_MS);
+    printf("  --menu-rounds <n>      Menu visits per mode, each followed by %d\n", MENU_EDGES);
+    printf("                         measured pulses (default: %d)\n", DEFAULT_MENU_ROUNDS);
+    printf("  --seed <n>             Edge timing seed (default: 1)\n");
+    printf("  --json <file>          Write per-group percentiles as JSON\n");
+    printf("  --baseline <file>      JSON from an earlier run: show p50/p99 deltas\n");
+    printf("  --max-regress <pct>    Fail if a p99 latency grew by more than pct\n");
+    printf("                         (groups of %d samples or more)\n", MIN_REGRESS_SAMPLES);
+    printf("  --help                 Show this help message\n");
+}
+
+int main(int argc, char **argv) {
+    const char *elf_path = NULL;
+    const char *json_path = NULL;
+    const char *baseline_path = NULL;
+    InputKind input = INPUT_B;
+    int num_pulses = DEFAULT_EDGES;
+    int menu_rounds = DEFAULT_MENU_ROUNDS;
+    uint32_t min_ms = DEFAULT_MIN_MS;
+    uint32_t max_ms = DEFAULT_MAX_MS;
+    uint64_t seed = 1;
+    double max_regress = -1;
+    int only_mode = -1;
+
+    for (int i = 1; i < argc; i++) {
+        bool has_arg = i + 1 < argc;
+        if (strcmp(argv[i], "--mode") == 0 && has_arg) {
+            ModeState mode;
+            if (!avr_target_parse_mode(argv[++i], &mode)) {
+                fprintf(stderr, "Error: Unknown mode: %s\n", argv[i]);
+                return 1;
+            }
+            only_mode = mode;
+        } else if (strcmp(argv[i], "--input") == 0 && has_arg) {
+            i++;
+            if (strcmp(argv[i], "b") == 0) {
+                input = INPUT_B;
+            } else if (strcmp(argv[i], "cv") == 0) {
+                input = INPUT_CV;
+            } else {
+                fprintf(stderr, "Error: Unknown input: %s\n", argv[i]);
+                return 1;
+            }
+        } else if (strcmp(argv[i], "--edges") == 0 && has_arg) {
+            num_pulses = atoi(argv[++i]);
+        } else if (strcmp(argv[i], "--min-ms") == 0 && has_arg) {
+            min_ms = (uint32_t)strtoul(argv[++i], NULL, 10);
+        } else if (strcmp(argv[i], "--max-ms") == 0 && has_arg) {
+            max_ms = (uint32_t)strtoul(argv[++i], NULL, 10);
+        } else if (strcmp(argv[i], "--menu-rounds") == 0 && has_arg) {
+            menu_rounds = atoi(argv[++i]);
+        } else if (strcmp(argv[i], "--seed") == 0 && has_arg) {
+            seed = strtoull(argv[++i], NULL, 10);
+        } else if (strcmp(argv[i], "--json") == 0 && has_arg) {
+            json_path = argv[++i];
+        } else if (strcmp(argv[i], "--baseline") == 0 && has_arg) {
+            baseline_path = argv[++i];
+        } else if (strcmp(argv[i], "--max-regress") == 0 && has_arg) {
+            max_regress = atof(argv[++i]);
+        } else if (strcmp(argv[i], "--help") == 0 || strcmp(argv[i], "-h") == 0) {
+            print_usage(argv[0]);
+            return 0;
+        } else if (argv[i][0] != '-' && !elf_path) {
+            elf_path = argv[i];
+        } else {
+            fprintf(stderr, "Unknown option: %s\n", argv[i]);
+            print_usage(argv[0]);
+            return 1;
+        }
+    }
+    if (!elf_path || num_pulses <= 0 || menu_rounds < 0 || min_ms == 0 || max_ms < min_ms) {
+        print_usage(argv[0]);
+        return 1;
+    }
+    if (max_regress >= 0 && !baseline_path) {
+        fprintf(stderr, "Error: --max-regress needs --baseline\n");
+        return 1;
+    }
+
+    FILE *baseline = NULL;
+    if (baseline_path && !(baseline = fopen(baseline_path, "r"))) {
+        perror(baseline_path);
+        return 1;
+    }
+
+    elf_firmware_t fw;
+    if (!avr_target_load(elf_path, &fw)) {
+        return 1;
+    }
+
+    // Same schedule for every mode: perform edges, then menu visits
+    uint8_t pin = (input == INPUT_CV) ? AVR_PIN_CV : AVR_PIN_BUTTON_B;
+    int capacity = 2 * num_pulses + menu_rounds * (8 + 2 * MENU_EDGES);
+    Edge *edges = malloc(capacity * sizeof(Edge));
+    if (!edges) {
+        fprintf(stderr, "Error: Out of memory\n");
+        return 1;
+    }
+    rng_state = seed ? seed : 1;
+    uint64_t t = (uint64_t)SETTLE_MS * AVR_TARGET_CYCLES_MS;
+    int n = add_pulses(edges, 0, &t, pin, num_pulses, false, min_ms, max_ms);
+    for (int r = 0; r < menu_rounds; r++) {
+        n = add_menu_toggle(edges, n, &t);          // Enter
+        n = add_menu_toggle(edges, n, &t);          // Leave (saves settings)
+        n = add_pulses(edges, n, &t, pin, MENU_EDGES, true, min_ms, max_ms);
+    }
+
+    bool modes[MODE_COUNT];
+    for (int m = 0; m < MODE_COUNT; m++) {
+        modes[m] = only_mode < 0 || only_mode == m;
+        if (modes[m] && !bench_mode(&fw, (ModeState)m, edges, n)) {
+            free(edges);
+            return 1;
+        }
+    }
+    free(edges);
+
+    double worst = report(modes, baseline);
+    fflush(stdout);
+    if (baseline) fclose(baseline);
+
+    if (json_path && !write_json(modes, json_path, (input == INPUT_CV) ? "cv" : "b", seed,
+                                 num_pulses, min_ms, max_ms)) {
+        return 1;
+    }
+    if (max_regress >= 0 && worst > max_regress) {
+        fprintf(stderr, "FAIL: p99 latency regressed %.1f%% (limit %.1f%%)\n", worst, max_regress);
+        return 1;
+    }
+    return 0;
+}
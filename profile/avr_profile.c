@@ -0,0 +1,499 @@
+#include "avr_target.h"
+
+#include <elf.h>
+#include <stdbool.h>
+#include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+/**
+ * @file avr_profile.c
+ * @brief Cycle-accurate firmware profiler on simavr
+ *
+ * Runs the real firmware ELF on a simulated ATtiny85 and counts cycles
+ * per function. Function entry addresses come from the ELF symbol table
+ * (build the firmware with -DKEEP_SYMBOLS=ON). The core is stepped one
+ * instruction at a time:
+ *
+ * - Landing on a function's entry address pushes a frame (calls, tail
+ *   jumps and interrupt vectors alike).
+ * - A frame is popped once the stack pointer rises above its value at
+ *   entry, i.e. the function has returned; its inclusive cycles are
+ *   recorded then.
+ * - Each instruction's cycles are charged to the innermost frame (self).
+ *
+ * Cycles are attributed to the mode running at the time, taken from the
+ * mode argument (r24) on entry to mode_handler_process(). Each mode is
+ * profiled in its own run, booted into that mode by preloading the
+ * settings into EEPROM, under the same stimulus on PB2 (button A), PB4
+ * (button B) and PB3 (CV input).
+ */
+
+#define FLASH_SIZE          8192            // ATtiny85
+#define MAX_FUNCS           512
+#define MAX_DEPTH           64
+#define MAX_EVENTS          1024
+#define DEFAULT_RUN_MS      2000
+#define DEFAULT_CV_PERIOD   20              // Default stimulus: 50 Hz CV clock
+#define MODE_HOOK           "mode_handler_process"
+
+typedef struct {
+    char name[48];
+    uint16_t addr;                          // Byte address in flash
+} Function;
+
+typedef struct {
+    uint32_t calls;
+    uint64_t self;
+    uint64_t inclusive;
+    uint32_t max_inclusive;                 // Worst single call
+} FuncStats;
+
+typedef struct {
+    uint16_t func;
+    uint16_t sp;                            // Stack pointer at entry
+    uint64_t start;                         // Cycle count at entry
+} Frame;
+
+typedef enum {
+    STIM_PRESS,
+    STIM_RELEASE,
+    STIM_CV
+} StimulusType;
+
+typedef struct {
+    uint32_t time_ms;
+    StimulusType type;
+    uint8_t pin;                            // PB2 or PB4 for buttons
+    uint32_t mv;                            // CV level
+} Stimulus;
+
+typedef struct {
+    Function funcs[MAX_FUNCS];
+    int num_funcs;
+    uint16_t func_at[FLASH_SIZE / 2];       // Word address -> function index + 1
+    uint16_t owner[FLASH_SIZE / 2];         // Word address -> containing function + 1
+    int mode_hook;                          // Index of MODE_HOOK, or -1
+
+    Stimulus events[MAX_EVENTS];
+    int num_events;
+    uint32_t cv_period_ms;                  // Square wave when no stimulus file
+
+    FuncStats stats[MODE_COUNT][MAX_FUNCS];
+    uint64_t mode_cycles[MODE_COUNT];
+} Profile;
+
+// =============================================================================
+// ELF Symbols
+// =============================================================================
+
+static int compare_funcs(const void *a, const void *b) {
+    return (int)((const Function*)a)->addr - (int)((const Function*)b)->addr;
+}
+
+// Read STT_FUNC symbols from the ELF symbol table
+static bool load_symbols(Profile *prof, const char *path) {
+    FILE *f = fopen(path, "rb");
+    if (!f) {
+        perror(path);
+        return false;
+    }
+    fseek(f, 0, SEEK_END);
+    long size = ftell(f);
+    fseek(f, 0, SEEK_SET);
+    uint8_t *elf = malloc(size);
+    if (!elf || fread(elf, 1, size, f) != (size_t)size) {
+        fprintf(stderr, "Error: Failed to read %s\n", path);
+        free(elf);
+        fclose(f);
+        return false;
+    }
+    fclose(f);
+
+    const Elf32_Ehdr *eh = (const Elf32_Ehdr*)elf;
+    if (size < (long)sizeof(*eh) || memcmp(eh->e_ident, ELFMAG, SELFMAG) != 0 ||
+        eh->e_ident[EI_CLASS] != ELFCLASS32 || eh->e_ident[EI_DATA] != ELFDATA2LSB ||
+        eh->e_shoff + (long)eh->e_shnum * sizeof(Elf32_Shdr) > (unsigned long)size) {
+        fprintf(stderr, "Error: %s is not an AVR ELF file\n", path);
+        free(elf);
+        return false;
+    }
+
+    const Elf32_Shdr *sh = (const Elf32_Shdr*)(elf + eh->e_shoff);
+    for (int i = 0; i < eh->e_shnum; i++) {
+        if (sh[i].sh_type != SHT_SYMTAB || sh[i].sh_link >= eh->e_shnum) continue;
+        const Elf32_Sym *syms = (const Elf32_Sym*)(elf + sh[i].sh_offset);
+        const char *strtab = (const char*)(elf + sh[sh[i].sh_link].sh_offset);
+        int count = sh[i].sh_size / sizeof(Elf32_Sym);
+
+        for (int s = 0; s < count && prof->num_funcs < MAX_FUNCS; s++) {
+            if (ELF32_ST_TYPE(syms[s].st_info) != STT_FUNC ||
+                syms[s].st_value >= FLASH_SIZE) continue;
+            Function *fn = &prof->funcs[prof->num_funcs++];
+            snprintf(fn->name, sizeof(fn->name), "%s", strtab + syms[s].st_name);
+            fn->addr = (uint16_t)syms[s].st_value;
+        }
+    }
+    free(elf);
+
+    if (prof->num_funcs == 0) {
+        fprintf(stderr, "Error: No function symbols in %s (build with -DKEEP_SYMBOLS=ON)\n",
+                path);
+        return false;
+    }
+
+    qsort(prof->funcs, prof->num_funcs, sizeof(Function), compare_funcs);
+    prof->mode_hook = -1;
+    for (int i = 0; i < prof->num_funcs; i++) {
+        uint16_t start = prof->funcs[i].addr / 2;
+        uint16_t end = (i + 1 < prof->num_funcs) ? prof->funcs[i + 1].addr / 2 : FLASH_SIZE / 2;
+        prof->func_at[start] = (uint16_t)(i + 1);
+        for (uint16_t w = start; w < end; w++) {
+            prof->owner[w] = (uint16_t)(i + 1);
+        }
+        if (strcmp(prof->funcs[i].name, MODE_HOOK) == 0) {
+            prof->mode_hook = i;
+        }
+    }
+    return true;
+}
+
+// =============================================================================
+// Stimulus
+// =============================================================================
+
+/**
+ * Stimulus file, one event per line ('#' starts a comment):
+ *   <ms> press a|b
+ *   <ms> release a|b
+ *   <ms> cv <millivolts>
+ */
+static bool load_stimulus(Profile *prof, const char *path) {
+    FILE *f = fopen(path, "r");
+    if (!f) {
+        perror(path);
+        return false;
+    }
+
+    char line[128];
+    int line_no = 0;
+    while (fgets(line, sizeof(line), f)) {
+        line_no++;
+        char *hash = strchr(line, '#');
+        if (hash) *hash = '\0';
+
+        unsigned long time_ms, value;
+        char action[16], arg[16];
+        int n = sscanf(line, "%lu %15s %15s", &time_ms, action, arg);
+        if (n <= 0) continue;
+
+        Stimulus ev = { .time_ms = (uint32_t)time_ms };
+        bool ok = n == 3 && prof->num_events < MAX_EVENTS;
+        if (ok && (strcmp(action, "press") == 0 || strcmp(action, "release") == 0)) {
+            ev.type = (action[0] == 'p') ? STIM_PRESS : STIM_RELEASE;
+            ev.pin = (strcmp(arg, "a") == 0) ? AVR_PIN_BUTTON_A :
+                     (strcmp(arg, "b") == 0) ? AVR_PIN_BUTTON_B : 0;
+            ok = ev.pin != 0;
+        } else if (ok && strcmp(action, "cv") == 0) {
+            ev.type = STIM_CV;
+            value = strtoul(arg, NULL, 10);
+            ok = value <= 5000;
+            ev.mv = (uint32_t)value;
+        } else {
+            ok = false;
+        }
+        if (!ok || (prof->num_events > 0 &&
+                    ev.time_ms < prof->events[prof->num_events - 1].time_ms)) {
+            fprintf(stderr, "Error: %s:%d: invalid or out-of-order event\n", path, line_no);
+            fclose(f);
+            return false;
+        }
+        prof->events[prof->num_events++] = ev;
+    }
+    fclose(f);
+    return true;
+}
+
+// =============================================================================
+// Run
+// =============================================================================
+
+static inline uint16_t stack_pointer(const avr_t *avr) {
+    return avr->data[R_SPL] | ((uint16_t)avr->data[R_SPH] << 8);
+}
+
+// Profile one boot into mode for run_ms of simulated time
+static bool profile_mode(Profile *prof, elf_firmware_t *fw, ModeState mode, uint32_t run_ms) {
+    AvrTarget target;
+    if (!avr_target_boot(&target, fw, mode)) {
+        return false;
+    }
+    avr_t *avr = target.avr;
+
+    Frame stack[MAX_DEPTH];
+    int depth = 0;
+    ModeState current = mode;
+    FuncStats *stats;
+    int next_event = 0;
+    uint64_t end = (uint64_t)run_ms * AVR_TARGET_CYCLES_MS;
+    bool cv_high = false;
+
+    while (avr->cycle < end) {
+        uint32_t now_ms = (uint32_t)(avr->cycle / AVR_TARGET_CYCLES_MS);
+
+        // Stimulus due
+        if (prof->num_events > 0) {
+            while (next_event < prof->num_events && prof->events[next_event].time_ms <= now_ms) {
+                const Stimulus *ev = &prof->events[next_event++];
+                if (ev->type == STIM_CV) {
+                    avr_target_cv(&target, ev->mv);
+                } else {
+                    avr_target_button(&target, ev->pin, ev->type == STIM_PRESS);
+                }
+            }
+        } else if (prof->cv_period_ms) {
+            bool high = (now_ms % prof->cv_period_ms) < prof->cv_period_ms / 2;
+            if (high != cv_high) {
+                cv_high = high;
+                avr_target_cv(&target, high ? 5000 : 0);
+            }
+        }
+
+        uint64_t before = avr->cycle;
+        avr_flashaddr_t prev_pc = avr->pc;
+        if (!avr_target_step(&target)) {
+            avr_target_close(&target);
+            return false;
+        }
+        uint64_t spent = avr->cycle - before;
+
+        // Self cycles to the innermost frame
+        stats = prof->stats[current];
+        if (depth > 0) {
+            stats[stack[depth - 1].func].self += spent;
+        }
+        prof->mode_cycles[current] += spent;
+
+        // Returns: frames whose stack pointer has been popped
+        uint16_t sp = stack_pointer(avr);
+        while (depth > 0 && sp > stack[depth - 1].sp) {
+            Frame *fr = &stack[--depth];
+            uint64_t incl = avr->cycle - fr->start;
+            FuncStats *st = &stats[fr->func];
+            st->inclusive += incl;
+            if (incl > st->max_inclusive) {
+                st->max_inclusive = (incl > UINT32_MAX) ? UINT32_MAX : (uint32_t)incl;
+            }
+        }
+
+        // Entries: landing on a function's first instruction from outside
+        // it (a loop branching back to the entry is not a call)
+        uint16_t idx = (avr->pc < FLASH_SIZE) ? prof->func_at[avr->pc / 2] : 0;
+        if (idx && (prev_pc >= FLASH_SIZE || prof->owner[prev_pc / 2] != idx)) {
+            int func = idx - 1;
+            if (func == prof->mode_hook && avr->data[24] < MODE_COUNT) {
+                current = (ModeState)avr->data[24];
+                stats = prof->stats[current];
+            }
+            stats[func].calls++;
+            if (depth < MAX_DEPTH) {
+                stack[depth++] = (Frame){ .func = (uint16_t)func, .sp = sp, .start = avr->cycle };
+            }
+        }
+    }
+
+    avr_target_close(&target);
+    return true;
+}
+
+// =============================================================================
+// Report
+// =============================================================================
+
+typedef struct {
+    int func;
+    uint64_t self;
+} HotEntry;
+
+static int compare_hot(const void *a, const void *b) {
+    uint64_t sa = ((const HotEntry*)a)->self;
+    uint64_t sb = ((const HotEntry*)b)->self;
+    return (sa < sb) - (sa > sb);
+}
+
+// Mean inclusive cycles per call from a baseline CSV, or -1
+static double baseline_mean(FILE *baseline, const char *mode, const char *func) {
+    if (!baseline) return -1;
+    rewind(baseline);
+    char line[256];
+    while (fgets(line, sizeof(line), baseline)) {
+        char m[16], fn[64];
+        unsigned long calls;
+        unsigned long long self, incl;
+        if (sscanf(line, "%15[^,],%63[^,],%lu,%llu,%llu", m, fn, &calls, &self, &incl) == 5 &&
+            strcmp(m, mode) == 0 && strcmp(fn, func) == 0 && calls > 0) {
+            return (double)incl / calls;
+        }
+    }
+    return -1;
+}
+
+static void report(const Profile *prof, bool modes[MODE_COUNT], int top, FILE *baseline) {
+    HotEntry hot[MAX_FUNCS];
+
+    for (int m = 0; m < MODE_COUNT; m++) {
+        if (!modes[m] || prof->mode_cycles[m] == 0) continue;
+        const FuncStats *stats = prof->stats[m];
+
+        int n = 0;
+        for (int i = 0; i < prof->num_funcs; i++) {
+            if (stats[i].calls) hot[n++] = (HotEntry){ i, stats[i].self };
+        }
+        qsort(hot, n, sizeof(HotEntry), compare_hot);
+
+        printf("\n%s mode: %llu cycles\n", avr_target_mode_name((ModeState)m),
+               (unsigned long long)prof->mode_cycles[m]);
+        printf("  %-32s %8s %6s %10s %10s %10s%s\n", "function", "calls", "self%",
+               "self", "incl/call", "max incl", baseline ? "      delta" : "");
+        for (int i = 0; i < n && i < top; i++) {
+            const FuncStats *st = &stats[hot[i].func];
+            const char *name = prof->funcs[hot[i].func].name;
+            double mean = (double)st->inclusive / st->calls;
+            printf("  %-32s %8lu %5.1f%% %10llu %10.0f %10lu", name,
+                   (unsigned long)st->calls, 100.0 * st->self / prof->mode_cycles[m],
+                   (unsigned long long)st->self, mean, (unsigned long)st->max_inclusive);
+            double base = baseline_mean(baseline, avr_target_mode_name((ModeState)m), name);
+            if (base > 0) {
+                printf("  %+9.1f%%", 100.0 * (mean - base) / base);
+            } else if (baseline) {
+                printf("  %10s", "new");
+            }
+            printf("\n");
+        }
+    }
+}
+
+static bool write_csv(const Profile *prof, bool modes[MODE_COUNT], const char *path) {
+    FILE *f = fopen(path, "w");
+    if (!f) {
+        perror(path);
+        return false;
+    }
+    fprintf(f, "mode,function,calls,self_cycles,inclusive_cycles,max_inclusive_cycles\n");
+    for (int m = 0; m < MODE_COUNT; m++) {
+        if (!modes[m]) continue;
+        for (int i = 0; i < prof->num_funcs; i++) {
+            const FuncStats *st = &prof->stats[m][i];
+            if (!st->calls) continue;
+            fprintf(f, "%s,%s,%lu,%llu,%llu,%lu\n", avr_target_mode_name((ModeState)m), prof->funcs[i].name,
+                    (unsigned long)st->calls, (unsigned long long)st->self,
+                    (unsigned long long)st->inclusive, (unsigned long)st->max_inclusive);
+        }
+    }
+    return fclose(f) == 0;
+}
+
+// =============================================================================
+// Main
+// =============================================================================
+
+static void print_usage(const char *progname) {
+    printf("Gatekeeper cycle profiler (simavr)\n\n");
+    printf("Usage: %s [options] <firmware.elf>\n\n", progname);
+    printf("The ELF must keep its symbol table (configure with -DKEEP_SYMBOLS=ON).\n\n");
+    printf("Options:\n");
+    printf("  --mode <name>        Profile one mode: gate, trigger, toggle, divide,\n");
+    printf("                       cycle (default: each in turn)\n");
+    printf("  --ms <n>             Simulated time per mode (default: %d)\n", DEFAULT_RUN_MS);
+    printf("  --stimulus <file>    Input events: '<ms> press|release a|b', '<ms> cv <mV>'\n");
+    printf("                       (default: %d ms square wave on the CV input)\n",
+           DEFAULT_CV_PERIOD);
+    printf("  --top <n>            Functions listed per mode (default: 20)\n");
+    printf("  --csv <file>         Write per-mode, per-function counts as CSV\n");
+    printf("  --baseline <file>    CSV from an earlier run: show inclusive cycle deltas\n");
+    printf("  --help               Show this help message\n");
+}
+
+int main(int argc, char **argv) {
+    static Profile prof;
+    const char *elf_path = NULL;
+    const char *stimulus_path = NULL;
+    const char *csv_path = NULL;
+    const char *baseline_path = NULL;
+    uint32_t run_ms = DEFAULT_RUN_MS;
+    int top = 20;
+    bool modes[MODE_COUNT];
+    int only_mode = -1;
+
+    for (int i = 1; i < argc; i++) {
+        bool has_arg = i + 1 < argc;
+        if (strcmp(argv[i], "--mode") == 0 && has_arg) {
+            ModeState mode;
+            if (!avr_target_parse_mode(argv[++i], &mode)) {
+                fprintf(stderr, "Error: Unknown mode: %s\n", argv[i]);
+                return 1;
+            }
+            only_mode = mode;
+        } else if (strcmp(argv[i], "--ms") == 0 && has_arg) {
+            run_ms = (uint32_t)strtoul(argv[++i], NULL, 10);
+        } else if (strcmp(argv[i], "--stimulus") == 0 && has_arg) {
+            stimulus_path = argv[++i];
+        } else if (strcmp(argv[i], "--top") == 0 && has_arg) {
+            top = atoi(argv[++i]);
+        } else if (strcmp(argv[i], "--csv") == 0 && has_arg) {
+            csv_path = argv[++i];
+        } else if (strcmp(argv[i], "--baseline") == 0 && has_arg) {
+            baseline_path = argv[++i];
+        } else if (strcmp(argv[i], "--help") == 0 || strcmp(argv[i], "-h") == 0) {
+            print_usage(argv[0]);
+            return 0;
+        } else if (argv[i][0] != '-' && !elf_path) {
+            elf_path = argv[i];
+        } else {
+            fprintf(stderr, "Unknown option: %s\n", argv[i]);
+            print_usage(argv[0]);
+            return 1;
+        }
+    }
+    if (!elf_path || run_ms == 0) {
+        print_usage(argv[0]);
+        return 1;
+    }
+
+    prof.cv_period_ms = DEFAULT_CV_PERIOD;
+    if (!load_symbols(&prof, elf_path) ||
+        (stimulus_path && !load_stimulus(&prof, stimulus_path))) {
+        return 1;
+    }
+    if (prof.mode_hook < 0) {
+        fprintf(stderr, "Warning: %s not found, cycles attributed to the boot mode\n",
+                MODE_HOOK);
+    }
+
+    FILE *baseline = NULL;
+    if (baseline_path && !(baseline = fopen(baseline_path, "r"))) {
+        perror(baseline_path);
+        return 1;
+    }
+
+    elf_firmware_t fw;
+    if (!avr_target_load(elf_path, &fw)) {
+        return 1;
+    }
+
+    for (int m = 0; m < MODE_COUNT; m++) {
+        modes[m] = only_mode < 0 || only_mode == m;
+        if (modes[m] && !profile_mode(&prof, &fw, (ModeState)m, run_ms)) {
+            return 1;
+        }
+    }
+
+    report(&prof, modes, top, baseline);
+    if (baseline) fclose(baseline);
+
+    if (csv_path && !write_csv(&prof, modes, csv_path)) {
+        return 1;
+    }
+    return 0;
+}
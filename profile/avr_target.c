@@ -0,0 +1,113 @@
+#include "avr_target.h"
+#include "avr_ioport.h"
+#include "avr_adc.h"
+#include "avr_eeprom.h"
+#include "app_init.h"
+
+#include <stdio.h>
+#include <string.h>
+
+/**
+ * @file avr_target.c
+ * @brief simavr ATtiny85 running the firmware
+ */
+
+static const char *mode_names[MODE_COUNT] = {
+    "gate", "trigger", "toggle", "divide", "cycle"
+};
+
+// Valid settings for mode, other parameters at index 0 (see app_init.c)
+static bool preload_settings(avr_t *avr, ModeState mode) {
+    uint8_t ee[EEPROM_CHECKSUM_ADDR + 1];
+    memset(ee, 0xFF, sizeof(ee));
+
+    AppSettings settings;
+    memset(&settings, 0, sizeof(settings));
+    settings.mode = (uint8_t)mode;
+
+    ee[EEPROM_MAGIC_ADDR] = EEPROM_MAGIC_VALUE & 0xFF;
+    ee[EEPROM_MAGIC_ADDR + 1] = EEPROM_MAGIC_VALUE >> 8;
+    ee[EEPROM_SCHEMA_ADDR] = SETTINGS_SCHEMA_VERSION;
+    memcpy(&ee[EEPROM_SETTINGS_ADDR], &settings, sizeof(settings));
+    uint8_t checksum = 0;
+    for (size_t i = 0; i < sizeof(settings); i++) {
+        checksum ^= ee[EEPROM_SETTINGS_ADDR + i];
+    }
+    ee[EEPROM_CHECKSUM_ADDR] = checksum;
+
+    avr_eeprom_desc_t desc = { .ee = ee, .offset = 0, .size = sizeof(ee) };
+    return avr_ioctl(avr, AVR_IOCTL_EEPROM_SET, &desc) == 0;
+}
+
+bool avr_target_load(const char *elf_path, elf_firmware_t *fw) {
+    memset(fw, 0, sizeof(*fw));
+    if (elf_read_firmware(elf_path, fw) != 0) {
+        fprintf(stderr, "Error: simavr failed to load %s\n", elf_path);
+        return false;
+    }
+    return true;
+}
+
+bool avr_target_boot(AvrTarget *target, elf_firmware_t *fw, ModeState mode) {
+    memset(target, 0, sizeof(*target));
+    target->mode = mode;
+
+    avr_t *avr = avr_make_mcu_by_name("attiny85");
+    if (!avr) {
+        fprintf(stderr, "Error: simavr has no attiny85 core\n");
+        return false;
+    }
+    avr_init(avr);
+    avr->frequency = AVR_TARGET_HZ;
+    avr->vcc = avr->avcc = avr->aref = 5000;
+    avr_load_firmware(avr, fw);
+    target->avr = avr;
+
+    if (!preload_settings(avr, mode)) {
+        fprintf(stderr, "Error: Failed to preload EEPROM\n");
+        avr_target_close(target);
+        return false;
+    }
+
+    for (int pin = 0; pin <= AVR_PIN_BUTTON_B; pin++) {
+        target->pin[pin] = avr_io_getirq(avr, AVR_IOCTL_IOPORT_GETIRQ('B'), pin);
+    }
+    target->cv = avr_io_getirq(avr, AVR_IOCTL_ADC_GETIRQ, ADC_IRQ_ADC3);
+
+    avr_target_button(target, AVR_PIN_BUTTON_A, false);
+    avr_target_button(target, AVR_PIN_BUTTON_B, false);
+    avr_target_cv(target, 0);
+    return true;
+}
+
+bool avr_target_step(AvrTarget *target) {
+    int state = avr_run(target->avr);
+    if (state == cpu_Done || state == cpu_Crashed) {
+        fprintf(stderr, "Error: Firmware stopped at pc 0x%04x in %s mode\n",
+                (unsigned)target->avr->pc, mode_names[target->mode]);
+        return false;
+    }
+    return true;
+}
+
+void avr_target_close(AvrTarget *target) {
+    if (target->avr) {
+        avr_terminate(target->avr);
+        target->avr = NULL;
+    }
+}
+
+const char* avr_target_mode_name(ModeState mode) {
+    if (mode >= MODE_COUNT) return "unknown";
+    return mode_names[mode];
+}
+
+bool avr_target_parse_mode(const char *name, ModeState *mode) {
+    for (int m = 0; m < MODE_COUNT; m++) {
+        if (strcmp(name, mode_names[m]) == 0) {
+            *mode = (ModeState)m;
+            return true;
+        }
+    }
+    return false;
+}
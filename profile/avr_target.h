@@ -0,0 +1,85 @@
+#ifndef GK_PROFILE_AVR_TARGET_H
+#define GK_PROFILE_AVR_TARGET_H
+
+#include "sim_avr.h"
+#include "sim_elf.h"
+#include "core/states.h"
+
+#include <stdbool.h>
+#include <stdint.h>
+
+/**
+ * @file avr_target.h
+ * @brief The real firmware on a simavr ATtiny85, for host-side tools
+ *
+ * Boots the firmware ELF into a chosen mode (settings preloaded into
+ * EEPROM, as app_init expects them) and drives its pins: buttons on
+ * PB2/PB4 (active-low, pull-ups), CV in millivolts on PB3 (ADC3).
+ * Shared by the cycle profiler and the latency bench.
+ */
+
+#define AVR_TARGET_HZ           8000000u
+#define AVR_TARGET_CYCLES_MS    (AVR_TARGET_HZ / 1000u)
+
+// Port B pins (match include/hardware/hal.h)
+#define AVR_PIN_NEOPIXEL        0
+#define AVR_PIN_SIG_OUT         1
+#define AVR_PIN_BUTTON_A        2
+#define AVR_PIN_CV              3
+#define AVR_PIN_BUTTON_B        4
+
+typedef struct {
+    avr_t *avr;
+    avr_irq_t *pin[AVR_PIN_BUTTON_B + 1];   // Port B pin IRQs
+    avr_irq_t *cv;                          // ADC3 input (mV)
+    ModeState mode;                         // Boot mode
+} AvrTarget;
+
+/**
+ * Load a firmware ELF for avr_target_boot.
+ */
+bool avr_target_load(const char *elf_path, elf_firmware_t *fw);
+
+/**
+ * Create a core, load fw and preload settings for mode.
+ * Buttons start released and CV at 0 V.
+ */
+bool avr_target_boot(AvrTarget *target, elf_firmware_t *fw, ModeState mode);
+
+/**
+ * Execute one instruction (or a sleep period).
+ * @return false if the firmware stopped or crashed (reported on stderr)
+ */
+bool avr_target_step(AvrTarget *target);
+
+/**
+ * Release the core.
+ */
+void avr_target_close(AvrTarget *target);
+
+/**
+ * Press or release a button (pin AVR_PIN_BUTTON_A or AVR_PIN_BUTTON_B).
+ */
+static inline void avr_target_button(AvrTarget *target, uint8_t pin, bool pressed) {
+    avr_raise_irq(target->pin[pin], !pressed);
+}
+
+/**
+ * Set the CV input voltage (0 - 5000 mV).
+ */
+static inline void avr_target_cv(AvrTarget *target, uint32_t mv) {
+    avr_raise_irq(target->cv, mv);
+}
+
+/**
+ * Get a mode name ("gate", "trigger", ...).
+ */
+const char* avr_target_mode_name(ModeState mode);
+
+/**
+ * Parse a mode name.
+ * @return false for an unknown name
+ */
+bool avr_target_parse_mode(const char *name, ModeState *mode);
+
+#endif /* GK_PROFILE_AVR_TARGET_H */
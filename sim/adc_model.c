@@ -0,0 +1,288 @@
+#include "adc_model.h"
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+/**
+ * @file adc_model.c
+ * @brief Analog front-end model
+ */
+
+#define ADC_MODEL_DEFAULT_SEED      0x9E3779B9u
+#define ADC_MODEL_DEFAULT_COUPLING_US 500
+#define US_PER_MS 1000
+
+// One LSB at 5V full scale (8-bit)
+#define MV_PER_LSB (5000.0f / 255.0f)
+
+// Standard deviation of the raw noise generators
+#define WHITE_RAW_SIGMA 37837.0f    // Sum of four uniforms in [-32768, 32768)
+#define PINK_RAW_SIGMA  56756.0f    // Eight Voss rows plus one white uniform
+
+static inline uint32_t xorshift32(uint32_t *state) {
+    uint32_t x = *state;
+    x ^= x << 13;
+    x ^= x >> 17;
+    x ^= x << 5;
+    *state = x;
+    return x;
+}
+
+// exp(-x) for x >= 0 without libm: series on a reduced argument, then square
+static float exp_neg(float x) {
+    int halvings = 0;
+    while (x > 0.03125f && halvings < 30) {
+        x *= 0.5f;
+        halvings++;
+    }
+    float r = 1.0f - x + x * x * 0.5f - x * x * x * (1.0f / 6.0f);
+    while (halvings-- > 0) {
+        r *= r;
+    }
+    return r;
+}
+
+// Fraction (Q16) left after gap_us at time constant tau_us
+static int32_t decay_q16(uint64_t gap_us, uint32_t tau_us) {
+    return (int32_t)(exp_neg((float)gap_us / (float)tau_us) * 65536.0f + 0.5f);
+}
+
+// Gap after which a full-scale Q8 value has decayed below one unit (ln(65536) ~ 11.1 tau)
+static uint32_t settle_us(uint32_t tau_us) {
+    return tau_us * 12;
+}
+
+static uint32_t coupling_tau_us(const AdcModel *m) {
+    return m->config.coupling_us ? m->config.coupling_us : ADC_MODEL_DEFAULT_COUPLING_US;
+}
+
+// Decay over a gap between reads. The loop usually reads at a fixed
+// interval, so this runs once rather than on every conversion.
+static void set_gap(AdcModel *m, uint64_t gap_us) {
+    m->gap_us = gap_us;
+    if (m->rc_settle_us) {
+        m->rc_alpha = 65536 - decay_q16(gap_us, m->config.rc_us);
+        if (m->rc_alpha < 1) m->rc_alpha = 1;
+    }
+    if (m->coupling_step) {
+        // Keep it below 1 so every gap shrinks the transient
+        m->coupling_decay = decay_q16(gap_us, coupling_tau_us(m));
+        if (m->coupling_decay > 65535) m->coupling_decay = 65535;
+    }
+}
+
+// Move value toward 0 by coefficient (Q16), truncating so it reaches 0
+static inline int32_t scale_q16(int32_t value, int32_t coeff) {
+    return (int32_t)(((int64_t)value * coeff) / 65536);
+}
+
+static int32_t noise_sample(AdcModel *m) {
+    uint32_t a = xorshift32(&m->rng);
+    if (m->color == ADC_NOISE_WHITE) {
+        uint32_t b = xorshift32(&m->rng);
+        return (int32_t)(a & 0xFFFF) + (int32_t)(a >> 16) +
+               (int32_t)(b & 0xFFFF) + (int32_t)(b >> 16) - 131072;
+    }
+
+    // Voss-McCartney: row k changes every 2^(k+1) samples
+    uint32_t c = ++m->pink_count;
+    int k = 0;
+    while (!(c & 1) && k < 7) {
+        c >>= 1;
+        k++;
+    }
+    int32_t v = (int32_t)(a & 0xFFFF) - 32768;
+    m->pink_sum += v - m->pink_rows[k];
+    m->pink_rows[k] = v;
+    return m->pink_sum + (int32_t)(a >> 16) - 32768;
+}
+
+void adc_model_init(AdcModel *model, const AdcModelConfig *config) {
+    memset(model, 0, sizeof(*model));
+    if (!config) return;
+    model->config = *config;
+
+    if (config->rc_us > 0) {
+        model->rc_settle_us = settle_us(config->rc_us);
+    }
+
+    if (config->coupling_mv > 0) {
+        model->coupling_step = (int32_t)(config->coupling_mv / MV_PER_LSB * 256.0f);
+        model->coupling_settle_us = settle_us(coupling_tau_us(model));
+    }
+
+    if (config->noise_mv > 0) {
+        float raw_sigma = (config->color == ADC_NOISE_PINK) ? PINK_RAW_SIGMA : WHITE_RAW_SIGMA;
+        model->noise_mult = (int32_t)(config->noise_mv / MV_PER_LSB * 256.0f / raw_sigma * 65536.0f);
+    }
+
+    model->color = config->color;
+    model->delay_ms = (config->delay_ms > ADC_MODEL_MAX_DELAY) ? ADC_MODEL_MAX_DELAY
+                                                               : config->delay_ms;
+    model->rng = config->seed ? config->seed : ADC_MODEL_DEFAULT_SEED;
+    model->enabled = config->rc_us > 0 || model->coupling_step != 0 ||
+                     model->noise_mult != 0 || model->delay_ms > 0;
+}
+
+uint8_t adc_model_read(AdcModel *m, uint8_t input, bool output, uint64_t now_us) {
+    if (!m->enabled) return input;
+
+    int32_t target = (int32_t)input << 8;
+    uint64_t now_ms = now_us / US_PER_MS;
+
+    // First read, or time went backwards (reset): start settled
+    if (!m->primed || now_us < m->last_us) {
+        m->primed = true;
+        m->last_us = now_us;
+        m->head_ms = now_ms;
+        m->level = target;
+        m->bounce = 0;
+        m->output = output;
+        memset(m->history, input, sizeof(m->history));
+    }
+    uint64_t dt = now_us - m->last_us;
+    m->last_us = now_us;
+
+    // Input filter, moved over the gap since the last read
+    if (dt >= m->rc_settle_us) {
+        m->level = target;
+    } else if (dt > 0 && m->level != target) {
+        if (dt != m->gap_us) set_gap(m, dt);
+        int32_t step = scale_q16(target - m->level, m->rc_alpha);
+        // Short gaps would otherwise stall a fraction of an LSB short
+        if (step == 0) step = (target > m->level) ? 1 : -1;
+        m->level += step;
+    }
+
+    // Switching transient
+    if (m->bounce != 0) {
+        if (dt >= m->coupling_settle_us) {
+            m->bounce = 0;
+        } else if (dt > 0) {
+            if (dt != m->gap_us) set_gap(m, dt);
+            m->bounce = scale_q16(m->bounce, m->coupling_decay);
+        }
+    }
+    if (output != m->output) {
+        m->output = output;
+        m->bounce += output ? m->coupling_step : -m->coupling_step;
+    }
+
+    int32_t sample = m->level + m->bounce;
+    if (m->noise_mult) {
+        sample += scale_q16(noise_sample(m), m->noise_mult);
+    }
+
+    // Quantize (round to nearest, clamp to the rails)
+    sample = (sample + 128) >> 8;
+    uint8_t result = (sample < 0) ? 0 : (sample > 255) ? 255 : (uint8_t)sample;
+
+    if (m->delay_ms == 0) {
+        return result;
+    }
+
+    // The first conversion of a millisecond enters the delay line, once
+    // for each millisecond since the last entry
+    if (now_ms != m->head_ms) {
+        uint64_t pushes = now_ms - m->head_ms;
+        if (pushes > ADC_MODEL_MAX_DELAY + 1) pushes = ADC_MODEL_MAX_DELAY + 1;
+        m->head_ms = now_ms;
+        for (uint64_t i = 0; i < pushes; i++) {
+            m->head = (uint8_t)((m->head + 1) % (ADC_MODEL_MAX_DELAY + 1));
+            m->history[m->head] = result;
+        }
+    }
+    uint8_t idx = (uint8_t)((m->head + ADC_MODEL_MAX_DELAY + 1 - m->delay_ms) %
+                            (ADC_MODEL_MAX_DELAY + 1));
+    return m->history[idx];
+}
+
+void adc_model_skip(AdcModel *m, uint32_t ms) {
+    // Static: the skipped conversions would have returned what is in the
+    // delay line already, so only the time of the last read moves
+    if (m->enabled && m->primed) {
+        m->last_us += (uint64_t)ms * US_PER_MS;
+        m->head_ms += ms;
+    }
+}
+
+bool adc_model_is_static(const AdcModel *m, uint8_t input, bool output) {
+    if (!m->enabled || !m->primed) return true;
+    if (m->noise_mult != 0 || m->bounce != 0 || output != m->output) return false;
+    if (m->level != (int32_t)input << 8) return false;
+
+    for (uint8_t i = 0; i <= m->delay_ms; i++) {
+        uint8_t idx = (uint8_t)((m->head + ADC_MODEL_MAX_DELAY + 1 - i) % (ADC_MODEL_MAX_DELAY + 1));
+        if (m->history[idx] != input) return false;
+    }
+    return true;
+}
+
+// =============================================================================
+// Spec Parsing
+// =============================================================================
+
+static bool parse_uint(const char *s, uint32_t max, uint32_t *value) {
+    char *end;
+    unsigned long v = strtoul(s, &end, 10);
+    if (end == s || *end != '\0' || v > max) return false;
+    *value = (uint32_t)v;
+    return true;
+}
+
+static bool parse_mv(const char *s, float *value) {
+    char *end;
+    float v = strtof(s, &end);
+    if (end == s || *end != '\0' || v < 0 || v > 5000) return false;
+    *value = v;
+    return true;
+}
+
+bool adc_model_parse(const char *spec, AdcModelConfig *config, char *err, size_t err_len) {
+    char buf[128];
+    if (strlen(spec) >= sizeof(buf)) {
+        snprintf(err, err_len, "ADC spec too long");
+        return false;
+    }
+    strcpy(buf, spec);
+
+    char *save = NULL;
+    for (char *item = strtok_r(buf, ",", &save); item; item = strtok_r(NULL, ",", &save)) {
+        char *value = strchr(item, '=');
+        if (value) *value++ = '\0';
+
+        uint32_t n;
+        bool ok = true;
+        if (strcmp(item, "ideal") == 0 && !value) {
+            memset(config, 0, sizeof(*config));
+        } else if (strcmp(item, "white") == 0 && !value) {
+            config->color = ADC_NOISE_WHITE;
+        } else if (strcmp(item, "pink") == 0 && !value) {
+            config->color = ADC_NOISE_PINK;
+        } else if (!value) {
+            ok = false;
+        } else if (strcmp(item, "noise") == 0) {
+            ok = parse_mv(value, &config->noise_mv);
+        } else if (strcmp(item, "coupling") == 0) {
+            ok = parse_mv(value, &config->coupling_mv);
+        } else if (strcmp(item, "rc") == 0) {
+            ok = parse_uint(value, 10000000, &config->rc_us);
+        } else if (strcmp(item, "coupling_us") == 0) {
+            ok = parse_uint(value, 10000000, &config->coupling_us);
+        } else if (strcmp(item, "delay") == 0) {
+            ok = parse_uint(value, ADC_MODEL_MAX_DELAY, &n);
+            if (ok) config->delay_ms = (uint8_t)n;
+        } else if (strcmp(item, "seed") == 0) {
+            ok = parse_uint(value, UINT32_MAX, &config->seed);
+        } else {
+            ok = false;
+        }
+
+        if (!ok) {
+            snprintf(err, err_len, "invalid ADC option: %s%s%s", item,
+                     value ? "=" : "", value ? value : "");
+            return false;
+        }
+    }
+    return true;
+}
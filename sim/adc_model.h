@@ -0,0 +1,124 @@
+#ifndef GK_SIM_ADC_MODEL_H
+#define GK_SIM_ADC_MODEL_H
+
+#include <stdbool.h>
+#include <stddef.h>
+#include <stdint.h>
+
+/**
+ * @file adc_model.h
+ * @brief Analog front end between the simulated CV input and the ADC
+ *
+ * Without a model the ADC returns the CV source's value exactly, so the
+ * input hysteresis never sees real conditions. The model adds, in signal
+ * order:
+ *
+ *   CV -> RC low-pass -> + switching transient + noise -> quantize -> delay
+ *
+ * - RC low-pass: first-order input filter (time constant rc_us).
+ * - Switching transient: ground bounce when the gate output changes, a
+ *   step of coupling_mv (up on rising, down on falling edges) decaying
+ *   with time constant coupling_us.
+ * - Noise: Gaussian-like white noise (sum of four uniforms) or pink
+ *   noise (Voss-McCartney, 8 rows), from a per-device xorshift32, so runs
+ *   are reproducible for a seed.
+ * - Quantize: rounded to the 8-bit result.
+ * - Delay: the result sampled delay_ms milliseconds earlier. The delay
+ *   line takes the first conversion of each millisecond, so the latency
+ *   does not depend on how many conversions a millisecond holds.
+ *
+ * Time is in microseconds, so the filter and transient decay over the
+ * real gap between conversions when the simulator runs on the
+ * microsecond clock (--tick-us). State is fixed point and updated lazily
+ * on each read; the decay factors for a gap are recomputed only when the
+ * gap changes, so the cost is a few arithmetic operations per
+ * conversion. The model reports
+ * itself static once the filter and transient have settled (and noise is
+ * off), so idle skipping still applies.
+ */
+
+// Longest conversion latency (ms)
+#define ADC_MODEL_MAX_DELAY 15
+
+typedef enum {
+    ADC_NOISE_WHITE,
+    ADC_NOISE_PINK
+} AdcNoiseColor;
+
+/**
+ * Front-end parameters. All zero = ideal ADC.
+ */
+typedef struct {
+    float noise_mv;         // RMS noise (0 = off)
+    AdcNoiseColor color;
+    uint32_t rc_us;         // Input filter time constant (0 = off)
+    float coupling_mv;      // Output switching step (0 = off)
+    uint32_t coupling_us;   // Transient decay time constant
+    uint8_t delay_ms;       // Conversion latency (0 - ADC_MODEL_MAX_DELAY)
+    uint32_t seed;          // Noise seed (0 = default)
+} AdcModelConfig;
+
+typedef struct {
+    bool enabled;
+    AdcModelConfig config;  // As configured (recorded in traces)
+    // Coefficients (derived from the config)
+    uint32_t rc_settle_us;  // Gap after which the filter has settled (0 = off)
+    int32_t coupling_step;  // Transient step (Q8 LSB)
+    uint32_t coupling_settle_us;
+    int32_t noise_mult;     // Noise scale (Q16 per raw unit)
+    AdcNoiseColor color;
+    uint8_t delay_ms;
+    // Decay over the last gap between reads (recomputed when it changes)
+    uint64_t gap_us;
+    int32_t rc_alpha;       // Filter step over the gap (Q16)
+    int32_t coupling_decay; // Transient left after the gap (Q16)
+    // State
+    bool primed;            // First read done
+    uint64_t last_us;       // Time of the last read
+    uint64_t head_ms;       // Millisecond of the newest delay line entry
+    uint32_t rng;
+    int32_t level;          // Filtered input (Q8 LSB)
+    int32_t bounce;         // Switching transient (Q8 LSB)
+    bool output;            // Output level at the last read
+    int32_t pink_rows[8];
+    int32_t pink_sum;
+    uint32_t pink_count;
+    uint8_t history[ADC_MODEL_MAX_DELAY + 1];   // Result per ms (ring)
+    uint8_t head;
+} AdcModel;
+
+/**
+ * Configure the model and clear its state.
+ * A NULL or all-zero config gives an ideal ADC.
+ */
+void adc_model_init(AdcModel *model, const AdcModelConfig *config);
+
+/**
+ * Convert the input as seen at time now_us.
+ * @param input   Ideal CV value (0-255)
+ * @param output  Current gate output level (for switching transients)
+ * @return ADC result (0-255)
+ */
+uint8_t adc_model_read(AdcModel *model, uint8_t input, bool output, uint64_t now_us);
+
+/**
+ * Move the model's clock past ms skipped milliseconds. Only valid while the model
+ * is static (see below), which is what makes skipping them exact.
+ */
+void adc_model_skip(AdcModel *model, uint32_t ms);
+
+/**
+ * Check that reads stay constant while input and output do: noise off,
+ * filter and transient settled, delay line flushed.
+ */
+bool adc_model_is_static(const AdcModel *model, uint8_t input, bool output);
+
+/**
+ * Parse a comma-separated spec, e.g. "noise=8,pink,rc=2000,coupling=40,delay=1".
+ * Keys: noise=<mV rms>, white, pink, rc=<us>, coupling=<mV>,
+ * coupling_us=<us> (default 500), delay=<ms>, seed=<n>; "ideal" clears.
+ * @return false with a message in err on a bad key or value
+ */
+bool adc_model_parse(const char *spec, AdcModelConfig *config, char *err, size_t err_len);
+
+#endif /* GK_SIM_ADC_MODEL_H */
@@ -1,23 +1,29 @@
 #include "command_handler.h"
+#include "socket_protocol.h"
 #include "sim_hal.h"
+#include "cv_graph.h"
 
 #include <stdio.h>
 #include <stdlib.h>
 #include <string.h>
-#include <ctype.h>
 
 /**
  * @file command_handler.c
  * @brief JSON command parser implementation
  *
- * Simple hand-rolled JSON parser for command protocol.
- * Only handles the specific structures we need.
+ * Simple hand-rolled JSON parser for command protocol. One pass over the
+ * line indexes the top-level keys of the object as views into the line
+ * (nothing is copied), handlers then look fields up in that index.
+ * Command names are dispatched on their length, then compared once.
+ * Binary frames are decoded at the end of the file and clamped the same
+ * way.
  */
 
 // Command type names
 static const char *cmd_type_names[] = {
     "unknown", "button", "cv_manual", "cv_lfo", "cv_envelope",
-    "cv_gate", "cv_trigger", "cv_wavetable", "reset", "quit"
+    "cv_gate", "cv_trigger", "cv_wavetable", "reset", "quit", "subscribe", "cv_stream",
+    "cv_file", "cv_graph"
 };
 
 const char* command_type_str(CommandType type) {
@@ -31,182 +37,341 @@ const char* command_type_str(CommandType type) {
 // Simple JSON Parser
 // =============================================================================
 
+// Maximum top-level fields in a command object
+#define JSON_MAX_FIELDS 16
+
+// String view into the command line (not NUL-terminated)
+typedef struct {
+    const char *p;
+    size_t len;
+} StrView;
+
+typedef enum {
+    JSON_STRING,    // value is the contents between the quotes (escapes kept)
+    JSON_NUMBER,
+    JSON_BOOL,      // value is "true" or "false"
+    JSON_NULL,
+    JSON_ARRAY,     // value includes the brackets
+    JSON_OBJECT     // value includes the braces
+} JsonType;
+
+typedef struct {
+    StrView key;
+    StrView value;
+    JsonType type;
+} JsonField;
+
+typedef struct {
+    JsonField fields[JSON_MAX_FIELDS];
+    int count;
+} JsonObject;
+
+static bool sv_eq(StrView v, const char *s) {
+    size_t n = strlen(s);
+    return v.len == n && memcmp(v.p, s, n) == 0;
+}
+
 // Skip whitespace
-static const char* skip_ws(const char *p) {
-    while (*p && isspace(*p)) p++;
+static const char* skip_ws(const char *p, const char *end) {
+    while (p < end && (*p == ' ' || *p == '\t' || *p == '\r' || *p == '\n')) p++;
     return p;
 }
 
-// Parse string value (returns pointer past closing quote, or NULL on error)
-// Writes string to buf (up to buf_size-1 chars)
-static const char* parse_string(const char *p, char *buf, size_t buf_size) {
-    p = skip_ws(p);
-    if (*p != '"') return NULL;
-    p++;
+// Scan a string starting at the opening quote
+// Returns pointer past closing quote, or NULL if unterminated
+static const char* scan_string(const char *p, const char *end, StrView *out) {
+    const char *start = ++p;
+    while (p < end && *p != '"') {
+        if (*p == '\\') p++;    // Skip escaped char
+        p++;
+    }
+    if (p >= end) return NULL;
+    out->p = start;
+    out->len = (size_t)(p - start);
+    return p + 1;
+}
 
-    size_t i = 0;
-    while (*p && *p != '"') {
-        if (*p == '\\' && *(p + 1)) {
-            p++;  // Skip escape char, take next literally
+// Scan an array or object (brackets balanced, strings skipped)
+static const char* scan_nested(const char *p, const char *end) {
+    int depth = 0;
+    while (p < end) {
+        char c = *p;
+        if (c == '"') {
+            StrView dummy;
+            p = scan_string(p, end, &dummy);
+            if (!p) return NULL;
+            continue;
         }
-        if (i < buf_size - 1) {
-            buf[i++] = *p;
+        if (c == '{' || c == '[') depth++;
+        else if (c == '}' || c == ']') {
+            if (--depth == 0) return p + 1;
         }
         p++;
     }
-    buf[i] = '\0';
-
-    if (*p != '"') return NULL;
-    return p + 1;
+    return NULL;
 }
 
-// Parse number (int or float)
-static const char* parse_number(const char *p, double *value) {
-    p = skip_ws(p);
-    char *end;
-    *value = strtod(p, &end);
-    if (end == p) return NULL;
-    return end;
+// Scan any value, setting its type and view
+static const char* scan_value(const char *p, const char *end, JsonField *field) {
+    if (p >= end) return NULL;
+
+    const char *start = p;
+    switch (*p) {
+        case '"':
+            field->type = JSON_STRING;
+            return scan_string(p, end, &field->value);
+        case '[':
+        case '{':
+            field->type = (*p == '[') ? JSON_ARRAY : JSON_OBJECT;
+            p = scan_nested(p, end);
+            break;
+        case 't':
+        case 'f':
+        case 'n': {
+            const char *word = (*p == 't') ? "true" : (*p == 'f') ? "false" : "null";
+            size_t n = strlen(word);
+            if ((size_t)(end - p) < n || memcmp(p, word, n) != 0) return NULL;
+            field->type = (*p == 'n') ? JSON_NULL : JSON_BOOL;
+            p += n;
+            break;
+        }
+        default:
+            field->type = JSON_NUMBER;
+            while (p < end && *p != ',' && *p != '}' && *p != ']' &&
+                   *p != ' ' && *p != '\t' && *p != '\r' && *p != '\n') {
+                p++;
+            }
+            if (p == start) return NULL;
+            break;
+    }
+    if (!p) return NULL;
+    field->value.p = start;
+    field->value.len = (size_t)(p - start);
+    return p;
 }
 
-// Parse boolean
-static const char* parse_bool(const char *p, bool *value) {
-    p = skip_ws(p);
-    if (strncmp(p, "true", 4) == 0) {
-        *value = true;
-        return p + 4;
+/**
+ * Index the top-level fields of a JSON object in one pass.
+ * Fields beyond JSON_MAX_FIELDS are skipped.
+ * @return false if the line isn't a well-formed object
+ */
+static bool json_tokenize(const char *json, size_t len, JsonObject *obj) {
+    const char *p = json;
+    const char *end = json + len;
+    obj->count = 0;
+
+    p = skip_ws(p, end);
+    if (p >= end || *p != '{') return false;
+    p = skip_ws(p + 1, end);
+    if (p < end && *p == '}') return true;
+
+    while (p < end) {
+        JsonField field;
+        if (*p != '"') return false;
+        p = scan_string(p, end, &field.key);
+        if (!p) return false;
+
+        p = skip_ws(p, end);
+        if (p >= end || *p != ':') return false;
+        p = skip_ws(p + 1, end);
+
+        p = scan_value(p, end, &field);
+        if (!p) return false;
+        if (obj->count < JSON_MAX_FIELDS) {
+            obj->fields[obj->count++] = field;
+        }
+
+        p = skip_ws(p, end);
+        if (p >= end) return false;
+        if (*p == '}') return true;
+        if (*p != ',') return false;
+        p = skip_ws(p + 1, end);
     }
-    if (strncmp(p, "false", 5) == 0) {
-        *value = false;
-        return p + 5;
+    return false;
+}
+
+// Find field by key (first occurrence wins)
+static const JsonField* json_get(const JsonObject *obj, const char *key) {
+    size_t n = strlen(key);
+    for (int i = 0; i < obj->count; i++) {
+        const JsonField *f = &obj->fields[i];
+        if (f->key.len == n && memcmp(f->key.p, key, n) == 0) {
+            return f;
+        }
     }
     return NULL;
 }
 
-// Find key in JSON object and return pointer to value
-// Assumes p points to start of object (after '{')
-static const char* find_key(const char *json, const char *key) {
-    const char *p = strchr(json, '{');
-    if (!p) return NULL;
-    p++;
-
-    char found_key[64];
-    while (*p) {
-        p = skip_ws(p);
-        if (*p == '}') return NULL;  // End of object
-        if (*p == ',') { p++; continue; }
-
-        // Parse key
-        const char *next = parse_string(p, found_key, sizeof(found_key));
-        if (!next) return NULL;
-        p = skip_ws(next);
+// Get string value for key (view; escapes are not resolved)
+static bool get_string(const JsonObject *obj, const char *key, StrView *value) {
+    const JsonField *f = json_get(obj, key);
+    if (!f || f->type != JSON_STRING) return false;
+    *value = f->value;
+    return true;
+}
 
-        // Expect colon
-        if (*p != ':') return NULL;
-        p++;
-        p = skip_ws(p);
+// Convert a number view
+static bool parse_number(StrView v, double *value) {
+    // strtod needs a terminator the view doesn't have
+    char buf[32];
+    if (v.len >= sizeof(buf)) return false;
+    memcpy(buf, v.p, v.len);
+    buf[v.len] = '\0';
+
+    char *num_end;
+    *value = strtod(buf, &num_end);
+    return num_end == buf + v.len;
+}
 
-        // Check if this is our key
-        if (strcmp(found_key, key) == 0) {
-            return p;  // Return pointer to value
-        }
+// Get number value for key
+static bool get_number(const JsonObject *obj, const char *key, double *value) {
+    const JsonField *f = json_get(obj, key);
+    if (!f || f->type != JSON_NUMBER) return false;
+    return parse_number(f->value, value);
+}
 
-        // Skip value (simplified: handles strings, numbers, bools, nested objects)
-        if (*p == '"') {
-            char dummy[256];
-            p = parse_string(p, dummy, sizeof(dummy));
-        } else if (*p == '{') {
-            // Skip nested object (count braces)
-            int depth = 1;
-            p++;
-            while (*p && depth > 0) {
-                if (*p == '{') depth++;
-                else if (*p == '}') depth--;
-                else if (*p == '"') {
-                    char dummy[256];
-                    p = parse_string(p, dummy, sizeof(dummy));
-                    if (!p) return NULL;
-                    continue;
-                }
-                p++;
-            }
-        } else if (*p == '[') {
-            // Skip array (count brackets)
-            int depth = 1;
-            p++;
-            while (*p && depth > 0) {
-                if (*p == '[') depth++;
-                else if (*p == ']') depth--;
-                p++;
-            }
-        } else {
-            // Number or bool - skip to next delimiter
-            while (*p && *p != ',' && *p != '}') p++;
+// Copy a string value, resolving the escapes a path can contain
+// Returns false if it doesn't fit or has other escapes
+static bool copy_string(StrView v, char *buf, size_t size) {
+    size_t n = 0;
+    for (size_t i = 0; i < v.len; i++) {
+        char c = v.p[i];
+        if (c == '\\') {
+            if (++i >= v.len) return false;
+            c = v.p[i];
+            if (c != '"' && c != '\\' && c != '/') return false;
         }
-
-        if (!p) return NULL;
+        if (n + 1 >= size) return false;
+        buf[n++] = c;
     }
-    return NULL;
+    buf[n] = '\0';
+    return true;
 }
 
-// Get string value for key
-static bool get_string(const char *json, const char *key, char *buf, size_t buf_size) {
-    const char *val = find_key(json, key);
-    if (!val) return false;
-    return parse_string(val, buf, buf_size) != NULL;
+// Get bool value for key
+static bool get_bool(const JsonObject *obj, const char *key, bool *value) {
+    const JsonField *f = json_get(obj, key);
+    if (!f || f->type != JSON_BOOL) return false;
+    *value = (f->value.p[0] == 't');
+    return true;
 }
 
-// Get number value for key
-static bool get_number(const char *json, const char *key, double *value) {
-    const char *val = find_key(json, key);
-    if (!val) return false;
-    return parse_number(val, value) != NULL;
+// Call fn for each number in an array value for key
+// Returns false if key is missing or not an array of numbers
+static bool for_each_number(const JsonObject *obj, const char *key,
+                            bool (*fn)(double item, void *arg), void *arg) {
+    const JsonField *f = json_get(obj, key);
+    if (!f || f->type != JSON_ARRAY) return false;
+
+    const char *p = f->value.p + 1;
+    const char *end = f->value.p + f->value.len - 1;     // At ']'
+    p = skip_ws(p, end);
+    while (p < end) {
+        JsonField item;
+        double value;
+        p = scan_value(p, end, &item);
+        if (!p || item.type != JSON_NUMBER || !parse_number(item.value, &value) ||
+            !fn(value, arg)) {
+            return false;
+        }
+        p = skip_ws(p, end);
+        if (p < end) {
+            if (*p != ',') return false;
+            p = skip_ws(p + 1, end);
+        }
+    }
+    return true;
 }
 
-// Get bool value for key
-static bool get_bool(const char *json, const char *key, bool *value) {
-    const char *val = find_key(json, key);
-    if (!val) return false;
-    return parse_bool(val, value) != NULL;
+// Call fn for each object in an array value for key
+// Returns false if key is missing or not an array of objects
+static bool for_each_object(const JsonObject *obj, const char *key,
+                            bool (*fn)(const JsonObject *item, void *arg), void *arg) {
+    const JsonField *f = json_get(obj, key);
+    if (!f || f->type != JSON_ARRAY) return false;
+
+    const char *p = f->value.p + 1;
+    const char *end = f->value.p + f->value.len - 1;     // At ']'
+    p = skip_ws(p, end);
+    while (p < end) {
+        JsonField item;
+        JsonObject item_obj;
+        p = scan_value(p, end, &item);
+        if (!p || item.type != JSON_OBJECT ||
+            !json_tokenize(item.value.p, item.value.len, &item_obj) || !fn(&item_obj, arg)) {
+            return false;
+        }
+        p = skip_ws(p, end);
+        if (p < end) {
+            if (*p != ',') return false;
+            p = skip_ws(p + 1, end);
+        }
+    }
+    return true;
+}
+
+// Call fn for each string in an array value for key
+// Returns false if key is missing or not an array of strings
+static bool for_each_string(const JsonObject *obj, const char *key,
+                            bool (*fn)(StrView item, void *arg), void *arg) {
+    const JsonField *f = json_get(obj, key);
+    if (!f || f->type != JSON_ARRAY) return false;
+
+    const char *p = f->value.p + 1;
+    const char *end = f->value.p + f->value.len - 1;     // At ']'
+    p = skip_ws(p, end);
+    while (p < end) {
+        StrView item;
+        if (*p != '"') return false;
+        p = scan_string(p, end, &item);
+        if (!p || !fn(item, arg)) return false;
+        p = skip_ws(p, end);
+        if (p < end) {
+            if (*p != ',') return false;
+            p = skip_ws(p + 1, end);
+        }
+    }
+    return true;
 }
 
 // =============================================================================
 // Command Handlers
 // =============================================================================
 
-static CommandResult handle_button(const char *json) {
-    CommandResult result = { CMD_BUTTON, false, false, "" };
+static CommandResult handle_button(const JsonObject *obj) {
+    CommandResult result = { .type = CMD_BUTTON };
 
-    char id[16];
+    StrView id;
     bool state;
 
-    if (!get_string(json, "id", id, sizeof(id))) {
+    if (!get_string(obj, "id", &id)) {
         snprintf(result.error, sizeof(result.error), "missing 'id' field");
         return result;
     }
-    if (!get_bool(json, "state", &state)) {
+    if (!get_bool(obj, "state", &state)) {
         snprintf(result.error, sizeof(result.error), "missing 'state' field");
         return result;
     }
 
-    if (strcmp(id, "a") == 0) {
+    if (sv_eq(id, "a")) {
         sim_set_button_a(state);
         result.success = true;
-    } else if (strcmp(id, "b") == 0) {
+    } else if (sv_eq(id, "b")) {
         sim_set_button_b(state);
         result.success = true;
     } else {
-        snprintf(result.error, sizeof(result.error), "invalid button id: %s", id);
+        snprintf(result.error, sizeof(result.error), "invalid button id: %.*s",
+                 (int)id.len, id.p);
     }
 
     return result;
 }
 
-static CommandResult handle_cv_manual(const char *json, CVSource *cv_source) {
-    CommandResult result = { CMD_CV_MANUAL, false, false, "" };
+static CommandResult handle_cv_manual(const JsonObject *obj, CVSource *cv_source) {
+    CommandResult result = { .type = CMD_CV_MANUAL };
 
     double value;
-    if (!get_number(json, "value", &value)) {
+    if (!get_number(obj, "value", &value)) {
         snprintf(result.error, sizeof(result.error), "missing 'value' field");
         return result;
     }
@@ -219,26 +384,26 @@ static CommandResult handle_cv_manual(const char *json, CVSource *cv_source) {
     return result;
 }
 
-static CommandResult handle_cv_lfo(const char *json, CVSource *cv_source) {
-    CommandResult result = { CMD_CV_LFO, false, false, "" };
+static CommandResult handle_cv_lfo(const JsonObject *obj, CVSource *cv_source) {
+    CommandResult result = { .type = CMD_CV_LFO };
 
     double freq_hz = 1.0;
     double min_val = 0;
     double max_val = 255;
-    char shape_str[16] = "sine";
+    StrView shape_str = { "sine", 4 };
 
-    get_number(json, "freq_hz", &freq_hz);
-    get_number(json, "min", &min_val);
-    get_number(json, "max", &max_val);
-    get_string(json, "shape", shape_str, sizeof(shape_str));
+    get_number(obj, "freq_hz", &freq_hz);
+    get_number(obj, "min", &min_val);
+    get_number(obj, "max", &max_val);
+    get_string(obj, "shape", &shape_str);
 
     // Parse shape
     LFOShape shape = LFO_SINE;
-    if (strcmp(shape_str, "sine") == 0) shape = LFO_SINE;
-    else if (strcmp(shape_str, "tri") == 0 || strcmp(shape_str, "triangle") == 0) shape = LFO_TRI;
-    else if (strcmp(shape_str, "saw") == 0 || strcmp(shape_str, "sawtooth") == 0) shape = LFO_SAW;
-    else if (strcmp(shape_str, "square") == 0) shape = LFO_SQUARE;
-    else if (strcmp(shape_str, "random") == 0 || strcmp(shape_str, "sh") == 0) shape = LFO_RANDOM;
+    if (sv_eq(shape_str, "sine")) shape = LFO_SINE;
+    else if (sv_eq(shape_str, "tri") || sv_eq(shape_str, "triangle")) shape = LFO_TRI;
+    else if (sv_eq(shape_str, "saw") || sv_eq(shape_str, "sawtooth")) shape = LFO_SAW;
+    else if (sv_eq(shape_str, "square")) shape = LFO_SQUARE;
+    else if (sv_eq(shape_str, "random") || sv_eq(shape_str, "sh")) shape = LFO_RANDOM;
 
     // Clamp values
     if (freq_hz < 0.01) freq_hz = 0.01;
@@ -254,18 +419,18 @@ static CommandResult handle_cv_lfo(const char *json, CVSource *cv_source) {
     return result;
 }
 
-static CommandResult handle_cv_envelope(const char *json, CVSource *cv_source) {
-    CommandResult result = { CMD_CV_ENVELOPE, false, false, "" };
+static CommandResult handle_cv_envelope(const JsonObject *obj, CVSource *cv_source) {
+    CommandResult result = { .type = CMD_CV_ENVELOPE };
 
     double attack = 10;
     double decay = 100;
     double sustain = 200;
     double release = 200;
 
-    get_number(json, "attack_ms", &attack);
-    get_number(json, "decay_ms", &decay);
-    get_number(json, "sustain", &sustain);
-    get_number(json, "release_ms", &release);
+    get_number(obj, "attack_ms", &attack);
+    get_number(obj, "decay_ms", &decay);
+    get_number(obj, "sustain", &sustain);
+    get_number(obj, "release_ms", &release);
 
     // Clamp values
     if (attack < 0) attack = 0;
@@ -283,11 +448,11 @@ static CommandResult handle_cv_envelope(const char *json, CVSource *cv_source) {
     return result;
 }
 
-static CommandResult handle_cv_gate(const char *json, CVSource *cv_source) {
-    CommandResult result = { CMD_CV_GATE, false, false, "" };
+static CommandResult handle_cv_gate(const JsonObject *obj, CVSource *cv_source) {
+    CommandResult result = { .type = CMD_CV_GATE };
 
     bool state;
-    if (!get_bool(json, "state", &state)) {
+    if (!get_bool(obj, "state", &state)) {
         snprintf(result.error, sizeof(result.error), "missing 'state' field");
         return result;
     }
@@ -302,63 +467,517 @@ static CommandResult handle_cv_gate(const char *json, CVSource *cv_source) {
 }
 
 static CommandResult handle_cv_trigger(CVSource *cv_source) {
-    CommandResult result = { CMD_CV_TRIGGER, true, false, "" };
+    CommandResult result = { .type = CMD_CV_TRIGGER, .success = true };
     cv_source_trigger(cv_source);
     return result;
 }
 
+// Samples collected from a cv_wavetable command
+typedef struct {
+    uint8_t samples[CV_WAVETABLE_MAX_SAMPLES];
+    uint32_t count;
+} WavetableSamples;
+
+static bool add_sample(double value, void *arg) {
+    WavetableSamples *wt = (WavetableSamples*)arg;
+    if (wt->count >= CV_WAVETABLE_MAX_SAMPLES) return false;
+    if (value < 0) value = 0;
+    if (value > 255) value = 255;
+    wt->samples[wt->count++] = (uint8_t)value;
+    return true;
+}
+
+static CommandResult handle_cv_wavetable(const JsonObject *obj, CVSource *cv_source) {
+    CommandResult result = { .type = CMD_CV_WAVETABLE };
+
+    WavetableSamples wt;
+    wt.count = 0;
+    if (!for_each_number(obj, "samples", add_sample, &wt) || wt.count == 0) {
+        snprintf(result.error, sizeof(result.error),
+                 "'samples' must be an array of 1-%d numbers (0-255)", CV_WAVETABLE_MAX_SAMPLES);
+        return result;
+    }
+
+    double freq_hz = 1.0;
+    get_number(obj, "freq_hz", &freq_hz);
+    if (freq_hz < 0.01) freq_hz = 0.01;
+    if (freq_hz > 100) freq_hz = 100;
+
+    if (!cv_source_set_wavetable(cv_source, wt.samples, (uint16_t)wt.count, (float)freq_hz)) {
+        snprintf(result.error, sizeof(result.error), "wavetable allocation failed");
+        return result;
+    }
+    result.success = true;
+    return result;
+}
+
+static CommandResult handle_cv_file(const JsonObject *obj, CVSource *cv_source) {
+    CommandResult result = { .type = CMD_CV_FILE };
+
+    StrView path_str;
+    char path[CV_FILE_PATH_MAX];
+    if (!get_string(obj, "path", &path_str)) {
+        snprintf(result.error, sizeof(result.error), "missing 'path' field");
+        return result;
+    }
+    if (!copy_string(path_str, path, sizeof(path))) {
+        snprintf(result.error, sizeof(result.error), "invalid 'path'");
+        return result;
+    }
+
+    CVFileConfig config = { .path = path, .format = CV_FILE_WAV, .loop = true };
+    StrView format;
+    if (get_string(obj, "format", &format) &&
+        !cv_file_parse_format(format.p, format.len, &config.format)) {
+        snprintf(result.error, sizeof(result.error), "invalid format: %.*s (wav, u8, s16)",
+                 (int)format.len, format.p);
+        return result;
+    }
+
+    double rate_hz = 0;
+    get_number(obj, "rate_hz", &rate_hz);
+    if (rate_hz < 0) rate_hz = 0;
+    if (rate_hz > CV_FILE_MAX_RATE_HZ) rate_hz = CV_FILE_MAX_RATE_HZ;
+    config.rate_hz = (uint32_t)rate_hz;
+    get_bool(obj, "loop", &config.loop);
+
+    result.success = cv_source_set_file(cv_source, &config, result.error, sizeof(result.error));
+    return result;
+}
+
+// Graph being built from a cv_graph command
+typedef struct {
+    CVGraph *graph;
+    CVNode *node;           // Node whose inputs are being collected
+    char *error;
+    size_t error_len;
+} GraphBuild;
+
+static bool add_input(double value, void *arg) {
+    GraphBuild *gb = (GraphBuild*)arg;
+    if (gb->node->input_count >= CV_GRAPH_MAX_INPUTS || value < 0 ||
+        value >= CV_GRAPH_MAX_NODES) {
+        return false;
+    }
+    gb->node->inputs[gb->node->input_count++] = (uint8_t)value;
+    return true;
+}
+
+// Operator levels may leave the 0-255 range, within reason
+static int16_t clamp_level(double value) {
+    if (value < -1024) return -1024;
+    if (value > 1024) return 1024;
+    return (int16_t)value;
+}
+
+static bool add_graph_node(const JsonObject *obj, void *arg) {
+    GraphBuild *gb = (GraphBuild*)arg;
+    int idx = gb->graph->count;
+
+    StrView type;
+    if (!get_string(obj, "type", &type)) {
+        snprintf(gb->error, gb->error_len, "node %d: missing 'type' field", idx);
+        return false;
+    }
+
+    // Source nodes take the same fields as the matching command
+    CommandResult (*source)(const JsonObject *, CVSource *) = NULL;
+    CVNodeType node_type = CV_NODE_SOURCE;
+    if (sv_eq(type, "manual")) source = handle_cv_manual;
+    else if (sv_eq(type, "lfo")) source = handle_cv_lfo;
+    else if (sv_eq(type, "envelope")) source = handle_cv_envelope;
+    else if (sv_eq(type, "wavetable")) source = handle_cv_wavetable;
+    else if (!cv_graph_parse_node_type(type.p, type.len, &node_type) ||
+             node_type == CV_NODE_SOURCE) {
+        snprintf(gb->error, gb->error_len, "node %d: unknown type: %.*s",
+                 idx, (int)type.len, type.p);
+        return false;
+    }
+
+    CVNode *node = cv_graph_add(gb->graph, node_type);
+    if (!node) {
+        snprintf(gb->error, gb->error_len, "too many nodes (max %d)", CV_GRAPH_MAX_NODES);
+        return false;
+    }
+
+    if (source) {
+        CommandResult r = source(obj, &node->source);
+        if (!r.success) {
+            snprintf(gb->error, gb->error_len, "node %d: %s", idx, r.error);
+            return false;
+        }
+        return true;
+    }
+
+    gb->node = node;
+    if (json_get(obj, "in") && !for_each_number(obj, "in", add_input, gb)) {
+        snprintf(gb->error, gb->error_len, "node %d: 'in' must be up to %d node indices",
+                 idx, CV_GRAPH_MAX_INPUTS);
+        return false;
+    }
+
+    double a, b;
+    switch (node_type) {
+        case CV_NODE_NOISE:
+            if (get_number(obj, "amount", &a)) {
+                node->noise.amount = (uint16_t)((a < 0) ? 0 : (a > 1024) ? 1024 : a);
+            }
+            break;
+        case CV_NODE_MUL:
+            if (get_number(obj, "gain", &a)) node->mul.gain = clamp_level(a);
+            break;
+        case CV_NODE_OFFSET:
+            if (get_number(obj, "value", &a)) node->offset.value = clamp_level(a);
+            break;
+        case CV_NODE_CLIP:
+            if (get_number(obj, "min", &a)) node->clip.min = clamp_level(a);
+            if (get_number(obj, "max", &b)) node->clip.max = clamp_level(b);
+            break;
+        case CV_NODE_SLEW:
+            a = b = 0;
+            get_number(obj, "rise_ms", &a);
+            get_number(obj, "fall_ms", &b);
+            if (a < 0) a = 0;
+            if (a > 60000) a = 60000;
+            if (b < 0) b = 0;
+            if (b > 60000) b = 60000;
+            cv_graph_set_slew(node, (uint32_t)a, (uint32_t)b);
+            break;
+        default:
+            break;
+    }
+    return true;
+}
+
+static CommandResult handle_cv_graph(const JsonObject *obj, CVSource *cv_source) {
+    CommandResult result = { .type = CMD_CV_GRAPH };
+
+    GraphBuild gb = {
+        .graph = cv_graph_create(),
+        .error = result.error,
+        .error_len = sizeof(result.error),
+    };
+    if (!gb.graph) {
+        snprintf(result.error, sizeof(result.error), "graph allocation failed");
+        return result;
+    }
+
+    if (!for_each_object(obj, "nodes", add_graph_node, &gb)) {
+        if (result.error[0] == '\0') {
+            snprintf(result.error, sizeof(result.error), "'nodes' must be an array of objects");
+        }
+        cv_graph_destroy(gb.graph);
+        return result;
+    }
+
+    // Output defaults to the last node
+    double out = gb.graph->count ? gb.graph->count - 1 : 0;
+    get_number(obj, "out", &out);
+    if (out < 0 || out >= CV_GRAPH_MAX_NODES ||
+        !cv_graph_build(gb.graph, (uint8_t)out, result.error, sizeof(result.error))) {
+        if (result.error[0] == '\0') {
+            snprintf(result.error, sizeof(result.error), "invalid 'out'");
+        }
+        cv_graph_destroy(gb.graph);
+        return result;
+    }
+
+    cv_source_set_graph(cv_source, gb.graph);
+    result.success = true;
+    return result;
+}
+
+// Topic names for subscribe
+static const struct {
+    const char *name;
+    SocketTopic topic;
+} topic_names[] = {
+    { "state",  SOCKET_TOPIC_STATE },
+    { "events", SOCKET_TOPIC_EVENTS },
+    { "leds",   SOCKET_TOPIC_LEDS },
+    { "cv",     SOCKET_TOPIC_CV },
+    { "changes", SOCKET_TOPIC_CHANGES },
+    { "timing", SOCKET_TOPIC_TIMING },
+};
+
+static bool add_topic(StrView name, void *arg) {
+    uint32_t *topics = (uint32_t*)arg;
+    for (size_t i = 0; i < sizeof(topic_names) / sizeof(topic_names[0]); i++) {
+        if (sv_eq(name, topic_names[i].name)) {
+            *topics |= topic_names[i].topic;
+            return true;
+        }
+    }
+    return false;
+}
+
+static CommandResult handle_subscribe(const JsonObject *obj) {
+    CommandResult result = { .type = CMD_SUBSCRIBE };
+
+    uint32_t topics = 0;
+    if (!for_each_string(obj, "topics", add_topic, &topics)) {
+        snprintf(result.error, sizeof(result.error),
+                 "'topics' must be an array of state, events, leds, cv, changes, timing");
+        return result;
+    }
+
+    double interval_ms = SOCKET_DEFAULT_INTERVAL_MS;
+    get_number(obj, "interval_ms", &interval_ms);
+    if (interval_ms < 0) interval_ms = 0;
+    if (interval_ms > SOCKET_MAX_INTERVAL_MS) interval_ms = SOCKET_MAX_INTERVAL_MS;
+
+    StrView policy = { "coalesce", 8 };
+    get_string(obj, "policy", &policy);
+    if (sv_eq(policy, "coalesce")) {
+        result.policy = SOCKET_POLICY_COALESCE;
+    } else if (sv_eq(policy, "drop")) {
+        result.policy = SOCKET_POLICY_DROP;
+    } else {
+        snprintf(result.error, sizeof(result.error), "invalid policy: %.*s",
+                 (int)policy.len, policy.p);
+        return result;
+    }
+
+    result.topics = topics;
+    result.interval_ms = (uint32_t)interval_ms;
+    result.success = true;
+    return result;
+}
+
 // =============================================================================
 // Main Entry Point
 // =============================================================================
 
-CommandResult command_handler_execute(const char *json, CVSource *cv_source) {
-    CommandResult result = { CMD_UNKNOWN, false, false, "" };
+/**
+ * Map a command name to its type: switch on length, then one compare.
+ */
+static CommandType lookup_command(StrView name) {
+#define NAME_IS(s) (memcmp(name.p, (s), sizeof(s) - 1) == 0)
+    switch (name.len) {
+        case 4:  if (NAME_IS("quit")) return CMD_QUIT; break;
+        case 5:  if (NAME_IS("reset")) return CMD_RESET; break;
+        case 6:
+            if (NAME_IS("button")) return CMD_BUTTON;
+            if (NAME_IS("cv_lfo")) return CMD_CV_LFO;
+            break;
+        case 7:
+            if (NAME_IS("cv_gate")) return CMD_CV_GATE;
+            if (NAME_IS("cv_file")) return CMD_CV_FILE;
+            break;
+        case 8:  if (NAME_IS("cv_graph")) return CMD_CV_GRAPH; break;
+        case 9:
+            if (NAME_IS("cv_manual")) return CMD_CV_MANUAL;
+            if (NAME_IS("subscribe")) return CMD_SUBSCRIBE;
+            break;
+        case 10: if (NAME_IS("cv_trigger")) return CMD_CV_TRIGGER; break;
+        case 11: if (NAME_IS("cv_envelope")) return CMD_CV_ENVELOPE; break;
+        case 12: if (NAME_IS("cv_wavetable")) return CMD_CV_WAVETABLE; break;
+        default: break;
+    }
+#undef NAME_IS
+    return CMD_UNKNOWN;
+}
+
+CommandResult command_handler_execute(const char *json, size_t len, CVSource *cv_source) {
+    CommandResult result = { .type = CMD_UNKNOWN };
 
     if (!json || !cv_source) {
         snprintf(result.error, sizeof(result.error), "null argument");
         return result;
     }
 
+    JsonObject obj;
+    if (!json_tokenize(json, len, &obj)) {
+        snprintf(result.error, sizeof(result.error), "malformed JSON object");
+        return result;
+    }
+
     // Get command type
-    char cmd[32];
-    if (!get_string(json, "cmd", cmd, sizeof(cmd))) {
+    StrView cmd;
+    if (!get_string(&obj, "cmd", &cmd)) {
         snprintf(result.error, sizeof(result.error), "missing 'cmd' field");
         return result;
     }
 
     // Dispatch to handler
-    if (strcmp(cmd, "button") == 0) {
-        return handle_button(json);
-    }
-    if (strcmp(cmd, "cv_manual") == 0) {
-        return handle_cv_manual(json, cv_source);
-    }
-    if (strcmp(cmd, "cv_lfo") == 0) {
-        return handle_cv_lfo(json, cv_source);
-    }
-    if (strcmp(cmd, "cv_envelope") == 0) {
-        return handle_cv_envelope(json, cv_source);
+    switch (lookup_command(cmd)) {
+        case CMD_BUTTON:      return handle_button(&obj);
+        case CMD_CV_MANUAL:   return handle_cv_manual(&obj, cv_source);
+        case CMD_CV_LFO:      return handle_cv_lfo(&obj, cv_source);
+        case CMD_CV_ENVELOPE: return handle_cv_envelope(&obj, cv_source);
+        case CMD_CV_GATE:     return handle_cv_gate(&obj, cv_source);
+        case CMD_CV_TRIGGER:  return handle_cv_trigger(cv_source);
+        case CMD_CV_WAVETABLE: return handle_cv_wavetable(&obj, cv_source);
+        case CMD_CV_FILE:     return handle_cv_file(&obj, cv_source);
+        case CMD_CV_GRAPH:    return handle_cv_graph(&obj, cv_source);
+        case CMD_SUBSCRIBE:   return handle_subscribe(&obj);
+
+        case CMD_RESET:
+            sim_reset_time();
+            cv_source_cleanup(cv_source);
+            cv_source_init(cv_source);
+            result.type = CMD_RESET;
+            result.success = true;
+            return result;
+
+        case CMD_QUIT:
+            result.type = CMD_QUIT;
+            result.success = true;
+            result.should_quit = true;
+            return result;
+
+        default:
+            snprintf(result.error, sizeof(result.error), "unknown command: %.*s",
+                     (int)cmd.len, cmd.p);
+            return result;
     }
-    if (strcmp(cmd, "cv_gate") == 0) {
-        return handle_cv_gate(json, cv_source);
-    }
-    if (strcmp(cmd, "cv_trigger") == 0) {
-        return handle_cv_trigger(cv_source);
+}
+
+// =============================================================================
+// Binary Frames
+// =============================================================================
+
+// Minimum payload length per command type (0 = no payload)
+static size_t binary_payload_len(uint8_t type) {
+    switch (type) {
+        case SOCKET_CMD_BUTTON:      return 2;
+        case SOCKET_CMD_CV_MANUAL:   return 1;
+        case SOCKET_CMD_CV_LFO:      return 7;
+        case SOCKET_CMD_CV_ENVELOPE: return 7;
+        case SOCKET_CMD_CV_GATE:     return 1;
+        case SOCKET_CMD_SUBSCRIBE:   return 4;
+        case SOCKET_CMD_CV_BLOCK:    return 4;
+        case SOCKET_CMD_CV_FILE:     return 7;
+        default:                     return 0;
     }
-    if (strcmp(cmd, "reset") == 0) {
-        sim_reset_time();
-        cv_source_init(cv_source);
-        result.type = CMD_RESET;
-        result.success = true;
+}
+
+CommandResult command_handler_execute_binary(uint8_t type, const uint8_t *p,
+                                             size_t len, CVSource *cv_source) {
+    CommandResult result = { .type = CMD_UNKNOWN };
+
+    if (!cv_source || (!p && len > 0)) {
+        snprintf(result.error, sizeof(result.error), "null argument");
         return result;
     }
-    if (strcmp(cmd, "quit") == 0) {
-        result.type = CMD_QUIT;
-        result.success = true;
-        result.should_quit = true;
+    if (len < binary_payload_len(type)) {
+        snprintf(result.error, sizeof(result.error),
+                 "frame 0x%02x: payload too short (%lu bytes)", type, (unsigned long)len);
         return result;
     }
 
-    snprintf(result.error, sizeof(result.error), "unknown command: %s", cmd);
+    switch (type) {
+        case SOCKET_CMD_BUTTON:
+            result.type = CMD_BUTTON;
+            if (p[0] == 0) {
+                sim_set_button_a(p[1] != 0);
+            } else if (p[0] == 1) {
+                sim_set_button_b(p[1] != 0);
+            } else {
+                snprintf(result.error, sizeof(result.error), "invalid button id: %u", p[0]);
+                return result;
+            }
+            break;
+
+        case SOCKET_CMD_CV_MANUAL:
+            result.type = CMD_CV_MANUAL;
+            cv_source_set_manual(cv_source, p[0]);
+            break;
+
+        case SOCKET_CMD_CV_LFO: {
+            result.type = CMD_CV_LFO;
+            float freq_hz = (float)sp_get_u32(p) / 1000.0f;
+            if (freq_hz < 0.01f) freq_hz = 0.01f;
+            if (freq_hz > 100.0f) freq_hz = 100.0f;
+            LFOShape shape = (p[4] < LFO_SHAPE_COUNT) ? (LFOShape)p[4] : LFO_SINE;
+            cv_source_set_lfo(cv_source, freq_hz, shape, p[5], p[6]);
+            break;
+        }
+
+        case SOCKET_CMD_CV_ENVELOPE:
+            result.type = CMD_CV_ENVELOPE;
+            cv_source_set_envelope(cv_source, sp_get_u16(p), sp_get_u16(p + 2),
+                                   p[4], sp_get_u16(p + 5));
+            break;
+
+        case SOCKET_CMD_CV_GATE:
+            result.type = CMD_CV_GATE;
+            if (p[0]) {
+                cv_source_gate_on(cv_source);
+            } else {
+                cv_source_gate_off(cv_source);
+            }
+            break;
+
+        case SOCKET_CMD_CV_TRIGGER:
+            result.type = CMD_CV_TRIGGER;
+            cv_source_trigger(cv_source);
+            break;
+
+        case SOCKET_CMD_RESET:
+            result.type = CMD_RESET;
+            sim_reset_time();
+            cv_source_cleanup(cv_source);
+            cv_source_init(cv_source);
+            break;
+
+        case SOCKET_CMD_QUIT:
+            result.type = CMD_QUIT;
+            result.should_quit = true;
+            break;
+
+        case SOCKET_CMD_SUBSCRIBE:
+            result.type = CMD_SUBSCRIBE;
+            if (p[1] > SOCKET_POLICY_DROP) {
+                snprintf(result.error, sizeof(result.error), "invalid policy: %u", p[1]);
+                return result;
+            }
+            result.topics = p[0] & ((1u << SOCKET_TOPIC_COUNT) - 1);
+            result.policy = (SocketPolicy)p[1];
+            result.interval_ms = sp_get_u16(p + 2);
+            if (result.interval_ms > SOCKET_MAX_INTERVAL_MS) {
+                result.interval_ms = SOCKET_MAX_INTERVAL_MS;
+            }
+            break;
+
+        case SOCKET_CMD_CV_BLOCK:
+            result.type = CMD_CV_STREAM;
+            if (cv_source_stream_push(cv_source, sp_get_u32(p), p + 4,
+                                      (uint32_t)(len - 4)) < 0) {
+                snprintf(result.error, sizeof(result.error), "cv stream allocation failed");
+                return result;
+            }
+            break;
+
+        case SOCKET_CMD_CV_FILE: {
+            result.type = CMD_CV_FILE;
+            char path[CV_FILE_PATH_MAX];
+            size_t path_len = len - 6;
+            if (path_len >= sizeof(path) || memchr(p + 6, '\0', path_len)) {
+                snprintf(result.error, sizeof(result.error), "invalid path");
+                return result;
+            }
+            memcpy(path, p + 6, path_len);
+            path[path_len] = '\0';
+
+            uint32_t rate_hz = sp_get_u32(p + 2);
+            CVFileConfig config = {
+                .path = path,
+                .format = (p[1] < CV_FILE_FORMAT_COUNT) ? (CVFileFormat)p[1] : CV_FILE_WAV,
+                .rate_hz = (rate_hz > CV_FILE_MAX_RATE_HZ) ? CV_FILE_MAX_RATE_HZ : rate_hz,
+                .loop = p[0] != 0,
+            };
+            if (!cv_source_set_file(cv_source, &config, result.error, sizeof(result.error))) {
+                return result;
+            }
+            break;
+        }
+
+        default:
+            snprintf(result.error, sizeof(result.error), "unknown frame type: 0x%02x", type);
+            return result;
+    }
+
+    result.success = true;
     return result;
 }
@@ -2,13 +2,15 @@
 #define GK_SIM_COMMAND_HANDLER_H
 
 #include "cv_source.h"
+#include "socket_server.h"
 #include <stdbool.h>
 
 /**
  * @file command_handler.h
  * @brief JSON command parser for socket protocol
  *
- * Parses NDJSON commands and applies them to simulator state.
+ * Parses NDJSON commands and binary command frames (socket_protocol.h)
+ * and applies them to simulator state.
  */
 
 // Command types
@@ -22,7 +24,11 @@ typedef enum {
     CMD_CV_TRIGGER,
     CMD_CV_WAVETABLE,
     CMD_RESET,
-    CMD_QUIT
+    CMD_QUIT,
+    CMD_SUBSCRIBE,
+    CMD_CV_STREAM,
+    CMD_CV_FILE,
+    CMD_CV_GRAPH
 } CommandType;
 
 // Command result
@@ -31,16 +37,35 @@ typedef struct {
     bool success;
     bool should_quit;
     char error[128];
+
+    // CMD_SUBSCRIBE: applied to the sending client by the caller
+    uint32_t topics;            // SocketTopic mask
+    uint32_t interval_ms;
+    SocketPolicy policy;
 } CommandResult;
 
 /**
  * Parse and execute a JSON command.
  *
- * @param json      JSON command string (without newline)
+ * @param json      JSON command (one line, without newline; need not be
+ *                  NUL-terminated)
+ * @param len       Line length
+ * @param cv_source CV source to modify
+ * @return Command result with type, success status, and any error
+ */
+CommandResult command_handler_execute(const char *json, size_t len, CVSource *cv_source);
+
+/**
+ * Decode and execute a binary command frame.
+ *
+ * @param type      Frame type (SOCKET_CMD_*)
+ * @param payload   Frame payload
+ * @param len       Payload length
  * @param cv_source CV source to modify
  * @return Command result with type, success status, and any error
  */
-CommandResult command_handler_execute(const char *json, CVSource *cv_source);
+CommandResult command_handler_execute_binary(uint8_t type, const uint8_t *payload,
+                                             size_t len, CVSource *cv_source);
 
 /**
  * Get command type name for logging.
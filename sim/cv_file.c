@@ -0,0 +1,172 @@
+#include "cv_file.h"
+#include <errno.h>
+#include <fcntl.h>
+#include <stdio.h>
+#include <string.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+/**
+ * @file cv_file.c
+ * @brief WAV/raw file mapping
+ */
+
+#define WAV_FORMAT_PCM          0x0001
+#define WAV_FORMAT_EXTENSIBLE   0xFFFE
+
+static const char *format_names[] = { "wav", "u8", "s16" };
+
+static uint16_t get_u16(const uint8_t *p) {
+    return (uint16_t)(p[0] | (p[1] << 8));
+}
+
+static uint32_t get_u32(const uint8_t *p) {
+    return (uint32_t)p[0] | ((uint32_t)p[1] << 8) |
+           ((uint32_t)p[2] << 16) | ((uint32_t)p[3] << 24);
+}
+
+/**
+ * Find the fmt and data chunks of a RIFF/WAVE image.
+ */
+static bool parse_wav(CVFile *file, const uint8_t *buf, size_t len, char *err, size_t err_len) {
+    if (len < 12 || memcmp(buf, "RIFF", 4) != 0 || memcmp(buf + 8, "WAVE", 4) != 0) {
+        snprintf(err, err_len, "not a WAV file");
+        return false;
+    }
+
+    const uint8_t *fmt = NULL;
+    const uint8_t *data = NULL;
+    size_t data_len = 0;
+
+    // Chunks are word aligned; a truncated data chunk is played as far as it goes
+    size_t pos = 12;
+    while (pos + 8 <= len && !(fmt && data)) {
+        const uint8_t *chunk = buf + pos;
+        size_t size = get_u32(chunk + 4);
+        size_t avail = len - pos - 8;
+        if (memcmp(chunk, "fmt ", 4) == 0 && size >= 16 && size <= avail) {
+            fmt = chunk + 8;
+        } else if (memcmp(chunk, "data", 4) == 0) {
+            data = chunk + 8;
+            data_len = (size < avail) ? size : avail;
+        }
+        pos += 8 + size + (size & 1);
+    }
+
+    if (!fmt || !data) {
+        snprintf(err, err_len, "WAV file without %s chunk", fmt ? "data" : "fmt");
+        return false;
+    }
+
+    uint16_t tag = get_u16(fmt);
+    uint16_t channels = get_u16(fmt + 2);
+    uint32_t rate = get_u32(fmt + 4);
+    uint16_t block_align = get_u16(fmt + 12);
+    uint16_t bits = get_u16(fmt + 14);
+
+    if (tag != WAV_FORMAT_PCM && tag != WAV_FORMAT_EXTENSIBLE) {
+        snprintf(err, err_len, "unsupported WAV encoding 0x%04x (PCM only)", tag);
+        return false;
+    }
+    if (bits != 8 && bits != 16) {
+        snprintf(err, err_len, "unsupported WAV sample size: %u bits", bits);
+        return false;
+    }
+    if (channels == 0 || rate == 0 || block_align < channels * (bits / 8)) {
+        snprintf(err, err_len, "invalid WAV format chunk");
+        return false;
+    }
+    if (rate > CV_FILE_MAX_RATE_HZ) {
+        snprintf(err, err_len, "unsupported WAV sample rate: %lu Hz (max %lu)",
+                 (unsigned long)rate, (unsigned long)CV_FILE_MAX_RATE_HZ);
+        return false;
+    }
+
+    file->data = data;
+    file->frame_bytes = block_align;
+    size_t frames = data_len / block_align;
+    file->frames = (frames > UINT32_MAX) ? UINT32_MAX : (uint32_t)frames;
+    file->wide = (bits == 16);
+    file->rate_hz = rate;
+    return true;
+}
+
+bool cv_file_open(CVFile *file, const CVFileConfig *config, char *err, size_t err_len) {
+    memset(file, 0, sizeof(*file));
+
+    if (config->format != CV_FILE_WAV && config->rate_hz == 0) {
+        snprintf(err, err_len, "raw files need a sample rate");
+        return false;
+    }
+
+    int fd = open(config->path, O_RDONLY);
+    if (fd < 0) {
+        snprintf(err, err_len, "%s: %s", config->path, strerror(errno));
+        return false;
+    }
+
+    struct stat st;
+    if (fstat(fd, &st) < 0) {
+        snprintf(err, err_len, "%s: %s", config->path, strerror(errno));
+        close(fd);
+        return false;
+    }
+    if (st.st_size == 0) {
+        snprintf(err, err_len, "%s: empty file", config->path);
+        close(fd);
+        return false;
+    }
+
+    size_t len = (size_t)st.st_size;
+    void *map = mmap(NULL, len, PROT_READ, MAP_PRIVATE, fd, 0);
+    close(fd);
+    if (map == MAP_FAILED) {
+        snprintf(err, err_len, "%s: mmap: %s", config->path, strerror(errno));
+        return false;
+    }
+
+    // Played front to back: let the kernel read ahead
+    madvise(map, len, MADV_SEQUENTIAL);
+
+    file->map = map;
+    file->map_len = len;
+
+    bool ok = true;
+    if (config->format == CV_FILE_WAV) {
+        ok = parse_wav(file, map, len, err, err_len);
+    } else {
+        file->wide = (config->format == CV_FILE_S16);
+        file->frame_bytes = file->wide ? 2 : 1;
+        file->data = map;
+        size_t frames = len / file->frame_bytes;
+        file->frames = (frames > UINT32_MAX) ? UINT32_MAX : (uint32_t)frames;
+        file->rate_hz = config->rate_hz;
+    }
+
+    if (ok && file->frames == 0) {
+        snprintf(err, err_len, "%s: no samples", config->path);
+        ok = false;
+    }
+    if (!ok) {
+        cv_file_close(file);
+    }
+    return ok;
+}
+
+void cv_file_close(CVFile *file) {
+    if (file->map) {
+        munmap(file->map, file->map_len);
+    }
+    memset(file, 0, sizeof(*file));
+}
+
+bool cv_file_parse_format(const char *name, size_t len, CVFileFormat *format) {
+    for (int i = 0; i < CV_FILE_FORMAT_COUNT; i++) {
+        if (strlen(format_names[i]) == len && memcmp(name, format_names[i], len) == 0) {
+            *format = (CVFileFormat)i;
+            return true;
+        }
+    }
+    return false;
+}
@@ -0,0 +1,85 @@
+#ifndef GK_SIM_CV_FILE_H
+#define GK_SIM_CV_FILE_H
+
+#include <stdbool.h>
+#include <stddef.h>
+#include <stdint.h>
+
+/**
+ * @file cv_file.h
+ * @brief Memory-mapped recorded CV files
+ *
+ * Maps a WAV file (PCM, 8-bit unsigned or 16-bit signed, any channel
+ * count and rate) or a headerless raw file read-only into memory, so
+ * minutes of captured signal can be played without loading or copying
+ * them. Only the first channel is used.
+ */
+
+// Longest accepted path (bytes, including the terminator)
+#define CV_FILE_PATH_MAX 256
+
+// Highest accepted sample rate (raw files and WAV headers)
+#define CV_FILE_MAX_RATE_HZ 1000000
+
+// Sample encoding
+typedef enum {
+    CV_FILE_WAV,            // Taken from the WAV header
+    CV_FILE_U8,             // Raw unsigned 8-bit
+    CV_FILE_S16,            // Raw signed 16-bit little-endian
+    CV_FILE_FORMAT_COUNT
+} CVFileFormat;
+
+/**
+ * How to open a file.
+ */
+typedef struct {
+    const char *path;
+    CVFileFormat format;
+    uint32_t rate_hz;       // Sample rate (raw files only)
+    bool loop;              // Loop at the end (else hold the last sample)
+} CVFileConfig;
+
+/**
+ * A mapped file.
+ */
+typedef struct {
+    void *map;              // Mapping (NULL if not open)
+    size_t map_len;
+    const uint8_t *data;    // First sample frame
+    uint32_t frames;        // Sample frames available
+    uint16_t frame_bytes;   // Bytes per frame (all channels)
+    bool wide;              // 16-bit signed samples (else 8-bit unsigned)
+    uint32_t rate_hz;
+} CVFile;
+
+/**
+ * Map a file and locate its samples.
+ * @param err      Receives a message on failure
+ * @param err_len  Size of err
+ * @return true on success (close with cv_file_close)
+ */
+bool cv_file_open(CVFile *file, const CVFileConfig *config, char *err, size_t err_len);
+
+/**
+ * Unmap a file. Safe on a closed file.
+ */
+void cv_file_close(CVFile *file);
+
+/**
+ * Get a frame's first-channel sample, scaled to 0-65535.
+ */
+static inline uint16_t cv_file_sample(const CVFile *file, uint32_t frame) {
+    const uint8_t *p = file->data + (size_t)frame * file->frame_bytes;
+    if (file->wide) {
+        return (uint16_t)((p[0] | (p[1] << 8)) ^ 0x8000);
+    }
+    return (uint16_t)(p[0] << 8 | p[0]);
+}
+
+/**
+ * Parse a format name ("wav", "u8", "s16").
+ * @return false if unknown
+ */
+bool cv_file_parse_format(const char *name, size_t len, CVFileFormat *format);
+
+#endif /* GK_SIM_CV_FILE_H */
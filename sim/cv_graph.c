@@ -0,0 +1,392 @@
+#include "cv_graph.h"
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+/**
+ * @file cv_graph.c
+ * @brief CV modulation graph evaluation
+ */
+
+static const char *node_type_names[] = {
+    "source", "noise", "sum", "mul", "offset", "clip", "slew", "sah"
+};
+
+// Inputs each node type takes
+static const uint8_t min_inputs[] = { 0, 0, 1, 1, 1, 1, 1, 2 };
+static const uint8_t max_inputs[] = { 0, 0, CV_GRAPH_MAX_INPUTS, 2, 1, 1, 1, 2 };
+
+// Sample-and-hold trigger threshold (2.5V)
+#define SAH_THRESHOLD 128
+
+// Full scale in 8.8 fixed point (slew rates)
+#define SLEW_FULL_SCALE (255 << 8)
+
+static inline int16_t sat16(int32_t v) {
+    if (v > INT16_MAX) return INT16_MAX;
+    if (v < INT16_MIN) return INT16_MIN;
+    return (int16_t)v;
+}
+
+static inline uint8_t clamp_cv(int16_t v) {
+    if (v < 0) return 0;
+    if (v > 255) return 255;
+    return (uint8_t)v;
+}
+
+static inline uint32_t xorshift32(uint32_t *state) {
+    uint32_t x = *state;
+    x ^= x << 13;
+    x ^= x >> 17;
+    x ^= x << 5;
+    *state = x;
+    return x;
+}
+
+static void reset_node(CVNode *node) {
+    switch (node->type) {
+        case CV_NODE_SOURCE:
+            cv_source_reset_phase(&node->source);
+            break;
+        case CV_NODE_SLEW:
+            node->slew.level = 0;
+            node->slew.settled = false;
+            break;
+        case CV_NODE_SAH:
+            node->sah.held = 0;
+            node->sah.high = false;
+            break;
+        default:
+            break;
+    }
+}
+
+// =============================================================================
+// Evaluation
+// =============================================================================
+
+/**
+ * Evaluate one node for n ticks into its buffer.
+ * Inputs are already evaluated (topological order).
+ */
+static void eval_node(CVGraph *graph, CVNode *node, int16_t *out, uint32_t n) {
+    const int16_t *in0 = graph->buf[node->inputs[0]];
+    const int16_t *in1 = graph->buf[node->inputs[1]];
+
+    switch (node->type) {
+        case CV_NODE_SOURCE: {
+            uint8_t tmp[CV_GRAPH_BLOCK];
+            cv_source_tick_block(&node->source, tmp, n);
+            for (uint32_t i = 0; i < n; i++) out[i] = tmp[i];
+            break;
+        }
+
+        case CV_NODE_NOISE: {
+            uint32_t amount = node->noise.amount;
+            int32_t centre = (int32_t)(amount / 2);
+            for (uint32_t i = 0; i < n; i++) {
+                uint32_t r = xorshift32(&node->noise.rng) >> 16;
+                out[i] = (int16_t)((int32_t)((r * amount) >> 16) - centre);
+            }
+            break;
+        }
+
+        case CV_NODE_SUM: {
+            int32_t acc[CV_GRAPH_BLOCK];
+            for (uint32_t i = 0; i < n; i++) acc[i] = in0[i];
+            for (uint8_t k = 1; k < node->input_count; k++) {
+                const int16_t *in = graph->buf[node->inputs[k]];
+                for (uint32_t i = 0; i < n; i++) acc[i] += in[i];
+            }
+            for (uint32_t i = 0; i < n; i++) out[i] = sat16(acc[i]);
+            break;
+        }
+
+        case CV_NODE_MUL:
+            if (node->input_count > 1) {
+                for (uint32_t i = 0; i < n; i++) out[i] = sat16((int32_t)in0[i] * in1[i] / 255);
+            } else {
+                int32_t gain = node->mul.gain;
+                for (uint32_t i = 0; i < n; i++) out[i] = sat16((int32_t)in0[i] * gain / 255);
+            }
+            break;
+
+        case CV_NODE_OFFSET: {
+            int32_t value = node->offset.value;
+            for (uint32_t i = 0; i < n; i++) out[i] = sat16(in0[i] + value);
+            break;
+        }
+
+        case CV_NODE_CLIP: {
+            int16_t lo = node->clip.min;
+            int16_t hi = node->clip.max;
+            for (uint32_t i = 0; i < n; i++) {
+                int16_t v = in0[i];
+                out[i] = (v < lo) ? lo : (v > hi) ? hi : v;
+            }
+            break;
+        }
+
+        case CV_NODE_SLEW: {
+            int32_t level = node->slew.level;
+            int32_t rise = node->slew.rise;
+            int32_t fall = node->slew.fall;
+            for (uint32_t i = 0; i < n; i++) {
+                int32_t diff = ((int32_t)in0[i] << 8) - level;
+                if (diff > rise) diff = rise;
+                else if (diff < -fall) diff = -fall;
+                level += diff;
+                out[i] = (int16_t)(level >> 8);
+            }
+            node->slew.level = level;
+            node->slew.settled = (level == ((int32_t)in0[n - 1] << 8));
+            break;
+        }
+
+        case CV_NODE_SAH: {
+            int16_t held = node->sah.held;
+            bool high = node->sah.high;
+            for (uint32_t i = 0; i < n; i++) {
+                bool now = in1[i] >= SAH_THRESHOLD;
+                if (now && !high) held = in0[i];
+                high = now;
+                out[i] = held;
+            }
+            node->sah.held = held;
+            node->sah.high = high;
+            break;
+        }
+
+        default:
+            memset(out, 0, n * sizeof(out[0]));
+            break;
+    }
+}
+
+// Evaluate the graph for n ticks (n <= CV_GRAPH_BLOCK)
+static void eval_block(CVGraph *graph, uint32_t n) {
+    for (uint8_t k = 0; k < graph->order_count; k++) {
+        uint8_t idx = graph->order[k];
+        eval_node(graph, &graph->nodes[idx], graph->buf[idx], n);
+    }
+    graph->value = clamp_cv(graph->buf[graph->output][n - 1]);
+}
+
+// =============================================================================
+// Construction
+// =============================================================================
+
+CVGraph* cv_graph_create(void) {
+    return (CVGraph*)calloc(1, sizeof(CVGraph));
+}
+
+void cv_graph_destroy(CVGraph *graph) {
+    if (!graph) return;
+    for (uint8_t i = 0; i < graph->count; i++) {
+        if (graph->nodes[i].type == CV_NODE_SOURCE) {
+            cv_source_cleanup(&graph->nodes[i].source);
+        }
+    }
+    free(graph);
+}
+
+CVNode* cv_graph_add(CVGraph *graph, CVNodeType type) {
+    if (!graph || graph->count >= CV_GRAPH_MAX_NODES || type >= CV_NODE_TYPE_COUNT) {
+        return NULL;
+    }
+
+    uint8_t idx = graph->count++;
+    CVNode *node = &graph->nodes[idx];
+    memset(node, 0, sizeof(*node));
+    node->type = type;
+
+    switch (type) {
+        case CV_NODE_SOURCE:
+            cv_source_init(&node->source);
+            cv_source_seed(&node->source, CV_SOURCE_DEFAULT_SEED + idx * 0x9E3779B9u);
+            break;
+        case CV_NODE_NOISE:
+            node->noise.rng = (CV_SOURCE_DEFAULT_SEED ^ (idx * 0x9E3779B9u)) | 1;
+            break;
+        case CV_NODE_MUL:
+            node->mul.gain = 255;
+            break;
+        case CV_NODE_CLIP:
+            node->clip.min = 0;
+            node->clip.max = 255;
+            break;
+        case CV_NODE_SLEW:
+            cv_graph_set_slew(node, 0, 0);
+            break;
+        default:
+            break;
+    }
+    return node;
+}
+
+void cv_graph_set_slew(CVNode *node, uint32_t rise_ms, uint32_t fall_ms) {
+    if (!node || node->type != CV_NODE_SLEW) return;
+    node->slew.rise = rise_ms ? (int32_t)(SLEW_FULL_SCALE / rise_ms) : INT32_MAX;
+    node->slew.fall = fall_ms ? (int32_t)(SLEW_FULL_SCALE / fall_ms) : INT32_MAX;
+    if (node->slew.rise < 1) node->slew.rise = 1;
+    if (node->slew.fall < 1) node->slew.fall = 1;
+}
+
+// Depth-first post-order from node idx (state: 0 new, 1 on stack, 2 done)
+static bool visit(CVGraph *graph, uint8_t idx, uint8_t *state) {
+    if (state[idx] == 2) return true;
+    if (state[idx] == 1) return false;     // Cycle
+
+    state[idx] = 1;
+    const CVNode *node = &graph->nodes[idx];
+    for (uint8_t k = 0; k < node->input_count; k++) {
+        if (!visit(graph, node->inputs[k], state)) return false;
+    }
+    state[idx] = 2;
+    graph->order[graph->order_count++] = idx;
+    return true;
+}
+
+bool cv_graph_build(CVGraph *graph, uint8_t output, char *err, size_t err_len) {
+    if (!graph || graph->count == 0) {
+        snprintf(err, err_len, "empty graph");
+        return false;
+    }
+    if (output >= graph->count) {
+        snprintf(err, err_len, "output node %u out of range", output);
+        return false;
+    }
+
+    for (uint8_t i = 0; i < graph->count; i++) {
+        const CVNode *node = &graph->nodes[i];
+        if (node->input_count < min_inputs[node->type] ||
+            node->input_count > max_inputs[node->type]) {
+            snprintf(err, err_len, "node %u (%s) takes %u-%u inputs", i,
+                     node_type_names[node->type], min_inputs[node->type],
+                     max_inputs[node->type]);
+            return false;
+        }
+        for (uint8_t k = 0; k < node->input_count; k++) {
+            if (node->inputs[k] >= graph->count) {
+                snprintf(err, err_len, "node %u input %u out of range", i, node->inputs[k]);
+                return false;
+            }
+        }
+        if (node->type == CV_NODE_SOURCE && node->source.type == CV_SOURCE_GRAPH) {
+            snprintf(err, err_len, "node %u: graphs can't be nested", i);
+            return false;
+        }
+    }
+
+    uint8_t state[CV_GRAPH_MAX_NODES] = {0};
+    graph->order_count = 0;
+    if (!visit(graph, output, state)) {
+        snprintf(err, err_len, "graph has a cycle");
+        return false;
+    }
+    graph->output = output;
+
+    for (uint8_t i = 0; i < graph->count; i++) {
+        reset_node(&graph->nodes[i]);
+    }
+
+    graph->value = 0;
+    return true;
+}
+
+// =============================================================================
+// Public API
+// =============================================================================
+
+uint8_t cv_graph_tick(CVGraph *graph, uint32_t delta_ms) {
+    if (!graph || graph->order_count == 0) return 0;
+
+    while (delta_ms > 0) {
+        uint32_t n = (delta_ms < CV_GRAPH_BLOCK) ? delta_ms : CV_GRAPH_BLOCK;
+        eval_block(graph, n);
+        delta_ms -= n;
+    }
+    return graph->value;
+}
+
+void cv_graph_tick_block(CVGraph *graph, uint8_t *out, uint32_t count) {
+    if (!graph || !out) return;
+    if (graph->order_count == 0) {
+        memset(out, 0, count);
+        return;
+    }
+
+    while (count > 0) {
+        uint32_t n = (count < CV_GRAPH_BLOCK) ? count : CV_GRAPH_BLOCK;
+        eval_block(graph, n);
+        const int16_t *result = graph->buf[graph->output];
+        for (uint32_t i = 0; i < n; i++) out[i] = clamp_cv(result[i]);
+        out += n;
+        count -= n;
+    }
+}
+
+bool cv_graph_is_static(const CVGraph *graph) {
+    if (!graph) return true;
+
+    for (uint8_t k = 0; k < graph->order_count; k++) {
+        const CVNode *node = &graph->nodes[graph->order[k]];
+        switch (node->type) {
+            case CV_NODE_SOURCE:
+                if (!cv_source_is_static(&node->source)) return false;
+                break;
+            case CV_NODE_NOISE:
+                if (node->noise.amount > 0) return false;
+                break;
+            case CV_NODE_SLEW:
+                if (!node->slew.settled) return false;
+                break;
+            default:
+                break;
+        }
+    }
+    return true;
+}
+
+void cv_graph_gate(CVGraph *graph, bool on) {
+    if (!graph) return;
+    for (uint8_t i = 0; i < graph->count; i++) {
+        if (graph->nodes[i].type != CV_NODE_SOURCE) continue;
+        if (on) {
+            cv_source_gate_on(&graph->nodes[i].source);
+        } else {
+            cv_source_gate_off(&graph->nodes[i].source);
+        }
+    }
+}
+
+void cv_graph_trigger(CVGraph *graph) {
+    if (!graph) return;
+    for (uint8_t i = 0; i < graph->count; i++) {
+        if (graph->nodes[i].type == CV_NODE_SOURCE) {
+            cv_source_trigger(&graph->nodes[i].source);
+        }
+    }
+}
+
+void cv_graph_reset_phase(CVGraph *graph) {
+    if (!graph) return;
+    for (uint8_t i = 0; i < graph->count; i++) {
+        reset_node(&graph->nodes[i]);
+    }
+}
+
+const char* cv_graph_node_type_str(CVNodeType type) {
+    if (type >= CV_NODE_TYPE_COUNT) return "unknown";
+    return node_type_names[type];
+}
+
+bool cv_graph_parse_node_type(const char *name, size_t len, CVNodeType *type) {
+    for (int i = 0; i < CV_NODE_TYPE_COUNT; i++) {
+        if (strlen(node_type_names[i]) == len && memcmp(name, node_type_names[i], len) == 0) {
+            *type = (CVNodeType)i;
+            return true;
+        }
+    }
+    return false;
+}
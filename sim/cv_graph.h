@@ -0,0 +1,160 @@
+#ifndef GK_SIM_CV_GRAPH_H
+#define GK_SIM_CV_GRAPH_H
+
+#include "cv_source.h"
+#include <stdbool.h>
+#include <stddef.h>
+#include <stdint.h>
+
+/**
+ * @file cv_graph.h
+ * @brief Composable CV modulation graph
+ *
+ * A small patch of nodes: sources (any CVSource, or noise) feeding
+ * operators (sum, multiply, offset, clip, slew, sample-and-hold), one of
+ * which drives the ADC. Install a built graph with cv_source_set_graph().
+ *
+ * Values between nodes are signed 16-bit in ADC units (0-255 = 0-5V), so
+ * intermediate signals can go negative or above 5V; only the output node
+ * is clamped to 0-255. The graph is evaluated a block of ticks at a time
+ * in topological order, each node into its own preallocated buffer, so a
+ * node costs one tight loop per block rather than a call per tick.
+ */
+
+#define CV_GRAPH_MAX_NODES  16
+#define CV_GRAPH_MAX_INPUTS 4
+#define CV_GRAPH_BLOCK      64      // Ticks evaluated per pass
+
+typedef enum {
+    CV_NODE_SOURCE,         // Embedded CVSource (no inputs)
+    CV_NODE_NOISE,          // White noise, centred on 0 (no inputs)
+    CV_NODE_SUM,            // Sum of 1-4 inputs
+    CV_NODE_MUL,            // in0 * in1 / 255, or in0 * gain / 255 with one input
+    CV_NODE_OFFSET,         // in0 + value
+    CV_NODE_CLIP,           // in0 clamped to [min, max]
+    CV_NODE_SLEW,           // in0 rate-limited
+    CV_NODE_SAH,            // in0 sampled on each rising edge of in1 (crossing 128)
+    CV_NODE_TYPE_COUNT
+} CVNodeType;
+
+typedef struct {
+    CVNodeType type;
+    uint8_t input_count;
+    uint8_t inputs[CV_GRAPH_MAX_INPUTS];    // Node indices
+    union {
+        CVSource source;
+        struct {
+            uint32_t rng;           // xorshift32 state
+            uint16_t amount;        // Peak-to-peak
+        } noise;
+        struct {
+            int16_t gain;           // 255 = unity
+        } mul;
+        struct {
+            int16_t value;
+        } offset;
+        struct {
+            int16_t min, max;
+        } clip;
+        struct {
+            int32_t rise, fall;     // Largest step per ms (8.8 fixed point)
+            int32_t level;          // Current output (8.8 fixed point)
+            bool settled;           // Output reached the input
+        } slew;
+        struct {
+            int16_t held;
+            bool high;              // Trigger above threshold last tick
+        } sah;
+    };
+} CVNode;
+
+typedef struct CVGraph {
+    CVNode nodes[CV_GRAPH_MAX_NODES];
+    uint8_t count;
+    uint8_t output;                         // Node driving the ADC
+    uint8_t order[CV_GRAPH_MAX_NODES];      // Evaluation order (set by build)
+    uint8_t order_count;                    // Nodes the output depends on
+    uint8_t value;                          // Last output
+    int16_t buf[CV_GRAPH_MAX_NODES][CV_GRAPH_BLOCK];
+} CVGraph;
+
+/**
+ * Allocate an empty graph.
+ * @return Graph, or NULL if allocation fails (free with cv_graph_destroy)
+ */
+CVGraph* cv_graph_create(void);
+
+/**
+ * Release a graph and its sources. Safe with NULL.
+ */
+void cv_graph_destroy(CVGraph *graph);
+
+/**
+ * Append a node with default parameters (unity gain, full-range clip,
+ * instant slew, manual source at 0, no noise).
+ * Set inputs and parameters on the returned node before building.
+ * @return Node (index count - 1), or NULL if the graph is full
+ */
+CVNode* cv_graph_add(CVGraph *graph, CVNodeType type);
+
+/**
+ * Set a slew node's rates.
+ * @param rise_ms  Time for a full-scale (0-255) rise (0 = instant)
+ * @param fall_ms  Time for a full-scale fall (0 = instant)
+ */
+void cv_graph_set_slew(CVNode *node, uint32_t rise_ms, uint32_t fall_ms);
+
+/**
+ * Validate inputs and compute the evaluation order.
+ * Only nodes the output depends on are evaluated.
+ * @param output   Index of the node driving the ADC
+ * @param err      Receives a message on failure
+ * @param err_len  Size of err
+ * @return false on a bad input count or index, or a cycle
+ */
+bool cv_graph_build(CVGraph *graph, uint8_t output, char *err, size_t err_len);
+
+/**
+ * Advance delta_ms ticks and return the output after the last one.
+ * delta_ms 0 returns the current output without advancing.
+ */
+uint8_t cv_graph_tick(CVGraph *graph, uint32_t delta_ms);
+
+/**
+ * Process count ticks, writing each tick's output to out.
+ */
+void cv_graph_tick_block(CVGraph *graph, uint8_t *out, uint32_t count);
+
+/**
+ * Check if the output is constant until reconfigured or gated: all
+ * sources static, no noise, and every slew settled.
+ */
+bool cv_graph_is_static(const CVGraph *graph);
+
+/**
+ * Gate every envelope source in the graph.
+ */
+void cv_graph_gate(CVGraph *graph, bool on);
+
+/**
+ * Trigger every envelope source in the graph.
+ */
+void cv_graph_trigger(CVGraph *graph);
+
+/**
+ * Reset every source's phase and every operator's state.
+ */
+void cv_graph_reset_phase(CVGraph *graph);
+
+/**
+ * Get node type as string.
+ */
+const char* cv_graph_node_type_str(CVNodeType type);
+
+/**
+ * Parse a node type name (as returned by cv_graph_node_type_str).
+ * @return false if unknown
+ */
+bool cv_graph_parse_node_type(const char *name, size_t len, CVNodeType *type);
+
+#endif /* GK_SIM_CV_GRAPH_H */
@@ -1,11 +1,8 @@
 #include "cv_source.h"
+#include "cv_graph.h"
+#include <stdio.h>
 #include <stdlib.h>
 #include <string.h>
-#include <math.h>
-
-#ifndef M_PI
-#define M_PI 3.14159265358979323846
-#endif
 
 /**
  * @file cv_source.c
@@ -14,7 +11,7 @@
 
 // String tables
 static const char *source_type_names[] = {
-    "manual", "lfo", "envelope", "wavetable"
+    "manual", "lfo", "envelope", "wavetable", "ramp", "stream", "file", "graph"
 };
 
 static const char *lfo_shape_names[] = {
@@ -26,73 +23,185 @@ static const char *envelope_state_names[] = {
 };
 
 // =============================================================================
-// LFO Implementation
+// DDS Core
 // =============================================================================
 
+// Sine table: 2^DDS_TABLE_BITS entries per cycle
+#define DDS_TABLE_BITS 8
+#define DDS_TABLE_SIZE (1 << DDS_TABLE_BITS)
+
+// One sine cycle, unipolar (0-65535), plus a guard entry equal to the first
+// so interpolation never wraps. Read-only, like the firmware's PROGMEM tables.
+static const uint16_t sine_table[DDS_TABLE_SIZE + 1] = {
+    32768, 33572, 34375, 35178, 35979, 36779, 37575, 38369,
+    39160, 39947, 40729, 41507, 42279, 43046, 43807, 44560,
+    45307, 46046, 46777, 47500, 48214, 48919, 49613, 50298,
+    50972, 51635, 52287, 52927, 53555, 54170, 54773, 55362,
+    55938, 56499, 57047, 57579, 58097, 58600, 59087, 59558,
+    60013, 60451, 60873, 61278, 61666, 62036, 62389, 62724,
+    63041, 63339, 63620, 63881, 64124, 64348, 64553, 64739,
+    64905, 65053, 65180, 65289, 65377, 65446, 65496, 65525,
+    65535, 65525, 65496, 65446, 65377, 65289, 65180, 65053,
+    64905, 64739, 64553, 64348, 64124, 63881, 63620, 63339,
+    63041, 62724, 62389, 62036, 61666, 61278, 60873, 60451,
+    60013, 59558, 59087, 58600, 58097, 57579, 57047, 56499,
+    55938, 55362, 54773, 54170, 53555, 52927, 52287, 51635,
+    50972, 50298, 49613, 48919, 48214, 47500, 46777, 46046,
+    45307, 44560, 43807, 43046, 42279, 41507, 40729, 39947,
+    39160, 38369, 37575, 36779, 35979, 35178, 34375, 33572,
+    32768, 31963, 31160, 30357, 29556, 28756, 27960, 27166,
+    26375, 25588, 24806, 24028, 23256, 22489, 21728, 20975,
+    20228, 19489, 18758, 18035, 17321, 16616, 15922, 15237,
+    14563, 13900, 13248, 12608, 11980, 11365, 10762, 10173,
+     9597,  9036,  8488,  7956,  7438,  6935,  6448,  5977,
+     5522,  5084,  4662,  4257,  3869,  3499,  3146,  2811,
+     2494,  2196,  1915,  1654,  1411,  1187,   982,   796,
+      630,   482,   355,   246,   158,    89,    39,    10,
+        0,    10,    39,    89,   158,   246,   355,   482,
+      630,   796,   982,  1187,  1411,  1654,  1915,  2196,
+     2494,  2811,  3146,  3499,  3869,  4257,  4662,  5084,
+     5522,  5977,  6448,  6935,  7438,  7956,  8488,  9036,
+     9597, 10173, 10762, 11365, 11980, 12608, 13248, 13900,
+    14563, 15237, 15922, 16616, 17321, 18035, 18758, 19489,
+    20228, 20975, 21728, 22489, 23256, 24028, 24806, 25588,
+    26375, 27166, 27960, 28756, 29556, 30357, 31160, 31963,
+    32768
+};
+
 /**
- * Get LFO waveform value for given phase.
- * @param shape  Waveform type
- * @param phase  Phase position (0.0 - 1.0)
- * @param random_val  Pointer to random value (for S&H, updated on phase wrap)
- * @return Normalized value (-1.0 to 1.0)
+ * Phase increment per ms for a frequency (one cycle = 2^32).
  */
-static float lfo_shape_value(LFOShape shape, float phase, float *random_val) {
-    switch (shape) {
-        case LFO_SINE:
-            return sinf(phase * 2.0f * (float)M_PI);
+static uint32_t dds_phase_inc(float freq_hz) {
+    if (!(freq_hz > 0.0f)) return 0;
+    double inc = (double)freq_hz * (4294967296.0 / 1000.0) + 0.5;
+    return (inc >= 4294967295.0) ? UINT32_MAX : (uint32_t)inc;
+}
 
-        case LFO_TRI:
-            // Triangle: rises 0->1 in first half, falls 1->0 in second half
-            // Normalized to -1..1
-            if (phase < 0.5f) {
-                return 4.0f * phase - 1.0f;
-            } else {
-                return 3.0f - 4.0f * phase;
-            }
+/**
+ * Sine lookup: table index from the top phase bits, linear interpolation
+ * on the next 16.
+ */
+static inline uint16_t dds_sine(uint32_t phase) {
+    uint32_t idx = phase >> (32 - DDS_TABLE_BITS);
+    int32_t frac = (int32_t)((phase >> (16 - DDS_TABLE_BITS)) & 0xFFFF);
+    int32_t a = sine_table[idx];
+    int32_t b = sine_table[idx + 1];
+    return (uint16_t)(a + (((b - a) * frac) >> 16));
+}
 
-        case LFO_SAW:
-            // Sawtooth: rises from -1 to 1 over the cycle
-            return 2.0f * phase - 1.0f;
+// Triangle: rises 0->max in the first half, falls back in the second
+static inline uint16_t dds_tri(uint32_t phase) {
+    uint32_t p = phase >> 15;
+    return (uint16_t)((p < 0x10000) ? p : 0x1FFFF - p);
+}
 
-        case LFO_SQUARE:
-            return (phase < 0.5f) ? 1.0f : -1.0f;
+// Sawtooth: rises over the cycle
+static inline uint16_t dds_saw(uint32_t phase) {
+    return (uint16_t)(phase >> 16);
+}
 
-        case LFO_RANDOM:
-            // Sample-and-hold: return stored random value
-            // (updated on phase wrap in tick function)
-            return *random_val;
+// Square: high in the first half
+static inline uint16_t dds_square(uint32_t phase) {
+    return (phase < 0x80000000u) ? 0xFFFF : 0;
+}
 
-        default:
-            return 0.0f;
+/**
+ * Map a unipolar value (0-65535) onto min + range, rounded.
+ * range may be negative (min above max).
+ */
+static inline uint8_t dds_scale(uint16_t v, int32_t min, int32_t range) {
+    return (uint8_t)(min + ((range * (int32_t)v + 0x8000) >> 16));
+}
+
+/**
+ * xorshift32 step. State must be non-zero.
+ */
+static inline uint32_t xorshift32(uint32_t *state) {
+    uint32_t x = *state;
+    x ^= x << 13;
+    x ^= x >> 17;
+    x ^= x << 5;
+    *state = x;
+    return x;
+}
+
+// =============================================================================
+// LFO Implementation
+// =============================================================================
+
+/**
+ * Get LFO waveform value for given phase.
+ * @return Unipolar value (0-65535)
+ */
+static uint16_t lfo_shape_value(const LFOParams *lfo, uint32_t phase) {
+    switch (lfo->shape) {
+        case LFO_SINE:   return dds_sine(phase);
+        case LFO_TRI:    return dds_tri(phase);
+        case LFO_SAW:    return dds_saw(phase);
+        case LFO_SQUARE: return dds_square(phase);
+        case LFO_RANDOM: return lfo->random_value;  // Updated on phase wrap
+        default:         return 0x8000;
     }
 }
 
 /**
  * Process LFO tick.
  */
-static uint8_t lfo_tick(LFOParams *lfo, uint32_t delta_ms) {
-    // Advance phase
-    float phase_inc = (lfo->freq_hz * (float)delta_ms) / 1000.0f;
-    lfo->phase += phase_inc;
-
-    // Handle phase wrap
-    while (lfo->phase >= 1.0f) {
-        lfo->phase -= 1.0f;
-        // Generate new random value on wrap (for S&H)
-        if (lfo->shape == LFO_RANDOM) {
-            lfo->random_value = ((float)rand() / (float)RAND_MAX) * 2.0f - 1.0f;
+static uint8_t lfo_tick(LFOParams *lfo, uint32_t *rng, uint32_t delta_ms) {
+    // Advance phase; the carry out of 32 bits counts completed cycles
+    uint64_t pos = (uint64_t)lfo->phase + (uint64_t)lfo->phase_inc * delta_ms;
+    uint32_t wraps = (uint32_t)(pos >> 32);
+    lfo->phase = (uint32_t)pos;
+
+    // New sample-and-hold value per cycle
+    if (lfo->shape == LFO_RANDOM) {
+        while (wraps--) {
+            lfo->random_value = (uint16_t)(xorshift32(rng) >> 16);
         }
     }
 
-    // Get normalized value (-1 to 1)
-    float normalized = lfo_shape_value(lfo->shape, lfo->phase, &lfo->random_value);
+    int32_t min = lfo->min_val;
+    return dds_scale(lfo_shape_value(lfo, lfo->phase), min, (int32_t)lfo->max_val - min);
+}
 
-    // Scale to 0..1
-    float scaled = (normalized + 1.0f) * 0.5f;
+/**
+ * Process count 1ms LFO ticks. One loop per shape, no branches inside.
+ */
+static void lfo_block(LFOParams *lfo, uint32_t *rng, uint8_t *out, uint32_t count) {
+    uint32_t phase = lfo->phase;
+    uint32_t inc = lfo->phase_inc;
+    int32_t min = lfo->min_val;
+    int32_t range = (int32_t)lfo->max_val - min;
 
-    // Map to min..max range
-    float range = (float)(lfo->max_val - lfo->min_val);
-    return lfo->min_val + (uint8_t)(scaled * range);
+    switch (lfo->shape) {
+        case LFO_SINE:
+            for (uint32_t i = 0; i < count; i++) {
+                out[i] = dds_scale(dds_sine(phase + (i + 1) * inc), min, range);
+            }
+            break;
+        case LFO_TRI:
+            for (uint32_t i = 0; i < count; i++) {
+                out[i] = dds_scale(dds_tri(phase + (i + 1) * inc), min, range);
+            }
+            break;
+        case LFO_SAW:
+            for (uint32_t i = 0; i < count; i++) {
+                out[i] = dds_scale(dds_saw(phase + (i + 1) * inc), min, range);
+            }
+            break;
+        case LFO_SQUARE:
+            for (uint32_t i = 0; i < count; i++) {
+                out[i] = dds_scale(dds_square(phase + (i + 1) * inc), min, range);
+            }
+            break;
+        default:
+            // Sample-and-hold draws on wraps: tick by tick
+            for (uint32_t i = 0; i < count; i++) {
+                out[i] = lfo_tick(lfo, rng, 1);
+            }
+            return;
+    }
+    lfo->phase = phase + count * inc;
 }
 
 // =============================================================================
@@ -197,31 +306,158 @@ static void envelope_gate_off_internal(EnvelopeParams *env, uint32_t current_tim
 // =============================================================================
 
 /**
- * Process wavetable tick with linear interpolation.
+ * Wavetable sample at a phase, linearly interpolated between entries.
+ */
+static inline uint8_t wavetable_value(const WavetableParams *wt, uint32_t phase) {
+    // 32.32 fixed-point table position
+    uint64_t pos = (uint64_t)phase * wt->length;
+    uint32_t idx0 = (uint32_t)(pos >> 32);
+    uint32_t idx1 = (idx0 + 1 == wt->length) ? 0 : idx0 + 1;
+    int32_t frac = (int32_t)((uint32_t)pos >> 16);
+    int32_t a = wt->samples[idx0];
+    int32_t b = wt->samples[idx1];
+    return (uint8_t)(a + (((b - a) * frac) >> 16));
+}
+
+/**
+ * Process wavetable tick (value at the current position, then advance).
  */
 static uint8_t wavetable_tick(WavetableParams *wt, uint32_t delta_ms) {
     if (!wt->samples || wt->length == 0) {
         return 0;
     }
 
-    // Get interpolated sample
-    uint16_t idx0 = (uint16_t)wt->position;
-    uint16_t idx1 = (idx0 + 1) % wt->length;
-    float frac = wt->position - (float)idx0;
+    uint8_t value = wavetable_value(wt, wt->phase);
+    wt->phase += (uint32_t)((uint64_t)wt->phase_inc * delta_ms);
+    return value;
+}
 
-    float sample = (1.0f - frac) * (float)wt->samples[idx0] +
-                   frac * (float)wt->samples[idx1];
+/**
+ * Process count 1ms wavetable ticks.
+ */
+static void wavetable_block(WavetableParams *wt, uint8_t *out, uint32_t count) {
+    if (!wt->samples || wt->length == 0) {
+        memset(out, 0, count);
+        return;
+    }
+
+    uint32_t phase = wt->phase;
+    uint32_t inc = wt->phase_inc;
+    for (uint32_t i = 0; i < count; i++) {
+        out[i] = wavetable_value(wt, phase + i * inc);
+    }
+    wt->phase = phase + count * inc;
+}
+
+// =============================================================================
+// Ramp Implementation
+// =============================================================================
+
+/**
+ * Process ramp tick (value at the start of the tick, then advance).
+ */
+static uint8_t ramp_tick(RampParams *ramp, uint32_t delta_ms) {
+    uint8_t value;
+    if (ramp->elapsed_ms >= ramp->duration_ms) {
+        value = ramp->to_val;
+    } else {
+        int32_t range = (int32_t)ramp->to_val - (int32_t)ramp->from_val;
+        value = (uint8_t)(ramp->from_val +
+                          range * (int32_t)ramp->elapsed_ms / (int32_t)ramp->duration_ms);
+    }
+
+    // Saturate one past the end: to_val has been output, ramp is done
+    ramp->elapsed_ms += delta_ms;
+    if (ramp->elapsed_ms > ramp->duration_ms) {
+        ramp->elapsed_ms = ramp->duration_ms + 1;
+    }
+    return value;
+}
+
+// =============================================================================
+// Stream Implementation
+// =============================================================================
+
+/**
+ * Process stream tick: play the samples due in delta_ms, output the last one.
+ */
+static uint8_t stream_tick(StreamParams *st, uint32_t delta_ms) {
+    uint64_t pos = st->phase + (uint64_t)st->rate_hz * delta_ms;
+    uint64_t due = pos / 1000;
+    st->phase = (uint32_t)(pos % 1000);
+
+    if (due == 0) {
+        return st->value;
+    }
+    if (due > st->count) {
+        st->underruns++;
+        due = st->count;
+    }
+    if (due > 0) {
+        st->head = (st->head + (uint32_t)due) & (CV_STREAM_CAPACITY - 1);
+        st->count -= (uint32_t)due;
+        st->value = st->samples[(st->head - 1) & (CV_STREAM_CAPACITY - 1)];
+    }
+    return st->value;
+}
+
+// =============================================================================
+// File Implementation
+// =============================================================================
+
+/**
+ * Value of the frames covered by one tick starting at fp->pos.
+ */
+static uint8_t file_value(const FileParams *fp, uint64_t span) {
+    const CVFile *f = &fp->file;
+    uint32_t i0 = (uint32_t)(fp->pos >> 32);
+    uint64_t spanned = span >> 32;
+
+    // Several frames per tick: average them (box filter) so content above
+    // the tick rate doesn't alias
+    if (spanned >= 2) {
+        uint32_t n = (spanned < f->frames - i0) ? (uint32_t)spanned : f->frames - i0;
+        uint64_t sum = 0;
+        for (uint32_t i = 0; i < n; i++) {
+            sum += cv_file_sample(f, i0 + i);
+        }
+        return (uint8_t)((sum / n) >> 8);
+    }
 
-    // Advance position
-    float pos_inc = (wt->freq_hz * (float)wt->length * (float)delta_ms) / 1000.0f;
-    wt->position += pos_inc;
+    // Otherwise interpolate between neighbouring frames
+    uint32_t i1 = i0 + 1;
+    if (i1 >= f->frames) {
+        i1 = fp->loop ? 0 : i0;
+    }
+    int32_t frac = (int32_t)((fp->pos >> 16) & 0xFFFF);
+    int32_t a = cv_file_sample(f, i0);
+    int32_t b = cv_file_sample(f, i1);
+    return (uint8_t)((a + (((b - a) * frac) >> 16)) >> 8);
+}
 
-    // Wrap position
-    while (wt->position >= (float)wt->length) {
-        wt->position -= (float)wt->length;
+/**
+ * Process file tick (value at the current position, then advance).
+ */
+static uint8_t file_tick(FileParams *fp, uint32_t delta_ms) {
+    if (fp->done) {
+        return fp->value;
     }
 
-    return (uint8_t)sample;
+    uint64_t span = fp->step * delta_ms;
+    uint64_t end = (uint64_t)fp->file.frames << 32;
+    fp->value = file_value(fp, span);
+    fp->pos += span;
+
+    if (fp->pos >= end) {
+        if (fp->loop) {
+            fp->pos %= end;
+        } else {
+            // Hold the last sample
+            fp->done = true;
+            fp->value = (uint8_t)(cv_file_sample(&fp->file, fp->file.frames - 1) >> 8);
+        }
+    }
+    return fp->value;
 }
 
 // =============================================================================
@@ -233,15 +469,32 @@ void cv_source_init(CVSource *src) {
     memset(src, 0, sizeof(CVSource));
     src->type = CV_SOURCE_MANUAL;
     src->time_ms = 0;
+    src->rng = CV_SOURCE_DEFAULT_SEED;
     src->manual_value = 0;
 }
 
+void cv_source_seed(CVSource *src, uint32_t seed) {
+    if (!src) return;
+    src->rng = seed ? seed : CV_SOURCE_DEFAULT_SEED;
+}
+
 void cv_source_cleanup(CVSource *src) {
     if (!src) return;
     if (src->type == CV_SOURCE_WAVETABLE && src->wavetable.samples) {
         free(src->wavetable.samples);
         src->wavetable.samples = NULL;
     }
+    if (src->type == CV_SOURCE_STREAM && src->stream.samples) {
+        free(src->stream.samples);
+        src->stream.samples = NULL;
+    }
+    if (src->type == CV_SOURCE_FILE) {
+        cv_file_close(&src->file.file);
+    }
+    if (src->type == CV_SOURCE_GRAPH) {
+        cv_graph_destroy(src->graph);
+        src->graph = NULL;
+    }
 }
 
 void cv_source_set_manual(CVSource *src, uint8_t value) {
@@ -261,8 +514,9 @@ void cv_source_set_lfo(CVSource *src, float freq_hz, LFOShape shape,
     src->lfo.shape = shape;
     src->lfo.min_val = min_val;
     src->lfo.max_val = max_val;
-    src->lfo.phase = 0.0f;
-    src->lfo.random_value = ((float)rand() / (float)RAND_MAX) * 2.0f - 1.0f;
+    src->lfo.phase = 0;
+    src->lfo.phase_inc = dds_phase_inc(freq_hz);
+    src->lfo.random_value = (uint16_t)(xorshift32(&src->rng) >> 16);
 }
 
 void cv_source_set_envelope(CVSource *src, uint16_t attack_ms, uint16_t decay_ms,
@@ -282,6 +536,18 @@ void cv_source_set_envelope(CVSource *src, uint16_t attack_ms, uint16_t decay_ms
     src->envelope.gate = false;
 }
 
+void cv_source_set_ramp(CVSource *src, uint8_t from_val, uint8_t to_val,
+                        uint32_t duration_ms) {
+    if (!src) return;
+    cv_source_cleanup(src);
+
+    src->type = CV_SOURCE_RAMP;
+    src->ramp.from_val = from_val;
+    src->ramp.to_val = to_val;
+    src->ramp.duration_ms = duration_ms;
+    src->ramp.elapsed_ms = 0;
+}
+
 bool cv_source_set_wavetable(CVSource *src, const uint8_t *samples,
                              uint16_t length, float freq_hz) {
     if (!src || !samples || length == 0) return false;
@@ -298,11 +564,77 @@ bool cv_source_set_wavetable(CVSource *src, const uint8_t *samples,
     src->wavetable.samples = buf;
     src->wavetable.length = length;
     src->wavetable.freq_hz = freq_hz;
-    src->wavetable.position = 0.0f;
+    src->wavetable.phase = 0;
+    src->wavetable.phase_inc = dds_phase_inc(freq_hz);
+
+    return true;
+}
+
+int cv_source_stream_push(CVSource *src, uint32_t rate_hz,
+                          const uint8_t *samples, uint32_t count) {
+    if (!src || (!samples && count > 0)) return -1;
+    if (rate_hz < 1) rate_hz = 1;
+    if (rate_hz > 1000000) rate_hz = 1000000;
+
+    if (src->type != CV_SOURCE_STREAM) {
+        uint8_t *buf = (uint8_t *)malloc(CV_STREAM_CAPACITY);
+        if (!buf) return -1;
+
+        // Hold the current output until the first sample is due
+        uint8_t value = cv_source_tick(src, 0);
+        cv_source_cleanup(src);
+        memset(&src->stream, 0, sizeof(src->stream));
+        src->type = CV_SOURCE_STREAM;
+        src->stream.samples = buf;
+        src->stream.value = value;
+    }
+
+    StreamParams *st = &src->stream;
+    st->rate_hz = rate_hz;
+
+    uint32_t space = CV_STREAM_CAPACITY - st->count;
+    uint32_t n = (count < space) ? count : space;
+    st->overflows += count - n;
+
+    // Copy in up to two pieces around the end of the ring
+    uint32_t tail = (st->head + st->count) & (CV_STREAM_CAPACITY - 1);
+    uint32_t first = CV_STREAM_CAPACITY - tail;
+    if (first > n) first = n;
+    memcpy(st->samples + tail, samples, first);
+    memcpy(st->samples, samples + first, n - first);
+    st->count += n;
+
+    return (int)n;
+}
 
+bool cv_source_set_file(CVSource *src, const CVFileConfig *config,
+                        char *err, size_t err_len) {
+    if (!src || !config || !config->path) {
+        snprintf(err, err_len, "no file");
+        return false;
+    }
+
+    CVFile file;
+    if (!cv_file_open(&file, config, err, err_len)) {
+        return false;
+    }
+
+    cv_source_cleanup(src);
+    memset(&src->file, 0, sizeof(src->file));
+    src->type = CV_SOURCE_FILE;
+    src->file.file = file;
+    src->file.loop = config->loop;
+    src->file.step = ((uint64_t)file.rate_hz << 32) / 1000;
     return true;
 }
 
+void cv_source_set_graph(CVSource *src, struct CVGraph *graph) {
+    if (!src || !graph) return;
+    cv_source_cleanup(src);
+    src->type = CV_SOURCE_GRAPH;
+    src->graph = graph;
+}
+
 uint8_t cv_source_tick(CVSource *src, uint32_t delta_ms) {
     if (!src) return 0;
 
@@ -314,7 +646,7 @@ uint8_t cv_source_tick(CVSource *src, uint32_t delta_ms) {
             return src->manual_value;
 
         case CV_SOURCE_LFO:
-            return lfo_tick(&src->lfo, delta_ms);
+            return lfo_tick(&src->lfo, &src->rng, delta_ms);
 
         case CV_SOURCE_ENVELOPE:
             return envelope_tick(&src->envelope, src->time_ms);
@@ -322,22 +654,151 @@ uint8_t cv_source_tick(CVSource *src, uint32_t delta_ms) {
         case CV_SOURCE_WAVETABLE:
             return wavetable_tick(&src->wavetable, delta_ms);
 
+        case CV_SOURCE_RAMP:
+            return ramp_tick(&src->ramp, delta_ms);
+
+        case CV_SOURCE_STREAM:
+            return stream_tick(&src->stream, delta_ms);
+
+        case CV_SOURCE_FILE:
+            return file_tick(&src->file, delta_ms);
+
+        case CV_SOURCE_GRAPH:
+            return cv_graph_tick(src->graph, delta_ms);
+
         default:
             return 0;
     }
 }
 
+void cv_source_tick_block(CVSource *src, uint8_t *out, uint32_t count) {
+    if (!src || !out) return;
+
+    switch (src->type) {
+        case CV_SOURCE_MANUAL:
+            src->time_ms += count;
+            memset(out, src->manual_value, count);
+            break;
+
+        case CV_SOURCE_LFO:
+            src->time_ms += count;
+            lfo_block(&src->lfo, &src->rng, out, count);
+            break;
+
+        case CV_SOURCE_WAVETABLE:
+            src->time_ms += count;
+            wavetable_block(&src->wavetable, out, count);
+            break;
+
+        case CV_SOURCE_GRAPH:
+            src->time_ms += count;
+            cv_graph_tick_block(src->graph, out, count);
+            break;
+
+        default:
+            for (uint32_t i = 0; i < count; i++) {
+                out[i] = cv_source_tick(src, 1);
+            }
+            break;
+    }
+}
+
+bool cv_source_is_static(const CVSource *src) {
+    if (!src) return true;
+
+    switch (src->type) {
+        case CV_SOURCE_MANUAL:
+            return true;
+
+        case CV_SOURCE_ENVELOPE:
+            return src->envelope.state == ENV_IDLE ||
+                   src->envelope.state == ENV_SUSTAIN;
+
+        case CV_SOURCE_WAVETABLE:
+            return !src->wavetable.samples || src->wavetable.length == 0;
+
+        case CV_SOURCE_RAMP:
+            return src->ramp.elapsed_ms > src->ramp.duration_ms;
+
+        case CV_SOURCE_STREAM:
+            return src->stream.count == 0;
+
+        case CV_SOURCE_FILE:
+            return src->file.done;
+
+        case CV_SOURCE_GRAPH:
+            return cv_graph_is_static(src->graph);
+
+        default:
+            return false;
+    }
+}
+
+// Lookahead block size (stack buffer)
+#define CV_LOOKAHEAD_BLOCK 256
+
+uint32_t cv_source_quiet_ticks(const CVSource *src, uint8_t lo, uint8_t hi,
+                               uint32_t max_ticks) {
+    if (!src || cv_source_is_static(src)) return max_ticks;
+
+    // A graph's state lives behind its pointer: a copy would share it
+    if (src->type == CV_SOURCE_GRAPH) return 0;
+
+    // Everything else keeps its state in the struct and only reads its
+    // buffers, so a copy runs ahead without touching the source
+    CVSource copy = *src;
+    uint8_t out[CV_LOOKAHEAD_BLOCK];
+    uint32_t done = 0;
+    while (done < max_ticks) {
+        uint32_t n = max_ticks - done;
+        if (n > CV_LOOKAHEAD_BLOCK) n = CV_LOOKAHEAD_BLOCK;
+        cv_source_tick_block(&copy, out, n);
+        for (uint32_t i = 0; i < n; i++) {
+            if (out[i] < lo || out[i] > hi) return done + i;
+        }
+        done += n;
+    }
+    return max_ticks;
+}
+
+void cv_source_advance(CVSource *src, uint32_t count) {
+    if (!src || count == 0) return;
+
+    if (cv_source_is_static(src)) {
+        cv_source_tick(src, count);
+        return;
+    }
+    uint8_t out[CV_LOOKAHEAD_BLOCK];
+    while (count > 0) {
+        uint32_t n = (count > CV_LOOKAHEAD_BLOCK) ? CV_LOOKAHEAD_BLOCK : count;
+        cv_source_tick_block(src, out, n);
+        count -= n;
+    }
+}
+
 void cv_source_gate_on(CVSource *src) {
+    if (src && src->type == CV_SOURCE_GRAPH) {
+        cv_graph_gate(src->graph, true);
+        return;
+    }
     if (!src || src->type != CV_SOURCE_ENVELOPE) return;
     envelope_gate_on_internal(&src->envelope, src->time_ms);
 }
 
 void cv_source_gate_off(CVSource *src) {
+    if (src && src->type == CV_SOURCE_GRAPH) {
+        cv_graph_gate(src->graph, false);
+        return;
+    }
     if (!src || src->type != CV_SOURCE_ENVELOPE) return;
     envelope_gate_off_internal(&src->envelope, src->time_ms);
 }
 
 void cv_source_trigger(CVSource *src) {
+    if (src && src->type == CV_SOURCE_GRAPH) {
+        cv_graph_trigger(src->graph);
+        return;
+    }
     if (!src || src->type != CV_SOURCE_ENVELOPE) return;
     envelope_gate_on_internal(&src->envelope, src->time_ms);
     // For trigger mode, we don't immediately gate off -
@@ -350,15 +811,25 @@ void cv_source_reset_phase(CVSource *src) {
 
     switch (src->type) {
         case CV_SOURCE_LFO:
-            src->lfo.phase = 0.0f;
+            src->lfo.phase = 0;
             break;
         case CV_SOURCE_WAVETABLE:
-            src->wavetable.position = 0.0f;
+            src->wavetable.phase = 0;
             break;
         case CV_SOURCE_ENVELOPE:
             src->envelope.state = ENV_IDLE;
             src->envelope.level = 0;
             break;
+        case CV_SOURCE_RAMP:
+            src->ramp.elapsed_ms = 0;
+            break;
+        case CV_SOURCE_FILE:
+            src->file.pos = 0;
+            src->file.done = false;
+            break;
+        case CV_SOURCE_GRAPH:
+            cv_graph_reset_phase(src->graph);
+            break;
         default:
             break;
     }
@@ -371,7 +842,7 @@ CVSourceType cv_source_get_type(const CVSource *src) {
 
 float cv_source_get_lfo_phase(const CVSource *src) {
     if (!src || src->type != CV_SOURCE_LFO) return 0.0f;
-    return src->lfo.phase;
+    return (float)src->lfo.phase / 4294967296.0f;
 }
 
 EnvelopeState cv_source_get_envelope_state(const CVSource *src) {
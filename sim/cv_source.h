@@ -1,15 +1,24 @@
 #ifndef GK_SIM_CV_SOURCE_H
 #define GK_SIM_CV_SOURCE_H
 
+#include "cv_file.h"
 #include <stdint.h>
 #include <stdbool.h>
+#include <stddef.h>
 
 /**
  * @file cv_source.h
  * @brief CV signal generators for simulator
  *
- * Provides LFO, envelope, wavetable, and manual CV sources.
+ * Provides LFO, envelope, wavetable, ramp, stream, file, and manual CV sources,
+ * and modulation graphs combining them (cv_graph.h).
  * The simulator owns timing - frontends send parameters, sim generates samples.
+ *
+ * Periodic sources are direct digital synthesis: a 32-bit phase accumulator
+ * (2^32 = one cycle) advanced by a fixed increment per millisecond, read
+ * through an interpolated lookup table. There is no float math per sample
+ * and no shared state: sample-and-hold draws from a per-source xorshift
+ * generator, so output is deterministic for a given seed.
  */
 
 // LFO waveform shapes
@@ -37,6 +46,10 @@ typedef enum {
     CV_SOURCE_LFO,
     CV_SOURCE_ENVELOPE,
     CV_SOURCE_WAVETABLE,
+    CV_SOURCE_RAMP,
+    CV_SOURCE_STREAM,
+    CV_SOURCE_FILE,
+    CV_SOURCE_GRAPH,
     CV_SOURCE_COUNT
 } CVSourceType;
 
@@ -47,8 +60,9 @@ typedef struct {
     uint8_t min_val;        // Output minimum (0-255)
     uint8_t max_val;        // Output maximum (0-255)
     // Internal state
-    float phase;            // 0.0 - 1.0
-    float random_value;     // For sample-and-hold
+    uint32_t phase;         // Phase accumulator (2^32 = one cycle)
+    uint32_t phase_inc;     // Phase advance per ms
+    uint16_t random_value;  // For sample-and-hold (0-65535)
 } LFOParams;
 
 // ADSR envelope parameters
@@ -73,26 +87,79 @@ typedef struct {
     uint16_t length;        // Number of samples
     float freq_hz;          // Playback rate
     // Internal state
-    float position;         // Current position (fractional)
+    uint32_t phase;         // Phase accumulator (2^32 = one pass over the table)
+    uint32_t phase_inc;     // Phase advance per ms
 } WavetableParams;
 
+// Linear ramp parameters (holds the end value when done)
+typedef struct {
+    uint8_t from_val;
+    uint8_t to_val;
+    uint32_t duration_ms;
+    // Internal state
+    uint32_t elapsed_ms;
+} RampParams;
+
+// Externally generated samples (ring buffer fed by cv_source_stream_push)
+#define CV_STREAM_CAPACITY 65536    // Samples buffered (power of two)
+
+typedef struct {
+    uint8_t *samples;       // Ring buffer, CV_STREAM_CAPACITY bytes
+    uint32_t rate_hz;       // Sample rate of the pushed data
+    uint32_t head;          // Next sample to play
+    uint32_t count;         // Samples buffered
+    uint32_t phase;         // Fractional sample position (units of 1/1000)
+    uint8_t value;          // Last played sample (held on underrun)
+    // Statistics
+    uint32_t underruns;     // Ticks that ran out of samples
+    uint32_t overflows;     // Samples dropped because the buffer was full
+} StreamParams;
+
+// Recorded file playback (mapped, see cv_file.h)
+typedef struct {
+    CVFile file;
+    bool loop;
+    // Internal state
+    uint64_t pos;           // Position in frames (32.32 fixed point)
+    uint64_t step;          // Frames per ms (32.32 fixed point)
+    bool done;              // Played to the end (not looping)
+    uint8_t value;          // Last output (held when done)
+} FileParams;
+
+struct CVGraph;
+
 // Main CV source struct
 typedef struct {
     CVSourceType type;
     uint32_t time_ms;       // Internal accumulated time for timing
+    uint32_t rng;           // xorshift32 state (kept across reconfiguration)
     union {
         uint8_t manual_value;
         LFOParams lfo;
         EnvelopeParams envelope;
         WavetableParams wavetable;
+        RampParams ramp;
+        StreamParams stream;
+        FileParams file;
+        struct CVGraph *graph;  // Owned, see cv_graph.h
     };
 } CVSource;
 
+// Random generator seed set by cv_source_init
+#define CV_SOURCE_DEFAULT_SEED 0x2545F491u
+
 /**
  * Initialize CV source to manual mode with value 0.
  */
 void cv_source_init(CVSource *src);
 
+/**
+ * Seed the source's random generator (sample-and-hold LFO).
+ * Give each instance its own seed for independent random sequences.
+ * @param seed  Any value (0 is replaced by CV_SOURCE_DEFAULT_SEED)
+ */
+void cv_source_seed(CVSource *src, uint32_t seed);
+
 /**
  * Clean up resources (frees wavetable buffer if allocated).
  */
@@ -133,6 +200,52 @@ void cv_source_set_envelope(CVSource *src, uint16_t attack_ms, uint16_t decay_ms
 bool cv_source_set_wavetable(CVSource *src, const uint8_t *samples,
                              uint16_t length, float freq_hz);
 
+/**
+ * Configure linear ramp source.
+ * Outputs from_val on the first tick, reaches to_val after duration_ms
+ * and holds it.
+ * @param from_val     Start value (0-255)
+ * @param to_val       End value (0-255)
+ * @param duration_ms  Ramp time in milliseconds (0 = jump to to_val)
+ */
+void cv_source_set_ramp(CVSource *src, uint8_t from_val, uint8_t to_val,
+                        uint32_t duration_ms);
+
+/**
+ * Queue externally generated samples, switching to the stream source.
+ * Samples are played at rate_hz; each tick outputs the latest sample due,
+ * like an ADC sampling the signal once per millisecond. When the buffer
+ * runs dry the last value is held.
+ * @param rate_hz  Sample rate (1 - 1000000 Hz)
+ * @param samples  Sample data (copied)
+ * @param count    Number of samples
+ * @return Number of samples queued (less than count if the buffer is full),
+ *         or -1 if the buffer couldn't be allocated
+ */
+int cv_source_stream_push(CVSource *src, uint32_t rate_hz,
+                          const uint8_t *samples, uint32_t count);
+
+/**
+ * Play a recorded file (WAV or raw 8/16-bit), switching to the file source.
+ * The file is mapped, not copied, and resampled to the 1ms tick: rates
+ * below 1kHz are linearly interpolated, higher rates are averaged over
+ * each tick so content above the tick rate doesn't alias.
+ * @param config   File, format and looping
+ * @param err      Receives a message on failure
+ * @param err_len  Size of err
+ * @return true on success; on failure the current source is unchanged
+ */
+bool cv_source_set_file(CVSource *src, const CVFileConfig *config,
+                        char *err, size_t err_len);
+
+/**
+ * Drive the output from a modulation graph, switching to the graph source.
+ * Gate, trigger and phase reset are forwarded to the graph's sources.
+ * @param graph  Built graph (see cv_graph_build); the source takes
+ *               ownership and destroys it when reconfigured
+ */
+void cv_source_set_graph(CVSource *src, struct CVGraph *graph);
+
 /**
  * Process one tick and return current CV value.
  * @param delta_ms  Time elapsed since last tick (typically 1ms)
@@ -140,6 +253,42 @@ bool cv_source_set_wavetable(CVSource *src, const uint8_t *samples,
  */
 uint8_t cv_source_tick(CVSource *src, uint32_t delta_ms);
 
+/**
+ * Process count 1ms ticks, writing each tick's value to out.
+ * Same output and end state as count calls to cv_source_tick(src, 1);
+ * LFO and wavetable sources use a branch-free loop per shape that the
+ * compiler can vectorize.
+ * @param out    Receives count values
+ * @param count  Number of ticks
+ */
+void cv_source_tick_block(CVSource *src, uint8_t *out, uint32_t count);
+
+/**
+ * Check if the source output is constant until reconfigured.
+ * Manual values, idle or sustained envelopes, finished ramps, empty
+ * streams and files played to the end are static; LFOs and wavetables
+ * change over time.
+ */
+bool cv_source_is_static(const CVSource *src);
+
+/**
+ * Count the 1ms ticks, from the next one on, whose values stay within
+ * [lo, hi]. Runs a copy of the source ahead, so the source is unchanged.
+ * Graph sources can't be copied and count as leaving at once (0) unless
+ * static.
+ * @param max_ticks  Most ticks to look at
+ * @return Ticks before the first value outside the range, or max_ticks
+ */
+uint32_t cv_source_quiet_ticks(const CVSource *src, uint8_t lo, uint8_t hi,
+                               uint32_t max_ticks);
+
+/**
+ * Advance count 1ms ticks without looking at their values: static
+ * sources in one step, others with the same end state as count calls to
+ * cv_source_tick(src, 1).
+ */
+void cv_source_advance(CVSource *src, uint32_t count);
+
 /**
  * Envelope gate on (start attack phase).
  * Only affects envelope source type.
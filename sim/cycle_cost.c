@@ -0,0 +1,201 @@
+#include "cycle_cost.h"
+#include <stdlib.h>
+#include <string.h>
+
+/**
+ * @file cycle_cost.c
+ * @brief AVR cycle accounting
+ */
+
+static const char *op_names[CYCLE_OP_COUNT] = {
+    "adc", "neopixel", "neopixel_latch", "eeprom_read", "eeprom_write",
+    "pin", "millis", "wdt"
+};
+
+static const char *phase_names[CYCLE_PHASE_COUNT] = {
+    "loop", "coordinator", "led_feedback", "output"
+};
+
+void cycle_cost_defaults(CycleCostConfig *config) {
+    memset(config, 0, sizeof(*config));
+    config->op[CYCLE_OP_ADC]            = 830;      // 13 x 64 + setup
+    config->op[CYCLE_OP_NEOPIXEL]       = 960;      // 48 bits, loop overhead
+    config->op[CYCLE_OP_NEOPIXEL_LATCH] = 480;      // 60 us
+    config->op[CYCLE_OP_EEPROM_READ]    = 20;
+    config->op[CYCLE_OP_EEPROM_WRITE]   = 27200;    // 3.4 ms
+    config->op[CYCLE_OP_PIN]            = 10;       // Indirect call + sbi/cbi
+    config->op[CYCLE_OP_MILLIS]         = 20;       // cli, 4-byte copy, restore
+    config->op[CYCLE_OP_WDT_RESET]      = 6;
+}
+
+static int bucket_for(uint32_t cycles) {
+    int b = 0;
+    while (cycles && b < CYCLE_HIST_BUCKETS - 1) {
+        cycles >>= 1;
+        b++;
+    }
+    return b;
+}
+
+static void record(CyclePhaseStats *st, uint32_t cycles) {
+    st->passes++;
+    st->cycles += cycles;
+    if (cycles > st->max_cycles) {
+        st->max_cycles = cycles;
+    }
+    st->hist[bucket_for(cycles)]++;
+}
+
+void cycle_account_init(CycleAccount *acct, const CycleCostConfig *config) {
+    memset(acct, 0, sizeof(*acct));
+    if (config) {
+        acct->config = *config;
+    } else {
+        cycle_cost_defaults(&acct->config);
+    }
+    acct->enabled = true;
+}
+
+void cycle_account_begin_pass(CycleAccount *acct) {
+    if (!acct->enabled) return;
+    memset(acct->pass_phase, 0, sizeof(acct->pass_phase));
+    acct->in_pass = true;
+    cycle_account_phase(acct, CYCLE_PHASE_LOOP);
+}
+
+void cycle_account_phase(CycleAccount *acct, CyclePhase phase) {
+    if (!acct->in_pass) return;
+    acct->phase = phase;
+    acct->pass_phase[phase] += acct->config.phase[phase];
+}
+
+uint8_t cycle_account_end_pass(CycleAccount *acct, uint32_t now_ms, uint32_t *cycles) {
+    if (!acct->in_pass) {
+        if (cycles) *cycles = 0;
+        return 0;
+    }
+    acct->in_pass = false;
+
+    uint32_t sum = 0;
+    for (int p = 0; p < CYCLE_PHASE_COUNT; p++) {
+        record(&acct->phases[p], acct->pass_phase[p]);
+        sum += acct->pass_phase[p];
+    }
+    if (sum > acct->total.max_cycles) {
+        acct->worst_time_ms = now_ms;
+    }
+    record(&acct->total, sum);
+    if (cycles) *cycles = sum;
+
+    uint8_t flags = 0;
+    if (acct->config.budget_us && CYCLE_US(sum) > acct->config.budget_us) {
+        flags |= CYCLE_FLAG_BUDGET;
+        acct->over_budget++;
+    }
+    if (sum > CYCLE_WATCHDOG_CYCLES) {
+        flags |= CYCLE_FLAG_WATCHDOG;
+        acct->over_watchdog++;
+    }
+    return flags;
+}
+
+static void print_histogram(const CyclePhaseStats *st, FILE *out) {
+    for (int b = 0; b < CYCLE_HIST_BUCKETS; b++) {
+        if (!st->hist[b]) continue;
+        if (b == 0) {
+            fprintf(out, "      %9s            0 : %lu\n", "", (unsigned long)st->hist[b]);
+        } else {
+            fprintf(out, "      [%9lu, %9lu) : %lu\n",
+                    (unsigned long)(1ul << (b - 1)), (unsigned long)(1ul << b),
+                    (unsigned long)st->hist[b]);
+        }
+    }
+}
+
+void cycle_account_report(const CycleAccount *acct, FILE *out) {
+    const CyclePhaseStats *t = &acct->total;
+    if (!acct->enabled || t->passes == 0) return;
+
+    fprintf(out, "Loop cycles: %lu passes, mean %lu, worst %lu (%lu us at %lu ms)\n",
+            (unsigned long)t->passes, (unsigned long)(t->cycles / t->passes),
+            (unsigned long)t->max_cycles, (unsigned long)CYCLE_US(t->max_cycles),
+            (unsigned long)acct->worst_time_ms);
+    if (acct->config.budget_us) {
+        fprintf(out, "  Over %lu us budget: %lu passes\n",
+                (unsigned long)acct->config.budget_us, (unsigned long)acct->over_budget);
+    }
+    if (acct->over_watchdog) {
+        fprintf(out, "  Over watchdog timeout: %lu passes\n", (unsigned long)acct->over_watchdog);
+    }
+
+    for (int p = 0; p < CYCLE_PHASE_COUNT; p++) {
+        const CyclePhaseStats *st = &acct->phases[p];
+        fprintf(out, "  %-13s mean %7lu, worst %7lu cycles\n", phase_names[p],
+                (unsigned long)(st->cycles / st->passes), (unsigned long)st->max_cycles);
+        print_histogram(st, out);
+    }
+}
+
+const char* cycle_phase_name(CyclePhase phase) {
+    if (phase >= CYCLE_PHASE_COUNT) return "unknown";
+    return phase_names[phase];
+}
+
+// =============================================================================
+// Spec Parsing
+// =============================================================================
+
+static int find_name(const char *const *names, int count, const char *key) {
+    for (int i = 0; i < count; i++) {
+        if (strcmp(names[i], key) == 0) return i;
+    }
+    return -1;
+}
+
+bool cycle_cost_parse(const char *spec, CycleCostConfig *config, char *err, size_t err_len) {
+    char buf[256];
+    if (strlen(spec) >= sizeof(buf)) {
+        snprintf(err, err_len, "cycle spec too long");
+        return false;
+    }
+    strcpy(buf, spec);
+
+    char *save = NULL;
+    for (char *item = strtok_r(buf, ",", &save); item; item = strtok_r(NULL, ",", &save)) {
+        char *value = strchr(item, '=');
+        if (value) *value++ = '\0';
+
+        if (strcmp(item, "avr") == 0 && !value) {
+            cycle_cost_defaults(config);
+            continue;
+        }
+
+        unsigned long v = 0;
+        bool ok = value != NULL;
+        if (ok) {
+            char *end;
+            v = strtoul(value, &end, 10);
+            ok = end != value && *end == '\0' && v <= 100000000ul;
+        }
+
+        int idx;
+        if (!ok) {
+            // Reported below
+        } else if (strcmp(item, "budget") == 0) {
+            config->budget_us = (uint32_t)v;
+        } else if ((idx = find_name(op_names, CYCLE_OP_COUNT, item)) >= 0) {
+            config->op[idx] = (uint32_t)v;
+        } else if ((idx = find_name(phase_names, CYCLE_PHASE_COUNT, item)) >= 0) {
+            config->phase[idx] = (uint32_t)v;
+        } else {
+            ok = false;
+        }
+
+        if (!ok) {
+            snprintf(err, err_len, "invalid cycle option: %s%s%s", item,
+                     value ? "=" : "", value ? value : "");
+            return false;
+        }
+    }
+    return true;
+}
@@ -0,0 +1,161 @@
+#ifndef GK_SIM_CYCLE_COST_H
+#define GK_SIM_CYCLE_COST_H
+
+#include <stdbool.h>
+#include <stddef.h>
+#include <stdint.h>
+#include <stdio.h>
+
+/**
+ * @file cycle_cost.h
+ * @brief AVR cycle accounting for simulated main-loop passes
+ *
+ * Simulated HAL calls and firmware functions take no host time worth
+ * measuring, so a sim run can't show whether a change pushed the loop
+ * past its budget. With accounting enabled, every HAL call made during
+ * a main-loop pass is charged its cost in target cycles (8 MHz) from a
+ * table, plus an optional fixed cost per firmware phase (an annotation
+ * for the code between HAL calls). At the end of each pass:
+ *
+ * - the pass total is checked against the watchdog timeout and an
+ *   optional latency budget, and over-running passes are flagged;
+ * - each phase's share goes into a log2 histogram.
+ *
+ * Accounting is independent of the microsecond clock (sim_clock.h): it
+ * works in 1 ms steps too and only counts, it never moves time.
+ */
+
+#define CYCLE_CPU_HZ            8000000u
+#define CYCLE_US(cycles)        ((cycles) / (CYCLE_CPU_HZ / 1000000u))
+#define CYCLE_WATCHDOG_CYCLES   (250u * (CYCLE_CPU_HZ / 1000u))    // 250 ms
+
+// Histogram buckets: [2^(i-1), 2^i) cycles, bucket 0 = no cycles
+#define CYCLE_HIST_BUCKETS      26
+
+// Costed HAL operations
+typedef enum {
+    CYCLE_OP_ADC,               // One conversion (13 ADC clocks x 64)
+    CYCLE_OP_NEOPIXEL,          // Flush of both LEDs (interrupts off)
+    CYCLE_OP_NEOPIXEL_LATCH,    // Reset pulse after a flush
+    CYCLE_OP_EEPROM_READ,       // Byte read
+    CYCLE_OP_EEPROM_WRITE,      // Byte write (3.4 ms)
+    CYCLE_OP_PIN,               // Pin set/clear/toggle/read
+    CYCLE_OP_MILLIS,            // Atomic millis() copy
+    CYCLE_OP_WDT_RESET,         // wdr
+    CYCLE_OP_COUNT
+} CycleOp;
+
+// Main-loop phases (mirrors main.c)
+typedef enum {
+    CYCLE_PHASE_LOOP,           // Loop head: watchdog feed, branch
+    CYCLE_PHASE_COORDINATOR,    // coordinator_update()
+    CYCLE_PHASE_LED_FEEDBACK,   // led_feedback_update()
+    CYCLE_PHASE_OUTPUT,         // Output pin update
+    CYCLE_PHASE_COUNT
+} CyclePhase;
+
+/**
+ * Cost table and limits.
+ */
+typedef struct {
+    uint32_t op[CYCLE_OP_COUNT];        // Cycles per HAL call
+    uint32_t phase[CYCLE_PHASE_COUNT];  // Annotated cycles per phase entry
+    uint32_t budget_us;                 // Pass latency budget (0 = none)
+} CycleCostConfig;
+
+typedef struct {
+    uint32_t passes;
+    uint64_t cycles;                    // Total
+    uint32_t max_cycles;                // Worst single pass
+    uint32_t hist[CYCLE_HIST_BUCKETS];
+} CyclePhaseStats;
+
+// Flags returned by cycle_account_end_pass
+#define CYCLE_FLAG_BUDGET       0x01    // Pass exceeded budget_us
+#define CYCLE_FLAG_WATCHDOG     0x02    // Pass exceeded the watchdog timeout
+
+typedef struct {
+    bool enabled;
+    CycleCostConfig config;
+
+    // Current pass
+    bool in_pass;
+    CyclePhase phase;
+    uint32_t pass_phase[CYCLE_PHASE_COUNT];
+
+    // Statistics
+    CyclePhaseStats phases[CYCLE_PHASE_COUNT];
+    CyclePhaseStats total;
+    uint32_t over_budget;               // Passes flagged CYCLE_FLAG_BUDGET
+    uint32_t over_watchdog;             // Passes flagged CYCLE_FLAG_WATCHDOG
+    uint32_t worst_time_ms;             // When the worst pass ran
+} CycleAccount;
+
+/**
+ * Fill config with the default 8 MHz cost table, no annotations and no
+ * budget.
+ */
+void cycle_cost_defaults(CycleCostConfig *config);
+
+/**
+ * Parse a comma-separated spec over the current config, e.g.
+ * "budget=500,coordinator=1200,eeprom_write=27200". Keys: budget=<us>,
+ * the operation names (adc, neopixel, neopixel_latch, eeprom_read,
+ * eeprom_write, pin, millis, wdt) and the phase names (loop, coordinator,
+ * led_feedback, output), all in cycles; "avr" resets to the defaults.
+ * @return false with a message in err on a bad key or value
+ */
+bool cycle_cost_parse(const char *spec, CycleCostConfig *config, char *err, size_t err_len);
+
+/**
+ * Enable accounting with config (NULL: defaults) and clear statistics.
+ */
+void cycle_account_init(CycleAccount *acct, const CycleCostConfig *config);
+
+/**
+ * Start a main-loop pass (in CYCLE_PHASE_LOOP).
+ */
+void cycle_account_begin_pass(CycleAccount *acct);
+
+/**
+ * Enter a phase of the current pass, charging its annotation.
+ */
+void cycle_account_phase(CycleAccount *acct, CyclePhase phase);
+
+/**
+ * Charge cycles to the current phase (no-op outside a pass).
+ */
+static inline void cycle_account_add(CycleAccount *acct, uint32_t cycles) {
+    if (acct->in_pass) {
+        acct->pass_phase[acct->phase] += cycles;
+    }
+}
+
+/**
+ * Charge one HAL operation to the current phase.
+ */
+static inline void cycle_account_charge(CycleAccount *acct, CycleOp op) {
+    if (acct->in_pass) {
+        acct->pass_phase[acct->phase] += acct->config.op[op];
+    }
+}
+
+/**
+ * End the pass: update statistics and check limits.
+ * @param now_ms  Time of the pass (for the worst-pass report)
+ * @param cycles  Receives the pass total (may be NULL)
+ * @return CYCLE_FLAG_* bits for the limits exceeded
+ */
+uint8_t cycle_account_end_pass(CycleAccount *acct, uint32_t now_ms, uint32_t *cycles);
+
+/**
+ * Print totals, flagged passes and per-phase histograms.
+ */
+void cycle_account_report(const CycleAccount *acct, FILE *out);
+
+/**
+ * Get a phase name ("loop", "coordinator", ...).
+ */
+const char* cycle_phase_name(CyclePhase phase);
+
+#endif /* GK_SIM_CYCLE_COST_H */
@@ -0,0 +1,193 @@
+#define _GNU_SOURCE
+#include "hal_stats.h"
+#include <link.h>
+#include <stdlib.h>
+#include <string.h>
+#include <unistd.h>
+
+/**
+ * @file hal_stats.c
+ * @brief HAL call counting implementation
+ */
+
+#define SITE_NAME_LEN 192
+
+static const char *fn_names[HAL_FN_COUNT] = {
+    "init", "set_pin", "clear_pin", "toggle_pin", "read_pin", "init_timer",
+    "millis", "delay_ms", "advance_time", "reset_time",
+    "eeprom_read_byte", "eeprom_write_byte", "eeprom_read_word", "eeprom_write_word",
+    "adc_read", "wdt_enable", "wdt_reset", "wdt_disable"
+};
+
+void hal_stats_init(HalStats *stats) {
+    memset(stats, 0, sizeof(*stats));
+    stats->enabled = true;
+}
+
+void hal_stats_record(HalStats *stats, HalFn fn, const void *site) {
+    if (!stats->enabled || fn >= HAL_FN_COUNT) return;
+    stats->calls[stats->tag][fn]++;
+    stats->tick_calls[fn]++;
+
+    // Open addressing on (site, tag); a site calls one HAL function
+    uintptr_t h = ((uintptr_t)site >> 2) * 2654435761u + stats->tag;
+    for (int probe = 0; probe < HAL_STATS_MAX_SITES; probe++) {
+        HalCallSite *s = &stats->sites[(h + probe) % HAL_STATS_MAX_SITES];
+        if (s->addr == site && s->tag == stats->tag) {
+            s->calls++;
+            return;
+        }
+        if (!s->addr) {
+            *s = (HalCallSite){ .addr = site, .fn = (uint8_t)fn, .tag = stats->tag, .calls = 1 };
+            return;
+        }
+    }
+    stats->sites_dropped++;
+}
+
+void hal_stats_set_tag(HalStats *stats, uint8_t tag) {
+    stats->tag = (tag < HAL_STATS_MAX_TAGS) ? tag : HAL_STATS_MAX_TAGS - 1;
+}
+
+void hal_stats_end_tick(HalStats *stats) {
+    if (!stats->enabled) return;
+    uint32_t total = 0;
+    for (int fn = 0; fn < HAL_FN_COUNT; fn++) {
+        if (stats->tick_calls[fn] > stats->max_tick_calls[fn]) {
+            stats->max_tick_calls[fn] = stats->tick_calls[fn];
+        }
+        total += stats->tick_calls[fn];
+        stats->tick_calls[fn] = 0;
+    }
+    if (total > stats->max_tick_total) {
+        stats->max_tick_total = total;
+    }
+    stats->ticks[stats->tag]++;
+}
+
+uint64_t hal_stats_calls(const HalStats *stats, HalFn fn) {
+    uint64_t total = 0;
+    for (int tag = 0; tag < HAL_STATS_MAX_TAGS; tag++) {
+        total += stats->calls[tag][fn];
+    }
+    return total;
+}
+
+const char* hal_fn_name(HalFn fn) {
+    if (fn >= HAL_FN_COUNT) return "unknown";
+    return fn_names[fn];
+}
+
+// =============================================================================
+// Report
+// =============================================================================
+
+static int compare_sites(const void *a, const void *b) {
+    const HalCallSite *x = *(const HalCallSite *const *)a;
+    const HalCallSite *y = *(const HalCallSite *const *)b;
+    if (x->tag != y->tag) return (int)x->tag - (int)y->tag;
+    return (x->calls < y->calls) - (x->calls > y->calls);
+}
+
+// Load bias of the executable (0 unless position-independent)
+static int find_bias(struct dl_phdr_info *info, size_t size, void *data) {
+    (void)size;
+    *(uintptr_t*)data = info->dlpi_addr;
+    return 1;   // The executable comes first
+}
+
+// "function (file:line)" for each site via addr2line, or the offset
+static void resolve_sites(const HalCallSite **sites, int n, char (*names)[SITE_NAME_LEN]) {
+    uintptr_t bias = 0;
+    dl_iterate_phdr(find_bias, &bias);
+    for (int i = 0; i < n; i++) {
+        // Return address - 1 lies in the call instruction
+        snprintf(names[i], SITE_NAME_LEN, "0x%lx", (unsigned long)((uintptr_t)sites[i]->addr - 1 - bias));
+    }
+
+    char exe[512];
+    ssize_t len = readlink("/proc/self/exe", exe, sizeof(exe) - 1);
+    if (len <= 0 || n == 0) return;
+    exe[len] = '\0';
+
+    size_t cmd_size = 64 + (size_t)len + (size_t)n * 20;
+    char *cmd = malloc(cmd_size);
+    if (!cmd) return;
+    int pos = snprintf(cmd, cmd_size, "addr2line -f -s -e '%s'", exe);
+    for (int i = 0; i < n; i++) {
+        pos += snprintf(cmd + pos, cmd_size - pos, " %s", names[i]);
+    }
+    snprintf(cmd + pos, cmd_size - pos, " 2>/dev/null");
+
+    FILE *p = popen(cmd, "r");
+    free(cmd);
+    if (!p) return;
+    char func[128], line[128];
+    for (int i = 0; i < n && fgets(func, sizeof(func), p) && fgets(line, sizeof(line), p); i++) {
+        func[strcspn(func, "\n")] = '\0';
+        line[strcspn(line, " \n")] = '\0';
+        if (strcmp(func, "??") == 0) continue;
+        if (strncmp(line, "??", 2) == 0) {
+            snprintf(names[i], SITE_NAME_LEN, "%.120s", func);
+        } else {
+            snprintf(names[i], SITE_NAME_LEN, "%.60s (%.120s)", func, line);
+        }
+    }
+    pclose(p);
+}
+
+void hal_stats_report(const HalStats *stats, const char *const *tag_names, int num_tags,
+                      int top, FILE *out) {
+    if (!stats->enabled) return;
+    if (num_tags > HAL_STATS_MAX_TAGS) num_tags = HAL_STATS_MAX_TAGS;
+
+    uint32_t ticks = 0;
+    for (int tag = 0; tag < HAL_STATS_MAX_TAGS; tag++) {
+        ticks += stats->ticks[tag];
+    }
+    fprintf(out, "HAL calls: %lu ticks, worst tick %lu calls\n", (unsigned long)ticks,
+            (unsigned long)stats->max_tick_total);
+    fprintf(out, "  %-18s %10s %9s %9s\n", "function", "calls", "per tick", "max tick");
+    for (int fn = 0; fn < HAL_FN_COUNT; fn++) {
+        uint64_t calls = hal_stats_calls(stats, (HalFn)fn);
+        if (!calls) continue;
+        fprintf(out, "  %-18s %10llu %9.2f %9lu\n", fn_names[fn], (unsigned long long)calls,
+                ticks ? (double)calls / ticks : 0.0, (unsigned long)stats->max_tick_calls[fn]);
+    }
+
+    // Sites grouped by tag, busiest first
+    const HalCallSite *sorted[HAL_STATS_MAX_SITES];
+    int n = 0;
+    for (int i = 0; i < HAL_STATS_MAX_SITES; i++) {
+        if (stats->sites[i].addr) sorted[n++] = &stats->sites[i];
+    }
+    qsort(sorted, n, sizeof(sorted[0]), compare_sites);
+
+    const HalCallSite *shown[HAL_STATS_MAX_SITES];
+    int num_shown = 0;
+    for (int i = 0, rank = 0; i < n; i++) {
+        rank = (i > 0 && sorted[i]->tag == sorted[i - 1]->tag) ? rank + 1 : 0;
+        if (rank < top) shown[num_shown++] = sorted[i];
+    }
+    char (*names)[SITE_NAME_LEN] = calloc(num_shown ? num_shown : 1, SITE_NAME_LEN);
+    if (!names) return;
+    resolve_sites(shown, num_shown, names);
+
+    for (int i = 0; i < num_shown; i++) {
+        const HalCallSite *s = shown[i];
+        if (i == 0 || s->tag != shown[i - 1]->tag) {
+            uint32_t tag_ticks = stats->ticks[s->tag];
+            const char *name = (s->tag < num_tags) ? tag_names[s->tag] : "other";
+            fprintf(out, "Top HAL call sites, %s (%lu ticks):\n", name, (unsigned long)tag_ticks);
+            fprintf(out, "  %9s %9s  %-18s %s\n", "calls", "per tick", "function", "site");
+        }
+        uint32_t tag_ticks = stats->ticks[s->tag];
+        fprintf(out, "  %9lu %9.2f  %-18s %s\n", (unsigned long)s->calls,
+                tag_ticks ? (double)s->calls / tag_ticks : 0.0, fn_names[s->fn], names[i]);
+    }
+    if (stats->sites_dropped) {
+        fprintf(out, "  (%lu calls from sites past the %d-entry table)\n",
+                (unsigned long)stats->sites_dropped, HAL_STATS_MAX_SITES);
+    }
+    free(names);
+}
@@ -0,0 +1,124 @@
+#ifndef GK_SIM_HAL_STATS_H
+#define GK_SIM_HAL_STATS_H
+
+#include <stdbool.h>
+#include <stdint.h>
+#include <stdio.h>
+
+/**
+ * @file hal_stats.h
+ * @brief HAL call counting for host builds (mock and simulator HAL)
+ *
+ * Every call through p_hal costs an indirect call on the AVR, and some
+ * of them a lot more (millis() disables interrupts, adc_read() waits
+ * for a conversion). Host HAL implementations record each call here,
+ * keyed by HAL function and by call site (the return address in the
+ * application code), under a tag chosen by the caller, usually the
+ * current mode. Counts are also kept per tick (one main-loop pass, ended
+ * with hal_stats_end_tick) to give calls per tick and the worst tick.
+ *
+ * Host only: shared by the simulator and the mock HAL (unit tests,
+ * benchmarks, fuzz target), never built into the firmware.
+ *
+ * Call sites are return addresses, so a HAL call in tail position that
+ * the compiler turns into a sibling call (a jump) is charged to the
+ * caller's caller. Targets that report sites build the application with
+ * -fno-optimize-sibling-calls (the simulator builds at -O0), and with -g
+ * so that sites resolve to file and line.
+ */
+
+/**
+ * HAL functions (one per HalInterface entry point).
+ */
+typedef enum {
+    HAL_FN_INIT,
+    HAL_FN_SET_PIN,
+    HAL_FN_CLEAR_PIN,
+    HAL_FN_TOGGLE_PIN,
+    HAL_FN_READ_PIN,
+    HAL_FN_INIT_TIMER,
+    HAL_FN_MILLIS,
+    HAL_FN_DELAY_MS,
+    HAL_FN_ADVANCE_TIME,
+    HAL_FN_RESET_TIME,
+    HAL_FN_EEPROM_READ_BYTE,
+    HAL_FN_EEPROM_WRITE_BYTE,
+    HAL_FN_EEPROM_READ_WORD,
+    HAL_FN_EEPROM_WRITE_WORD,
+    HAL_FN_ADC_READ,
+    HAL_FN_WDT_ENABLE,
+    HAL_FN_WDT_RESET,
+    HAL_FN_WDT_DISABLE,
+    HAL_FN_COUNT
+} HalFn;
+
+#define HAL_STATS_MAX_TAGS      8
+#define HAL_STATS_MAX_SITES     256     // Distinct (call site, tag) pairs
+
+// Call site of the enclosing HAL function (use directly in its body)
+#define HAL_STATS_CALLER() __builtin_extract_return_addr(__builtin_return_address(0))
+
+typedef struct {
+    const void *addr;                   // Return address (NULL: free slot)
+    uint8_t fn;                         // HalFn
+    uint8_t tag;
+    uint32_t calls;
+} HalCallSite;
+
+typedef struct {
+    bool enabled;
+    uint8_t tag;                        // Tag for calls and ticks
+
+    uint64_t calls[HAL_STATS_MAX_TAGS][HAL_FN_COUNT];
+    uint32_t ticks[HAL_STATS_MAX_TAGS];
+
+    // Per tick
+    uint32_t tick_calls[HAL_FN_COUNT];  // Current tick
+    uint32_t max_tick_calls[HAL_FN_COUNT];
+    uint32_t max_tick_total;            // Worst tick, all functions
+
+    HalCallSite sites[HAL_STATS_MAX_SITES];
+    uint32_t sites_dropped;             // Calls from sites past the table
+} HalStats;
+
+/**
+ * Clear statistics and enable recording.
+ */
+void hal_stats_init(HalStats *stats);
+
+/**
+ * Record one call of fn from site (HAL_STATS_CALLER()).
+ */
+void hal_stats_record(HalStats *stats, HalFn fn, const void *site);
+
+/**
+ * Set the tag for following calls and ticks (0 - HAL_STATS_MAX_TAGS-1).
+ */
+void hal_stats_set_tag(HalStats *stats, uint8_t tag);
+
+/**
+ * End a tick: update per-tick maxima and count the tick for the tag.
+ */
+void hal_stats_end_tick(HalStats *stats);
+
+/**
+ * Get total calls of fn over all tags.
+ */
+uint64_t hal_stats_calls(const HalStats *stats, HalFn fn);
+
+/**
+ * Print calls per function (total, per tick, worst tick), then the top
+ * call sites of each tag. Sites are resolved to function and line with
+ * addr2line when it is installed (build with -g for line numbers).
+ * @param tag_names  Names of tags 0..num_tags-1
+ * @param top        Call sites listed per tag
+ */
+void hal_stats_report(const HalStats *stats, const char *const *tag_names, int num_tags,
+                      int top, FILE *out);
+
+/**
+ * Get a HAL function name ("millis", "read_pin", ...).
+ */
+const char* hal_fn_name(HalFn fn);
+
+#endif /* GK_SIM_HAL_STATS_H */
@@ -1,24 +1,27 @@
 #include "input_source.h"
 #include "sim_hal.h"
 #include "cv_source.h"
+#include "trace.h"
 #include <stdio.h>
 #include <stdlib.h>
 #include <string.h>
+#include <strings.h>
 #include <stdarg.h>
 #include <ctype.h>
 #include <termios.h>
 #include <unistd.h>
 #include <sys/select.h>
 
-// Simple logging for script mode (outputs to stdout)
-static void script_log(uint32_t time_ms, const char *fmt, ...) {
-    printf("[%8lu ms] ", (unsigned long)time_ms);
+// Simple logging for script mode (stdout unless redirected, NULL = silent)
+static void script_log(FILE *log, uint32_t time_ms, const char *fmt, ...) {
+    if (!log) return;
+    fprintf(log, "[%8lu ms] ", (unsigned long)time_ms);
     va_list args;
     va_start(args, fmt);
-    vprintf(fmt, args);
+    vfprintf(log, fmt, args);
     va_end(args);
-    printf("\n");
-    fflush(stdout);
+    fprintf(log, "\n");
+    fflush(log);
 }
 
 // =============================================================================
@@ -28,7 +31,7 @@ static void script_log(uint32_t time_ms, const char *fmt, ...) {
 // CV voltage step size for +/- keys (in ADC units, ~0.2V per step)
 #define CV_VOLTAGE_STEP 10
 
-// External: Get CV source from sim_main.c
+// External: Get CV source of the bound simulator instance (sim_instance.c)
 extern CVSource* sim_get_cv_source(void);
 
 // LFO preset states for cycling
@@ -40,16 +43,14 @@ typedef enum {
     LFO_PRESET_COUNT
 } LFOPreset;
 
-static LFOPreset current_lfo_preset = LFO_PRESET_OFF;
-
 // Cycle to next LFO preset
-static void cycle_lfo_preset(void) {
+static void cycle_lfo_preset(LFOPreset *preset) {
     CVSource *cv = sim_get_cv_source();
     if (!cv) return;
 
-    current_lfo_preset = (current_lfo_preset + 1) % LFO_PRESET_COUNT;
+    *preset = (*preset + 1) % LFO_PRESET_COUNT;
 
-    switch (current_lfo_preset) {
+    switch (*preset) {
         case LFO_PRESET_OFF:
             cv_source_set_manual(cv, 0);
             break;
@@ -81,6 +82,7 @@ typedef struct {
     bool realtime;
     AutoRelease auto_release_a;
     AutoRelease auto_release_b;
+    LFOPreset lfo_preset;
     SimState *sim_state;  // For UI controls (F/L keys), may be NULL
 } KeyboardCtx;
 
@@ -198,7 +200,7 @@ static bool keyboard_update(InputSource *self, uint32_t current_time_ms) {
 
             case 'l':
                 // Cycle LFO preset
-                cycle_lfo_preset();
+                cycle_lfo_preset(&ctx->lfo_preset);
                 break;
 
             case 'L':
@@ -215,6 +217,16 @@ static bool keyboard_update(InputSource *self, uint32_t current_time_ms) {
     return true;
 }
 
+static void keyboard_observe(InputSource *self, const SimState *state) {
+    (void)self;
+    (void)state;
+}
+
+static uint32_t keyboard_next_event_time(InputSource *self, uint32_t current_time_ms) {
+    (void)self;
+    return current_time_ms + 1;  // Keys can arrive at any time
+}
+
 static bool keyboard_is_realtime(InputSource *self) {
     KeyboardCtx *ctx = (KeyboardCtx*)self->ctx;
     return ctx->realtime;
@@ -256,11 +268,14 @@ InputSource* input_source_keyboard_create(SimState *sim_state) {
     // Initialize auto-release timers
     ctx->auto_release_a.release_time = 0;
     ctx->auto_release_b.release_time = 0;
+    ctx->lfo_preset = LFO_PRESET_OFF;
 
     // Store sim_state for UI controls
     ctx->sim_state = sim_state;
 
     src->update = keyboard_update;
+    src->observe = keyboard_observe;
+    src->next_event_time = keyboard_next_event_time;
     src->is_realtime = keyboard_is_realtime;
     src->has_failed = keyboard_has_failed;
     src->cleanup = keyboard_cleanup;
@@ -278,30 +293,67 @@ typedef enum {
     ACT_RELEASE,
     ACT_ASSERT,
     ACT_QUIT,
-    ACT_LOG
+    ACT_LOG,
+    ACT_CV_SET,             // cv <volts>
+    ACT_CV_RAMP,            // cv_ramp <from_volts> <to_volts> <ms>
+    ACT_CV_FILE,            // cv_file <path> [loop|once] [u8|s16 <rate_hz>]
+    ACT_EXPECT_EDGE,        // expect_edge <target> <rise|fall> within <ms>
+    ACT_EXPECT_WIDTH,       // expect_width <target> <ms> [tol <ms>]
+    ACT_EXPECT_PERIOD       // expect_period <target> <ms> [tol <ms>]
 } ScriptAction;
 
 typedef enum {
     TGT_BUTTON_A,
     TGT_BUTTON_B,
     TGT_CV,
-    TGT_OUTPUT
+    TGT_OUTPUT,
+    TGT_STATE,              // Top-level state (perform/menu)
+    TGT_MODE,
+    TGT_PAGE,
+    TGT_LED_MODE,
+    TGT_LED_ACTIVITY
 } ScriptTarget;
 
 typedef struct {
     uint32_t time_ms;       // Absolute time to execute
     ScriptAction action;
     ScriptTarget target;
-    bool value;             // For assert: expected value
-    char message[128];      // For log action (generous size on x86)
+    bool value;             // For assert: expected value; expect_edge: rising
+    int enum_value;         // For state/mode/page assert
+    uint8_t rgb[3];         // For LED assert
+    uint8_t cv_from;        // For cv/cv_ramp (0-255)
+    uint8_t cv_to;
+    uint32_t duration_ms;   // cv_ramp time, expect_edge window, expected width/period,
+                            // cv_file raw sample rate
+    float tolerance_ms;     // For expect_width/expect_period
+    int line;               // Script line (for messages)
+    char message[128];      // For log action, cv_file path (generous size on x86)
 } ScriptEvent;
 
+// Pending timing expectation, checked after every tick
+typedef struct {
+    const ScriptEvent *evt;
+    uint32_t armed_ms;      // Time the expectation started
+    bool last_level;        // Target level at the previous observation
+    bool marked;            // Width/period: first rising edge seen
+    uint32_t mark_ms;       // Width/period: time of first rising edge
+} ScriptMonitor;
+
+#define SCRIPT_MAX_MONITORS 16
+
 typedef struct {
     ScriptEvent *events;
     int event_count;
     int event_capacity;
     int current_event;
     bool failed;
+    int asserts_passed;
+    int asserts_failed;
+    FILE *log;              // Script log lines
+    FILE *summary;          // Completion summary
+    const SimState *state;  // Last observed state (NULL before start)
+    ScriptMonitor monitors[SCRIPT_MAX_MONITORS];
+    int monitor_count;
 } ScriptCtx;
 
 static bool parse_target(const char *str, ScriptTarget *target) {
@@ -321,9 +373,34 @@ static bool parse_target(const char *str, ScriptTarget *target) {
         *target = TGT_OUTPUT;
         return true;
     }
+    if (strcmp(str, "state") == 0) {
+        *target = TGT_STATE;
+        return true;
+    }
+    if (strcmp(str, "mode") == 0) {
+        *target = TGT_MODE;
+        return true;
+    }
+    if (strcmp(str, "page") == 0) {
+        *target = TGT_PAGE;
+        return true;
+    }
+    if (strcmp(str, "led_mode") == 0) {
+        *target = TGT_LED_MODE;
+        return true;
+    }
+    if (strcmp(str, "led_activity") == 0) {
+        *target = TGT_LED_ACTIVITY;
+        return true;
+    }
     return false;
 }
 
+// Targets with a digital level (press/release, bool assert, edge monitors)
+static bool target_is_digital(ScriptTarget target) {
+    return target <= TGT_OUTPUT;
+}
+
 static bool parse_bool(const char *str, bool *value) {
     if (strcmp(str, "high") == 0 || strcmp(str, "1") == 0 || strcmp(str, "true") == 0) {
         *value = true;
@@ -336,6 +413,65 @@ static bool parse_bool(const char *str, bool *value) {
     return false;
 }
 
+// Match a name against a string table (case-insensitive)
+static bool parse_name(const char *str, const char* (*name_of)(int), int count, int *value) {
+    for (int i = 0; i < count; i++) {
+        if (strcasecmp(str, name_of(i)) == 0) {
+            *value = i;
+            return true;
+        }
+    }
+    return false;
+}
+
+static const char* state_name(int i) { return sim_top_state_str((TopState)i); }
+static const char* mode_name(int i)  { return sim_mode_str((ModeState)i); }
+static const char* page_name(int i)  { return sim_page_str((MenuPage)i); }
+
+// Parse "<r> <g> <b>" or "off"
+static bool parse_rgb(const char *str, uint8_t rgb[3]) {
+    if (strcmp(str, "off") == 0) {
+        rgb[0] = rgb[1] = rgb[2] = 0;
+        return true;
+    }
+    unsigned r, g, b;
+    char extra;
+    if (sscanf(str, "%u %u %u %c", &r, &g, &b, &extra) != 3) return false;
+    if (r > 255 || g > 255 || b > 255) return false;
+    rgb[0] = (uint8_t)r;
+    rgb[1] = (uint8_t)g;
+    rgb[2] = (uint8_t)b;
+    return true;
+}
+
+// Parse volts (0.0 - 5.0) to ADC value
+static bool parse_volts(const char *str, uint8_t *value) {
+    char *end;
+    float volts = strtof(str, &end);
+    if (end == str || volts < 0.0f || volts > 5.0f) return false;
+    *value = (uint8_t)(volts * 255.0f / 5.0f + 0.5f);
+    return true;
+}
+
+// Parse "<ms> [tol <ms>]" for expect_width/expect_period
+static bool parse_timing(const char *str, uint32_t *expected, float *tolerance) {
+    unsigned ms;
+    float tol = 0.0f;
+    char keyword[8];
+    int n = sscanf(str, "%u %7s %f", &ms, keyword, &tol);
+    if (n == 1) {
+        *expected = ms;
+        *tolerance = 0.0f;
+        return true;
+    }
+    if (n == 3 && strcmp(keyword, "tol") == 0 && tol >= 0.0f) {
+        *expected = ms;
+        *tolerance = tol;
+        return true;
+    }
+    return false;
+}
+
 static void script_add_event(ScriptCtx *ctx, ScriptEvent *evt) {
     if (ctx->event_count >= ctx->event_capacity) {
         ctx->event_capacity = ctx->event_capacity ? ctx->event_capacity * 2 : 32;
@@ -408,40 +544,134 @@ static bool parse_script(ScriptCtx *ctx, const char *filename) {
 
         ScriptEvent evt = {0};
         evt.time_ms = current_time;
+        evt.line = line_num;
 
         // Convert to lowercase
         for (char *s = action_str; *s; s++) *s = tolower(*s);
         for (char *s = arg1; *s; s++) *s = tolower(*s);
 
+        // Lowercase copy of arg2 for value parsing (log keeps original case)
+        char arg2_lower[64];
+        strncpy(arg2_lower, arg2, sizeof(arg2_lower) - 1);
+        arg2_lower[sizeof(arg2_lower) - 1] = '\0';
+        for (char *s = arg2_lower; *s; s++) *s = tolower(*s);
+
+        const char *error = NULL;
+
         if (strcmp(action_str, "press") == 0) {
             evt.action = ACT_PRESS;
-            if (!parse_target(arg1, &evt.target)) {
-                fprintf(stderr, "Script error line %d: invalid target '%s'\n", line_num, arg1);
-                fclose(f);
-                return false;
+            if (!parse_target(arg1, &evt.target) || !target_is_digital(evt.target)) {
+                error = "invalid target";
             }
         } else if (strcmp(action_str, "release") == 0) {
             evt.action = ACT_RELEASE;
-            if (!parse_target(arg1, &evt.target)) {
-                fprintf(stderr, "Script error line %d: invalid target '%s'\n", line_num, arg1);
-                fclose(f);
-                return false;
+            if (!parse_target(arg1, &evt.target) || !target_is_digital(evt.target)) {
+                error = "invalid target";
             }
         } else if (strcmp(action_str, "assert") == 0) {
             evt.action = ACT_ASSERT;
             if (!parse_target(arg1, &evt.target)) {
-                fprintf(stderr, "Script error line %d: invalid target '%s'\n", line_num, arg1);
-                fclose(f);
-                return false;
+                error = "invalid target";
+            } else {
+                bool ok;
+                switch (evt.target) {
+                    case TGT_STATE:
+                        ok = parse_name(arg2_lower, state_name, TOP_STATE_COUNT, &evt.enum_value);
+                        break;
+                    case TGT_MODE:
+                        ok = parse_name(arg2_lower, mode_name, MODE_COUNT, &evt.enum_value);
+                        break;
+                    case TGT_PAGE:
+                        ok = parse_name(arg2_lower, page_name, PAGE_COUNT, &evt.enum_value);
+                        break;
+                    case TGT_LED_MODE:
+                    case TGT_LED_ACTIVITY:
+                        ok = parse_rgb(arg2_lower, evt.rgb);
+                        break;
+                    default:
+                        ok = parse_bool(arg2_lower, &evt.value);
+                        break;
+                }
+                if (!ok) error = "invalid value";
             }
-            // For arg2, don't lowercase - parse separately
-            char arg2_lower[64];
-            strncpy(arg2_lower, arg2, sizeof(arg2_lower) - 1);
-            for (char *s = arg2_lower; *s; s++) *s = tolower(*s);
-            if (!parse_bool(arg2_lower, &evt.value)) {
-                fprintf(stderr, "Script error line %d: invalid value '%s'\n", line_num, arg2);
-                fclose(f);
-                return false;
+        } else if (strcmp(action_str, "cv") == 0) {
+            evt.action = ACT_CV_SET;
+            if (!parse_volts(arg1, &evt.cv_to)) {
+                error = "invalid voltage (0-5)";
+            }
+        } else if (strcmp(action_str, "cv_ramp") == 0) {
+            evt.action = ACT_CV_RAMP;
+            char to_str[32];
+            unsigned ms;
+            if (!parse_volts(arg1, &evt.cv_from) ||
+                sscanf(arg2_lower, "%31s %u", to_str, &ms) != 2 ||
+                !parse_volts(to_str, &evt.cv_to)) {
+                error = "expected cv_ramp <from_volts> <to_volts> <ms>";
+            } else {
+                evt.duration_ms = ms;
+            }
+        } else if (strcmp(action_str, "cv_file") == 0) {
+            evt.action = ACT_CV_FILE;
+            // Path keeps its case and may be longer than arg1
+            char opts[64] = "";
+            char fmt_str[16] = "";
+            unsigned rate = 0;
+            evt.value = true;
+            evt.enum_value = CV_FILE_WAV;
+            if (sscanf(p, "%*s %127s %63[^\n]", evt.message, opts) < 1) {
+                error = "expected cv_file <path> [loop|once] [u8|s16 <rate_hz>]";
+            } else {
+                for (char *s = opts; *s; s++) *s = tolower(*s);
+                char *o = opts;
+                char play[8];
+                int used = 0;
+                if (sscanf(o, "%7s%n", play, &used) == 1 &&
+                    (strcmp(play, "loop") == 0 || strcmp(play, "once") == 0)) {
+                    evt.value = (play[0] == 'l');
+                    o += used;
+                }
+                int fields = sscanf(o, "%15s %u", fmt_str, &rate);
+                CVFileFormat format = CV_FILE_WAV;
+                if (fields > 0 &&
+                    (fields != 2 || !cv_file_parse_format(fmt_str, strlen(fmt_str), &format) ||
+                     rate == 0 || rate > CV_FILE_MAX_RATE_HZ)) {
+                    error = "expected cv_file <path> [loop|once] [u8|s16 <rate_hz>]";
+                } else {
+                    evt.enum_value = format;
+                    evt.duration_ms = rate;
+
+                    // Catch a bad file now rather than partway through the run
+                    CVFileConfig config = { .path = evt.message, .format = format, .rate_hz = rate };
+                    CVFile probe;
+                    char err[128];
+                    if (!cv_file_open(&probe, &config, err, sizeof(err))) {
+                        fprintf(stderr, "Script error line %d: %s\n", line_num, err);
+                        fclose(f);
+                        return false;
+                    }
+                    cv_file_close(&probe);
+                }
+            }
+        } else if (strcmp(action_str, "expect_edge") == 0) {
+            evt.action = ACT_EXPECT_EDGE;
+            char dir[16];
+            unsigned ms;
+            if (!parse_target(arg1, &evt.target) || !target_is_digital(evt.target)) {
+                error = "invalid target";
+            } else if (sscanf(arg2_lower, "%15s within %u", dir, &ms) != 2 ||
+                       (strcmp(dir, "rise") != 0 && strcmp(dir, "fall") != 0)) {
+                error = "expected expect_edge <target> <rise|fall> within <ms>";
+            } else {
+                evt.value = (strcmp(dir, "rise") == 0);
+                evt.duration_ms = ms;
+            }
+        } else if (strcmp(action_str, "expect_width") == 0 ||
+                   strcmp(action_str, "expect_period") == 0) {
+            evt.action = (action_str[7] == 'w') ? ACT_EXPECT_WIDTH : ACT_EXPECT_PERIOD;
+            if (!parse_target(arg1, &evt.target) || !target_is_digital(evt.target)) {
+                error = "invalid target";
+            } else if (!parse_timing(arg2_lower, &evt.duration_ms, &evt.tolerance_ms)) {
+                error = "expected <target> <ms> [tol <ms>]";
             }
         } else if (strcmp(action_str, "log") == 0) {
             evt.action = ACT_LOG;
@@ -455,6 +685,12 @@ static bool parse_script(ScriptCtx *ctx, const char *filename) {
             return false;
         }
 
+        if (error) {
+            fprintf(stderr, "Script error line %d: %s '%s %s'\n", line_num, error, arg1, arg2);
+            fclose(f);
+            return false;
+        }
+
         script_add_event(ctx, &evt);
     }
 
@@ -462,6 +698,231 @@ static bool parse_script(ScriptCtx *ctx, const char *filename) {
     return true;
 }
 
+static const char* target_name(ScriptTarget target) {
+    switch (target) {
+        case TGT_BUTTON_A:      return "Button A";
+        case TGT_BUTTON_B:      return "Button B";
+        case TGT_CV:            return "CV";
+        case TGT_OUTPUT:        return "Output";
+        case TGT_STATE:         return "State";
+        case TGT_MODE:          return "Mode";
+        case TGT_PAGE:          return "Page";
+        case TGT_LED_MODE:      return "Mode LED";
+        case TGT_LED_ACTIVITY:  return "Activity LED";
+        default:                return "Unknown";
+    }
+}
+
+// Digital level of a target in observed state
+static bool target_level(const SimState *state, ScriptTarget target) {
+    switch (target) {
+        case TGT_BUTTON_A:  return state->button_a;
+        case TGT_BUTTON_B:  return state->button_b;
+        case TGT_CV:        return state->cv_in;
+        case TGT_OUTPUT:    return state->signal_out;
+        default:            return false;
+    }
+}
+
+static void script_result(ScriptCtx *ctx, bool ok, const char *fmt, ...) {
+    if (ok) {
+        ctx->asserts_passed++;
+    } else {
+        ctx->asserts_failed++;
+        ctx->failed = true;
+    }
+
+    if (!ctx->log) return;
+    char msg[192];
+    va_list args;
+    va_start(args, fmt);
+    vsnprintf(msg, sizeof(msg), fmt, args);
+    va_end(args);
+    script_log(ctx->log, sim_get_time(), "%s", msg);
+}
+
+// Point-in-time assertion (state as of the previous tick)
+static void script_assert(ScriptCtx *ctx, const ScriptEvent *evt) {
+    const char *name = target_name(evt->target);
+
+    if (target_is_digital(evt->target)) {
+        bool actual = false;
+        switch (evt->target) {
+            case TGT_OUTPUT:
+                actual = sim_get_output();
+                break;
+            case TGT_BUTTON_A:
+                actual = sim_get_button_a();
+                break;
+            case TGT_BUTTON_B:
+                actual = sim_get_button_b();
+                break;
+            default:
+                actual = ctx->state ? ctx->state->cv_in : false;
+                break;
+        }
+        if (actual != evt->value) {
+            script_result(ctx, false, "ASSERT FAILED: %s expected %s, got %s",
+                          name,
+                          evt->value ? "HIGH" : "LOW",
+                          actual ? "HIGH" : "LOW");
+        } else {
+            script_result(ctx, true, "ASSERT OK: %s is %s", name, actual ? "HIGH" : "LOW");
+        }
+        return;
+    }
+
+    const SimState *state = ctx->state;
+    if (!state) {
+        script_result(ctx, false, "ASSERT FAILED: %s not observed yet", name);
+        return;
+    }
+
+    const char *expected = NULL;
+    const char *actual = NULL;
+    switch (evt->target) {
+        case TGT_STATE:
+            expected = sim_top_state_str((TopState)evt->enum_value);
+            actual = sim_top_state_str(state->top_state);
+            break;
+        case TGT_MODE:
+            expected = sim_mode_str((ModeState)evt->enum_value);
+            actual = sim_mode_str(state->mode);
+            break;
+        case TGT_PAGE:
+            expected = sim_page_str((MenuPage)evt->enum_value);
+            actual = state->in_menu ? sim_page_str(state->page) : "(not in menu)";
+            break;
+        case TGT_LED_MODE:
+        case TGT_LED_ACTIVITY: {
+            const SimLED *led = &state->leds[evt->target == TGT_LED_MODE ? 0 : 1];
+            bool match = led->r == evt->rgb[0] && led->g == evt->rgb[1] && led->b == evt->rgb[2];
+            if (match) {
+                script_result(ctx, true, "ASSERT OK: %s is %u %u %u",
+                              name, led->r, led->g, led->b);
+            } else {
+                script_result(ctx, false, "ASSERT FAILED: %s expected %u %u %u, got %u %u %u",
+                              name, evt->rgb[0], evt->rgb[1], evt->rgb[2],
+                              led->r, led->g, led->b);
+            }
+            return;
+        }
+        default:
+            return;
+    }
+
+    if (strcmp(expected, actual) != 0) {
+        script_result(ctx, false, "ASSERT FAILED: %s expected %s, got %s", name, expected, actual);
+    } else {
+        script_result(ctx, true, "ASSERT OK: %s is %s", name, actual);
+    }
+}
+
+static void script_arm_monitor(ScriptCtx *ctx, const ScriptEvent *evt, uint32_t now) {
+    if (ctx->monitor_count >= SCRIPT_MAX_MONITORS) {
+        script_result(ctx, false, "EXPECT FAILED: too many pending expectations (line %d)",
+                      evt->line);
+        return;
+    }
+
+    ScriptMonitor *mon = &ctx->monitors[ctx->monitor_count++];
+    mon->evt = evt;
+    mon->armed_ms = now;
+    mon->last_level = ctx->state ? target_level(ctx->state, evt->target) : false;
+    mon->marked = false;
+    mon->mark_ms = 0;
+}
+
+// Check a measured width/period against expected +/- tolerance
+static void script_check_timing(ScriptCtx *ctx, const ScriptEvent *evt,
+                                const char *what, uint32_t measured) {
+    float error = (float)measured - (float)evt->duration_ms;
+    if (error < 0.0f) error = -error;
+    script_result(ctx, error <= evt->tolerance_ms,
+                  "EXPECT %s: %s %s %lu ms (expected %lu +/- %.1f)",
+                  error <= evt->tolerance_ms ? "OK" : "FAILED",
+                  target_name(evt->target), what,
+                  (unsigned long)measured, (unsigned long)evt->duration_ms,
+                  (double)evt->tolerance_ms);
+}
+
+// Advance one monitor with the latest observation. Returns true when done.
+static bool script_monitor_update(ScriptCtx *ctx, ScriptMonitor *mon,
+                                  const SimState *state) {
+    const ScriptEvent *evt = mon->evt;
+    uint32_t now = state->timestamp_ms;
+    bool level = target_level(state, evt->target);
+    bool edge = (level != mon->last_level);
+    mon->last_level = level;
+
+    switch (evt->action) {
+        case ACT_EXPECT_EDGE:
+            if (edge && level == evt->value) {
+                script_result(ctx, true, "EXPECT OK: %s %s after %lu ms",
+                              target_name(evt->target), evt->value ? "rise" : "fall",
+                              (unsigned long)(now - mon->armed_ms));
+                return true;
+            }
+            if (now - mon->armed_ms >= evt->duration_ms) {
+                script_result(ctx, false, "EXPECT FAILED: %s %s not within %lu ms",
+                              target_name(evt->target), evt->value ? "rise" : "fall",
+                              (unsigned long)evt->duration_ms);
+                return true;
+            }
+            return false;
+
+        case ACT_EXPECT_WIDTH:
+            if (edge && level) {
+                mon->marked = true;
+                mon->mark_ms = now;
+            } else if (edge && mon->marked) {
+                script_check_timing(ctx, evt, "pulse width", now - mon->mark_ms);
+                return true;
+            }
+            return false;
+
+        case ACT_EXPECT_PERIOD:
+            if (edge && level) {
+                if (mon->marked) {
+                    script_check_timing(ctx, evt, "period", now - mon->mark_ms);
+                    return true;
+                }
+                mon->marked = true;
+                mon->mark_ms = now;
+            }
+            return false;
+
+        default:
+            return true;
+    }
+}
+
+// Fail expectations still pending when the script ends
+static void script_fail_pending(ScriptCtx *ctx) {
+    for (int i = 0; i < ctx->monitor_count; i++) {
+        const ScriptEvent *evt = ctx->monitors[i].evt;
+        const char *what = (evt->action == ACT_EXPECT_WIDTH) ? "pulse width" :
+                           (evt->action == ACT_EXPECT_PERIOD) ? "period" :
+                           evt->value ? "rise" : "fall";
+        script_result(ctx, false, "EXPECT FAILED: %s %s never observed (line %d)",
+                      target_name(evt->target), what, evt->line);
+    }
+    ctx->monitor_count = 0;
+}
+
+static void script_set_cv(uint8_t from, uint8_t to, uint32_t duration_ms) {
+    // Drive CV through the CV source so the next tick doesn't overwrite it
+    CVSource *cv = sim_get_cv_source();
+    if (cv) {
+        if (duration_ms > 0) {
+            cv_source_set_ramp(cv, from, to, duration_ms);
+        } else {
+            cv_source_set_manual(cv, to);
+        }
+    }
+    sim_set_cv_voltage(duration_ms > 0 ? from : to);
+}
+
 static bool script_update(InputSource *self, uint32_t current_time_ms) {
     ScriptCtx *ctx = (ScriptCtx*)self->ctx;
 
@@ -479,15 +940,15 @@ static bool script_update(InputSource *self, uint32_t current_time_ms) {
                 switch (evt->target) {
                     case TGT_BUTTON_A:
                         sim_set_button_a(true);
-                        script_log(sim_get_time(), "Script: Button A pressed");
+                        script_log(ctx->log, sim_get_time(), "Script: Button A pressed");
                         break;
                     case TGT_BUTTON_B:
                         sim_set_button_b(true);
-                        script_log(sim_get_time(), "Script: Button B pressed");
+                        script_log(ctx->log, sim_get_time(), "Script: Button B pressed");
                         break;
                     case TGT_CV:
-                        sim_set_cv_voltage(255);  // 5V = HIGH
-                        script_log(sim_get_time(), "Script: CV high (5V)");
+                        script_set_cv(255, 255, 0);  // 5V = HIGH
+                        script_log(ctx->log, sim_get_time(), "Script: CV high (5V)");
                         break;
                     default:
                         break;
@@ -498,59 +959,76 @@ static bool script_update(InputSource *self, uint32_t current_time_ms) {
                 switch (evt->target) {
                     case TGT_BUTTON_A:
                         sim_set_button_a(false);
-                        script_log(sim_get_time(), "Script: Button A released");
+                        script_log(ctx->log, sim_get_time(), "Script: Button A released");
                         break;
                     case TGT_BUTTON_B:
                         sim_set_button_b(false);
-                        script_log(sim_get_time(), "Script: Button B released");
+                        script_log(ctx->log, sim_get_time(), "Script: Button B released");
                         break;
                     case TGT_CV:
-                        sim_set_cv_voltage(0);  // 0V = LOW
-                        script_log(sim_get_time(), "Script: CV low (0V)");
+                        script_set_cv(0, 0, 0);  // 0V = LOW
+                        script_log(ctx->log, sim_get_time(), "Script: CV low (0V)");
                         break;
                     default:
                         break;
                 }
                 break;
 
-            case ACT_ASSERT: {
-                bool actual = false;
-                const char *name = "";
-                switch (evt->target) {
-                    case TGT_OUTPUT:
-                        actual = sim_get_output();
-                        name = "Output";
-                        break;
-                    case TGT_BUTTON_A:
-                        actual = sim_get_button_a();
-                        name = "Button A";
-                        break;
-                    case TGT_BUTTON_B:
-                        actual = sim_get_button_b();
-                        name = "Button B";
-                        break;
-                    default:
-                        name = "Unknown";
-                        break;
-                }
-                if (actual != evt->value) {
-                    script_log(sim_get_time(), "ASSERT FAILED: %s expected %s, got %s",
-                                  name,
-                                  evt->value ? "HIGH" : "LOW",
-                                  actual ? "HIGH" : "LOW");
-                    ctx->failed = true;
+            case ACT_ASSERT:
+                script_assert(ctx, evt);
+                break;
+
+            case ACT_CV_SET: {
+                script_set_cv(evt->cv_to, evt->cv_to, 0);
+                uint16_t mv = (uint16_t)evt->cv_to * 5000 / 255;
+                script_log(ctx->log, sim_get_time(), "Script: CV %u.%02uV",
+                           mv / 1000, (mv % 1000) / 10);
+                break;
+            }
+
+            case ACT_CV_RAMP: {
+                script_set_cv(evt->cv_from, evt->cv_to, evt->duration_ms);
+                uint16_t from_mv = (uint16_t)evt->cv_from * 5000 / 255;
+                uint16_t to_mv = (uint16_t)evt->cv_to * 5000 / 255;
+                script_log(ctx->log, sim_get_time(), "Script: CV ramp %u.%02uV -> %u.%02uV over %lu ms",
+                           from_mv / 1000, (from_mv % 1000) / 10,
+                           to_mv / 1000, (to_mv % 1000) / 10,
+                           (unsigned long)evt->duration_ms);
+                break;
+            }
+
+            case ACT_CV_FILE: {
+                CVFileConfig config = {
+                    .path = evt->message,
+                    .format = (CVFileFormat)evt->enum_value,
+                    .rate_hz = evt->duration_ms,
+                    .loop = evt->value,
+                };
+                char err[128];
+                CVSource *cv = sim_get_cv_source();
+                if (cv && cv_source_set_file(cv, &config, err, sizeof(err))) {
+                    script_log(ctx->log, sim_get_time(), "Script: CV file %s (%s)",
+                               evt->message, evt->value ? "loop" : "once");
                 } else {
-                    script_log(sim_get_time(), "ASSERT OK: %s is %s", name, actual ? "HIGH" : "LOW");
+                    script_log(ctx->log, sim_get_time(), "Script: CV file failed: %s",
+                               cv ? err : "no CV source");
                 }
                 break;
             }
 
+            case ACT_EXPECT_EDGE:
+            case ACT_EXPECT_WIDTH:
+            case ACT_EXPECT_PERIOD:
+                script_arm_monitor(ctx, evt, current_time_ms);
+                break;
+
             case ACT_LOG:
-                script_log(sim_get_time(), "Script: %s", evt->message);
+                script_log(ctx->log, sim_get_time(), "Script: %s", evt->message);
                 break;
 
             case ACT_QUIT:
-                script_log(sim_get_time(), "Script: quit");
+                script_log(ctx->log, sim_get_time(), "Script: quit");
+                script_fail_pending(ctx);
                 return false;
         }
 
@@ -559,13 +1037,47 @@ static bool script_update(InputSource *self, uint32_t current_time_ms) {
 
     // If we've processed all events and there's no quit, auto-quit
     if (ctx->current_event >= ctx->event_count) {
-        script_log(sim_get_time(), "Script: end of script");
+        script_log(ctx->log, sim_get_time(), "Script: end of script");
+        script_fail_pending(ctx);
         return false;
     }
 
     return true;
 }
 
+static void script_observe(InputSource *self, const SimState *state) {
+    ScriptCtx *ctx = (ScriptCtx*)self->ctx;
+    ctx->state = state;
+
+    // Check pending expectations, dropping the ones that completed
+    int kept = 0;
+    for (int i = 0; i < ctx->monitor_count; i++) {
+        if (!script_monitor_update(ctx, &ctx->monitors[i], state)) {
+            ctx->monitors[kept++] = ctx->monitors[i];
+        }
+    }
+    ctx->monitor_count = kept;
+}
+
+static uint32_t script_next_event_time(InputSource *self, uint32_t current_time_ms) {
+    ScriptCtx *ctx = (ScriptCtx*)self->ctx;
+    if (ctx->current_event >= ctx->event_count) {
+        return current_time_ms + 1;
+    }
+    uint32_t next = ctx->events[ctx->current_event].time_ms;
+
+    // Edge windows must fail at their exact deadline
+    for (int i = 0; i < ctx->monitor_count; i++) {
+        const ScriptMonitor *mon = &ctx->monitors[i];
+        if (mon->evt->action == ACT_EXPECT_EDGE) {
+            uint32_t deadline = mon->armed_ms + mon->evt->duration_ms;
+            if (deadline < next) next = deadline;
+        }
+    }
+
+    return (next > current_time_ms) ? next : current_time_ms + 1;
+}
+
 static bool script_is_realtime(InputSource *self) {
     (void)self;
     return false;  // Scripts always run fast
@@ -578,10 +1090,12 @@ static bool script_has_failed(InputSource *self) {
 
 static void script_cleanup(InputSource *self) {
     ScriptCtx *ctx = (ScriptCtx*)self->ctx;
-    if (ctx->failed) {
-        fprintf(stderr, "\nScript completed with FAILURES\n");
-    } else {
-        fprintf(stderr, "\nScript completed successfully\n");
+    if (ctx->summary) {
+        if (ctx->failed) {
+            fprintf(ctx->summary, "\nScript completed with FAILURES\n");
+        } else {
+            fprintf(ctx->summary, "\nScript completed successfully\n");
+        }
     }
     free(ctx->events);
     free(ctx);
@@ -598,12 +1112,18 @@ InputSource* input_source_script_create(const char *filename) {
     }
 
     if (!parse_script(ctx, filename)) {
+        free(ctx->events);
         free(ctx);
         free(src);
         return NULL;
     }
 
+    ctx->log = stdout;
+    ctx->summary = stderr;
+
     src->update = script_update;
+    src->observe = script_observe;
+    src->next_event_time = script_next_event_time;
     src->is_realtime = script_is_realtime;
     src->has_failed = script_has_failed;
     src->cleanup = script_cleanup;
@@ -611,3 +1131,192 @@ InputSource* input_source_script_create(const char *filename) {
 
     return src;
 }
+
+void input_source_script_set_log(InputSource *src, FILE *log) {
+    ScriptCtx *ctx = (ScriptCtx*)src->ctx;
+    ctx->log = log;
+    ctx->summary = log;
+}
+
+void input_source_script_get_stats(InputSource *src, ScriptStats *stats) {
+    ScriptCtx *ctx = (ScriptCtx*)src->ctx;
+    stats->events_total = ctx->event_count;
+    stats->events_run = ctx->current_event;
+    stats->asserts_passed = ctx->asserts_passed;
+    stats->asserts_failed = ctx->asserts_failed;
+}
+
+// =============================================================================
+// Trace Replay Input Source
+// =============================================================================
+
+typedef struct {
+    TraceReader *reader;
+    TraceFrame expected;    // Recorded state up to the current time
+    TraceFrame next;        // Next record (already decoded)
+    bool have_next;
+    bool applied;           // At least one record applied
+    bool failed;
+    uint32_t records;
+    FILE *log;
+} ReplayCtx;
+
+static void replay_mismatch(ReplayCtx *ctx, uint32_t time_ms, const char *what,
+                            unsigned expected, unsigned actual) {
+    script_log(ctx->log, time_ms, "REPLAY MISMATCH: %s expected %u, got %u",
+               what, expected, actual);
+    ctx->failed = true;
+}
+
+static bool replay_update(InputSource *self, uint32_t current_time_ms) {
+    ReplayCtx *ctx = (ReplayCtx*)self->ctx;
+
+    if (ctx->failed) {
+        return false;  // Stop at the first divergence
+    }
+
+    while (ctx->have_next && ctx->next.time_ms <= current_time_ms) {
+        if (ctx->next.flags & TRACE_F_END) {
+            script_log(ctx->log, sim_get_time(), "Replay: end of trace (%lu records)",
+                       (unsigned long)ctx->records);
+            return false;
+        }
+
+        // Apply recorded inputs; outputs are checked in replay_observe
+        if (ctx->next.flags & TRACE_F_BUTTONS) {
+            sim_set_button_a(ctx->next.button_a);
+            sim_set_button_b(ctx->next.button_b);
+        }
+        if (ctx->next.flags & TRACE_F_CV) {
+            CVSource *cv = sim_get_cv_source();
+            if (cv) {
+                cv_source_set_manual(cv, ctx->next.cv_voltage);
+            }
+            sim_set_cv_voltage(ctx->next.cv_voltage);
+        }
+
+        ctx->expected = ctx->next;
+        ctx->applied = true;
+        ctx->records++;
+        ctx->have_next = trace_reader_next(ctx->reader, &ctx->next);
+    }
+
+    if (!ctx->have_next) {
+        script_log(ctx->log, sim_get_time(), "Replay: trace %s before end record",
+                   trace_reader_corrupt(ctx->reader) ? "corrupt" : "truncated");
+        ctx->failed = true;
+        return false;
+    }
+
+    return true;
+}
+
+static void replay_observe(InputSource *self, const SimState *state) {
+    ReplayCtx *ctx = (ReplayCtx*)self->ctx;
+    const TraceFrame *exp = &ctx->expected;
+    uint32_t t = state->timestamp_ms;
+
+    if (!ctx->applied || ctx->failed) return;
+
+    if (state->button_a != exp->button_a) {
+        replay_mismatch(ctx, t, "button A", exp->button_a, state->button_a);
+    } else if (state->button_b != exp->button_b) {
+        replay_mismatch(ctx, t, "button B", exp->button_b, state->button_b);
+    } else if (state->cv_voltage != exp->cv_voltage) {
+        replay_mismatch(ctx, t, "CV", exp->cv_voltage, state->cv_voltage);
+    } else if (state->cv_in != exp->cv_in) {
+        replay_mismatch(ctx, t, "CV digital", exp->cv_in, state->cv_in);
+    } else if (state->signal_out != exp->signal_out) {
+        replay_mismatch(ctx, t, "output", exp->signal_out, state->signal_out);
+    } else if (state->top_state != exp->top_state) {
+        replay_mismatch(ctx, t, "state", exp->top_state, state->top_state);
+    } else if (state->mode != exp->mode) {
+        replay_mismatch(ctx, t, "mode", exp->mode, state->mode);
+    } else if (state->page != exp->page) {
+        replay_mismatch(ctx, t, "page", exp->page, state->page);
+    } else if (state->in_menu != exp->in_menu) {
+        replay_mismatch(ctx, t, "in menu", exp->in_menu, state->in_menu);
+    } else {
+        for (int i = 0; i < SIM_NUM_LEDS; i++) {
+            const SimLED *a = &state->leds[i];
+            const SimLED *e = &exp->leds[i];
+            if (a->r != e->r || a->g != e->g || a->b != e->b) {
+                script_log(ctx->log, t,
+                           "REPLAY MISMATCH: LED %d expected (%u,%u,%u), got (%u,%u,%u)",
+                           i, e->r, e->g, e->b, a->r, a->g, a->b);
+                ctx->failed = true;
+                break;
+            }
+        }
+    }
+}
+
+static uint32_t replay_next_event_time(InputSource *self, uint32_t current_time_ms) {
+    ReplayCtx *ctx = (ReplayCtx*)self->ctx;
+    if (!ctx->have_next || ctx->failed || ctx->next.time_ms <= current_time_ms) {
+        return current_time_ms + 1;
+    }
+    return ctx->next.time_ms;
+}
+
+static bool replay_is_realtime(InputSource *self) {
+    (void)self;
+    return false;  // Replays run at full speed
+}
+
+static bool replay_has_failed(InputSource *self) {
+    ReplayCtx *ctx = (ReplayCtx*)self->ctx;
+    return ctx->failed;
+}
+
+static void replay_cleanup(InputSource *self) {
+    ReplayCtx *ctx = (ReplayCtx*)self->ctx;
+    if (ctx->log) {
+        fprintf(stderr, "\nReplay %s (%lu records)\n",
+                ctx->failed ? "DIVERGED from trace" : "matched trace",
+                (unsigned long)ctx->records);
+    }
+    trace_reader_close(ctx->reader);
+    free(ctx);
+    free(self);
+}
+
+InputSource* input_source_replay_create(const char *filename) {
+    TraceReader *reader = trace_reader_open(filename);
+    if (!reader) {
+        return NULL;  // Error already printed
+    }
+
+    InputSource *src = malloc(sizeof(InputSource));
+    ReplayCtx *ctx = calloc(1, sizeof(ReplayCtx));
+    if (!src || !ctx) {
+        free(src);
+        free(ctx);
+        trace_reader_close(reader);
+        return NULL;
+    }
+
+    ctx->reader = reader;
+    ctx->log = stdout;
+
+    // Boot from the recorded EEPROM so app_init loads the same settings
+    uint16_t eeprom_size;
+    const uint8_t *eeprom = trace_reader_eeprom(reader, &eeprom_size);
+    sim_load_eeprom(eeprom, eeprom_size);
+
+    // The recorded CV is the ADC input: read it through the same model
+    sim_set_adc_model(trace_reader_adc(reader));
+
+    ctx->next.time_ms = trace_reader_start_time(reader);
+    ctx->have_next = trace_reader_next(reader, &ctx->next);
+
+    src->update = replay_update;
+    src->observe = replay_observe;
+    src->next_event_time = replay_next_event_time;
+    src->is_realtime = replay_is_realtime;
+    src->has_failed = replay_has_failed;
+    src->cleanup = replay_cleanup;
+    src->ctx = ctx;
+
+    return src;
+}
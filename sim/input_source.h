@@ -3,6 +3,7 @@
 
 #include <stdbool.h>
 #include <stdint.h>
+#include <stdio.h>
 #include "sim_state.h"
 
 /**
@@ -22,6 +23,7 @@ typedef struct InputSource InputSource;
  * Implementations:
  * - KeyboardInput: Interactive terminal input
  * - ScriptInput: Reads from script file
+ * - ReplayInput: Replays and verifies a recorded trace (trace.h)
  */
 struct InputSource {
     /**
@@ -33,6 +35,26 @@ struct InputSource {
      */
     bool (*update)(InputSource *self, uint32_t current_time_ms);
 
+    /**
+     * Observe the simulator state after the application update.
+     * Called once after startup and after every full loop iteration,
+     * so sources can check outputs and timing as the run progresses.
+     *
+     * @param state  Observed state (updated in place every tick)
+     */
+    void (*observe)(InputSource *self, const SimState *state);
+
+    /**
+     * Get the next time this source may change inputs.
+     * Lets the main loop skip idle time between scripted events.
+     * Sources that can't predict their input (keyboard) return
+     * current_time_ms + 1.
+     *
+     * @param current_time_ms  Current simulation time
+     * @return Earliest time of the next input change (> current_time_ms)
+     */
+    uint32_t (*next_event_time)(InputSource *self, uint32_t current_time_ms);
+
     /**
      * Check if simulation should run in real-time.
      * Scripts run fast, keyboard runs real-time.
@@ -73,4 +95,45 @@ InputSource* input_source_keyboard_create(SimState *sim_state);
  */
 InputSource* input_source_script_create(const char *filename);
 
+/**
+ * Script execution statistics
+ */
+typedef struct {
+    int events_total;       // Events in the script
+    int events_run;         // Events executed so far
+    int asserts_passed;
+    int asserts_failed;
+} ScriptStats;
+
+/**
+ * Redirect script log lines and the completion summary.
+ * By default log lines go to stdout and the summary to stderr.
+ *
+ * @param src  Script input source
+ * @param log  Destination stream, or NULL to discard
+ */
+void input_source_script_set_log(InputSource *src, FILE *log);
+
+/**
+ * Get script execution statistics.
+ *
+ * @param src    Script input source
+ * @param stats  Output statistics
+ */
+void input_source_script_get_stats(InputSource *src, ScriptStats *stats);
+
+/**
+ * Create trace replay input source
+ *
+ * Applies the recorded inputs at their recorded times and checks the
+ * observed outputs, state and LEDs against the trace, failing at the
+ * first difference. Loads the recorded EEPROM image into the bound
+ * hardware, so create it after sim_instance_init() and before
+ * sim_instance_start().
+ *
+ * @param filename  Path to trace file (see --record)
+ * @return InputSource or NULL on error
+ */
+InputSource* input_source_replay_create(const char *filename);
+
 #endif /* GK_SIM_INPUT_SOURCE_H */
@@ -0,0 +1,78 @@
+#include "pacer.h"
+#include <errno.h>
+#include <string.h>
+#include <time.h>
+
+/**
+ * @file pacer.c
+ * @brief Deadline-based realtime pacing
+ */
+
+#define NS_PER_MS 1000000ull
+#define NS_PER_SEC 1000000000ull
+
+static uint64_t monotonic_ns(void) {
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return (uint64_t)ts.tv_sec * NS_PER_SEC + (uint64_t)ts.tv_nsec;
+}
+
+static void anchor(Pacer *pacer, uint32_t sim_ms, uint64_t now_ns) {
+    pacer->anchored = true;
+    pacer->epoch_ns = now_ns;
+    pacer->anchor_ms = sim_ms;
+}
+
+static void record(SimTiming *stats, uint64_t late_ns) {
+    uint64_t late_us64 = late_ns / 1000;
+    uint32_t late_us = (late_us64 > UINT32_MAX) ? UINT32_MAX : (uint32_t)late_us64;
+
+    stats->ticks++;
+    stats->hist[sim_timing_bucket(late_us)]++;
+    if (late_us >= 1000) {
+        stats->late_ticks++;
+    }
+    if (late_us > stats->max_late_us) {
+        stats->max_late_us = late_us;
+    }
+}
+
+void pacer_init(Pacer *pacer, uint32_t max_catchup_ms) {
+    memset(pacer, 0, sizeof(*pacer));
+    pacer->max_catchup_ms = max_catchup_ms;
+}
+
+void pacer_stop(Pacer *pacer) {
+    pacer->anchored = false;
+}
+
+void pacer_wait(Pacer *pacer, uint32_t sim_ms) {
+    uint64_t now = monotonic_ns();
+
+    // New timeline: first tick, after fast-forward, or time reset
+    int32_t ahead = (int32_t)(sim_ms - pacer->anchor_ms);
+    if (!pacer->anchored || ahead < 0) {
+        anchor(pacer, sim_ms, now);
+        return;
+    }
+
+    uint64_t deadline = pacer->epoch_ns + (uint64_t)ahead * NS_PER_MS;
+    if (now < deadline) {
+        struct timespec ts = {
+            .tv_sec = (time_t)(deadline / NS_PER_SEC),
+            .tv_nsec = (long)(deadline % NS_PER_SEC),
+        };
+        while (clock_nanosleep(CLOCK_MONOTONIC, TIMER_ABSTIME, &ts, NULL) == EINTR) {
+        }
+        now = monotonic_ns();
+    }
+
+    uint64_t late = (now > deadline) ? now - deadline : 0;
+    record(&pacer->stats, late);
+
+    // Too far behind: drop the backlog rather than race through it
+    if (pacer->max_catchup_ms && late > (uint64_t)pacer->max_catchup_ms * NS_PER_MS) {
+        anchor(pacer, sim_ms, now);
+        pacer->stats.resyncs++;
+    }
+}
@@ -0,0 +1,56 @@
+#ifndef GK_SIM_PACER_H
+#define GK_SIM_PACER_H
+
+#include "sim_state.h"
+#include <stdbool.h>
+#include <stdint.h>
+
+/**
+ * @file pacer.h
+ * @brief Realtime pacing of simulated time against the wall clock
+ *
+ * Each simulated millisecond has an absolute CLOCK_MONOTONIC deadline,
+ * counted from an anchor (wall time, sim time) pair, and the pacer sleeps
+ * until it with clock_nanosleep(TIMER_ABSTIME). Loop cost and wake-up
+ * latency therefore don't accumulate: simulated time stays locked to the
+ * wall clock instead of drifting slower.
+ *
+ * Ticks that start late are caught up by running back to back. When the
+ * backlog exceeds the catch-up limit (e.g. the process was stopped) it is
+ * dropped and the anchor moves to now, so the simulation never races
+ * through seconds of input at once. A limit of 0 turns this off.
+ */
+
+// Default catch-up limit (ms of backlog run back to back)
+#define PACER_DEFAULT_CATCHUP_MS 100
+
+typedef struct {
+    bool anchored;
+    uint64_t epoch_ns;          // Wall time (CLOCK_MONOTONIC) of anchor_ms
+    uint32_t anchor_ms;         // Simulated time at epoch_ns
+    uint32_t max_catchup_ms;
+    SimTiming stats;
+} Pacer;
+
+/**
+ * Initialize pacer.
+ * @param max_catchup_ms  Largest backlog caught up before resyncing
+ *                        (0: no limit, catch up any backlog, never resync)
+ */
+void pacer_init(Pacer *pacer, uint32_t max_catchup_ms);
+
+/**
+ * Wait until simulated time `sim_ms` is due.
+ * Call after each tick with the time of the next one. The first call
+ * (and the first after the simulated time goes backwards, as on reset)
+ * anchors the pacer and returns immediately.
+ */
+void pacer_wait(Pacer *pacer, uint32_t sim_ms);
+
+/**
+ * Forget the anchor, e.g. while running fast-forward.
+ * The next pacer_wait() starts a new timeline; statistics are kept.
+ */
+void pacer_stop(Pacer *pacer);
+
+#endif /* GK_SIM_PACER_H */
@@ -0,0 +1,113 @@
+#include "json_buf.h"
+#include <stdlib.h>
+#include <string.h>
+
+/**
+ * @file json_buf.c
+ * @brief Growable output buffer with JSON formatting helpers
+ */
+
+// Initial allocation; enough for a full state frame with events
+#define JB_INITIAL_CAP 4096
+
+void jb_init(JsonBuf *jb) {
+    jb->data = NULL;
+    jb->len = 0;
+    jb->cap = 0;
+    jb->oom = false;
+}
+
+void jb_free(JsonBuf *jb) {
+    free(jb->data);
+    jb_init(jb);
+}
+
+bool jb_reserve(JsonBuf *jb, size_t n) {
+    if (jb->len + n <= jb->cap) return true;
+    if (jb->oom) return false;
+
+    size_t cap = jb->cap ? jb->cap : JB_INITIAL_CAP;
+    while (cap < jb->len + n) cap *= 2;
+
+    char *data = realloc(jb->data, cap);
+    if (!data) {
+        jb->oom = true;
+        return false;
+    }
+    jb->data = data;
+    jb->cap = cap;
+    return true;
+}
+
+void jb_append(JsonBuf *jb, const char *s, size_t n) {
+    if (!jb_reserve(jb, n)) return;
+    memcpy(jb->data + jb->len, s, n);
+    jb->len += n;
+}
+
+void jb_str(JsonBuf *jb, const char *s) {
+    jb_append(jb, s, strlen(s));
+}
+
+void jb_quoted(JsonBuf *jb, const char *s) {
+    // Worst case every character needs a two-byte escape
+    size_t n = strlen(s);
+    if (!jb_reserve(jb, n * 2 + 2)) return;
+
+    char *p = jb->data + jb->len;
+    *p++ = '"';
+    for (; *s; s++) {
+        switch (*s) {
+            case '"':  *p++ = '\\'; *p++ = '"';  break;
+            case '\\': *p++ = '\\'; *p++ = '\\'; break;
+            case '\n': *p++ = '\\'; *p++ = 'n';  break;
+            case '\r': *p++ = '\\'; *p++ = 'r';  break;
+            case '\t': *p++ = '\\'; *p++ = 't';  break;
+            default:   *p++ = *s;                break;
+        }
+    }
+    *p++ = '"';
+    jb->len = p - jb->data;
+}
+
+void jb_u32(JsonBuf *jb, uint32_t v) {
+    if (!jb_reserve(jb, 10)) return;
+
+    char digits[10];
+    int n = 0;
+    do {
+        digits[n++] = (char)('0' + v % 10);
+        v /= 10;
+    } while (v);
+
+    char *p = jb->data + jb->len;
+    while (n) *p++ = digits[--n];
+    jb->len = p - jb->data;
+}
+
+void jb_int(JsonBuf *jb, int v) {
+    if (v < 0) {
+        jb_char(jb, '-');
+        jb_u32(jb, 0u - (uint32_t)v);
+    } else {
+        jb_u32(jb, (uint32_t)v);
+    }
+}
+
+void jb_bool(JsonBuf *jb, bool v) {
+    if (v) {
+        jb_lit(jb, "true");
+    } else {
+        jb_lit(jb, "false");
+    }
+}
+
+void jb_char(JsonBuf *jb, char c) {
+    if (!jb_reserve(jb, 1)) return;
+    jb->data[jb->len++] = c;
+}
+
+bool jb_write(const JsonBuf *jb, FILE *out) {
+    if (jb->len == 0) return true;
+    return fwrite(jb->data, 1, jb->len, out) == jb->len;
+}
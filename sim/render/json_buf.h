@@ -0,0 +1,91 @@
+#ifndef SIM_JSON_BUF_H
+#define SIM_JSON_BUF_H
+
+#include <stdbool.h>
+#include <stddef.h>
+#include <stdint.h>
+#include <stdio.h>
+
+/**
+ * @file json_buf.h
+ * @brief Growable output buffer with JSON formatting helpers
+ *
+ * Frames are built in one reusable buffer with hand-rolled integer and
+ * string formatting (no printf), then written with a single call.
+ * The buffer only grows, so steady-state output doesn't allocate.
+ */
+
+typedef struct {
+    char *data;
+    size_t len;
+    size_t cap;
+    bool oom;           // An allocation failed; contents are truncated
+} JsonBuf;
+
+/**
+ * Initialize an empty buffer (allocates on first append).
+ */
+void jb_init(JsonBuf *jb);
+
+/**
+ * Release the buffer's memory.
+ */
+void jb_free(JsonBuf *jb);
+
+/**
+ * Start a new frame (keeps the allocation).
+ */
+static inline void jb_reset(JsonBuf *jb) {
+    jb->len = 0;
+    jb->oom = false;
+}
+
+/**
+ * Make room for n more bytes.
+ * @return false if the buffer couldn't grow
+ */
+bool jb_reserve(JsonBuf *jb, size_t n);
+
+/**
+ * Append raw bytes.
+ */
+void jb_append(JsonBuf *jb, const char *s, size_t n);
+
+/**
+ * Append a string literal (length known at compile time).
+ */
+#define jb_lit(jb, s) jb_append((jb), (s), sizeof(s) - 1)
+
+/**
+ * Append a NUL-terminated string without escaping.
+ */
+void jb_str(JsonBuf *jb, const char *s);
+
+/**
+ * Append a quoted, escaped JSON string.
+ */
+void jb_quoted(JsonBuf *jb, const char *s);
+
+/**
+ * Append an unsigned / signed decimal integer.
+ */
+void jb_u32(JsonBuf *jb, uint32_t v);
+void jb_int(JsonBuf *jb, int v);
+
+/**
+ * Append true or false.
+ */
+void jb_bool(JsonBuf *jb, bool v);
+
+/**
+ * Append one character.
+ */
+void jb_char(JsonBuf *jb, char c);
+
+/**
+ * Write the buffer to a stream with one fwrite.
+ * @return false on write error
+ */
+bool jb_write(const JsonBuf *jb, FILE *out);
+
+#endif /* SIM_JSON_BUF_H */
@@ -39,6 +39,12 @@ struct Renderer {
      */
     void (*cleanup)(Renderer *self);
 
+    /**
+     * True if ticks where only the timestamp changed produce output.
+     * Renderers that only print events can be skipped over idle time.
+     */
+    bool idle_frames;
+
     /**
      * Private context for implementation.
      */
@@ -54,8 +60,9 @@ Renderer* render_terminal_create(void);
  * Create JSON renderer.
  *
  * @param stream_mode If true, output at fixed intervals; if false, only on state change
+ * @param delta_mode  If true, frames carry only changed fields between periodic keyframes
  */
-Renderer* render_json_create(bool stream_mode);
+Renderer* render_json_create(bool stream_mode, bool delta_mode);
 
 /**
  * Create batch renderer (plain text events only).
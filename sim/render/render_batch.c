@@ -11,7 +11,7 @@
  */
 
 typedef struct {
-    int last_event_count;
+    uint32_t last_event_total;
 } BatchCtx;
 
 static void batch_init(Renderer *self) {
@@ -26,9 +26,9 @@ static void batch_render(Renderer *self, const SimState *state) {
     int start = (state->event_count < SIM_MAX_EVENTS) ? 0 : state->event_head;
     int count = (state->event_count < SIM_MAX_EVENTS) ? state->event_count : SIM_MAX_EVENTS;
 
-    int new_events = state->event_count - ctx->last_event_count;
-    if (new_events > count) new_events = count;
-    if (new_events < 0) new_events = 0;
+    // Compare running totals: event_count saturates once the ring is full
+    uint32_t unseen = state->event_total - ctx->last_event_total;
+    int new_events = (unseen > (uint32_t)count) ? count : (int)unseen;
 
     int output_start = (start + count - new_events) % SIM_MAX_EVENTS;
 
@@ -43,7 +43,7 @@ static void batch_render(Renderer *self, const SimState *state) {
         fflush(stdout);
     }
 
-    ctx->last_event_count = state->event_count;
+    ctx->last_event_total = state->event_total;
 }
 
 static bool batch_handle_input(Renderer *self, SimState *state, int key) {
@@ -71,12 +71,13 @@ Renderer* render_batch_create(void) {
         return NULL;
     }
 
-    ctx->last_event_count = 0;
+    ctx->last_event_total = 0;
 
     r->init = batch_init;
     r->render = batch_render;
     r->handle_input = batch_handle_input;
     r->cleanup = batch_cleanup;
+    r->idle_frames = false;
     r->ctx = ctx;
 
     return r;
@@ -1,4 +1,5 @@
 #include "render.h"
+#include "json_buf.h"
 #include <stdio.h>
 #include <stdlib.h>
 #include <string.h>
@@ -9,136 +10,274 @@
  *
  * Outputs simulator state as newline-delimited JSON (NDJSON).
  * Each state change produces one JSON object on stdout.
+ *
+ * Frames are built in a reusable buffer and written with one fwrite.
+ * In delta mode, frames carry only the fields that changed since the
+ * previous frame, with a full keyframe at least every
+ * JSON_KEYFRAME_INTERVAL_MS (schema: sim/schema/sim_state_delta_v1.json).
  */
 
-typedef struct {
-    bool stream_mode;
-    int last_event_count;
-} JsonCtx;
+// Delta mode: full keyframe at least this often (simulation time)
+#define JSON_KEYFRAME_INTERVAL_MS 1000
+
+// LED names by index (see schema)
+static const char* const led_names[SIM_NUM_LEDS] = {"mode", "activity"};
 
 /**
- * Escape a string for JSON output.
- * Writes escaped string to buffer, returns bytes written.
+ * Fields last sent, for delta frames.
  */
-static int json_escape_string(char *buf, size_t buf_size, const char *str) {
-    size_t i = 0;
-    while (*str && i < buf_size - 1) {
-        switch (*str) {
-            case '"':
-                if (i + 2 >= buf_size) goto done;
-                buf[i++] = '\\';
-                buf[i++] = '"';
-                break;
-            case '\\':
-                if (i + 2 >= buf_size) goto done;
-                buf[i++] = '\\';
-                buf[i++] = '\\';
-                break;
-            case '\n':
-                if (i + 2 >= buf_size) goto done;
-                buf[i++] = '\\';
-                buf[i++] = 'n';
-                break;
-            case '\r':
-                if (i + 2 >= buf_size) goto done;
-                buf[i++] = '\\';
-                buf[i++] = 'r';
-                break;
-            case '\t':
-                if (i + 2 >= buf_size) goto done;
-                buf[i++] = '\\';
-                buf[i++] = 't';
-                break;
-            default:
-                buf[i++] = *str;
-                break;
-        }
-        str++;
-    }
-done:
-    buf[i] = '\0';
-    return (int)i;
-}
+typedef struct {
+    TopState top_state;
+    ModeState mode;
+    MenuPage page;
+    bool in_menu;
+    bool button_a;
+    bool button_b;
+    bool cv_in;
+    bool signal_out;
+    SimLED leds[SIM_NUM_LEDS];
+} JsonSent;
+
+typedef struct {
+    bool stream_mode;
+    bool delta_mode;
+    uint32_t last_event_total;
+    JsonBuf buf;                // Reused for every frame
+    JsonSent sent;
+    bool have_keyframe;
+    uint32_t last_keyframe_ms;
+} JsonCtx;
 
 static void json_init(Renderer *self) {
     (void)self;
     // No terminal setup needed
 }
 
-static void json_render(Renderer *self, const SimState *state) {
-    JsonCtx *ctx = (JsonCtx*)self->ctx;
-    char escaped[256];
+static void json_page(JsonBuf *jb, const SimState *state) {
+    jb_lit(jb, "\"page\":");
+    if (state->in_menu) {
+        jb_char(jb, '"');
+        jb_str(jb, sim_page_str(state->page));
+        jb_char(jb, '"');
+    } else {
+        jb_lit(jb, "null");
+    }
+}
 
-    // Output JSON object
-    printf("{");
+static void json_led(JsonBuf *jb, const SimState *state, int i) {
+    jb_lit(jb, "{\"index\":");
+    jb_int(jb, i);
+    jb_lit(jb, ",\"name\":\"");
+    jb_str(jb, led_names[i]);
+    jb_lit(jb, "\",\"r\":");
+    jb_int(jb, state->leds[i].r);
+    jb_lit(jb, ",\"g\":");
+    jb_int(jb, state->leds[i].g);
+    jb_lit(jb, ",\"b\":");
+    jb_int(jb, state->leds[i].b);
+    jb_char(jb, '}');
+}
 
-    // Version and timestamp
-    printf("\"version\":%d,", state->version);
-    printf("\"timestamp_ms\":%lu,", (unsigned long)state->timestamp_ms);
+// Full state sections (everything between timestamp and events)
+static void json_full_state(JsonBuf *jb, const SimState *state) {
+    jb_lit(jb, "\"state\":{\"top\":\"");
+    jb_str(jb, sim_top_state_str(state->top_state));
+    jb_lit(jb, "\",\"mode\":\"");
+    jb_str(jb, sim_mode_str(state->mode));
+    jb_lit(jb, "\",");
+    json_page(jb, state);
+    jb_lit(jb, "},");
 
-    // State
-    printf("\"state\":{");
-    printf("\"top\":\"%s\",", sim_top_state_str(state->top_state));
-    printf("\"mode\":\"%s\",", sim_mode_str(state->mode));
-    if (state->in_menu) {
-        printf("\"page\":\"%s\"", sim_page_str(state->page));
+    jb_lit(jb, "\"inputs\":{\"button_a\":");
+    jb_bool(jb, state->button_a);
+    jb_lit(jb, ",\"button_b\":");
+    jb_bool(jb, state->button_b);
+    jb_lit(jb, ",\"cv_in\":");
+    jb_bool(jb, state->cv_in);
+    jb_lit(jb, "},");
+
+    jb_lit(jb, "\"outputs\":{\"signal\":");
+    jb_bool(jb, state->signal_out);
+    jb_lit(jb, "},");
+
+    jb_lit(jb, "\"leds\":[");
+    for (int i = 0; i < SIM_NUM_LEDS; i++) {
+        if (i > 0) jb_char(jb, ',');
+        json_led(jb, state, i);
+    }
+    jb_lit(jb, "],");
+}
+
+// Comma-separated field inside an optional object section
+static void json_delta_field(JsonBuf *jb, bool *open, const char *section) {
+    if (!*open) {
+        jb_char(jb, '"');
+        jb_str(jb, section);
+        jb_lit(jb, "\":{");
+        *open = true;
     } else {
-        printf("\"page\":null");
+        jb_char(jb, ',');
+    }
+}
+
+static void json_delta_close(JsonBuf *jb, bool open) {
+    if (open) jb_lit(jb, "},");
+}
+
+// Changed fields only; sections with no changes are omitted
+static void json_delta_state(JsonBuf *jb, const SimState *state, const JsonSent *sent) {
+    bool open = false;
+    if (state->top_state != sent->top_state) {
+        json_delta_field(jb, &open, "state");
+        jb_lit(jb, "\"top\":\"");
+        jb_str(jb, sim_top_state_str(state->top_state));
+        jb_char(jb, '"');
+    }
+    if (state->mode != sent->mode) {
+        json_delta_field(jb, &open, "state");
+        jb_lit(jb, "\"mode\":\"");
+        jb_str(jb, sim_mode_str(state->mode));
+        jb_char(jb, '"');
     }
-    printf("},");
+    if (state->in_menu != sent->in_menu || (state->in_menu && state->page != sent->page)) {
+        json_delta_field(jb, &open, "state");
+        json_page(jb, state);
+    }
+    json_delta_close(jb, open);
 
-    // Inputs
-    printf("\"inputs\":{");
-    printf("\"button_a\":%s,", state->button_a ? "true" : "false");
-    printf("\"button_b\":%s,", state->button_b ? "true" : "false");
-    printf("\"cv_in\":%s", state->cv_in ? "true" : "false");
-    printf("},");
+    open = false;
+    if (state->button_a != sent->button_a) {
+        json_delta_field(jb, &open, "inputs");
+        jb_lit(jb, "\"button_a\":");
+        jb_bool(jb, state->button_a);
+    }
+    if (state->button_b != sent->button_b) {
+        json_delta_field(jb, &open, "inputs");
+        jb_lit(jb, "\"button_b\":");
+        jb_bool(jb, state->button_b);
+    }
+    if (state->cv_in != sent->cv_in) {
+        json_delta_field(jb, &open, "inputs");
+        jb_lit(jb, "\"cv_in\":");
+        jb_bool(jb, state->cv_in);
+    }
+    json_delta_close(jb, open);
 
-    // Outputs
-    printf("\"outputs\":{");
-    printf("\"signal\":%s", state->signal_out ? "true" : "false");
-    printf("},");
+    if (state->signal_out != sent->signal_out) {
+        jb_lit(jb, "\"outputs\":{\"signal\":");
+        jb_bool(jb, state->signal_out);
+        jb_lit(jb, "},");
+    }
 
-    // LEDs
-    printf("\"leds\":[");
-    const char* led_names[] = {"mode", "activity"};
+    // Changed LEDs only, identified by index
+    bool first = true;
     for (int i = 0; i < SIM_NUM_LEDS; i++) {
-        if (i > 0) printf(",");
-        printf("{\"index\":%d,\"name\":\"%s\",\"r\":%d,\"g\":%d,\"b\":%d}",
-               i, led_names[i],
-               state->leds[i].r, state->leds[i].g, state->leds[i].b);
+        const SimLED *a = &state->leds[i];
+        const SimLED *b = &sent->leds[i];
+        if (a->r == b->r && a->g == b->g && a->b == b->b) continue;
+        jb_str(jb, first ? "\"leds\":[" : ",");
+        first = false;
+        json_led(jb, state, i);
+    }
+    if (!first) jb_lit(jb, "],");
+}
+
+static void json_timing(JsonBuf *jb, const SimTiming *t) {
+    jb_lit(jb, "\"timing\":{\"ticks\":");
+    jb_u32(jb, t->ticks);
+    jb_lit(jb, ",\"late_ticks\":");
+    jb_u32(jb, t->late_ticks);
+    jb_lit(jb, ",\"max_late_us\":");
+    jb_u32(jb, t->max_late_us);
+    jb_lit(jb, ",\"resyncs\":");
+    jb_u32(jb, t->resyncs);
+    jb_lit(jb, ",\"lateness_hist\":[");
+    for (int i = 0; i < SIM_TIMING_BUCKETS; i++) {
+        if (i > 0) jb_char(jb, ',');
+        jb_u32(jb, t->hist[i]);
+    }
+    jb_lit(jb, "]},");
+}
+
+static void json_remember(JsonSent *sent, const SimState *state) {
+    sent->top_state = state->top_state;
+    sent->mode = state->mode;
+    sent->page = state->page;
+    sent->in_menu = state->in_menu;
+    sent->button_a = state->button_a;
+    sent->button_b = state->button_b;
+    sent->cv_in = state->cv_in;
+    sent->signal_out = state->signal_out;
+    memcpy(sent->leds, state->leds, sizeof(sent->leds));
+}
+
+static void json_render(Renderer *self, const SimState *state) {
+    JsonCtx *ctx = (JsonCtx*)self->ctx;
+    JsonBuf *jb = &ctx->buf;
+
+    bool keyframe = !ctx->delta_mode || !ctx->have_keyframe ||
+                    (state->timestamp_ms - ctx->last_keyframe_ms >= JSON_KEYFRAME_INTERVAL_MS);
+
+    jb_reset(jb);
+
+    // Version and timestamp
+    jb_lit(jb, "{\"version\":");
+    jb_int(jb, state->version);
+    jb_lit(jb, ",\"timestamp_ms\":");
+    jb_u32(jb, state->timestamp_ms);
+    jb_char(jb, ',');
+
+    if (ctx->delta_mode) {
+        jb_str(jb, keyframe ? "\"keyframe\":true," : "\"delta\":true,");
+    }
+
+    if (keyframe) {
+        json_full_state(jb, state);
+        ctx->have_keyframe = true;
+        ctx->last_keyframe_ms = state->timestamp_ms;
+    } else {
+        json_delta_state(jb, state, &ctx->sent);
+    }
+    json_remember(&ctx->sent, state);
+
+    // Pacing statistics, realtime only (not part of the state deltas)
+    if (state->realtime_mode) {
+        json_timing(jb, &state->timing);
     }
-    printf("],");
 
-    // Events (only new events since last render)
-    printf("\"events\":[");
+    // Events
     int start = (state->event_count < SIM_MAX_EVENTS) ? 0 : state->event_head;
     int count = (state->event_count < SIM_MAX_EVENTS) ? state->event_count : SIM_MAX_EVENTS;
 
-    // In stream mode, output all events; otherwise just new ones
-    int events_to_output = ctx->stream_mode ? count : (state->event_count - ctx->last_event_count);
-    if (events_to_output > count) events_to_output = count;
-    if (events_to_output < 0) events_to_output = 0;
+    // In plain stream mode, output all events; otherwise just new ones
+    // (compare running totals: event_count saturates once the ring is full)
+    uint32_t unseen = state->event_total - ctx->last_event_total;
+    int events_to_output = count;
+    if ((!ctx->stream_mode || ctx->delta_mode) && unseen < (uint32_t)count) {
+        events_to_output = (int)unseen;
+    }
 
     int output_start = (start + count - events_to_output) % SIM_MAX_EVENTS;
-    bool first = true;
+    jb_lit(jb, "\"events\":[");
     for (int i = 0; i < events_to_output; i++) {
         int idx = (output_start + i) % SIM_MAX_EVENTS;
-        if (!first) printf(",");
-        first = false;
+        if (i > 0) jb_char(jb, ',');
 
-        json_escape_string(escaped, sizeof(escaped), state->events[idx].message);
-        printf("{\"time_ms\":%lu,\"type\":\"%s\",\"message\":\"%s\"}",
-               (unsigned long)state->events[idx].time_ms,
-               sim_event_type_str(state->events[idx].type),
-               escaped);
+        jb_lit(jb, "{\"time_ms\":");
+        jb_u32(jb, state->events[idx].time_ms);
+        jb_lit(jb, ",\"type\":\"");
+        jb_str(jb, sim_event_type_str(state->events[idx].type));
+        jb_lit(jb, "\",\"message\":");
+        jb_quoted(jb, state->events[idx].message);
+        jb_char(jb, '}');
     }
-    printf("]");
+    jb_lit(jb, "]}\n");
 
-    printf("}\n");
+    // One write per frame; consumers read frames as they happen
+    jb_write(jb, stdout);
     fflush(stdout);
 
-    ctx->last_event_count = state->event_count;
+    ctx->last_event_total = state->event_total;
 }
 
 static bool json_handle_input(Renderer *self, SimState *state, int key) {
@@ -153,27 +292,29 @@ static bool json_handle_input(Renderer *self, SimState *state, int key) {
 }
 
 static void json_cleanup(Renderer *self) {
-    (void)self;
-    // No cleanup needed
+    JsonCtx *ctx = (JsonCtx*)self->ctx;
+    jb_free(&ctx->buf);
 }
 
-Renderer* render_json_create(bool stream_mode) {
+Renderer* render_json_create(bool stream_mode, bool delta_mode) {
     Renderer *r = malloc(sizeof(Renderer));
     if (!r) return NULL;
 
-    JsonCtx *ctx = malloc(sizeof(JsonCtx));
+    JsonCtx *ctx = calloc(1, sizeof(JsonCtx));
     if (!ctx) {
         free(r);
         return NULL;
     }
 
     ctx->stream_mode = stream_mode;
-    ctx->last_event_count = 0;
+    ctx->delta_mode = delta_mode;
+    jb_init(&ctx->buf);
 
     r->init = json_init;
     r->render = json_render;
     r->handle_input = json_handle_input;
     r->cleanup = json_cleanup;
+    r->idle_frames = true;
     r->ctx = ctx;
 
     return r;
@@ -133,6 +133,15 @@ static void terminal_render(Renderer *self, const SimState *state) {
 
     // Mode indicator
     printf("  Speed: %-25s\033[K\n", state->realtime_mode ? "Realtime (1ms tick)" : "Fast-forward");
+    if (state->realtime_mode && state->timing.ticks > 0) {
+        const SimTiming *t = &state->timing;
+        printf("  \033[2mPacing: %lu/%lu ticks late, max %lu.%02lu ms, %lu resyncs\033[0m\033[K\n",
+               (unsigned long)t->late_ticks, (unsigned long)t->ticks,
+               (unsigned long)(t->max_late_us / 1000), (unsigned long)(t->max_late_us % 1000 / 10),
+               (unsigned long)t->resyncs);
+    } else {
+        printf("\033[K\n");
+    }
 
     // Legend (if visible)
     if (state->legend_visible) {
@@ -214,6 +223,7 @@ Renderer* render_terminal_create(void) {
     r->render = terminal_render;
     r->handle_input = terminal_handle_input;
     r->cleanup = terminal_cleanup;
+    r->idle_frames = true;
     r->ctx = ctx;
 
     return r;
@@ -0,0 +1,154 @@
+#include "sim_clock.h"
+#include <string.h>
+
+/**
+ * @file sim_clock.c
+ * @brief Microsecond clock and interrupt controller
+ */
+
+#define US_PER_MS 1000
+
+static const char *irq_names[] = { "pcint0", "adc", "timer0_compa" };
+
+static void service(SimClock *clock, SimIrq irq) {
+    clock->pending &= ~(1u << irq);
+
+    SimIrqStats *st = &clock->stats[irq];
+    uint64_t latency = clock->now_us - clock->raised_us[irq];
+    uint32_t latency_us = (latency > UINT32_MAX) ? UINT32_MAX : (uint32_t)latency;
+    st->count++;
+    st->total_latency_us += latency_us;
+    if (latency_us > st->max_latency_us) {
+        st->max_latency_us = latency_us;
+    }
+
+    clock->handlers[irq](irq, clock->now_us, clock->handler_ctx[irq]);
+
+    // The ISR itself takes time, with interrupts off (no nesting)
+    clock->now_us += clock->cost.isr_us;
+}
+
+// Service pending vectors in priority order until none are left
+static void service_pending(SimClock *clock) {
+    while (clock->irq_enabled && clock->pending) {
+        for (int irq = 0; irq < SIM_IRQ_COUNT; irq++) {
+            if (clock->pending & (1u << irq)) {
+                service(clock, (SimIrq)irq);
+                break;
+            }
+        }
+    }
+}
+
+static void raise_at(SimClock *clock, SimIrq irq, uint64_t at_us) {
+    // Disabled vectors never interrupt the program
+    if (!clock->handlers[irq]) return;
+
+    uint32_t bit = 1u << irq;
+    if (clock->pending & bit) {
+        clock->stats[irq].lost++;
+        return;
+    }
+    clock->pending |= bit;
+    clock->raised_us[irq] = at_us;
+}
+
+void sim_clock_enable(SimClock *clock, uint32_t time_ms, uint32_t tick_us,
+                      const SimCostModel *cost) {
+    static const SimCostModel avr = SIM_COST_MODEL_AVR;
+
+    memset(clock, 0, sizeof(*clock));
+    clock->enabled = true;
+    clock->tick_us = (tick_us < 1) ? 1 : (tick_us > US_PER_MS) ? US_PER_MS : tick_us;
+    clock->cost = cost ? *cost : avr;
+    clock->now_us = (uint64_t)time_ms * US_PER_MS;
+    clock->timer0_due_us = clock->now_us + US_PER_MS;
+    clock->irq_enabled = true;
+}
+
+void sim_clock_advance_to(SimClock *clock, uint64_t target_us) {
+    if (!clock->enabled) return;
+
+    for (;;) {
+        uint64_t next = clock->timer0_due_us;
+        SimIrq irq = SIM_IRQ_TIMER0_COMPA;
+        if (clock->adc_due_us && clock->adc_due_us < next) {
+            next = clock->adc_due_us;
+            irq = SIM_IRQ_ADC;
+        }
+        if (next > target_us) break;
+
+        // An ISR may have run past the event; it is raised when due
+        if (clock->now_us < next) {
+            clock->now_us = next;
+        }
+        if (irq == SIM_IRQ_TIMER0_COMPA) {
+            clock->timer0_due_us += US_PER_MS;
+        } else {
+            clock->adc_due_us = 0;
+        }
+        raise_at(clock, irq, next);
+        service_pending(clock);
+    }
+
+    if (clock->now_us < target_us) {
+        clock->now_us = target_us;
+    }
+}
+
+void sim_clock_raise(SimClock *clock, SimIrq irq) {
+    if (!clock->enabled || irq >= SIM_IRQ_COUNT) return;
+    raise_at(clock, irq, clock->now_us);
+    service_pending(clock);
+}
+
+void sim_clock_adc_convert(SimClock *clock) {
+    if (!clock->enabled) return;
+    clock->adc_due_us = clock->now_us + clock->cost.adc_us;
+    sim_clock_advance_to(clock, clock->adc_due_us);
+}
+
+void sim_clock_cli(SimClock *clock) {
+    if (!clock->enabled || !clock->irq_enabled) return;
+    clock->irq_enabled = false;
+    clock->cli_start_us = clock->now_us;
+}
+
+void sim_clock_sei(SimClock *clock) {
+    if (!clock->enabled || clock->irq_enabled) return;
+    uint64_t off = clock->now_us - clock->cli_start_us;
+    if (off > clock->max_cli_us) {
+        clock->max_cli_us = (off > UINT32_MAX) ? UINT32_MAX : (uint32_t)off;
+    }
+    clock->irq_enabled = true;
+    service_pending(clock);
+}
+
+void sim_clock_skip(SimClock *clock, uint32_t ms) {
+    if (!clock->enabled) return;
+    uint64_t us = (uint64_t)ms * US_PER_MS;
+    clock->now_us += us;
+    clock->timer0_due_us += us;
+    if (clock->handlers[SIM_IRQ_TIMER0_COMPA]) {
+        clock->stats[SIM_IRQ_TIMER0_COMPA].count += ms;
+    }
+}
+
+void sim_clock_reset(SimClock *clock) {
+    if (!clock->enabled) return;
+    clock->now_us = 0;
+    clock->timer0_due_us = US_PER_MS;
+    clock->adc_due_us = 0;
+    clock->pending = 0;
+}
+
+void sim_clock_attach(SimClock *clock, SimIrq irq, SimIrqHandler handler, void *ctx) {
+    if (irq >= SIM_IRQ_COUNT) return;
+    clock->handlers[irq] = handler;
+    clock->handler_ctx[irq] = ctx;
+}
+
+const char* sim_irq_name(SimIrq irq) {
+    if (irq >= SIM_IRQ_COUNT) return "unknown";
+    return irq_names[irq];
+}
@@ -0,0 +1,159 @@
+#ifndef GK_SIM_CLOCK_H
+#define GK_SIM_CLOCK_H
+
+#include <stdbool.h>
+#include <stdint.h>
+
+/**
+ * @file sim_clock.h
+ * @brief Microsecond clock and interrupt controller for the simulator
+ *
+ * By default the simulator runs one main-loop pass per millisecond and
+ * time only moves between passes. With the clock enabled, time is kept
+ * in microseconds and moves inside a pass too:
+ *
+ * - Blocking HAL calls advance it by what they cost on the AVR (ADC
+ *   conversion, EEPROM write, Neopixel transfer, delay_ms).
+ * - Each main-loop pass takes at least tick_us; the loop free-runs
+ *   within a millisecond like the firmware's while(1).
+ * - Timer0 compare fires every 1000us. ADC-complete and pin-change are
+ *   due when a conversion ends and when a button pin changes.
+ *
+ * A vector is only raised, serviced and charged once an ISR is attached,
+ * like an enable bit on the AVR. The firmware enables Timer0 alone (its
+ * ISR increments millis(), as hal.c does); hal_adc_read busy-waits and
+ * the buttons are polled, so their vectors stay off.
+ *
+ * Interrupts are serviced in AVR vector priority order when raised, or
+ * when re-enabled after a cli() section (Neopixel transfer). A vector
+ * raised again while still pending is lost, like the hardware's single
+ * flag bit, so a long cli() section makes millis() fall behind.
+ * Per-vector latency statistics show the effect of blocking sections.
+ */
+
+// Interrupt vectors, in priority order (lower AVR vector number first)
+typedef enum {
+    SIM_IRQ_PCINT0,         // Pin change (buttons)
+    SIM_IRQ_ADC,            // ADC conversion complete
+    SIM_IRQ_TIMER0_COMPA,   // Timer0 compare match (1 ms tick)
+    SIM_IRQ_COUNT
+} SimIrq;
+
+/**
+ * Interrupt service routine.
+ * @param now_us  Time the ISR runs
+ */
+typedef void (*SimIrqHandler)(SimIrq irq, uint64_t now_us, void *ctx);
+
+/**
+ * Time blocking operations take on the target (8 MHz ATtiny85).
+ */
+typedef struct {
+    uint16_t adc_us;            // One conversion (13 ADC clocks at 125 kHz)
+    uint16_t eeprom_read_us;    // Byte read
+    uint16_t eeprom_write_us;   // Byte write (erase + write)
+    uint16_t neopixel_byte_us;  // 8 bits at 800 kHz, interrupts disabled
+    uint16_t neopixel_latch_us; // Reset pulse after a transfer
+    uint16_t isr_us;            // ISR entry, body and exit
+} SimCostModel;
+
+// Costs for the 8 MHz target
+#define SIM_COST_MODEL_AVR { \
+    .adc_us = 104, .eeprom_read_us = 1, .eeprom_write_us = 3400, \
+    .neopixel_byte_us = 10, .neopixel_latch_us = 60, .isr_us = 2 }
+
+typedef struct {
+    uint32_t count;             // ISRs run
+    uint32_t lost;              // Raised while already pending
+    uint32_t max_latency_us;    // Longest raise-to-service delay
+    uint64_t total_latency_us;
+} SimIrqStats;
+
+typedef struct {
+    bool enabled;
+    uint32_t tick_us;           // Shortest main-loop pass
+    SimCostModel cost;
+    uint64_t now_us;
+
+    // Interrupt controller
+    bool irq_enabled;           // Global interrupt flag (SREG I)
+    uint32_t pending;           // Bit per SimIrq
+    uint64_t raised_us[SIM_IRQ_COUNT];
+    uint64_t timer0_due_us;     // Next compare match
+    uint64_t adc_due_us;        // Conversion end (0 = idle)
+    uint64_t cli_start_us;
+    SimIrqHandler handlers[SIM_IRQ_COUNT];  // NULL: vector disabled
+    void *handler_ctx[SIM_IRQ_COUNT];
+
+    // Statistics
+    SimIrqStats stats[SIM_IRQ_COUNT];
+    uint32_t max_cli_us;        // Longest interrupts-off section
+} SimClock;
+
+/**
+ * Enable the clock at time_ms with the given pass length and costs.
+ * @param tick_us  Shortest main-loop pass (1 - 1000 us)
+ * @param cost     Blocking costs (NULL: SIM_COST_MODEL_AVR)
+ */
+void sim_clock_enable(SimClock *clock, uint32_t time_ms, uint32_t tick_us,
+                      const SimCostModel *cost);
+
+/**
+ * Run time forward to target_us, raising and servicing interrupts that
+ * fall due on the way, in time order.
+ */
+void sim_clock_advance_to(SimClock *clock, uint64_t target_us);
+
+/**
+ * Block for us microseconds (a busy-wait or blocking HAL call).
+ */
+static inline void sim_clock_spend(SimClock *clock, uint32_t us) {
+    if (clock->enabled && us > 0) {
+        sim_clock_advance_to(clock, clock->now_us + us);
+    }
+}
+
+/**
+ * Raise an interrupt now (serviced at once unless interrupts are off).
+ * Does nothing while the vector has no ISR.
+ */
+void sim_clock_raise(SimClock *clock, SimIrq irq);
+
+/**
+ * Start an ADC conversion; ADC-complete is due adc_us later.
+ * Blocks until then, like hal_adc_read's busy-wait.
+ */
+void sim_clock_adc_convert(SimClock *clock);
+
+/**
+ * Disable interrupts (cli).
+ */
+void sim_clock_cli(SimClock *clock);
+
+/**
+ * Re-enable interrupts (sei), servicing anything raised meanwhile.
+ */
+void sim_clock_sei(SimClock *clock);
+
+/**
+ * Jump over ms idle milliseconds: the Timer0 ticks in between count as
+ * serviced on time.
+ */
+void sim_clock_skip(SimClock *clock, uint32_t ms);
+
+/**
+ * Restart the clock at 0 (time reset).
+ */
+void sim_clock_reset(SimClock *clock);
+
+/**
+ * Attach an ISR to a vector, enabling it (NULL disables it).
+ */
+void sim_clock_attach(SimClock *clock, SimIrq irq, SimIrqHandler handler, void *ctx);
+
+/**
+ * Get vector name ("pcint0", "adc", "timer0_compa").
+ */
+const char* sim_irq_name(SimIrq irq);
+
+#endif /* GK_SIM_CLOCK_H */
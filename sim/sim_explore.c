@@ -0,0 +1,806 @@
+#include "state_space.h"
+#include "work_pool.h"
+
+#include <errno.h>
+#include <stdarg.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <sys/stat.h>
+#include <time.h>
+
+/**
+ * @file sim_explore.c
+ * @brief Exhaustive state-space explorer for the coordinator
+ *
+ * Breadth-first search over every state the application can reach from
+ * boot, with user actions as the edges (see state_space.h for actions,
+ * time steps and the dedup key). Each level runs on the work-stealing
+ * pool in three phases:
+ *
+ *   1. Expand: workers take slices of the frontier, check the properties
+ *      on each state and compute every successor's key. Keys already
+ *      seen on earlier levels are dropped (the key sets are read-only
+ *      during this phase).
+ *   2. Dedup: one task per key-set shard inserts that shard's candidates
+ *      in frontier order, so the first candidate of each new key wins,
+ *      exactly as in a sequential search.
+ *   3. The new states are numbered in frontier order and their snapshots
+ *      recomputed from their parents in parallel.
+ *
+ * Results don't depend on the number of workers. States keep only their
+ * parent and action, so the first failing state of a property is
+ * reached by a minimal number of actions; the explorer replays that
+ * path and writes it, plus the property's check, as a .gks script that
+ * gatekeeper-sim --script runs.
+ */
+
+#define NUM_SHARDS          64
+#define SHARD_OF(hash)      ((uint32_t)((hash) >> 58))
+#define CHUNKS_PER_WORKER   8
+#define DEFAULT_MAX_STATES  20000000u
+#define NO_NODE             UINT32_MAX
+
+// =============================================================================
+// Properties
+// =============================================================================
+
+typedef struct {
+    uint8_t buttons;        // INPUT_A / INPUT_B (CV stays as it is)
+    uint32_t hold_ms;       // 0 ends the list
+} ProbeStep;
+
+/**
+ * A property is checked from every reachable state in its scope by
+ * running its steps: it holds if the application is in PERFORM with the
+ * mode moved on by mode_delta after one of them (leaving the menu early,
+ * e.g. by a timeout due on the next tick, counts). A property without
+ * steps is checked on the state itself.
+ */
+typedef enum {
+    SCOPE_ALL,
+    SCOPE_MENU,
+    SCOPE_PERFORM
+} PropertyScope;
+
+typedef struct {
+    const char *name;
+    const char *description;
+    PropertyScope scope;
+    uint8_t mode_delta;
+    ProbeStep steps[4];
+} Property;
+
+static const Property properties[] = {
+    { "menu-exit", "the exit gesture (A, then B held) leaves the menu", SCOPE_MENU, 0,
+      { { 0, 1 }, { INPUT_A, 1 }, { INPUT_A | INPUT_B, EP_HOLD_THRESHOLD_MS + 1 } } },
+    { "menu-timeout", "the menu times out with the buttons released", SCOPE_MENU, 0,
+      { { 0, 1 }, { 0, MENU_TIMEOUT_MS } } },
+    { "mode-advance", "B, then A held, advances to the next mode", SCOPE_PERFORM, 1,
+      { { 0, 1 }, { INPUT_B, 1 }, { INPUT_A | INPUT_B, EP_HOLD_THRESHOLD_MS + 1 } } },
+    { "in-range", "FSM states and settings stay within their enums", SCOPE_ALL, 0,
+      { { 0, 0 } } },
+};
+#define NUM_PROPERTIES ((int)(sizeof(properties) / sizeof(properties[0])))
+
+static bool property_applies(const Property *prop, const Snapshot *snap) {
+    switch (prop->scope) {
+        case SCOPE_MENU:    return coordinator_in_menu(&snap->coord);
+        case SCOPE_PERFORM: return !coordinator_in_menu(&snap->coord);
+        default:            return true;
+    }
+}
+
+static ModeState expected_mode(const Property *prop, const Snapshot *snap) {
+    return (ModeState)((coordinator_get_mode(&snap->coord) + prop->mode_delta) % MODE_COUNT);
+}
+
+static bool property_reached(const Property *prop, const Snapshot *start, const Snapshot *snap) {
+    return !coordinator_in_menu(&snap->coord) &&
+           coordinator_get_mode(&snap->coord) == expected_mode(prop, start);
+}
+
+// Run the probe from `snap` (inst bound to the calling thread)
+static bool property_holds(const Property *prop, SimInstance *inst, const Snapshot *snap) {
+    if (prop->steps[0].hold_ms == 0) {
+        return state_space_in_range(snap);
+    }
+
+    Snapshot a = *snap, b;
+    for (int i = 0; i < 4 && prop->steps[i].hold_ms; i++) {
+        uint8_t inputs = prop->steps[i].buttons | (a.inputs & INPUT_CV);
+        state_space_apply(inst, &a, inputs, prop->steps[i].hold_ms, &b);
+        if (property_reached(prop, snap, &b)) return true;
+        a = b;
+    }
+    return false;
+}
+
+// Per-property results
+typedef struct {
+    uint64_t checked;
+    uint64_t failed;
+    uint32_t first;         // Frontier index (per level) or node of the first failure
+    uint32_t depth;
+} PropertyResult;
+
+// =============================================================================
+// Key Sets (one per shard, open addressing)
+// =============================================================================
+
+typedef struct {
+    StateKey *keys;
+    uint8_t *used;
+    size_t cap;             // Power of two
+    size_t count;
+} KeySet;
+
+static bool keyset_contains(const KeySet *set, const StateKey *key, uint64_t hash) {
+    if (!set->cap) return false;
+    for (size_t i = hash & (set->cap - 1);; i = (i + 1) & (set->cap - 1)) {
+        if (!set->used[i]) return false;
+        if (memcmp(&set->keys[i], key, sizeof(*key)) == 0) return true;
+    }
+}
+
+static bool keyset_grow(KeySet *set) {
+    size_t cap = set->cap ? set->cap * 2 : 1024;
+    StateKey *keys = malloc(cap * sizeof(StateKey));
+    uint8_t *used = calloc(cap, 1);
+    if (!keys || !used) {
+        free(keys);
+        free(used);
+        return false;
+    }
+    for (size_t i = 0; i < set->cap; i++) {
+        if (!set->used[i]) continue;
+        size_t j = state_key_hash(&set->keys[i]) & (cap - 1);
+        while (used[j]) j = (j + 1) & (cap - 1);
+        keys[j] = set->keys[i];
+        used[j] = 1;
+    }
+    free(set->keys);
+    free(set->used);
+    set->keys = keys;
+    set->used = used;
+    set->cap = cap;
+    return true;
+}
+
+// Returns 1 if inserted, 0 if already present, -1 out of memory
+static int keyset_insert(KeySet *set, const StateKey *key, uint64_t hash) {
+    if ((set->count + 1) * 2 > set->cap && !keyset_grow(set)) return -1;
+    size_t i = hash & (set->cap - 1);
+    for (; set->used[i]; i = (i + 1) & (set->cap - 1)) {
+        if (memcmp(&set->keys[i], key, sizeof(*key)) == 0) return 0;
+    }
+    set->keys[i] = *key;
+    set->used[i] = 1;
+    set->count++;
+    return 1;
+}
+
+// =============================================================================
+// Search State
+// =============================================================================
+
+typedef struct {
+    uint32_t parent;        // Node id, NO_NODE for the root
+    uint8_t action;
+} Node;
+
+typedef struct {
+    StateKey key;
+    uint64_t hash;
+    uint32_t parent;        // Frontier index
+    uint8_t action;
+    bool accepted;          // First of its key (set by the dedup phase)
+} Candidate;
+
+typedef struct Explorer Explorer;
+
+// One slice of the frontier (expand and snapshot phases)
+typedef struct {
+    Explorer *ex;
+    uint32_t begin, end;
+    Candidate *cands;
+    size_t num_cands, cap_cands;
+    uint64_t transitions;
+    PropertyResult results[NUM_PROPERTIES];
+    bool failed;            // Out of memory
+} Chunk;
+
+typedef struct {
+    Explorer *ex;
+    uint32_t shard;
+    bool failed;
+} ShardTask;
+
+struct Explorer {
+    int jobs;
+    bool use_cv;
+    bool grow;              // Generate successors this level
+
+    Node *nodes;
+    size_t num_nodes, cap_nodes;
+    KeySet sets[NUM_SHARDS];
+
+    // Current frontier
+    Snapshot *snaps;
+    uint32_t *node_ids;
+    uint32_t frontier;
+
+    // Next frontier, before its snapshots exist
+    Snapshot *next_snaps;
+    uint32_t *next_parent;  // Frontier index
+    uint8_t *next_action;
+
+    Chunk *chunks;
+    int num_chunks;
+    uint32_t steals;
+};
+
+static SimInstance* scratch_create(void) {
+    SimInstance *inst = malloc(sizeof(SimInstance));
+    if (inst) {
+        sim_instance_init(inst);
+    }
+    return inst;
+}
+
+static void scratch_destroy(SimInstance *inst) {
+    sim_instance_bind(NULL);
+    free(inst);
+}
+
+static bool chunk_push(Chunk *c, const Candidate *cand) {
+    if (c->num_cands == c->cap_cands) {
+        size_t cap = c->cap_cands ? c->cap_cands * 2 : 256;
+        Candidate *cands = realloc(c->cands, cap * sizeof(Candidate));
+        if (!cands) return false;
+        c->cands = cands;
+        c->cap_cands = cap;
+    }
+    c->cands[c->num_cands++] = *cand;
+    return true;
+}
+
+// Phase 1: check properties, collect successors not seen on earlier levels
+static void expand_task(void *arg) {
+    Chunk *c = (Chunk*)arg;
+    Explorer *ex = c->ex;
+    SimInstance *inst = scratch_create();
+    if (!inst) {
+        c->failed = true;
+        return;
+    }
+
+    for (uint32_t i = c->begin; i < c->end; i++) {
+        const Snapshot *snap = &ex->snaps[i];
+
+        for (int p = 0; p < NUM_PROPERTIES; p++) {
+            if (!property_applies(&properties[p], snap)) continue;
+            PropertyResult *r = &c->results[p];
+            r->checked++;
+            if (!property_holds(&properties[p], inst, snap)) {
+                if (!r->failed) r->first = i;
+                r->failed++;
+            }
+        }
+        if (!ex->grow) continue;
+
+        for (int a = 0; a < ACTION_COUNT; a++) {
+            uint8_t action = (uint8_t)a;
+            if (!ex->use_cv && (ACTION_INPUTS(action) & INPUT_CV)) continue;
+
+            Snapshot next;
+            state_space_apply_action(inst, snap, action, &next);
+            c->transitions++;
+
+            Candidate cand = { .parent = i, .action = action };
+            state_space_key(&next, &cand.key);
+            cand.hash = state_key_hash(&cand.key);
+            if (keyset_contains(&ex->sets[SHARD_OF(cand.hash)], &cand.key, cand.hash)) {
+                continue;
+            }
+            if (!chunk_push(c, &cand)) {
+                c->failed = true;
+                break;
+            }
+        }
+    }
+    scratch_destroy(inst);
+}
+
+// Phase 2: first candidate of each key in frontier order wins
+static void dedup_task(void *arg) {
+    ShardTask *t = (ShardTask*)arg;
+    Explorer *ex = t->ex;
+    KeySet *set = &ex->sets[t->shard];
+
+    for (int c = 0; c < ex->num_chunks; c++) {
+        Chunk *chunk = &ex->chunks[c];
+        for (size_t i = 0; i < chunk->num_cands; i++) {
+            Candidate *cand = &chunk->cands[i];
+            if (SHARD_OF(cand->hash) != t->shard) continue;
+            int inserted = keyset_insert(set, &cand->key, cand->hash);
+            if (inserted < 0) {
+                t->failed = true;
+                return;
+            }
+            cand->accepted = (inserted == 1);
+        }
+    }
+}
+
+// Phase 3: snapshots of the new frontier
+static void snapshot_task(void *arg) {
+    Chunk *c = (Chunk*)arg;
+    Explorer *ex = c->ex;
+    SimInstance *inst = scratch_create();
+    if (!inst) {
+        c->failed = true;
+        return;
+    }
+    for (uint32_t i = c->begin; i < c->end; i++) {
+        state_space_apply_action(inst, &ex->snaps[ex->next_parent[i]], ex->next_action[i],
+                                 &ex->next_snaps[i]);
+    }
+    scratch_destroy(inst);
+}
+
+// Split [0, count) into chunks and run `fn` on each
+static bool run_chunks(Explorer *ex, uint32_t count, WorkPoolTask fn) {
+    int max_chunks = ex->jobs * CHUNKS_PER_WORKER;
+    int n = (count < (uint32_t)max_chunks) ? (int)count : max_chunks;
+    if (n < 1) n = 1;
+
+    WorkPool *pool = work_pool_create(ex->jobs);
+    if (!pool) return false;
+
+    ex->num_chunks = n;
+    for (int i = 0; i < n; i++) {
+        Chunk *c = &ex->chunks[i];
+        free(c->cands);
+        memset(c, 0, sizeof(*c));
+        c->ex = ex;
+        c->begin = (uint32_t)((uint64_t)count * i / n);
+        c->end = (uint32_t)((uint64_t)count * (i + 1) / n);
+        if (!work_pool_submit(pool, fn, c)) {
+            work_pool_destroy(pool);
+            return false;
+        }
+    }
+    bool ok = work_pool_run(pool);
+    ex->steals += work_pool_steals(pool);
+    work_pool_destroy(pool);
+
+    for (int i = 0; i < n; i++) {
+        if (ex->chunks[i].failed) ok = false;
+    }
+    return ok;
+}
+
+static bool run_dedup(Explorer *ex) {
+    ShardTask tasks[NUM_SHARDS];
+    WorkPool *pool = work_pool_create(ex->jobs);
+    if (!pool) return false;
+
+    bool ok = true;
+    for (uint32_t s = 0; s < NUM_SHARDS && ok; s++) {
+        tasks[s] = (ShardTask){ .ex = ex, .shard = s };
+        ok = work_pool_submit(pool, dedup_task, &tasks[s]);
+    }
+    ok = ok && work_pool_run(pool);
+    ex->steals += work_pool_steals(pool);
+    work_pool_destroy(pool);
+
+    for (uint32_t s = 0; s < NUM_SHARDS; s++) {
+        if (tasks[s].failed) ok = false;
+    }
+    return ok;
+}
+
+static bool add_node(Explorer *ex, uint32_t parent, uint8_t action) {
+    if (ex->num_nodes == ex->cap_nodes) {
+        size_t cap = ex->cap_nodes ? ex->cap_nodes * 2 : 4096;
+        Node *nodes = realloc(ex->nodes, cap * sizeof(Node));
+        if (!nodes) return false;
+        ex->nodes = nodes;
+        ex->cap_nodes = cap;
+    }
+    ex->nodes[ex->num_nodes++] = (Node){ .parent = parent, .action = action };
+    return true;
+}
+
+// =============================================================================
+// Counterexample Scripts
+// =============================================================================
+
+typedef struct {
+    FILE *f;
+    uint32_t last;          // Time of the previous line
+} ScriptOut;
+
+static void script_line(ScriptOut *out, uint32_t time, const char *fmt, ...) {
+    fprintf(out->f, "%-7lu ", (unsigned long)(time - out->last));
+    va_list args;
+    va_start(args, fmt);
+    vfprintf(out->f, fmt, args);
+    va_end(args);
+    fputc('\n', out->f);
+    out->last = time;
+}
+
+static void script_inputs(ScriptOut *out, uint32_t time, uint8_t from, uint8_t to) {
+    static const struct { uint8_t bit; const char *name; } inputs[] = {
+        { INPUT_A, "a" }, { INPUT_B, "b" }, { INPUT_CV, "cv" },
+    };
+    for (int i = 0; i < 3; i++) {
+        if ((from ^ to) & inputs[i].bit) {
+            script_line(out, time, "%-7s %s", (to & inputs[i].bit) ? "press" : "release",
+                        inputs[i].name);
+        }
+    }
+}
+
+// Asserts for whatever changed since `prev` (asserts see the last tick)
+static void script_asserts(ScriptOut *out, const Snapshot *prev, const Snapshot *snap) {
+    const Coordinator *p = &prev->coord, *c = &snap->coord;
+    bool menu = coordinator_in_menu(c);
+
+    if (coordinator_get_top_state(p) != coordinator_get_top_state(c)) {
+        script_line(out, snap->now, "assert  state %s",
+                    sim_top_state_str(coordinator_get_top_state(c)));
+    }
+    if (coordinator_get_mode(p) != coordinator_get_mode(c)) {
+        script_line(out, snap->now, "assert  mode %s", sim_mode_str(coordinator_get_mode(c)));
+    }
+    if (menu && (coordinator_get_page(p) != coordinator_get_page(c) ||
+                 !coordinator_in_menu(p))) {
+        script_line(out, snap->now, "assert  page %s", sim_page_str(coordinator_get_page(c)));
+    }
+}
+
+static bool write_counterexample(const Explorer *ex, const char *dir, int p,
+                                 const PropertyResult *r, const Snapshot *root) {
+    const Property *prop = &properties[p];
+
+    // Actions from the root, in order
+    uint8_t *path = malloc(r->depth + 1);
+    if (!path) return false;
+    uint32_t len = 0;
+    for (uint32_t n = r->first; ex->nodes[n].parent != NO_NODE; n = ex->nodes[n].parent) {
+        path[len++] = ex->nodes[n].action;
+    }
+
+    char file[1024];
+    snprintf(file, sizeof(file), "%s/%s.gks", dir, prop->name);
+    ScriptOut out = { .f = fopen(file, "w"), .last = 0 };
+    if (!out.f) {
+        perror(file);
+        free(path);
+        return false;
+    }
+
+    SimInstance *inst = scratch_create();
+    if (!inst) {
+        fclose(out.f);
+        free(path);
+        return false;
+    }
+
+    fprintf(out.f, "# Counterexample for %s: %s\n", prop->name, prop->description);
+    fprintf(out.f, "# Written by gatekeeper-sim-explore: %lu action(s) from boot\n",
+            (unsigned long)len);
+    fprintf(out.f, "# Replay: gatekeeper-sim --script %s.gks --batch\n", prop->name);
+    fprintf(out.f, "\n# Path to the failing state (first column: ms since the previous line)\n");
+
+    Snapshot a = *root, b;
+    while (len > 0) {
+        uint8_t action = path[--len];
+        script_inputs(&out, a.now, a.inputs, ACTION_INPUTS(action));
+        state_space_apply_action(inst, &a, action, &b);
+        script_asserts(&out, &a, &b);
+        a = b;
+    }
+    free(path);
+
+    if (prop->steps[0].hold_ms == 0) {
+        fprintf(out.f, "\n# Out of range here: %s %s page %u\n",
+                sim_top_state_str(coordinator_get_top_state(&a.coord)),
+                sim_mode_str(coordinator_get_mode(&a.coord)),
+                (unsigned)coordinator_get_page(&a.coord));
+    } else {
+        ModeState mode = expected_mode(prop, &a);
+        fprintf(out.f, "\n# Check: %s\n", prop->description);
+        for (int i = 0; i < 4 && prop->steps[i].hold_ms; i++) {
+            uint8_t inputs = prop->steps[i].buttons | (a.inputs & INPUT_CV);
+            script_inputs(&out, a.now, a.inputs, inputs);
+            state_space_apply(inst, &a, inputs, prop->steps[i].hold_ms, &b);
+            a = b;
+        }
+        // The state never matched, so asserting it after the last step fails
+        script_line(&out, a.now, "assert  state %s", sim_top_state_str(TOP_PERFORM));
+        script_line(&out, a.now, "assert  mode %s", sim_mode_str(mode));
+    }
+    script_line(&out, a.now, "quit");
+
+    scratch_destroy(inst);
+    fclose(out.f);
+    printf("        counterexample: %s\n", file);
+    return true;
+}
+
+// =============================================================================
+// Search
+// =============================================================================
+
+static double wall_time_s(void) {
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return ts.tv_sec + ts.tv_nsec / 1e9;
+}
+
+static void print_usage(const char *progname) {
+    printf("Gatekeeper state-space explorer\n\n");
+    printf("Usage: %s [options]\n\n", progname);
+    printf("Explores every state reachable from boot by button and CV actions\n");
+    printf("held for a tick, tap, hold or menu timeout, and checks:\n");
+    for (int p = 0; p < NUM_PROPERTIES; p++) {
+        printf("  %-14s %s\n", properties[p].name, properties[p].description);
+    }
+    printf("\nOptions:\n");
+    printf("  -j, --jobs <n>      Worker threads (default: number of CPUs)\n");
+    printf("  --max-depth <n>     Stop after n actions (default: until no new states)\n");
+    printf("  --max-states <n>    Stop growing past n states (default: %u)\n",
+           DEFAULT_MAX_STATES);
+    printf("  --no-cv             Keep CV at 0 V (buttons only)\n");
+    printf("  -o, --out <dir>     Directory for counterexample scripts (default: .)\n");
+    printf("  --help              Show this help message\n");
+    printf("\n");
+    printf("A failing property writes <dir>/<property>.gks: the shortest action\n");
+    printf("sequence to a failing state, then the property's check and asserts.\n");
+    printf("Exit status is non-zero if any property fails.\n");
+}
+
+static bool parse_count(const char *arg, uint32_t *value) {
+    char *end;
+    unsigned long v = arg ? strtoul(arg, &end, 10) : 0;
+    if (!arg || *end != '\0' || v == 0 || v > UINT32_MAX - 1) return false;
+    *value = (uint32_t)v;
+    return true;
+}
+
+int main(int argc, char **argv) {
+    int jobs = 0;
+    uint32_t max_depth = 0;
+    uint32_t max_states = DEFAULT_MAX_STATES;
+    bool use_cv = true;
+    const char *out_dir = ".";
+
+    for (int i = 1; i < argc; i++) {
+        const char *next = (i + 1 < argc) ? argv[i + 1] : NULL;
+        if (strcmp(argv[i], "-j") == 0 || strcmp(argv[i], "--jobs") == 0) {
+            if (!next) {
+                fprintf(stderr, "Error: %s requires a number\n", argv[i]);
+                return 1;
+            }
+            jobs = atoi(argv[++i]);
+        } else if (strcmp(argv[i], "--max-depth") == 0) {
+            if (!parse_count(next, &max_depth)) {
+                fprintf(stderr, "Error: --max-depth requires a positive number\n");
+                return 1;
+            }
+            i++;
+        } else if (strcmp(argv[i], "--max-states") == 0) {
+            if (!parse_count(next, &max_states)) {
+                fprintf(stderr, "Error: --max-states requires a positive number\n");
+                return 1;
+            }
+            i++;
+        } else if (strcmp(argv[i], "--no-cv") == 0) {
+            use_cv = false;
+        } else if (strcmp(argv[i], "-o") == 0 || strcmp(argv[i], "--out") == 0) {
+            if (!next) {
+                fprintf(stderr, "Error: %s requires a directory\n", argv[i]);
+                return 1;
+            }
+            out_dir = argv[++i];
+        } else if (strcmp(argv[i], "--help") == 0 || strcmp(argv[i], "-h") == 0) {
+            print_usage(argv[0]);
+            return 0;
+        } else {
+            fprintf(stderr, "Unknown option: %s\n", argv[i]);
+            print_usage(argv[0]);
+            return 1;
+        }
+    }
+
+    Explorer ex = { .use_cv = use_cv };
+    WorkPool *probe = work_pool_create(jobs);
+    if (!probe) {
+        fprintf(stderr, "Error: Out of memory\n");
+        return 1;
+    }
+    ex.jobs = work_pool_num_workers(probe);
+    work_pool_destroy(probe);
+
+    ex.chunks = calloc((size_t)ex.jobs * CHUNKS_PER_WORKER, sizeof(Chunk));
+    ex.snaps = malloc(sizeof(Snapshot));
+    ex.node_ids = malloc(sizeof(uint32_t));
+    if (!ex.chunks || !ex.snaps || !ex.node_ids) {
+        fprintf(stderr, "Error: Out of memory\n");
+        return 1;
+    }
+
+    // Root: the state right after boot
+    Snapshot root;
+    SimInstance *inst = scratch_create();
+    if (!inst) {
+        fprintf(stderr, "Error: Out of memory\n");
+        return 1;
+    }
+    state_space_boot(inst, &root);
+    scratch_destroy(inst);
+
+    StateKey key;
+    state_space_key(&root, &key);
+    uint64_t hash = state_key_hash(&key);
+    if (keyset_insert(&ex.sets[SHARD_OF(hash)], &key, hash) < 0 ||
+        !add_node(&ex, NO_NODE, 0)) {
+        fprintf(stderr, "Error: Out of memory\n");
+        return 1;
+    }
+    ex.snaps[0] = root;
+    ex.node_ids[0] = 0;
+    ex.frontier = 1;
+
+    printf("Exploring from boot (mode %s), %d worker(s), %d actions per state\n",
+           sim_mode_str(coordinator_get_mode(&root.coord)), ex.jobs,
+           (use_cv ? INPUT_COMBOS : INPUT_COMBOS / 2) * STEP_COUNT);
+    printf("  %5s %10s %12s\n", "depth", "states", "total");
+
+    PropertyResult results[NUM_PROPERTIES];
+    for (int p = 0; p < NUM_PROPERTIES; p++) {
+        results[p] = (PropertyResult){ .first = NO_NODE };
+    }
+
+    double start = wall_time_s();
+    uint64_t transitions = 0;
+    uint32_t depth = 0;
+    bool truncated = false;
+    bool ok = true;
+
+    while (ex.frontier > 0 && ok) {
+        printf("  %5lu %10lu %12lu\n", (unsigned long)depth, (unsigned long)ex.frontier,
+               (unsigned long)ex.num_nodes);
+        fflush(stdout);
+
+        ex.grow = (!max_depth || depth < max_depth) && ex.num_nodes < max_states;
+        if (!ex.grow) truncated = true;
+
+        // Phase 1
+        ok = run_chunks(&ex, ex.frontier, expand_task);
+        if (!ok) break;
+        for (int c = 0; c < ex.num_chunks; c++) {
+            Chunk *chunk = &ex.chunks[c];
+            transitions += chunk->transitions;
+            for (int p = 0; p < NUM_PROPERTIES; p++) {
+                PropertyResult *r = &results[p];
+                const PropertyResult *cr = &chunk->results[p];
+                r->checked += cr->checked;
+                if (cr->failed && r->first == NO_NODE) {
+                    r->first = ex.node_ids[cr->first];
+                    r->depth = depth;
+                }
+                r->failed += cr->failed;
+            }
+        }
+        if (!ex.grow) break;
+
+        // Phase 2
+        ok = run_dedup(&ex);
+        if (!ok) break;
+
+        // Number the new states in frontier order
+        uint32_t next = 0;
+        for (int c = 0; c < ex.num_chunks; c++) {
+            for (size_t i = 0; i < ex.chunks[c].num_cands; i++) {
+                next += ex.chunks[c].cands[i].accepted;
+            }
+        }
+        free(ex.next_snaps);
+        free(ex.next_parent);
+        free(ex.next_action);
+        ex.next_snaps = malloc((size_t)(next ? next : 1) * sizeof(Snapshot));
+        ex.next_parent = malloc((size_t)(next ? next : 1) * sizeof(uint32_t));
+        ex.next_action = malloc(next ? next : 1);
+        uint32_t *next_ids = malloc((size_t)(next ? next : 1) * sizeof(uint32_t));
+        ok = ex.next_snaps && ex.next_parent && ex.next_action && next_ids;
+
+        uint32_t n = 0;
+        for (int c = 0; c < ex.num_chunks && ok; c++) {
+            const Chunk *chunk = &ex.chunks[c];
+            for (size_t i = 0; i < chunk->num_cands && ok; i++) {
+                const Candidate *cand = &chunk->cands[i];
+                if (!cand->accepted) continue;
+                ex.next_parent[n] = cand->parent;
+                ex.next_action[n] = cand->action;
+                next_ids[n] = (uint32_t)ex.num_nodes;
+                ok = add_node(&ex, ex.node_ids[cand->parent], cand->action);
+                n++;
+            }
+        }
+
+        // Phase 3
+        ok = ok && run_chunks(&ex, next, snapshot_task);
+        if (!ok) {
+            free(next_ids);
+            break;
+        }
+
+        free(ex.snaps);
+        free(ex.node_ids);
+        ex.snaps = ex.next_snaps;
+        ex.node_ids = next_ids;
+        ex.frontier = next;
+        ex.next_snaps = NULL;
+        depth++;
+    }
+    double secs = wall_time_s() - start;
+
+    if (!ok) {
+        fprintf(stderr, "Error: Out of memory after %lu states\n", (unsigned long)ex.num_nodes);
+        return 1;
+    }
+
+    printf("\nExplored %lu states, %llu transitions, depth %lu in %.1f s",
+           (unsigned long)ex.num_nodes, (unsigned long long)transitions,
+           (unsigned long)depth, secs);
+    if (ex.jobs > 1) {
+        printf(" (%lu steals)", (unsigned long)ex.steals);
+    }
+    printf("\n");
+    if (truncated) {
+        printf("Search cut short by --max-depth/--max-states: the deepest level was "
+               "checked but not expanded\n");
+    }
+
+    int failures = 0;
+    for (int p = 0; p < NUM_PROPERTIES; p++) {
+        const Property *prop = &properties[p];
+        const PropertyResult *r = &results[p];
+        if (!r->failed) {
+            printf("  PASS  %-14s %s (%llu states)\n", prop->name, prop->description,
+                   (unsigned long long)r->checked);
+            continue;
+        }
+        failures++;
+        printf("  FAIL  %-14s %s (%llu of %llu states, first at depth %lu)\n",
+               prop->name, prop->description, (unsigned long long)r->failed,
+               (unsigned long long)r->checked, (unsigned long)r->depth);
+        if (mkdir(out_dir, 0755) != 0 && errno != EEXIST) {
+            perror(out_dir);
+            continue;
+        }
+        write_counterexample(&ex, out_dir, p, r, &root);
+    }
+
+    for (int s = 0; s < NUM_SHARDS; s++) {
+        free(ex.sets[s].keys);
+        free(ex.sets[s].used);
+    }
+    for (int c = 0; c < ex.jobs * CHUNKS_PER_WORKER; c++) {
+        free(ex.chunks[c].cands);
+    }
+    free(ex.chunks);
+    free(ex.nodes);
+    free(ex.snaps);
+    free(ex.node_ids);
+    free(ex.next_parent);
+    free(ex.next_action);
+    free(ex.next_snaps);
+
+    return failures ? 1 : 0;
+}
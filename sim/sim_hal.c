@@ -11,30 +11,11 @@
  * Display is handled by renderers.
  */
 
-// Simulated hardware state
-#define SIM_NUM_PINS 8
-static uint8_t pin_states[SIM_NUM_PINS] = {0};
-
-// Simulated EEPROM
-#define SIM_EEPROM_SIZE 512
-static uint8_t sim_eeprom[SIM_EEPROM_SIZE];
-
-// Time tracking
-static uint32_t sim_time_ms = 0;
-
-// LED state (for neopixel simulation)
-static uint8_t led_r[SIM_NUM_LEDS] = {0};
-static uint8_t led_g[SIM_NUM_LEDS] = {0};
-static uint8_t led_b[SIM_NUM_LEDS] = {0};
-
-// CV input voltage (0-255 ADC value, maps to 0-5V)
-static uint8_t sim_cv_voltage = 0;
+// Hardware bound to this thread (see sim_hal_bind)
+static GK_THREAD_LOCAL SimHardware *hw = NULL;
 
 // Watchdog simulation
 #define SIM_WDT_TIMEOUT_MS 250
-static bool wdt_enabled = false;
-static uint32_t wdt_last_reset_time = 0;
-static bool wdt_fired = false;
 
 // Pin assignments (match mock_hal for consistency)
 // Note: Neopixels are controlled via sim_neopixel.c, not GPIO
@@ -42,6 +23,10 @@ static bool wdt_fired = false;
 #define PIN_BUTTON_B    4
 #define PIN_SIG_OUT     1   // Also drives output LED via buffer circuit
 
+// Count a HAL call from the application (see sim_set_hal_stats)
+#define SIM_HAL_STAT(fn) \
+    if (hw->hal_stats.enabled) hal_stats_record(&hw->hal_stats, fn, HAL_STATS_CALLER())
+
 // Forward declarations
 static void sim_hal_init(void);
 static void sim_set_pin(uint8_t pin);
@@ -64,7 +49,7 @@ static void sim_wdt_disable(void);
 static void check_watchdog(void);
 
 // Global HAL pointer (defined in hal_interface.h as extern)
-HalInterface *p_hal = NULL;
+GK_THREAD_LOCAL HalInterface *p_hal = NULL;
 
 // The simulator HAL interface
 static HalInterface sim_hal = {
@@ -97,171 +82,288 @@ static HalInterface sim_hal = {
 // =============================================================================
 
 static void sim_hal_init(void) {
-    memset(pin_states, 0, sizeof(pin_states));
+    SIM_HAL_STAT(HAL_FN_INIT);
+    memset(hw->pin_states, 0, sizeof(hw->pin_states));
     // Button pins start HIGH (simulating internal pull-ups, active-low buttons)
     // Press = clear pin (LOW), Release = set pin (HIGH)
-    pin_states[PIN_BUTTON_A] = 1;
-    pin_states[PIN_BUTTON_B] = 1;
+    hw->pin_states[PIN_BUTTON_A] = 1;
+    hw->pin_states[PIN_BUTTON_B] = 1;
 
-    memset(sim_eeprom, 0xFF, sizeof(sim_eeprom));
-    sim_time_ms = 0;
+    memset(hw->eeprom, 0xFF, sizeof(hw->eeprom));
+    hw->time_ms = 0;
 }
 
 static void sim_set_pin(uint8_t pin) {
+    SIM_HAL_STAT(HAL_FN_SET_PIN);
+    cycle_account_charge(&hw->cycles, CYCLE_OP_PIN);
     if (pin >= SIM_NUM_PINS) return;
-    pin_states[pin] = 1;
+    hw->pin_states[pin] = 1;
 }
 
 static void sim_clear_pin(uint8_t pin) {
+    SIM_HAL_STAT(HAL_FN_CLEAR_PIN);
+    cycle_account_charge(&hw->cycles, CYCLE_OP_PIN);
     if (pin >= SIM_NUM_PINS) return;
-    pin_states[pin] = 0;
+    hw->pin_states[pin] = 0;
 }
 
 static void sim_toggle_pin(uint8_t pin) {
+    SIM_HAL_STAT(HAL_FN_TOGGLE_PIN);
+    cycle_account_charge(&hw->cycles, CYCLE_OP_PIN);
     if (pin >= SIM_NUM_PINS) return;
-    pin_states[pin] = !pin_states[pin];
+    hw->pin_states[pin] = !hw->pin_states[pin];
 }
 
 static uint8_t sim_read_pin(uint8_t pin) {
+    SIM_HAL_STAT(HAL_FN_READ_PIN);
+    cycle_account_charge(&hw->cycles, CYCLE_OP_PIN);
     if (pin >= SIM_NUM_PINS) return 0;
-    return pin_states[pin];
+    return hw->pin_states[pin];
 }
 
 static void sim_init_timer(void) {
-    // Nothing needed
+    SIM_HAL_STAT(HAL_FN_INIT_TIMER);
 }
 
 static uint32_t sim_millis(void) {
-    return sim_time_ms;
+    SIM_HAL_STAT(HAL_FN_MILLIS);
+    cycle_account_charge(&hw->cycles, CYCLE_OP_MILLIS);
+    return hw->time_ms;
 }
 
 static void sim_delay_ms(uint32_t ms) {
-    sim_time_ms += ms;
+    SIM_HAL_STAT(HAL_FN_DELAY_MS);
+    cycle_account_add(&hw->cycles, ms * (CYCLE_CPU_HZ / 1000));
+    if (hw->clock.enabled) {
+        sim_clock_spend(&hw->clock, ms * 1000);
+        return;
+    }
+    hw->time_ms += ms;
     check_watchdog();
 }
 
 static void sim_advance_time(uint32_t ms) {
-    sim_time_ms += ms;
+    SIM_HAL_STAT(HAL_FN_ADVANCE_TIME);
+    if (hw->clock.enabled) {
+        sim_clock_spend(&hw->clock, ms * 1000);
+        return;
+    }
+    hw->time_ms += ms;
     check_watchdog();
 }
 
 void sim_reset_time(void) {
-    sim_time_ms = 0;
+    SIM_HAL_STAT(HAL_FN_RESET_TIME);
+    hw->time_ms = 0;
+    sim_clock_reset(&hw->clock);
+}
+
+void sim_skip_time(uint32_t ms) {
+    if (ms == 0) return;
+    hw->time_ms += ms;
+    sim_clock_skip(&hw->clock, ms);
+    adc_model_skip(&hw->adc, ms);
+    // The last skipped iteration fed the watchdog one tick ago
+    if (hw->wdt_enabled) {
+        hw->wdt_last_reset_time = hw->time_ms - 1;
+    }
+    check_watchdog();
 }
 
 static uint8_t sim_eeprom_read_byte(uint16_t addr) {
+    SIM_HAL_STAT(HAL_FN_EEPROM_READ_BYTE);
+    cycle_account_charge(&hw->cycles, CYCLE_OP_EEPROM_READ);
+    sim_clock_spend(&hw->clock, hw->clock.cost.eeprom_read_us);
     if (addr >= SIM_EEPROM_SIZE) return 0xFF;
-    return sim_eeprom[addr];
+    return hw->eeprom[addr];
 }
 
 static void sim_eeprom_write_byte(uint16_t addr, uint8_t value) {
+    SIM_HAL_STAT(HAL_FN_EEPROM_WRITE_BYTE);
+    cycle_account_charge(&hw->cycles, CYCLE_OP_EEPROM_WRITE);
+    sim_clock_spend(&hw->clock, hw->clock.cost.eeprom_write_us);
     if (addr >= SIM_EEPROM_SIZE) return;
-    sim_eeprom[addr] = value;
+    hw->eeprom[addr] = value;
 }
 
 static uint16_t sim_eeprom_read_word(uint16_t addr) {
+    SIM_HAL_STAT(HAL_FN_EEPROM_READ_WORD);
+    cycle_account_add(&hw->cycles, 2 * hw->cycles.config.op[CYCLE_OP_EEPROM_READ]);
+    sim_clock_spend(&hw->clock, 2 * hw->clock.cost.eeprom_read_us);
     if (addr + 1 >= SIM_EEPROM_SIZE) return 0xFFFF;
-    return sim_eeprom[addr] | ((uint16_t)sim_eeprom[addr + 1] << 8);
+    return hw->eeprom[addr] | ((uint16_t)hw->eeprom[addr + 1] << 8);
 }
 
 static void sim_eeprom_write_word(uint16_t addr, uint16_t value) {
+    SIM_HAL_STAT(HAL_FN_EEPROM_WRITE_WORD);
+    cycle_account_add(&hw->cycles, 2 * hw->cycles.config.op[CYCLE_OP_EEPROM_WRITE]);
+    sim_clock_spend(&hw->clock, 2 * hw->clock.cost.eeprom_write_us);
     if (addr + 1 >= SIM_EEPROM_SIZE) return;
-    sim_eeprom[addr] = value & 0xFF;
-    sim_eeprom[addr + 1] = (value >> 8) & 0xFF;
+    hw->eeprom[addr] = value & 0xFF;
+    hw->eeprom[addr + 1] = (value >> 8) & 0xFF;
+}
+
+void sim_load_eeprom(const uint8_t *image, uint16_t size) {
+    if (size > SIM_EEPROM_SIZE) size = SIM_EEPROM_SIZE;
+    memcpy(hw->eeprom, image, size);
 }
 
 static uint8_t sim_adc_read(uint8_t channel) {
+    SIM_HAL_STAT(HAL_FN_ADC_READ);
+    cycle_account_charge(&hw->cycles, CYCLE_OP_ADC);
     // In simulator, channel 3 (CV input) returns the simulated CV voltage
-    // Other channels return 0
+    // through the front-end model. Other channels return 0. The input
+    // is sampled at the start of the conversion, then the busy-wait
+    // blocks until ADC-complete
+    uint8_t result = 0;
     if (channel == 3) {
-        return sim_cv_voltage;
+        uint64_t now_us = hw->clock.enabled ? hw->clock.now_us : (uint64_t)hw->time_ms * 1000;
+        result = adc_model_read(&hw->adc, hw->cv_voltage, hw->pin_states[PIN_SIG_OUT], now_us);
     }
-    return 0;
+    sim_clock_adc_convert(&hw->clock);
+    return result;
+}
+
+// Timer0 compare ISR: the millis() tick (mirrors hal.c)
+static void timer0_isr(SimIrq irq, uint64_t now_us, void *ctx) {
+    (void)irq;
+    (void)now_us;
+    SimHardware *h = ctx;
+    h->time_ms++;
+    check_watchdog();
 }
 
 // Watchdog simulation - checks if timeout exceeded
 static void check_watchdog(void) {
-    if (wdt_enabled && !wdt_fired) {
-        uint32_t elapsed = sim_time_ms - wdt_last_reset_time;
+    if (hw->wdt_enabled && !hw->wdt_fired) {
+        uint32_t elapsed = hw->time_ms - hw->wdt_last_reset_time;
         if (elapsed >= SIM_WDT_TIMEOUT_MS) {
-            wdt_fired = true;
+            hw->wdt_fired = true;
             fprintf(stderr, "\n*** WATCHDOG FIRED! ***\n");
             fprintf(stderr, "    Time since last wdt_reset: %u ms (timeout: %d ms)\n",
                     (unsigned)elapsed, SIM_WDT_TIMEOUT_MS);
-            fprintf(stderr, "    Current time: %u ms\n", (unsigned)sim_time_ms);
+            fprintf(stderr, "    Current time: %u ms\n", (unsigned)hw->time_ms);
             fprintf(stderr, "    This would reset the MCU and cause a boot loop!\n\n");
         }
     }
 }
 
 static void sim_wdt_enable(void) {
-    wdt_enabled = true;
-    wdt_last_reset_time = sim_time_ms;
-    wdt_fired = false;
+    SIM_HAL_STAT(HAL_FN_WDT_ENABLE);
+    hw->wdt_enabled = true;
+    hw->wdt_last_reset_time = hw->time_ms;
+    hw->wdt_fired = false;
 }
 
 static void sim_wdt_reset(void) {
-    if (wdt_enabled) {
-        wdt_last_reset_time = sim_time_ms;
+    SIM_HAL_STAT(HAL_FN_WDT_RESET);
+    cycle_account_charge(&hw->cycles, CYCLE_OP_WDT_RESET);
+    if (hw->wdt_enabled) {
+        hw->wdt_last_reset_time = hw->time_ms;
     }
 }
 
 static void sim_wdt_disable(void) {
-    wdt_enabled = false;
+    SIM_HAL_STAT(HAL_FN_WDT_DISABLE);
+    hw->wdt_enabled = false;
 }
 
 // =============================================================================
 // Public API
 // =============================================================================
 
+void sim_hal_bind(SimHardware *bound) {
+    hw = bound;
+}
+
+SimHardware* sim_hal_bound(void) {
+    return hw;
+}
+
 HalInterface* sim_get_hal(void) {
     return &sim_hal;
 }
 
+// Drive an input pin, raising pin-change on an edge
+static void set_input_pin(uint8_t pin, uint8_t level) {
+    if (hw->pin_states[pin] == level) return;
+    hw->pin_states[pin] = level;
+    sim_clock_raise(&hw->clock, SIM_IRQ_PCINT0);
+}
+
 void sim_set_button_a(bool pressed) {
     // Active-low: pressed = LOW (0), released = HIGH (1)
-    pin_states[PIN_BUTTON_A] = !pressed;
+    set_input_pin(PIN_BUTTON_A, !pressed);
 }
 
 void sim_set_button_b(bool pressed) {
     // Active-low: pressed = LOW (0), released = HIGH (1)
-    pin_states[PIN_BUTTON_B] = !pressed;
+    set_input_pin(PIN_BUTTON_B, !pressed);
 }
 
 void sim_set_cv_voltage(uint8_t adc_value) {
-    sim_cv_voltage = adc_value;
+    hw->cv_voltage = adc_value;
 }
 
 void sim_adjust_cv_voltage(int16_t delta) {
-    int16_t new_value = (int16_t)sim_cv_voltage + delta;
+    int16_t new_value = (int16_t)hw->cv_voltage + delta;
     if (new_value < 0) new_value = 0;
     if (new_value > 255) new_value = 255;
-    sim_cv_voltage = (uint8_t)new_value;
+    hw->cv_voltage = (uint8_t)new_value;
+}
+
+void sim_set_adc_model(const AdcModelConfig *config) {
+    adc_model_init(&hw->adc, config);
+}
+
+bool sim_adc_is_static(void) {
+    return adc_model_is_static(&hw->adc, hw->cv_voltage, hw->pin_states[PIN_SIG_OUT]);
+}
+
+void sim_set_clock(uint32_t tick_us) {
+    sim_clock_enable(&hw->clock, hw->time_ms, tick_us, NULL);
+    sim_clock_attach(&hw->clock, SIM_IRQ_TIMER0_COMPA, timer0_isr, hw);
+}
+
+SimClock* sim_get_clock(void) {
+    return &hw->clock;
+}
+
+void sim_set_cycle_cost(const CycleCostConfig *config) {
+    cycle_account_init(&hw->cycles, config);
+}
+
+void sim_set_hal_stats(void) {
+    hal_stats_init(&hw->hal_stats);
+}
+
+HalStats* sim_get_hal_stats(void) {
+    return &hw->hal_stats;
 }
 
 bool sim_get_button_a(void) {
     // Active-low: pin LOW = pressed (return true)
-    return !pin_states[PIN_BUTTON_A];
+    return !hw->pin_states[PIN_BUTTON_A];
 }
 
 bool sim_get_button_b(void) {
     // Active-low: pin LOW = pressed (return true)
-    return !pin_states[PIN_BUTTON_B];
+    return !hw->pin_states[PIN_BUTTON_B];
 }
 
 uint8_t sim_get_cv_voltage(void) {
-    return sim_cv_voltage;
+    return hw->cv_voltage;
 }
 
 bool sim_get_output(void) {
-    return pin_states[PIN_SIG_OUT];
+    return hw->pin_states[PIN_SIG_OUT];
 }
 
 void sim_set_led(uint8_t index, uint8_t r, uint8_t g, uint8_t b) {
     if (index >= SIM_NUM_LEDS) return;
-    led_r[index] = r;
-    led_g[index] = g;
-    led_b[index] = b;
+    hw->led_r[index] = r;
+    hw->led_g[index] = g;
+    hw->led_b[index] = b;
 }
 
 void sim_get_led(uint8_t index, uint8_t *r, uint8_t *g, uint8_t *b) {
@@ -271,19 +373,19 @@ void sim_get_led(uint8_t index, uint8_t *r, uint8_t *g, uint8_t *b) {
         if (b) *b = 0;
         return;
     }
-    if (r) *r = led_r[index];
-    if (g) *g = led_g[index];
-    if (b) *b = led_b[index];
+    if (r) *r = hw->led_r[index];
+    if (g) *g = hw->led_g[index];
+    if (b) *b = hw->led_b[index];
 }
 
 uint32_t sim_get_time(void) {
-    return sim_time_ms;
+    return hw->time_ms;
 }
 
 bool sim_wdt_has_fired(void) {
-    return wdt_fired;
+    return hw->wdt_fired;
 }
 
 void sim_wdt_clear_fired(void) {
-    wdt_fired = false;
+    hw->wdt_fired = false;
 }
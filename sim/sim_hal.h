@@ -2,6 +2,11 @@
 #define GK_SIM_HAL_H
 
 #include "hardware/hal_interface.h"
+#include "output/neopixel.h"
+#include "adc_model.h"
+#include "sim_clock.h"
+#include "cycle_cost.h"
+#include "hal_stats.h"
 #include <stdbool.h>
 #include <stdint.h>
 
@@ -11,11 +16,71 @@
  *
  * Pure hardware abstraction layer for x86 simulator.
  * Display is handled separately by renderers.
+ *
+ * All hardware state lives in a SimHardware struct. The HAL functions
+ * act on the struct bound to the calling thread, so several simulated
+ * devices can run in one process, one per thread.
  */
 
 // Number of simulated LEDs
 #define SIM_NUM_LEDS 2
 
+// Number of simulated GPIO pins
+#define SIM_NUM_PINS 8
+
+// Simulated EEPROM size (bytes)
+#define SIM_EEPROM_SIZE 512
+
+/**
+ * Simulated hardware state for one device.
+ */
+typedef struct {
+    uint8_t pin_states[SIM_NUM_PINS];
+    uint8_t eeprom[SIM_EEPROM_SIZE];
+    uint32_t time_ms;
+
+    // LED state as shown by renderers
+    uint8_t led_r[SIM_NUM_LEDS];
+    uint8_t led_g[SIM_NUM_LEDS];
+    uint8_t led_b[SIM_NUM_LEDS];
+
+    // Neopixel driver buffer (sim_neopixel.c)
+    NeopixelColor neopixel[NEOPIXEL_COUNT];
+    bool neopixel_dirty;
+
+    // CV input voltage (0-255 ADC value, maps to 0-5V)
+    uint8_t cv_voltage;
+
+    // Analog front end between cv_voltage and the ADC (ideal when zeroed)
+    AdcModel adc;
+
+    // Microsecond clock and interrupts (disabled: 1 ms steps)
+    SimClock clock;
+
+    // AVR cycle accounting of main-loop passes (disabled when zeroed)
+    CycleAccount cycles;
+
+    // HAL call counts per function and call site (disabled when zeroed)
+    HalStats hal_stats;
+
+    // Watchdog simulation
+    bool wdt_enabled;
+    uint32_t wdt_last_reset_time;
+    bool wdt_fired;
+} SimHardware;
+
+/**
+ * Bind simulated hardware to the calling thread.
+ * All HAL calls and sim_* accessors on this thread act on hw.
+ * Must be called before p_hal->init().
+ */
+void sim_hal_bind(SimHardware *hw);
+
+/**
+ * Get the hardware bound to the calling thread (NULL if none).
+ */
+SimHardware* sim_hal_bound(void);
+
 /**
  * Get the simulator HAL interface.
  * Assign to p_hal before running app code.
@@ -41,6 +106,47 @@ void sim_set_cv_voltage(uint8_t adc_value);
  */
 void sim_adjust_cv_voltage(int16_t delta);
 
+/**
+ * Configure the analog front-end model of the CV ADC input.
+ * NULL (the default) gives an ideal ADC returning the CV voltage exactly.
+ */
+void sim_set_adc_model(const AdcModelConfig *config);
+
+/**
+ * Check that ADC reads are constant while the CV voltage and output are
+ * (see adc_model_is_static).
+ */
+bool sim_adc_is_static(void);
+
+/**
+ * Switch to microsecond time with interrupt and HAL cost modeling
+ * (see sim_clock.h). Call after p_hal->init() and before app init.
+ * @param tick_us  Shortest main-loop pass (1 - 1000 us)
+ */
+void sim_set_clock(uint32_t tick_us);
+
+/**
+ * Get the bound device's clock (clock->enabled is false in 1 ms mode).
+ */
+SimClock* sim_get_clock(void);
+
+/**
+ * Enable AVR cycle accounting of main-loop passes (see cycle_cost.h).
+ * @param config  Cost table and budget (NULL: defaults)
+ */
+void sim_set_cycle_cost(const CycleCostConfig *config);
+
+/**
+ * Enable HAL call counting (see hal_stats.h). The instance tags each
+ * main-loop pass with its mode and ends a tick after it.
+ */
+void sim_set_hal_stats(void);
+
+/**
+ * Get the bound device's HAL call counts (enabled is false when off).
+ */
+HalStats* sim_get_hal_stats(void);
+
 /**
  * Input state getters.
  */
@@ -68,11 +174,24 @@ void sim_get_led(uint8_t index, uint8_t *r, uint8_t *g, uint8_t *b);
  */
 uint32_t sim_get_time(void);
 
+/**
+ * Skip simulation time forward by ms.
+ * Equivalent to ms idle main loop iterations: the watchdog is treated
+ * as fed on every skipped tick, so it only fires for real stalls.
+ */
+void sim_skip_time(uint32_t ms);
+
 /**
  * Reset simulation time to 0.
  */
 void sim_reset_time(void);
 
+/**
+ * Load an EEPROM image (e.g. from a trace) before app init.
+ * Bytes past size keep their current value.
+ */
+void sim_load_eeprom(const uint8_t *image, uint16_t size);
+
 /**
  * Check if the simulated watchdog has fired.
  * Returns true if wdt_enable() was called and more than 250ms
@@ -0,0 +1,408 @@
+#include "sim_instance.h"
+#include "sim_schedule.h"
+#include <string.h>
+
+/**
+ * @file sim_instance.c
+ * @brief Simulated Gatekeeper instance implementation
+ *
+ * The tick functions mirror the main loop in main.c, with the
+ * simulator's input handling and state observation around it.
+ */
+
+// Most ticks of a changing CV source looked at per skip
+#define SIM_CV_LOOKAHEAD_MS 1000
+
+// Instance bound to this thread (see sim_instance_bind)
+static GK_THREAD_LOCAL SimInstance *current = NULL;
+
+CVSource* sim_get_cv_source(void) {
+    return current ? &current->cv_source : NULL;
+}
+
+// Track input state changes (sim-specific observation)
+static void track_input_changes(SimInstance *inst) {
+    SimTracking *t = &inst->track;
+
+    bool button_a = sim_get_button_a();
+    bool button_b = sim_get_button_b();
+    uint8_t cv_voltage = sim_get_cv_voltage();
+
+    if (button_a != t->button_a) {
+        sim_state_add_event(&inst->state, EVT_TYPE_INPUT, sim_get_time(),
+            "Button A %s", button_a ? "pressed" : "released");
+        t->button_a = button_a;
+    }
+
+    if (button_b != t->button_b) {
+        sim_state_add_event(&inst->state, EVT_TYPE_INPUT, sim_get_time(),
+            "Button B %s", button_b ? "pressed" : "released");
+        t->button_b = button_b;
+    }
+
+    // Only log CV changes when they cross thresholds (avoid noise from +/-)
+    // Log when voltage changes significantly (> ~0.5V)
+    if ((cv_voltage > t->cv_voltage + SIM_CV_LOG_DELTA) ||
+        (cv_voltage + SIM_CV_LOG_DELTA < t->cv_voltage)) {
+        uint16_t mv = (uint16_t)cv_voltage * 5000 / 255;
+        sim_state_add_event(&inst->state, EVT_TYPE_INPUT, sim_get_time(),
+            "CV -> %u.%uV", mv / 1000, (mv % 1000) / 100);
+        t->cv_voltage = cv_voltage;
+    }
+}
+
+// Update state tracking for render/logging (sim-specific observation)
+static void track_state_changes(SimInstance *inst) {
+    SimTracking *t = &inst->track;
+    Coordinator *coord = &inst->coordinator;
+
+    TopState top_state = coordinator_get_top_state(coord);
+    ModeState mode = coordinator_get_mode(coord);
+    MenuPage page = coordinator_get_page(coord);
+    bool in_menu = coordinator_in_menu(coord);
+    bool output = coordinator_get_output(coord);
+
+    // Log state changes (sim-specific event logging)
+    if (top_state != t->top_state) {
+        sim_state_add_event(&inst->state, EVT_TYPE_STATE_CHANGE, sim_get_time(),
+            "State -> %s", sim_top_state_str(top_state));
+        t->top_state = top_state;
+    }
+
+    if (mode != t->mode) {
+        sim_state_add_event(&inst->state, EVT_TYPE_MODE_CHANGE, sim_get_time(),
+            "Mode -> %s", sim_mode_str(mode));
+        t->mode = mode;
+    }
+
+    if (in_menu && page != t->page) {
+        sim_state_add_event(&inst->state, EVT_TYPE_PAGE_CHANGE, sim_get_time(),
+            "Page -> %s", sim_page_str(page));
+        t->page = page;
+    }
+
+    if (output != t->output) {
+        sim_state_add_event(&inst->state, EVT_TYPE_OUTPUT, sim_get_time(),
+            "Output -> %s", output ? "HIGH" : "LOW");
+        t->output = output;
+    }
+
+    // Update state struct for renderer
+    sim_state_set_fsm(&inst->state, top_state, mode, page, in_menu);
+    sim_state_set_output(&inst->state, output);
+}
+
+// Copy the inputs and LEDs into the observed state
+static void observe_signals(SimInstance *inst) {
+    bool cv_digital = coordinator_get_cv_state(&inst->coordinator);
+    sim_state_set_inputs(&inst->state,
+        sim_get_button_a(),
+        sim_get_button_b(),
+        cv_digital,
+        sim_get_cv_voltage());
+
+    for (int i = 0; i < SIM_NUM_LEDS; i++) {
+        uint8_t r, g, b;
+        sim_get_led(i, &r, &g, &b);
+        sim_state_set_led(&inst->state, i, r, g, b);
+    }
+}
+
+// Publish observed state for renderers and the input source
+static void observe_state(SimInstance *inst) {
+    track_state_changes(inst);
+    observe_signals(inst);
+    sim_state_set_time(&inst->state, inst->tick_time);
+
+    inst->input->observe(inst->input, &inst->state);
+}
+
+void sim_instance_init(SimInstance *inst) {
+    memset(inst, 0, sizeof(*inst));
+
+    inst->track.top_state = TOP_PERFORM;
+    inst->track.mode = MODE_GATE;
+    inst->track.page = PAGE_GATE_CV;
+
+    sim_state_init(&inst->state);
+
+    sim_instance_bind(inst);
+
+    // Initialize hardware (via sim HAL)
+    p_hal->init();
+
+    // Initialize CV source (starts in manual mode at 0V)
+    cv_source_init(&inst->cv_source);
+}
+
+void sim_instance_bind(SimInstance *inst) {
+    current = inst;
+    sim_hal_bind(inst ? &inst->hw : NULL);
+    p_hal = inst ? sim_get_hal() : NULL;
+}
+
+SimInstance* sim_instance_current(void) {
+    return current;
+}
+
+AppInitResult sim_instance_start(SimInstance *inst, InputSource *input) {
+    inst->input = input;
+
+    // EEPROM as the app will find it, for the trace header
+    uint8_t boot_eeprom[SIM_EEPROM_SIZE];
+    memcpy(boot_eeprom, inst->hw.eeprom, sizeof(boot_eeprom));
+
+    // Run app initialization
+    AppInitResult init_result = app_init_run(&inst->settings);
+
+    if (inst->trace) {
+        trace_writer_begin(inst->trace, boot_eeprom, sizeof(boot_eeprom),
+                           &inst->settings, &inst->hw.adc.config, sim_get_time());
+    }
+
+    if (init_result == APP_INIT_OK_FACTORY_RESET) {
+        sim_state_add_event(&inst->state, EVT_TYPE_INFO, sim_get_time(), "Factory reset performed");
+    } else if (init_result == APP_INIT_OK_DEFAULTS) {
+        sim_state_add_event(&inst->state, EVT_TYPE_INFO, sim_get_time(), "Using default settings");
+    }
+
+    // Initialize coordinator
+    coordinator_init(&inst->coordinator, &inst->settings);
+
+    // Restore mode from saved settings
+    if (inst->settings.mode < MODE_COUNT) {
+        coordinator_set_mode(&inst->coordinator, (ModeState)inst->settings.mode);
+    }
+
+    // Start coordinator
+    coordinator_start(&inst->coordinator);
+
+    // Initialize LED feedback controller
+    led_feedback_init(&inst->led_ctrl);
+    led_feedback_set_mode(&inst->led_ctrl, coordinator_get_mode(&inst->coordinator));
+
+    sim_state_add_event(&inst->state, EVT_TYPE_INFO, sim_get_time(),
+        "App initialized, mode=%s", sim_mode_str(coordinator_get_mode(&inst->coordinator)));
+
+    // Enable watchdog timer (250ms timeout) after init complete
+    // This mirrors main.c - watchdog must be enabled AFTER app_init completes
+    p_hal->wdt_enable();
+
+    // Initial observation, so the first tick's script asserts see real state
+    inst->tick_time = p_hal->millis();
+    observe_state(inst);
+
+    if (inst->vcd) {
+        const SimClock *clock = &inst->hw.clock;
+        vcd_writer_begin(inst->vcd, &inst->state, clock->enabled,
+                         clock->enabled ? clock->now_us : inst->tick_time);
+    }
+
+    return init_result;
+}
+
+// Tag HAL calls with the mode, or MODE_COUNT in the menu
+static void tag_hal_stats(SimInstance *inst) {
+    HalStats *stats = &inst->hw.hal_stats;
+    if (stats->enabled) {
+        hal_stats_set_tag(stats, coordinator_in_menu(&inst->coordinator)
+                                 ? MODE_COUNT : coordinator_get_mode(&inst->coordinator));
+    }
+}
+
+bool sim_instance_begin_tick(SimInstance *inst) {
+    tag_hal_stats(inst);
+
+    // Feed watchdog at start of each loop iteration (mirrors main.c)
+    p_hal->wdt_reset();
+
+    inst->tick_time = p_hal->millis();
+
+    // ========== SIM-SPECIFIC: Input handling ==========
+    return inst->input->update(inst->input, inst->tick_time);
+}
+
+// Flag a pass over budget: the first one, then each new worst
+static void check_loop_budget(SimInstance *inst) {
+    CycleAccount *cycles = &inst->hw.cycles;
+    uint32_t worst = cycles->total.max_cycles;
+    uint32_t pass;
+    uint8_t flags = cycle_account_end_pass(cycles, sim_get_time(), &pass);
+
+    if (flags && (pass > worst || cycles->over_budget + cycles->over_watchdog == 1)) {
+        sim_state_add_event(&inst->state, EVT_TYPE_INFO, sim_get_time(),
+            "Loop pass %lu cycles (%lu us) over %s",
+            (unsigned long)pass, (unsigned long)CYCLE_US(pass),
+            (flags & CYCLE_FLAG_WATCHDOG) ? "watchdog timeout" : "budget");
+    }
+}
+
+// Sample the waveform between loop passes on the microsecond clock, so
+// it shows when within the tick each signal changed. Same signals as
+// observe_state(), without event logging
+static void sample_vcd_pass(SimInstance *inst) {
+    Coordinator *coord = &inst->coordinator;
+    sim_state_set_fsm(&inst->state, coordinator_get_top_state(coord),
+                      coordinator_get_mode(coord), coordinator_get_page(coord),
+                      coordinator_in_menu(coord));
+    sim_state_set_output(&inst->state, coordinator_get_output(coord));
+    observe_signals(inst);
+    vcd_writer_tick(inst->vcd, &inst->state, inst->hw.clock.now_us);
+}
+
+// ========== MIRRORS main.c: Application logic ==========
+static void run_loop_body(SimInstance *inst) {
+    Coordinator *coord = &inst->coordinator;
+    CycleAccount *cycles = &inst->hw.cycles;
+
+    // The loop head feeds the watchdog
+    tag_hal_stats(inst);
+    cycle_account_begin_pass(cycles);
+    cycle_account_charge(cycles, CYCLE_OP_WDT_RESET);
+
+    // Update coordinator (processes inputs, runs mode handlers)
+    cycle_account_phase(cycles, CYCLE_PHASE_COORDINATOR);
+    coordinator_update(coord);
+
+    // Update LED feedback
+    cycle_account_phase(cycles, CYCLE_PHASE_LED_FEEDBACK);
+    LEDFeedback feedback;
+    coordinator_get_led_feedback(coord, &feedback);
+    led_feedback_update(&inst->led_ctrl, &feedback, p_hal->millis());
+
+    // Update output pin based on coordinator output state
+    cycle_account_phase(cycles, CYCLE_PHASE_OUTPUT);
+    if (coordinator_get_output(coord)) {
+        p_hal->set_pin(p_hal->sig_out_pin);
+    } else {
+        p_hal->clear_pin(p_hal->sig_out_pin);
+    }
+
+    if (cycles->enabled) {
+        check_loop_budget(inst);
+    }
+    hal_stats_end_tick(&inst->hw.hal_stats);
+}
+
+void sim_instance_end_tick(SimInstance *inst) {
+    // Update CV source and apply to simulated ADC
+    uint8_t cv_val = cv_source_tick(&inst->cv_source, 1);  // 1ms tick
+    sim_set_cv_voltage(cv_val);
+
+    // Track input changes for event logging
+    track_input_changes(inst);
+
+    SimClock *clock = &inst->hw.clock;
+    if (!clock->enabled) {
+        run_loop_body(inst);
+    } else {
+        // The firmware loop free-runs: pass after pass until the Timer0
+        // ISR moves millis() on. Blocking HAL calls spend their AVR cost
+        // on the way; each pass takes at least tick_us
+        uint32_t start_ms = inst->hw.time_ms;
+        if (inst->vcd) {
+            sample_vcd_pass(inst);      // This tick's inputs
+        }
+        do {
+            uint64_t pass_end = clock->now_us + clock->tick_us;
+            run_loop_body(inst);
+            if (inst->vcd) {
+                sample_vcd_pass(inst);
+            }
+            sim_clock_advance_to(clock, pass_end);
+        } while (inst->hw.time_ms == start_ms);
+
+        // A pass that blocked past the next tick: keep CV in step
+        uint32_t extra = inst->hw.time_ms - start_ms - 1;
+        if (extra > 0) {
+            cv_source_tick(&inst->cv_source, extra);
+        }
+    }
+
+    // ========== SIM-SPECIFIC: State observation ==========
+    observe_state(inst);
+
+    if (inst->trace) {
+        trace_writer_tick(inst->trace, &inst->state);
+    }
+    if (inst->vcd && !clock->enabled) {
+        vcd_writer_tick(inst->vcd, &inst->state, inst->tick_time);
+    }
+
+    // Advance simulated time (the clock's Timer0 ISR already has)
+    if (!clock->enabled) {
+        p_hal->advance_time(1);
+    }
+}
+
+// Range of CV values that nothing reacts to: within the event log's
+// delta of the last logged value and on the current side of the CV input
+// hysteresis, or only the current value when every change is observed
+static void cv_quiet_range(const SimInstance *inst, bool cv_values, uint8_t *lo, uint8_t *hi) {
+    if (cv_values) {
+        *lo = *hi = sim_get_cv_voltage();
+        return;
+    }
+
+    uint8_t logged = inst->track.cv_voltage;
+    *lo = (logged > SIM_CV_LOG_DELTA) ? logged - SIM_CV_LOG_DELTA : 0;
+    *hi = (logged < 255 - SIM_CV_LOG_DELTA) ? logged + SIM_CV_LOG_DELTA : 255;
+
+    const CVInput *cv = &inst->coordinator.cv_input;
+    if (cv_input_get_state(cv)) {
+        if (*lo < cv->low_threshold) *lo = cv->low_threshold;
+    } else {
+        if (*hi > cv->high_threshold) *hi = cv->high_threshold;
+    }
+}
+
+void sim_instance_skip_idle(SimInstance *inst, uint32_t limit, bool cv_values) {
+    // Inputs are constant until the next input event, the CV stays in a
+    // range nothing reacts to, and the application is quiet until its
+    // next deadline, so the ticks in between would produce no events.
+    // Jump over them.
+    if (!sim_adc_is_static()) return;
+
+    // Cycle accounting reports per loop pass, so every pass has to run
+    if (inst->hw.cycles.enabled) return;
+
+    uint32_t deadline = sim_schedule_next_deadline(&inst->coordinator,
+                                                   &inst->led_ctrl, inst->tick_time);
+    uint32_t next_input = inst->input->next_event_time(inst->input, inst->tick_time);
+    if (next_input < deadline) {
+        deadline = next_input;
+    }
+    if (limit < deadline) {
+        deadline = limit;
+    }
+
+    uint32_t now = p_hal->millis();
+    if (deadline <= now) return;
+
+    if (!cv_source_is_static(&inst->cv_source)) {
+        // The ADC model filters the value the application reads
+        if (inst->hw.adc.enabled) return;
+
+        uint32_t span = deadline - now;
+        if (span > SIM_CV_LOOKAHEAD_MS) span = SIM_CV_LOOKAHEAD_MS;
+        uint8_t lo, hi;
+        cv_quiet_range(inst, cv_values || inst->trace || inst->vcd, &lo, &hi);
+        deadline = now + cv_source_quiet_ticks(&inst->cv_source, lo, hi, span);
+        if (deadline == now) return;
+    } else if (deadline == SIM_SCHEDULE_NEVER) {
+        return;
+    }
+
+    uint32_t skip = deadline - now;
+    cv_source_advance(&inst->cv_source, skip);
+    sim_skip_time(skip);
+}
+
+bool sim_instance_step(SimInstance *inst) {
+    if (!sim_instance_begin_tick(inst)) {
+        return false;
+    }
+    sim_instance_end_tick(inst);
+    sim_instance_skip_idle(inst, SIM_SCHEDULE_NEVER, false);
+    return true;
+}
@@ -0,0 +1,133 @@
+#ifndef GK_SIM_INSTANCE_H
+#define GK_SIM_INSTANCE_H
+
+#include "sim_hal.h"
+#include "sim_state.h"
+#include "cv_source.h"
+#include "input_source.h"
+#include "trace.h"
+#include "vcd.h"
+#include "app_init.h"
+#include "core/coordinator.h"
+#include "output/led_feedback.h"
+#include <stdbool.h>
+#include <stdint.h>
+
+/**
+ * @file sim_instance.h
+ * @brief One simulated Gatekeeper
+ *
+ * Holds everything a simulated device needs: hardware state, application
+ * state and the simulator's observation state. Instances share no mutable
+ * state, so several can run in one process as long as each is bound to
+ * its own thread (the HAL and coordinator use thread-local bindings,
+ * see GK_HAL_PER_THREAD).
+ *
+ * Typical use:
+ *   sim_instance_init(&inst);          // binds to the calling thread
+ *   sim_instance_start(&inst, input);  // app init, coordinator start
+ *   while (sim_instance_step(&inst)) {}
+ *
+ * The main loop is split into begin/end halves so the interactive
+ * simulator can process socket commands and render in between.
+ * Each begin/end pair covers one millisecond: a single application
+ * pass, or on the microsecond clock (sim_set_clock) as many passes as
+ * fit before the Timer0 ISR moves millis() on.
+ *
+ * To record a trace or VCD waveform, set inst.trace / inst.vcd before
+ * sim_instance_start(); headers are written at start and every changing
+ * tick after that.
+ */
+
+/**
+ * Last observed values, used to turn state into events.
+ */
+typedef struct {
+    bool button_a;
+    bool button_b;
+    uint8_t cv_voltage;
+    TopState top_state;
+    ModeState mode;
+    MenuPage page;
+    bool output;
+} SimTracking;
+
+typedef struct {
+    SimHardware hw;                 // Pins, EEPROM, time, LEDs, watchdog
+    SimState state;                 // Observed state for renderers
+    CVSource cv_source;             // CV input generator
+    AppSettings settings;           // Settings loaded by app_init
+    Coordinator coordinator;        // Application
+    LEDFeedbackController led_ctrl; // LED feedback
+    InputSource *input;             // Input source (not owned)
+    TraceWriter *trace;             // Trace recorder, or NULL (not owned)
+    VcdWriter *vcd;                 // Waveform writer, or NULL (not owned)
+    SimTracking track;              // Event tracking state
+    uint32_t tick_time;             // Time of the current loop iteration
+} SimInstance;
+
+/**
+ * Initialize an instance and bind it to the calling thread.
+ * Resets hardware state and the CV source; does not run the app yet.
+ */
+void sim_instance_init(SimInstance *inst);
+
+/**
+ * Bind an instance to the calling thread.
+ * Points p_hal at the simulator HAL and routes HAL calls to inst.
+ * An instance must only be driven from the thread it is bound to.
+ */
+void sim_instance_bind(SimInstance *inst);
+
+/**
+ * Get the instance bound to the calling thread (NULL if none).
+ */
+SimInstance* sim_instance_current(void);
+
+/**
+ * Run app initialization and start the coordinator.
+ * Mirrors main.c up to the main loop (including watchdog enable).
+ *
+ * @param inst   Bound instance
+ * @param input  Input source driving this instance
+ * @return       Result of app_init_run()
+ */
+AppInitResult sim_instance_start(SimInstance *inst, InputSource *input);
+
+/**
+ * First half of a loop iteration: feed watchdog, apply input.
+ *
+ * @return false if the input source requested quit
+ */
+bool sim_instance_begin_tick(SimInstance *inst);
+
+/**
+ * Second half of a loop iteration: CV, application logic, observation,
+ * and advancing time by 1ms.
+ */
+void sim_instance_end_tick(SimInstance *inst);
+
+/**
+ * Skip idle time up to the next scheduled change: a deadline of the
+ * application, the next input event, or the next tick whose CV value
+ * something reacts to (the input event log or the CV input hysteresis,
+ * and with cv_values set, any change of the value). Only call when
+ * nothing else needs to observe the skipped ticks. Does nothing while
+ * cycle accounting is on, since it reports on every loop pass.
+ *
+ * @param limit      Latest time to skip to, e.g. a socket message due
+ *                   then (SIM_SCHEDULE_NEVER: none)
+ * @param cv_values  Something outside the instance follows the raw CV
+ *                   value (traces and waveforms are handled here)
+ */
+void sim_instance_skip_idle(SimInstance *inst, uint32_t limit, bool cv_values);
+
+/**
+ * Run one full loop iteration, then skip idle time.
+ * For headless runs with no renderer or socket.
+ *
+ * @return false when the instance has finished (input requested quit)
+ */
+bool sim_instance_step(SimInstance *inst);
+
+#endif /* GK_SIM_INSTANCE_H */
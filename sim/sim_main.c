@@ -1,20 +1,16 @@
-#include "sim_hal.h"
-#include "sim_state.h"
-#include "input_source.h"
-#include "cv_source.h"
+#include "sim_instance.h"
+#include "sim_schedule.h"
 #include "socket_server.h"
+#include "socket_publisher.h"
+#include "socket_protocol.h"
 #include "command_handler.h"
+#include "pacer.h"
 #include "render/render.h"
-#include "hardware/hal_interface.h"
-#include "app_init.h"
-#include "core/coordinator.h"
-#include "output/led_feedback.h"
 
 #include <stdio.h>
 #include <stdlib.h>
 #include <string.h>
 #include <signal.h>
-#include <unistd.h>
 
 /**
  * @file sim_main.c
@@ -22,31 +18,36 @@
  *
  * Headless architecture: state is collected into SimState,
  * then rendered by the selected renderer (terminal, JSON, batch).
+ * The simulated device itself is a SimInstance; this file is the
+ * command line front end around one instance.
+ *
+ * When nothing observes idle ticks (batch output, no pending socket
+ * input), the loop jumps straight to the next scheduled change, input
+ * event, CV threshold crossing or message due to a socket client instead
+ * of stepping every millisecond. --step disables this.
  */
 
 static volatile bool running = true;
 static InputSource *input_source = NULL;
 static Renderer *renderer = NULL;
 static SocketServer *socket_server = NULL;
-static SimState sim_state;
-static LEDFeedbackController led_ctrl;
-static CVSource cv_source;
+static SocketPublisher publisher;
+static SimInstance sim;
 
 static void handle_signal(int sig) {
     (void)sig;
     running = false;
 }
 
-/**
- * Get the CV source for external control (e.g., keyboard input).
- */
-CVSource* sim_get_cv_source(void) {
-    return &cv_source;
-}
+// Socket commands handled per socket_server_poll() call
+#define SOCKET_POLL_BATCH 64
 
 // Auto-release duration for tap keys (milliseconds) - for help text
 #define TAP_AUTO_RELEASE_MS 200
 
+// Call sites listed per mode by --hal-stats
+#define HAL_STATS_DEFAULT_TOP 5
+
 static void print_usage(const char *progname) {
     printf("Gatekeeper x86 Simulator\n\n");
     printf("Usage: %s [options]\n\n", progname);
@@ -55,8 +56,33 @@ static void print_usage(const char *progname) {
     printf("  --batch          Batch mode: plain text output (for CI/scripts)\n");
     printf("  --json           JSON output: one object per state change\n");
     printf("  --json-stream    JSON stream: continuous output at fixed interval\n");
+    printf("  --json-delta     JSON frames with changed fields only (keyframe every 1s)\n");
+    printf("  --json-interval <ms>  Periodic JSON frame interval (default: 100, 500 fast)\n");
     printf("  --socket [path]  Enable socket server (default: %s)\n", SOCKET_DEFAULT_PATH);
     printf("  --fast           Run in fast-forward mode (interactive only)\n");
+    printf("  --catchup <ms>   Realtime: largest backlog run back to back before\n");
+    printf("                   resyncing to the wall clock (default: %d,\n"
+           "                   0 = no limit, never resync)\n",
+           PACER_DEFAULT_CATCHUP_MS);
+    printf("  --step           Step every 1ms tick (disable idle time skipping)\n");
+    printf("  --record <file>  Record a binary trace of the run\n");
+    printf("  --replay <file>  Replay a trace and verify outputs match\n");
+    printf("  --vcd <file>     Write a VCD waveform of pins and internal signals\n");
+    printf("  --cv-file <file> Play a recorded CV file (WAV, or raw with --cv-format)\n");
+    printf("  --cv-format <f>  CV file encoding: wav, u8, s16 (default: wav)\n");
+    printf("  --cv-rate <hz>   Sample rate of a raw CV file\n");
+    printf("  --cv-once        Hold the last CV sample instead of looping\n");
+    printf("  --adc <spec>     Model the CV ADC front end (default: ideal), e.g.\n");
+    printf("                   noise=8,pink,rc=2000,coupling=40,delay=1 (see sim/adc_model.h)\n");
+    printf("  --tick-us <us>   Microsecond time: loop passes of at least <us> (1-1000),\n");
+    printf("                   Timer0/ADC/pin-change interrupts and AVR costs for\n");
+    printf("                   blocking HAL calls (see sim/sim_clock.h)\n");
+    printf("  --cycles <spec>  Count AVR cycles per loop pass and flag passes over\n");
+    printf("                   budget, e.g. avr or budget=500,coordinator=1200\n");
+    printf("                   (see sim/cycle_cost.h; implies --step)\n");
+    printf("  --hal-stats [n]  Count HAL calls per function and call site; print the\n");
+    printf("                   top <n> sites per mode on exit (default: %d;\n"
+           "                   implies --step)\n", HAL_STATS_DEFAULT_TOP);
     printf("  --help           Show this help message\n");
     printf("\n");
     printf("Interactive Controls:\n");
@@ -79,6 +105,12 @@ static void print_usage(const char *progname) {
     printf("\n");
     printf("Actions: press, release, assert, log, quit\n");
     printf("Targets: a, b, cv, output\n");
+    printf("Assert:  assert state|mode|page <name>, assert led_mode|led_activity <r g b|off>\n");
+    printf("CV:      cv <volts>, cv_ramp <from_volts> <to_volts> <ms>\n");
+    printf("         cv_file <path> [loop|once] [u8|s16 <rate_hz>]\n");
+    printf("Timing:  expect_edge <target> <rise|fall> within <ms>\n");
+    printf("         expect_width <target> <ms> [tol <ms>]   (next high pulse)\n");
+    printf("         expect_period <target> <ms> [tol <ms>]  (next rise to rise)\n");
     printf("\n");
     printf("Socket Protocol (NDJSON):\n");
     printf("  {\"cmd\": \"button\", \"id\": \"a\", \"state\": true}\n");
@@ -87,99 +119,54 @@ static void print_usage(const char *progname) {
     printf("  {\"cmd\": \"cv_envelope\", \"attack_ms\": 10, \"decay_ms\": 100, \"sustain\": 180, \"release_ms\": 200}\n");
     printf("  {\"cmd\": \"cv_gate\", \"state\": true}\n");
     printf("  {\"cmd\": \"cv_trigger\"}\n");
+    printf("  {\"cmd\": \"cv_wavetable\", \"samples\": [0, 128, 255, 128], \"freq_hz\": 1.0}\n");
+    printf("  {\"cmd\": \"cv_file\", \"path\": \"cv.wav\", \"loop\": true}\n");
+    printf("  {\"cmd\": \"cv_graph\", \"nodes\": [{\"type\": \"envelope\"}, {\"type\": \"lfo\", \"freq_hz\": 5, \"max\": 30},\n");
+    printf("           {\"type\": \"sum\", \"in\": [0, 1]}], \"out\": 2}\n");
     printf("  {\"cmd\": \"reset\"}\n");
+    printf("  {\"cmd\": \"subscribe\", \"topics\": [\"state\", \"changes\", \"leds\"], \"interval_ms\": 16, \"policy\": \"coalesce\"}\n");
     printf("  {\"cmd\": \"quit\"}\n");
+    printf("  Send \"%s\" first for binary frames instead (see sim/socket_protocol.h)\n",
+           SOCKET_BINARY_MAGIC);
     printf("\n");
 }
 
-// Track input state changes (sim-specific observation)
-static void track_input_changes(void) {
-    static bool last_button_a = false;
-    static bool last_button_b = false;
-    static uint8_t last_cv_voltage = 0;
-
-    bool button_a = sim_get_button_a();
-    bool button_b = sim_get_button_b();
-    uint8_t cv_voltage = sim_get_cv_voltage();
-
-    if (button_a != last_button_a) {
-        sim_state_add_event(&sim_state, EVT_TYPE_INPUT, sim_get_time(),
-            "Button A %s", button_a ? "pressed" : "released");
-        last_button_a = button_a;
-    }
-
-    if (button_b != last_button_b) {
-        sim_state_add_event(&sim_state, EVT_TYPE_INPUT, sim_get_time(),
-            "Button B %s", button_b ? "pressed" : "released");
-        last_button_b = button_b;
-    }
-
-    // Only log CV changes when they cross thresholds (avoid noise from +/-)
-    // Log when voltage changes significantly (> ~0.5V)
-    if ((cv_voltage > last_cv_voltage + 25) || (cv_voltage + 25 < last_cv_voltage)) {
-        uint16_t mv = (uint16_t)cv_voltage * 5000 / 255;
-        sim_state_add_event(&sim_state, EVT_TYPE_INPUT, sim_get_time(),
-            "CV -> %u.%uV", mv / 1000, (mv % 1000) / 100);
-        last_cv_voltage = cv_voltage;
-    }
-}
-
-// Update state tracking for render/logging (sim-specific observation)
-static void track_state_changes(Coordinator *coord) {
-    static TopState last_top_state = TOP_PERFORM;
-    static ModeState last_mode = MODE_GATE;
-    static MenuPage last_page = PAGE_GATE_CV;
-    static bool last_output = false;
-
-    TopState top_state = coordinator_get_top_state(coord);
-    ModeState mode = coordinator_get_mode(coord);
-    MenuPage page = coordinator_get_page(coord);
-    bool in_menu = coordinator_in_menu(coord);
-    bool output = coordinator_get_output(coord);
-
-    // Log state changes (sim-specific event logging)
-    if (top_state != last_top_state) {
-        sim_state_add_event(&sim_state, EVT_TYPE_STATE_CHANGE, sim_get_time(),
-            "State -> %s", sim_top_state_str(top_state));
-        last_top_state = top_state;
-    }
-
-    if (mode != last_mode) {
-        sim_state_add_event(&sim_state, EVT_TYPE_MODE_CHANGE, sim_get_time(),
-            "Mode -> %s", sim_mode_str(mode));
-        last_mode = mode;
-    }
-
-    if (in_menu && page != last_page) {
-        sim_state_add_event(&sim_state, EVT_TYPE_PAGE_CHANGE, sim_get_time(),
-            "Page -> %s", sim_page_str(page));
-        last_page = page;
-    }
-
-    if (output != last_output) {
-        sim_state_add_event(&sim_state, EVT_TYPE_OUTPUT, sim_get_time(),
-            "Output -> %s", output ? "HIGH" : "LOW");
-        last_output = output;
-    }
-
-    // Update state struct for renderer
-    sim_state_set_fsm(&sim_state, top_state, mode, page, in_menu);
-    sim_state_set_output(&sim_state, output);
-}
-
 int main(int argc, char **argv) {
     bool fast_mode = false;
+    bool step_mode = false;
     bool batch_mode = false;
     bool json_mode = false;
     bool json_stream = false;
+    bool json_delta = false;
+    uint32_t json_interval = 0;     // 0 = default render interval
+    uint32_t catchup_ms = PACER_DEFAULT_CATCHUP_MS;
     bool socket_mode = false;
     const char *socket_path = NULL;
     const char *script_file = NULL;
+    const char *record_file = NULL;
+    const char *replay_file = NULL;
+    const char *vcd_file = NULL;
+    CVFileConfig cv_file = { .format = CV_FILE_WAV, .loop = true };
+    AdcModelConfig adc_config = {0};
+    bool adc_model = false;
+    uint32_t tick_us = 0;           // 0 = 1 ms steps
+    CycleCostConfig cycle_config;
+    bool cycle_cost = false;
+    int hal_stats_top = 0;
+    cycle_cost_defaults(&cycle_config);
 
     // Parse command line arguments
     for (int i = 1; i < argc; i++) {
         if (strcmp(argv[i], "--fast") == 0) {
             fast_mode = true;
+        } else if (strcmp(argv[i], "--catchup") == 0) {
+            if (i + 1 >= argc || atoi(argv[i + 1]) < 0) {
+                fprintf(stderr, "Error: --catchup requires a number of ms\n");
+                return 1;
+            }
+            catchup_ms = (uint32_t)atoi(argv[++i]);
+        } else if (strcmp(argv[i], "--step") == 0) {
+            step_mode = true;
         } else if (strcmp(argv[i], "--batch") == 0) {
             batch_mode = true;
         } else if (strcmp(argv[i], "--json") == 0) {
@@ -187,12 +174,96 @@ int main(int argc, char **argv) {
         } else if (strcmp(argv[i], "--json-stream") == 0) {
             json_mode = true;
             json_stream = true;
+        } else if (strcmp(argv[i], "--json-delta") == 0) {
+            json_mode = true;
+            json_delta = true;
+        } else if (strcmp(argv[i], "--json-interval") == 0) {
+            if (i + 1 >= argc || atoi(argv[i + 1]) <= 0) {
+                fprintf(stderr, "Error: --json-interval requires a positive number of ms\n");
+                return 1;
+            }
+            json_interval = (uint32_t)atoi(argv[++i]);
         } else if (strcmp(argv[i], "--script") == 0) {
             if (i + 1 >= argc) {
                 fprintf(stderr, "Error: --script requires a filename\n");
                 return 1;
             }
             script_file = argv[++i];
+        } else if (strcmp(argv[i], "--record") == 0) {
+            if (i + 1 >= argc) {
+                fprintf(stderr, "Error: --record requires a filename\n");
+                return 1;
+            }
+            record_file = argv[++i];
+        } else if (strcmp(argv[i], "--replay") == 0) {
+            if (i + 1 >= argc) {
+                fprintf(stderr, "Error: --replay requires a filename\n");
+                return 1;
+            }
+            replay_file = argv[++i];
+        } else if (strcmp(argv[i], "--vcd") == 0) {
+            if (i + 1 >= argc) {
+                fprintf(stderr, "Error: --vcd requires a filename\n");
+                return 1;
+            }
+            vcd_file = argv[++i];
+        } else if (strcmp(argv[i], "--cv-file") == 0) {
+            if (i + 1 >= argc) {
+                fprintf(stderr, "Error: --cv-file requires a filename\n");
+                return 1;
+            }
+            cv_file.path = argv[++i];
+        } else if (strcmp(argv[i], "--cv-format") == 0) {
+            if (i + 1 >= argc ||
+                !cv_file_parse_format(argv[i + 1], strlen(argv[i + 1]), &cv_file.format)) {
+                fprintf(stderr, "Error: --cv-format requires wav, u8 or s16\n");
+                return 1;
+            }
+            i++;
+        } else if (strcmp(argv[i], "--cv-rate") == 0) {
+            if (i + 1 >= argc || atoi(argv[i + 1]) <= 0 ||
+                atoi(argv[i + 1]) > CV_FILE_MAX_RATE_HZ) {
+                fprintf(stderr, "Error: --cv-rate requires a rate in Hz\n");
+                return 1;
+            }
+            cv_file.rate_hz = (uint32_t)atoi(argv[++i]);
+        } else if (strcmp(argv[i], "--cv-once") == 0) {
+            cv_file.loop = false;
+        } else if (strcmp(argv[i], "--adc") == 0) {
+            char err[96];
+            if (i + 1 >= argc || !adc_model_parse(argv[i + 1], &adc_config, err, sizeof(err))) {
+                fprintf(stderr, "Error: %s\n", (i + 1 >= argc) ? "--adc requires a spec" : err);
+                return 1;
+            }
+            adc_model = true;
+            i++;
+        } else if (strcmp(argv[i], "--tick-us") == 0) {
+            if (i + 1 >= argc || atoi(argv[i + 1]) < 1 || atoi(argv[i + 1]) > 1000) {
+                fprintf(stderr, "Error: --tick-us requires 1-1000\n");
+                return 1;
+            }
+            tick_us = (uint32_t)atoi(argv[++i]);
+        } else if (strcmp(argv[i], "--cycles") == 0) {
+            char err[96];
+            if (i + 1 >= argc ||
+                !cycle_cost_parse(argv[i + 1], &cycle_config, err, sizeof(err))) {
+                fprintf(stderr, "Error: %s\n", (i + 1 >= argc) ? "--cycles requires a spec" : err);
+                return 1;
+            }
+            cycle_cost = true;
+            i++;
+        } else if (strcmp(argv[i], "--hal-stats") == 0) {
+            hal_stats_top = HAL_STATS_DEFAULT_TOP;
+            // Calls per loop pass: skipped idle ticks would make none
+            step_mode = true;
+            // Optional site count
+            if (i + 1 < argc && argv[i + 1][0] != '-') {
+                hal_stats_top = atoi(argv[++i]);
+                if (hal_stats_top < 1) {
+                    fprintf(stderr, "Error: --hal-stats requires a positive count\n");
+                    return 1;
+                }
+            }
         } else if (strcmp(argv[i], "--socket") == 0) {
             socket_mode = true;
             // Optional path argument
@@ -213,17 +284,53 @@ int main(int argc, char **argv) {
     signal(SIGINT, handle_signal);
     signal(SIGTERM, handle_signal);
 
-    // Initialize state early so keyboard input can access it
-    sim_state_init(&sim_state);
+    // Initialize instance early so keyboard input can access its state
+    sim_instance_init(&sim);
+
+    if (script_file && replay_file) {
+        fprintf(stderr, "Error: --script and --replay can't be combined\n");
+        return 1;
+    }
+    if (adc_model && replay_file) {
+        fprintf(stderr, "Error: --replay uses the ADC model recorded in the trace, "
+                        "--adc can't be combined with it\n");
+        return 1;
+    }
+
+    if (adc_model) {
+        sim_set_adc_model(&adc_config);
+    }
+    if (tick_us) {
+        sim_set_clock(tick_us);
+    }
+    if (cycle_cost) {
+        sim_set_cycle_cost(&cycle_config);
+    }
+    if (hal_stats_top) {
+        sim_set_hal_stats();
+    }
+
+    if (cv_file.path) {
+        char err[128];
+        if (!cv_source_set_file(&sim.cv_source, &cv_file, err, sizeof(err))) {
+            fprintf(stderr, "Error: %s\n", err);
+            return 1;
+        }
+    }
 
     // Create input source
-    if (script_file) {
+    if (replay_file) {
+        input_source = input_source_replay_create(replay_file);
+        if (!input_source) {
+            return 1;  // Error already printed
+        }
+    } else if (script_file) {
         input_source = input_source_script_create(script_file);
         if (!input_source) {
             return 1;  // Error already printed
         }
     } else {
-        input_source = input_source_keyboard_create(&sim_state);
+        input_source = input_source_keyboard_create(&sim.state);
         if (!input_source) {
             fprintf(stderr, "Error: Failed to create keyboard input\n");
             return 1;
@@ -232,7 +339,7 @@ int main(int argc, char **argv) {
 
     // Create renderer based on mode
     if (json_mode) {
-        renderer = render_json_create(json_stream);
+        renderer = render_json_create(json_stream, json_delta);
     } else if (batch_mode) {
         renderer = render_batch_create();
     } else {
@@ -247,20 +354,11 @@ int main(int argc, char **argv) {
 
     // Set initial mode based on input source
     bool realtime = !fast_mode && input_source->is_realtime(input_source);
-    sim_state_set_realtime(&sim_state, realtime);
+    sim_state_set_realtime(&sim.state, realtime);
 
     // Initialize renderer
     renderer->init(renderer);
 
-    // Point global HAL to simulator HAL
-    p_hal = sim_get_hal();
-
-    // Initialize hardware (via sim HAL)
-    p_hal->init();
-
-    // Initialize CV source (starts in manual mode at 0V)
-    cv_source_init(&cv_source);
-
     // Create socket server if requested
     if (socket_mode) {
         socket_server = socket_server_create(socket_path);
@@ -275,155 +373,173 @@ int main(int argc, char **argv) {
             }
             return 1;
         }
+        socket_publisher_init(&publisher);
     }
 
-    // Run app initialization
-    AppSettings settings;
-    AppInitResult init_result = app_init_run(&settings);
-
-    if (init_result == APP_INIT_OK_FACTORY_RESET) {
-        sim_state_add_event(&sim_state, EVT_TYPE_INFO, sim_get_time(), "Factory reset performed");
-    } else if (init_result == APP_INIT_OK_DEFAULTS) {
-        sim_state_add_event(&sim_state, EVT_TYPE_INFO, sim_get_time(), "Using default settings");
+    // Open trace/waveform before start so they capture the boot state
+    if (record_file) {
+        sim.trace = trace_writer_create(record_file);
     }
-
-    // Initialize coordinator
-    Coordinator coordinator;
-    coordinator_init(&coordinator, &settings);
-
-    // Restore mode from saved settings
-    if (settings.mode < MODE_COUNT) {
-        coordinator_set_mode(&coordinator, (ModeState)settings.mode);
+    if (vcd_file) {
+        sim.vcd = vcd_writer_create(vcd_file);
+    }
+    if ((record_file && !sim.trace) || (vcd_file && !sim.vcd)) {
+        if (sim.trace) {
+            trace_writer_close(sim.trace, 0, NULL);
+        }
+        if (sim.vcd) {
+            vcd_writer_close(sim.vcd, 0);
+        }
+        if (socket_server) {
+            socket_server_destroy(socket_server);
+        }
+        renderer->cleanup(renderer);
+        render_destroy(renderer);
+        input_source->cleanup(input_source);
+        return 1;
     }
 
-    // Start coordinator
-    coordinator_start(&coordinator);
-
-    // Initialize LED feedback controller
-    led_feedback_init(&led_ctrl);
-    led_feedback_set_mode(&led_ctrl, coordinator_get_mode(&coordinator));
-
-    sim_state_add_event(&sim_state, EVT_TYPE_INFO, sim_get_time(),
-        "App initialized, mode=%s", sim_mode_str(coordinator_get_mode(&coordinator)));
-
-    // Enable watchdog timer (250ms timeout) after init complete
-    // This mirrors main.c - watchdog must be enabled AFTER app_init completes
-    p_hal->wdt_enable();
+    // Run app initialization and start the coordinator
+    sim_instance_start(&sim, input_source);
 
     // Main loop
+    Pacer pacer;
+    pacer_init(&pacer, catchup_ms);
     uint32_t last_render = 0;
     while (running) {
-        // Feed watchdog at start of each loop iteration (mirrors main.c)
-        p_hal->wdt_reset();
-
-        uint32_t current_time = p_hal->millis();
-
-        // ========== SIM-SPECIFIC: Input handling ==========
-        if (!input_source->update(input_source, current_time)) {
+        if (!sim_instance_begin_tick(&sim)) {
             break;
         }
 
         // Process socket commands (non-blocking)
         if (socket_server) {
-            char cmd_buf[512];
-            while (socket_server_poll(socket_server, cmd_buf, sizeof(cmd_buf))) {
-                CommandResult result = command_handler_execute(cmd_buf, &cv_source);
-                if (result.should_quit) {
-                    running = false;
-                    break;
-                }
-                if (!result.success && result.error[0]) {
-                    fprintf(stderr, "Socket command error: %s\n", result.error);
+            SocketRequest reqs[SOCKET_POLL_BATCH];
+            int n;
+            socket_server_service(socket_server);
+            while (running && (n = socket_server_poll(socket_server, reqs, SOCKET_POLL_BATCH)) > 0) {
+                for (int i = 0; i < n; i++) {
+                    const SocketRequest *req = &reqs[i];
+                    CommandResult result = (req->format == SOCKET_FORMAT_BINARY)
+                        ? command_handler_execute_binary(req->type, (const uint8_t*)req->data,
+                                                         req->len, &sim.cv_source)
+                        : command_handler_execute(req->data, req->len, &sim.cv_source);
+                    if (result.should_quit) {
+                        running = false;
+                        break;
+                    }
+                    if (result.type == CMD_SUBSCRIBE && result.success) {
+                        socket_server_subscribe(socket_server, req->client_id, result.topics,
+                                                result.interval_ms, result.policy);
+                    }
+                    if (!result.success && result.error[0]) {
+                        fprintf(stderr, "Socket command error: %s\n", result.error);
+                    }
+                    socket_publisher_reply(&publisher, socket_server, req, &result,
+                                           &sim.cv_source);
                 }
             }
         }
 
-        // Update CV source and apply to simulated ADC
-        uint8_t cv_val = cv_source_tick(&cv_source, 1);  // 1ms tick
-        sim_set_cv_voltage(cv_val);
-
-        // Track input changes for event logging
-        track_input_changes();
+        sim_instance_end_tick(&sim);
 
-        // ========== MIRRORS main.c: Application logic ==========
-        // Update coordinator (processes inputs, runs mode handlers)
-        coordinator_update(&coordinator);
-
-        // Update LED feedback
-        LEDFeedback feedback;
-        coordinator_get_led_feedback(&coordinator, &feedback);
-        led_feedback_update(&led_ctrl, &feedback, current_time);
+        // Render periodically or on state change
+        uint32_t now = p_hal->millis();
+        uint32_t render_interval = sim.state.realtime_mode ? 100 : 500;
+        if (json_interval) {
+            render_interval = json_interval;
+        }
+        if (sim_state_is_dirty(&sim.state) || (now - last_render >= render_interval)) {
+            renderer->render(renderer, &sim.state);
+            sim_state_clear_dirty(&sim.state);
+            last_render = now;
+        }
 
-        // Update output pin based on coordinator output state
-        if (coordinator_get_output(&coordinator)) {
-            p_hal->set_pin(p_hal->sig_out_pin);
-        } else {
-            p_hal->clear_pin(p_hal->sig_out_pin);
+        // Publish state to subscribed socket clients
+        if (socket_server && socket_server_connected(socket_server)) {
+            socket_publisher_tick(&publisher, socket_server, &sim.state);
         }
 
-        // ========== SIM-SPECIFIC: State observation & rendering ==========
-        track_state_changes(&coordinator);
-
-        // Update sim_state for renderer
-        bool cv_digital = coordinator_get_cv_state(&coordinator);
-        sim_state_set_inputs(&sim_state,
-            sim_get_button_a(),
-            sim_get_button_b(),
-            cv_digital,
-            sim_get_cv_voltage());
-
-        for (int i = 0; i < SIM_NUM_LEDS; i++) {
-            uint8_t r, g, b;
-            sim_get_led(i, &r, &g, &b);
-            sim_state_set_led(&sim_state, i, r, g, b);
+        // ========== SIM-SPECIFIC: Idle time skipping ==========
+        // Socket clients bound the jump by the next message their interval
+        // holds back, and see every CV change if they follow the value
+        if (!step_mode && !renderer->idle_frames &&
+            !(socket_server && socket_server_has_input(socket_server))) {
+            uint32_t limit = SIM_SCHEDULE_NEVER;
+            bool cv_values = false;
+            if (socket_server && socket_server_connected(socket_server)) {
+                limit = socket_publisher_next_due(&publisher, socket_server,
+                                                  sim.state.timestamp_ms);
+                cv_values = socket_publisher_sends_cv(socket_server);
+            }
+            sim_instance_skip_idle(&sim, limit, cv_values);
         }
 
-        sim_state_set_time(&sim_state, current_time);
+        // Real-time pacing if needed: wait until the next tick is due
+        if (sim.state.realtime_mode && input_source->is_realtime(input_source)) {
+            pacer_wait(&pacer, p_hal->millis());
+            sim_state_set_timing(&sim.state, &pacer.stats);
+        } else {
+            pacer_stop(&pacer);
+        }
+    }
 
-        // Advance simulated time
-        p_hal->advance_time(1);
+    // Get result before cleanup
+    bool failed = input_source->has_failed(input_source);
 
-        // Real-time pacing if needed
-        if (sim_state.realtime_mode && input_source->is_realtime(input_source)) {
-            usleep(1000);  // 1ms
+    if (sim.trace) {
+        uint64_t bytes = 0;
+        if (!trace_writer_close(sim.trace, sim_get_time(), &bytes)) {
+            fprintf(stderr, "Error: Failed to write trace file: %s\n", record_file);
+            failed = true;
+        } else {
+            fprintf(stderr, "Trace: %lu ms in %llu bytes -> %s\n",
+                    (unsigned long)sim_get_time(), (unsigned long long)bytes, record_file);
         }
+        sim.trace = NULL;
+    }
 
-        // Render periodically or on state change
-        uint32_t now = p_hal->millis();
-        uint32_t render_interval = sim_state.realtime_mode ? 100 : 500;
-        if (sim_state_is_dirty(&sim_state) || (now - last_render >= render_interval)) {
-            renderer->render(renderer, &sim_state);
-            sim_state_clear_dirty(&sim_state);
-            last_render = now;
+    if (sim.vcd) {
+        uint64_t end = sim.hw.clock.enabled ? sim.hw.clock.now_us : sim_get_time();
+        if (!vcd_writer_close(sim.vcd, end)) {
+            fprintf(stderr, "Error: Failed to write VCD file: %s\n", vcd_file);
+            failed = true;
         }
+        sim.vcd = NULL;
+    }
 
-        // Send state to socket client (max 60Hz, only when dirty or connected)
-        static uint32_t last_socket_send = 0;
-        if (socket_server && socket_server_connected(socket_server)) {
-            if ((now - last_socket_send) >= 16) {  // ~60Hz
-                // Use JSON renderer to format state
-                // For now, send a simple status line
-                char state_json[512];
-                snprintf(state_json, sizeof(state_json),
-                    "{\"timestamp_ms\":%lu,\"state\":\"%s\",\"mode\":\"%s\","
-                    "\"cv_voltage\":%u,\"output\":%s}",
-                    (unsigned long)now,
-                    sim_top_state_str(sim_state.top_state),
-                    sim_mode_str(sim_state.mode),
-                    sim_state.cv_voltage,
-                    sim_state.signal_out ? "true" : "false");
-                socket_server_send(socket_server, state_json);
-                last_socket_send = now;
-            }
+    if (sim.hw.clock.enabled) {
+        const SimClock *clock = &sim.hw.clock;
+        // Only the vectors the firmware enables
+        fprintf(stderr, "Interrupts:");
+        const char *sep = "";
+        for (int i = 0; i < SIM_IRQ_COUNT; i++) {
+            if (!clock->handlers[i]) continue;
+            const SimIrqStats *st = &clock->stats[i];
+            fprintf(stderr, "%s %s %lu (max latency %lu us, %lu lost)",
+                    sep, sim_irq_name((SimIrq)i), (unsigned long)st->count,
+                    (unsigned long)st->max_latency_us, (unsigned long)st->lost);
+            sep = ",";
         }
+        fprintf(stderr, "\n");
+        fprintf(stderr, "Longest interrupts-off section: %lu us\n",
+                (unsigned long)clock->max_cli_us);
     }
 
-    // Get result before cleanup
-    bool failed = input_source->has_failed(input_source);
+    cycle_account_report(&sim.hw.cycles, stderr);
+
+    if (hal_stats_top) {
+        const char *tag_names[MODE_COUNT + 1];
+        for (int m = 0; m < MODE_COUNT; m++) {
+            tag_names[m] = sim_mode_str((ModeState)m);
+        }
+        tag_names[MODE_COUNT] = "menu";
+        hal_stats_report(&sim.hw.hal_stats, tag_names, MODE_COUNT + 1, hal_stats_top, stderr);
+    }
 
     // Cleanup
     if (socket_server) {
         socket_server_destroy(socket_server);
+        socket_publisher_free(&publisher);
     }
     renderer->cleanup(renderer);
     render_destroy(renderer);
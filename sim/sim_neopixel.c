@@ -8,15 +8,14 @@
  *
  * Routes neopixel colors to the simulator display via sim_set_led().
  * Used instead of mock_neopixel.c when building the simulator.
+ *
+ * The LED buffer lives in the SimHardware bound to the calling thread.
  */
 
-// LED buffer (RGB format)
-static NeopixelColor sim_leds[NEOPIXEL_COUNT];
-static bool buffer_dirty = false;
-
 void neopixel_init(void) {
-    memset(sim_leds, 0, sizeof(sim_leds));
-    buffer_dirty = false;
+    SimHardware *hw = sim_hal_bound();
+    memset(hw->neopixel, 0, sizeof(hw->neopixel));
+    hw->neopixel_dirty = false;
 
     // Clear display LEDs
     for (int i = 0; i < NEOPIXEL_COUNT; i++) {
@@ -26,16 +25,18 @@ void neopixel_init(void) {
 
 void neopixel_set_color(uint8_t index, NeopixelColor color) {
     if (index >= NEOPIXEL_COUNT) return;
-    sim_leds[index] = color;
-    buffer_dirty = true;
+    SimHardware *hw = sim_hal_bound();
+    hw->neopixel[index] = color;
+    hw->neopixel_dirty = true;
 }
 
 void neopixel_set_rgb(uint8_t index, uint8_t r, uint8_t g, uint8_t b) {
     if (index >= NEOPIXEL_COUNT) return;
-    sim_leds[index].r = r;
-    sim_leds[index].g = g;
-    sim_leds[index].b = b;
-    buffer_dirty = true;
+    SimHardware *hw = sim_hal_bound();
+    hw->neopixel[index].r = r;
+    hw->neopixel[index].g = g;
+    hw->neopixel[index].b = b;
+    hw->neopixel_dirty = true;
 }
 
 NeopixelColor neopixel_get_color(uint8_t index) {
@@ -43,25 +44,35 @@ NeopixelColor neopixel_get_color(uint8_t index) {
         NeopixelColor black = {0, 0, 0};
         return black;
     }
-    return sim_leds[index];
+    return sim_hal_bound()->neopixel[index];
 }
 
 void neopixel_clear(void) {
-    memset(sim_leds, 0, sizeof(sim_leds));
-    buffer_dirty = true;
+    SimHardware *hw = sim_hal_bound();
+    memset(hw->neopixel, 0, sizeof(hw->neopixel));
+    hw->neopixel_dirty = true;
 }
 
 bool neopixel_is_dirty(void) {
-    return buffer_dirty;
+    return sim_hal_bound()->neopixel_dirty;
 }
 
 void neopixel_flush(void) {
-    if (!buffer_dirty) return;
+    SimHardware *hw = sim_hal_bound();
+    if (!hw->neopixel_dirty) return;
 
     // Update simulator display
     for (int i = 0; i < NEOPIXEL_COUNT; i++) {
-        sim_set_led(i, sim_leds[i].r, sim_leds[i].g, sim_leds[i].b);
+        sim_set_led(i, hw->neopixel[i].r, hw->neopixel[i].g, hw->neopixel[i].b);
     }
 
-    buffer_dirty = false;
+    // The bit-banged transfer runs with interrupts off, then latches
+    cycle_account_charge(&hw->cycles, CYCLE_OP_NEOPIXEL);
+    cycle_account_charge(&hw->cycles, CYCLE_OP_NEOPIXEL_LATCH);
+    sim_clock_cli(&hw->clock);
+    sim_clock_spend(&hw->clock, NEOPIXEL_COUNT * 3 * hw->clock.cost.neopixel_byte_us);
+    sim_clock_sei(&hw->clock);
+    sim_clock_spend(&hw->clock, hw->clock.cost.neopixel_latch_us);
+
+    hw->neopixel_dirty = false;
 }
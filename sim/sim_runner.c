@@ -0,0 +1,303 @@
+#include "sim_instance.h"
+#include "work_pool.h"
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+
+/**
+ * @file sim_runner.c
+ * @brief Parallel script regression runner
+ *
+ * Runs many .gks scripts concurrently, each on its own SimInstance, on a
+ * work-stealing thread pool. Script logs are captured per script and
+ * only printed for failures (or with --verbose), followed by one
+ * aggregated report.
+ */
+
+typedef struct {
+    const char *path;
+    const AdcModelConfig *adc;  // ADC front end (NULL: ideal)
+    uint32_t tick_us;       // Microsecond clock pass length (0: 1 ms steps)
+    const CycleCostConfig *cycles;  // Cycle accounting (NULL: off)
+    bool loaded;            // Script parsed successfully
+    bool failed;            // Assertion failed
+    bool wdt_fired;         // Simulated watchdog fired
+    ScriptStats stats;
+    uint32_t sim_ms;        // Simulated time at end of script
+    SimIrqStats timer0;     // Timer0 ISR statistics (with tick_us)
+    uint32_t worst_cycles;  // Costliest loop pass (with cycles)
+    uint32_t over_budget;   // Passes over the cycle budget
+    double wall_ms;         // Wall time to run the script
+    char *log;              // Captured script log
+    size_t log_len;
+} RunResult;
+
+static double wall_time_ms(void) {
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return ts.tv_sec * 1000.0 + ts.tv_nsec / 1e6;
+}
+
+// Pool task: run one script to completion on the calling thread
+static void run_script(void *arg) {
+    RunResult *res = (RunResult*)arg;
+    double start = wall_time_ms();
+
+    FILE *log = open_memstream(&res->log, &res->log_len);
+
+    SimInstance *inst = malloc(sizeof(SimInstance));
+    if (!inst) {
+        if (log) fclose(log);
+        return;
+    }
+    sim_instance_init(inst);
+    sim_set_adc_model(res->adc);
+    if (res->tick_us) {
+        sim_set_clock(res->tick_us);
+    }
+    if (res->cycles) {
+        sim_set_cycle_cost(res->cycles);
+    }
+
+    InputSource *input = input_source_script_create(res->path);
+    if (input) {
+        res->loaded = true;
+        input_source_script_set_log(input, log);
+
+        sim_instance_start(inst, input);
+        while (sim_instance_step(inst)) {
+        }
+
+        input_source_script_get_stats(input, &res->stats);
+        res->failed = input->has_failed(input);
+        res->wdt_fired = sim_wdt_has_fired();
+        res->sim_ms = sim_get_time();
+        res->timer0 = inst->hw.clock.stats[SIM_IRQ_TIMER0_COMPA];
+        res->worst_cycles = inst->hw.cycles.total.max_cycles;
+        res->over_budget = inst->hw.cycles.over_budget + inst->hw.cycles.over_watchdog;
+        input->cleanup(input);
+    }
+
+    sim_instance_bind(NULL);
+    free(inst);
+    if (log) fclose(log);
+
+    res->wall_ms = wall_time_ms() - start;
+}
+
+static bool result_passed(const RunResult *res) {
+    return res->loaded && !res->failed && !res->wdt_fired && res->over_budget == 0;
+}
+
+static const char* result_label(const RunResult *res) {
+    if (!res->loaded) return "ERROR";
+    if (res->wdt_fired) return "WDT";
+    if (res->over_budget) return "SLOW";
+    return res->failed ? "FAIL" : "PASS";
+}
+
+static void print_usage(const char *progname) {
+    printf("Gatekeeper simulator regression runner\n\n");
+    printf("Usage: %s [options] <script.gks>...\n\n", progname);
+    printf("Options:\n");
+    printf("  -j, --jobs <n>   Worker threads (default: number of CPUs)\n");
+    printf("  -v, --verbose    Print logs of passing scripts too\n");
+    printf("  --adc <spec>     Model the CV ADC front end in every script, e.g.\n");
+    printf("                   noise=8,pink,rc=2000,coupling=40,delay=1 (see sim/adc_model.h)\n");
+    printf("  --tick-us <us>   Run every script on the microsecond clock with loop\n");
+    printf("                   passes of at least <us> (see sim/sim_clock.h)\n");
+    printf("  --cycles <spec>  Count AVR cycles per loop pass, stepping every tick;\n");
+    printf("                   scripts with passes over budget or the watchdog fail\n");
+    printf("                   (see sim/cycle_cost.h)\n");
+    printf("  --help           Show this help message\n");
+    printf("\n");
+    printf("Exit status is non-zero if any script fails, fires the\n");
+    printf("watchdog, has loop passes over the --cycles budget, or\n");
+    printf("can't be loaded.\n");
+}
+
+int main(int argc, char **argv) {
+    int jobs = 0;
+    bool verbose = false;
+    AdcModelConfig adc_config = {0};
+    const AdcModelConfig *adc = NULL;
+    uint32_t tick_us = 0;
+    CycleCostConfig cycle_config;
+    const CycleCostConfig *cycles = NULL;
+    cycle_cost_defaults(&cycle_config);
+    const char **paths = calloc(argc, sizeof(char*));
+    int num_scripts = 0;
+
+    if (!paths) return 1;
+
+    // Parse command line arguments
+    for (int i = 1; i < argc; i++) {
+        if (strcmp(argv[i], "-j") == 0 || strcmp(argv[i], "--jobs") == 0) {
+            if (i + 1 >= argc) {
+                fprintf(stderr, "Error: %s requires a number\n", argv[i]);
+                free(paths);
+                return 1;
+            }
+            jobs = atoi(argv[++i]);
+        } else if (strcmp(argv[i], "-v") == 0 || strcmp(argv[i], "--verbose") == 0) {
+            verbose = true;
+        } else if (strcmp(argv[i], "--adc") == 0) {
+            char err[96];
+            if (i + 1 >= argc || !adc_model_parse(argv[i + 1], &adc_config, err, sizeof(err))) {
+                fprintf(stderr, "Error: %s\n", (i + 1 >= argc) ? "--adc requires a spec" : err);
+                free(paths);
+                return 1;
+            }
+            adc = &adc_config;
+            i++;
+        } else if (strcmp(argv[i], "--tick-us") == 0) {
+            if (i + 1 >= argc || atoi(argv[i + 1]) < 1 || atoi(argv[i + 1]) > 1000) {
+                fprintf(stderr, "Error: --tick-us requires 1-1000\n");
+                free(paths);
+                return 1;
+            }
+            tick_us = (uint32_t)atoi(argv[++i]);
+        } else if (strcmp(argv[i], "--cycles") == 0) {
+            char err[96];
+            if (i + 1 >= argc ||
+                !cycle_cost_parse(argv[i + 1], &cycle_config, err, sizeof(err))) {
+                fprintf(stderr, "Error: %s\n", (i + 1 >= argc) ? "--cycles requires a spec" : err);
+                free(paths);
+                return 1;
+            }
+            cycles = &cycle_config;
+            i++;
+        } else if (strcmp(argv[i], "--help") == 0 || strcmp(argv[i], "-h") == 0) {
+            print_usage(argv[0]);
+            free(paths);
+            return 0;
+        } else if (argv[i][0] == '-') {
+            fprintf(stderr, "Unknown option: %s\n", argv[i]);
+            print_usage(argv[0]);
+            free(paths);
+            return 1;
+        } else {
+            paths[num_scripts++] = argv[i];
+        }
+    }
+
+    if (num_scripts == 0) {
+        print_usage(argv[0]);
+        free(paths);
+        return 1;
+    }
+
+    RunResult *results = calloc(num_scripts, sizeof(RunResult));
+    WorkPool *pool = work_pool_create(jobs);
+    if (!results || !pool) {
+        fprintf(stderr, "Error: Out of memory\n");
+        free(results);
+        free(paths);
+        work_pool_destroy(pool);
+        return 1;
+    }
+
+    for (int i = 0; i < num_scripts; i++) {
+        results[i].path = paths[i];
+        results[i].adc = adc;
+        results[i].tick_us = tick_us;
+        results[i].cycles = cycles;
+        if (!work_pool_submit(pool, run_script, &results[i])) {
+            fprintf(stderr, "Error: Out of memory\n");
+            return 1;
+        }
+    }
+
+    double start = wall_time_ms();
+    if (!work_pool_run(pool)) {
+        fprintf(stderr, "Error: Failed to run worker pool\n");
+        return 1;
+    }
+    double wall_ms = wall_time_ms() - start;
+
+    // Report in command line order
+    int passed = 0;
+    int asserts_passed = 0;
+    int asserts_failed = 0;
+    double sim_ms_total = 0;
+    double wall_ms_total = 0;
+    uint32_t timer0_max_latency = 0;
+    uint32_t timer0_lost = 0;
+    const RunResult *worst = NULL;
+
+    for (int i = 0; i < num_scripts; i++) {
+        RunResult *res = &results[i];
+        bool ok = result_passed(res);
+
+        printf("%-5s %s", result_label(res), res->path);
+        if (res->loaded) {
+            double ratio = (res->wall_ms > 0) ? res->sim_ms / res->wall_ms : 0;
+            printf("  (%d/%d asserts, %lu ms sim, %.2f ms wall, %.0fx)",
+                   res->stats.asserts_passed,
+                   res->stats.asserts_passed + res->stats.asserts_failed,
+                   (unsigned long)res->sim_ms, res->wall_ms, ratio);
+            if (res->cycles) {
+                printf("  worst pass %lu cycles (%lu us)", (unsigned long)res->worst_cycles,
+                       (unsigned long)CYCLE_US(res->worst_cycles));
+                if (res->over_budget) {
+                    printf(", %lu over budget", (unsigned long)res->over_budget);
+                }
+            }
+        }
+        printf("\n");
+
+        if ((!ok || verbose) && res->log && res->log_len > 0) {
+            // Indent captured log under the result line
+            char *line = res->log;
+            while (*line) {
+                char *next = strchr(line, '\n');
+                int len = next ? (int)(next - line) : (int)strlen(line);
+                printf("      %.*s\n", len, line);
+                if (!next) break;
+                line = next + 1;
+            }
+        }
+
+        if (ok) passed++;
+        asserts_passed += res->stats.asserts_passed;
+        asserts_failed += res->stats.asserts_failed;
+        sim_ms_total += res->sim_ms;
+        if (res->timer0.max_latency_us > timer0_max_latency) {
+            timer0_max_latency = res->timer0.max_latency_us;
+        }
+        timer0_lost += res->timer0.lost;
+        if (res->loaded && (!worst || res->worst_cycles > worst->worst_cycles)) {
+            worst = res;
+        }
+        wall_ms_total += res->wall_ms;
+        free(res->log);
+    }
+
+    printf("\n%d scripts: %d passed, %d failed\n",
+           num_scripts, passed, num_scripts - passed);
+    printf("Assertions: %d passed, %d failed\n", asserts_passed, asserts_failed);
+    printf("Simulated %.1f s in %.1f ms wall (%.0fx realtime, %.0fx per worker)\n",
+           sim_ms_total / 1000.0, wall_ms,
+           (wall_ms > 0) ? sim_ms_total / wall_ms : 0,
+           (wall_ms_total > 0) ? sim_ms_total / wall_ms_total : 0);
+    if (tick_us) {
+        printf("Timer0 ISR: max latency %lu us, %lu ticks lost (%lu us passes)\n",
+               (unsigned long)timer0_max_latency, (unsigned long)timer0_lost,
+               (unsigned long)tick_us);
+    }
+    if (cycles && worst) {
+        printf("Worst loop pass: %lu cycles (%lu us) in %s\n",
+               (unsigned long)worst->worst_cycles,
+               (unsigned long)CYCLE_US(worst->worst_cycles), worst->path);
+    }
+    printf("Workers: %d, steals: %lu\n",
+           work_pool_num_workers(pool), (unsigned long)work_pool_steals(pool));
+
+    work_pool_destroy(pool);
+    free(results);
+    free(paths);
+
+    return (passed == num_scripts) ? 0 : 1;
+}
@@ -0,0 +1,117 @@
+#include "sim_schedule.h"
+#include "events/events.h"
+#include "modes/mode_handlers.h"
+#include "output/led_animation.h"
+#include "utility/status.h"
+
+/**
+ * @file sim_schedule.c
+ * @brief Discrete-event scheduling implementation
+ *
+ * Each helper mirrors one time-dependent check in the application and
+ * returns the first time that check can change its outcome. Anything we
+ * can't predict cheaply (cycle mode phase, glow animation) asks for the
+ * next tick, which keeps the result exact at the cost of not skipping.
+ */
+
+// Earlier of two deadlines
+static uint32_t earliest(uint32_t a, uint32_t b) {
+    return (a < b) ? a : b;
+}
+
+// Hold threshold deadlines (mirrors event_processor_update)
+static uint32_t events_deadline(const EventProcessor *ep) {
+    uint32_t deadline = SIM_SCHEDULE_NEVER;
+
+    if (STATUS_ANY(ep->status, EP_A_PRESSED) && !STATUS_ANY(ep->status, EP_A_HOLD)) {
+        deadline = earliest(deadline, ep->a_press_time + EP_HOLD_THRESHOLD_MS);
+    }
+    if (STATUS_ANY(ep->status, EP_B_PRESSED) && !STATUS_ANY(ep->status, EP_B_HOLD)) {
+        deadline = earliest(deadline, ep->b_press_time + EP_HOLD_THRESHOLD_MS);
+    }
+
+    return deadline;
+}
+
+// Mode handler deadlines (mirrors mode_handler_process, perform mode only)
+// Without `phase`, cycle mode only counts its output flips
+static uint32_t mode_deadline(ModeState mode, const ModeContext *ctx, uint32_t now, bool phase) {
+    switch (mode) {
+        case MODE_TRIGGER:
+            if (ctx->trigger.output_state) {
+                return ctx->trigger.pulse_start + ctx->trigger.pulse_duration_ms;
+            }
+            return SIM_SCHEDULE_NEVER;
+
+        case MODE_DIVIDE:
+            if (ctx->divide.output_state) {
+                return ctx->divide.pulse_start + OUTPUT_PULSE_MS;
+            }
+            return SIM_SCHEDULE_NEVER;
+
+        case MODE_CYCLE:
+            if (!ctx->cycle.running) {
+                return SIM_SCHEDULE_NEVER;
+            }
+            // Phase drives the activity LED brightness every few ms
+            return phase ? now + 1 : ctx->cycle.last_toggle + ctx->cycle.period_ms / 2;
+
+        case MODE_GATE:
+        case MODE_TOGGLE:
+        default:
+            // Purely input-driven
+            return SIM_SCHEDULE_NEVER;
+    }
+}
+
+// Animation deadlines (mirrors led_animation_update)
+static uint32_t animation_deadline(const LEDAnimation *anim, uint32_t now) {
+    switch (anim->type) {
+        case ANIM_BLINK:
+            return anim->last_update + anim->period_ms / 2;
+        case ANIM_GLOW:
+            return now + 1;
+        case ANIM_NONE:
+        default:
+            return SIM_SCHEDULE_NEVER;
+    }
+}
+
+// Coordinator deadlines
+static uint32_t coordinator_deadline(const Coordinator *coord, uint32_t now, bool phase) {
+    uint32_t deadline = events_deadline(&coord->events);
+
+    if (coordinator_in_menu(coord)) {
+        deadline = earliest(deadline, coord->last_activity + MENU_TIMEOUT_MS);
+    } else {
+        deadline = earliest(deadline,
+            mode_deadline(coordinator_get_mode(coord), &coord->mode_ctx, now, phase));
+    }
+    return deadline;
+}
+
+uint32_t sim_schedule_next_deadline(const Coordinator *coord,
+                                    const LEDFeedbackController *led_ctrl,
+                                    uint32_t now) {
+    if (!coord || !led_ctrl) return now + 1;
+
+    uint32_t deadline = coordinator_deadline(coord, now, true);
+    deadline = earliest(deadline, animation_deadline(&led_ctrl->mode_anim, now));
+    deadline = earliest(deadline, animation_deadline(&led_ctrl->activity_anim, now));
+
+    // Overdue deadlines fire on the very next tick
+    if (deadline <= now) {
+        deadline = now + 1;
+    }
+    return deadline;
+}
+
+uint32_t sim_schedule_next_state_change(const Coordinator *coord, uint32_t now) {
+    if (!coord) return now + 1;
+
+    uint32_t deadline = coordinator_deadline(coord, now, false);
+    if (deadline <= now) {
+        deadline = now + 1;
+    }
+    return deadline;
+}
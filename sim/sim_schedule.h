@@ -0,0 +1,55 @@
+#ifndef GK_SIM_SCHEDULE_H
+#define GK_SIM_SCHEDULE_H
+
+#include "core/coordinator.h"
+#include "output/led_feedback.h"
+#include <stdbool.h>
+#include <stdint.h>
+
+/**
+ * @file sim_schedule.h
+ * @brief Discrete-event scheduling for the simulator main loop
+ *
+ * With inputs held constant, the application only changes state at a few
+ * well-known deadlines (hold thresholds, pulse expiry, menu timeout, LED
+ * blink toggles). The simulator uses these to skip idle milliseconds
+ * instead of running the full pipeline for every one of them.
+ */
+
+// Deadline value meaning "nothing scheduled"
+#define SIM_SCHEDULE_NEVER UINT32_MAX
+
+// CV change (in ADC units, ~0.5V) that the simulator logs as an input event
+#define SIM_CV_LOG_DELTA 25
+
+/**
+ * Get the earliest time at which application state may change.
+ *
+ * Inspects the coordinator (event processor, menu timeout, mode handler)
+ * and the LED controller (animations). Only valid when called right after
+ * a full loop iteration at time `now`, with inputs unchanged since.
+ *
+ * @param coord     Coordinator after its update at `now`
+ * @param led_ctrl  LED controller after its update at `now`
+ * @param now       Time of the last full iteration
+ * @return          Deadline in ms (> now), or SIM_SCHEDULE_NEVER
+ */
+uint32_t sim_schedule_next_deadline(const Coordinator *coord,
+                                    const LEDFeedbackController *led_ctrl,
+                                    uint32_t now);
+
+/**
+ * Get the earliest time at which coordinator state other than the
+ * cycle mode LED phase may change.
+ *
+ * Same contract as sim_schedule_next_deadline(), for callers that don't
+ * look at the LEDs (the state-space explorer): cycle mode only wakes up
+ * to flip its output.
+ *
+ * @param coord     Coordinator after its update at `now`
+ * @param now       Time of the last update
+ * @return          Deadline in ms (> now), or SIM_SCHEDULE_NEVER
+ */
+uint32_t sim_schedule_next_state_change(const Coordinator *coord, uint32_t now);
+
+#endif /* GK_SIM_SCHEDULE_H */
@@ -128,6 +128,7 @@ void sim_state_add_event(SimState *state, SimEventType type, uint32_t time_ms, c
     if (state->event_count < SIM_MAX_EVENTS) {
         state->event_count++;
     }
+    state->event_total++;
     state->dirty = true;
 }
 
@@ -145,6 +146,23 @@ void sim_state_set_realtime(SimState *state, bool realtime) {
     }
 }
 
+void sim_state_set_timing(SimState *state, const SimTiming *timing) {
+    if (!state || !timing) return;
+    state->timing = *timing;
+}
+
+const uint32_t sim_timing_bucket_us[SIM_TIMING_BUCKETS] = {
+    50, 100, 250, 500, 1000, 2000, 10000, UINT32_MAX
+};
+
+int sim_timing_bucket(uint32_t late_us) {
+    int i = 0;
+    while (i < SIM_TIMING_BUCKETS - 1 && late_us >= sim_timing_bucket_us[i]) {
+        i++;
+    }
+    return i;
+}
+
 bool sim_state_is_dirty(const SimState *state) {
     if (!state) return false;
     return state->dirty;
@@ -45,6 +45,21 @@ typedef struct {
     uint8_t r, g, b;
 } SimLED;
 
+// Realtime lateness histogram buckets (upper bounds: sim_timing_bucket_us)
+#define SIM_TIMING_BUCKETS 8
+
+/**
+ * Realtime pacing statistics, filled in by the front end.
+ * Lateness is how long after its wall-clock deadline a tick started.
+ */
+typedef struct {
+    uint32_t ticks;         // Paced ticks
+    uint32_t late_ticks;    // Ticks started a full tick (1ms) or more late
+    uint32_t max_late_us;   // Worst lateness
+    uint32_t resyncs;       // Backlogs dropped for exceeding the catch-up limit
+    uint32_t hist[SIM_TIMING_BUCKETS];
+} SimTiming;
+
 /**
  * Complete simulator state snapshot
  */
@@ -77,9 +92,11 @@ typedef struct {
     SimStateEvent events[SIM_MAX_EVENTS];
     int event_head;
     int event_count;
+    uint32_t event_total;   // Events ever added (renderers diff this for new events)
 
     // Display hints (for terminal renderer)
     bool realtime_mode;
+    SimTiming timing;       // Pacing statistics (realtime mode only)
     bool legend_visible;
 
     // Dirty tracking
@@ -131,6 +148,22 @@ void sim_state_toggle_legend(SimState *state);
  */
 void sim_state_set_realtime(SimState *state, bool realtime);
 
+/**
+ * Update pacing statistics (doesn't mark the state dirty).
+ */
+void sim_state_set_timing(SimState *state, const SimTiming *timing);
+
+/**
+ * Get the histogram bucket for a lateness.
+ */
+int sim_timing_bucket(uint32_t late_us);
+
+/**
+ * Upper bounds (exclusive) of the lateness histogram buckets in us.
+ * The last bucket is open-ended (UINT32_MAX).
+ */
+extern const uint32_t sim_timing_bucket_us[SIM_TIMING_BUCKETS];
+
 /**
  * Check if state has changed since last render.
  */
@@ -0,0 +1,153 @@
+#ifndef GK_SIM_SOCKET_PROTOCOL_H
+#define GK_SIM_SOCKET_PROTOCOL_H
+
+#include <stdint.h>
+
+/**
+ * @file socket_protocol.h
+ * @brief Binary framed socket protocol
+ *
+ * Alternative to NDJSON for high-rate clients (CV streaming, per-tick
+ * state). A client selects it by sending the 4-byte magic "GKB1" as the
+ * very first bytes after connecting; the server answers with a HELLO
+ * frame and from then on both directions use frames:
+ *
+ *   u8 type | u8 reserved (0) | u16 payload length | payload
+ *
+ * All integers are little-endian. Enum values (state, mode, page, LFO
+ * shape, event type) are the simulator's own enum values. A client that
+ * sends anything else first (or nothing for SOCKET_NEGOTIATE_MS) gets
+ * NDJSON as before.
+ *
+ * Commands (client -> simulator), fixed layouts:
+ *
+ *   0x01 BUTTON       u8 id (0 = A, 1 = B), u8 pressed
+ *   0x02 CV_MANUAL    u8 value
+ *   0x03 CV_LFO       u32 freq (mHz), u8 shape, u8 min, u8 max
+ *   0x04 CV_ENVELOPE  u16 attack_ms, u16 decay_ms, u8 sustain, u16 release_ms
+ *   0x05 CV_GATE      u8 on
+ *   0x06 CV_TRIGGER   -
+ *   0x07 RESET        -
+ *   0x08 QUIT         -
+ *   0x09 SUBSCRIBE    u8 topics (SocketTopic mask), u8 policy, u16 interval_ms
+ *                     (clamped to 60000)
+ *   0x0A CV_BLOCK     u32 rate_hz, u8 samples[payload length - 4]
+ *   0x0B CV_FILE      u8 loop, u8 format (CVFileFormat), u32 rate_hz (raw),
+ *                     path bytes[payload length - 6]
+ *
+ * CV_BLOCK queues samples on the stream CV source (see
+ * cv_source_stream_push) and is answered with CV_STATUS, which a
+ * generator can use to keep the buffer level steady.
+ *
+ * Messages (simulator -> client):
+ *
+ *   0x80 HELLO        u8 version, u8 reserved, u16 max payload
+ *   0x81 STATE        u32 timestamp_ms, u8 state, u8 mode, u8 page,
+ *                     u8 cv_voltage, u8 flags (SOCKET_STATE_*)
+ *   0x82 EVENTS       u8 count, then per event:
+ *                     u32 time_ms, u8 type, u8 length, message bytes
+ *   0x83 LEDS         u32 timestamp_ms, u8 count, count x (u8 r, g, b)
+ *   0x84 CV           u32 timestamp_ms, u8 value
+ *   0x85 SUBSCRIBED   -
+ *   0x86 ERROR        message bytes (not NUL-terminated)
+ *   0x87 DROPPED      u32 messages dropped by backpressure
+ *   0x88 CV_STATUS    u32 samples buffered, u32 underruns, u32 overflows
+ *   0x89 CHANGES      u16 count, then count change records:
+ *                     u32 time_ms, u8 kind (SOCKET_CHANGE_*), kind fields:
+ *                       OUTPUT  u8 level
+ *                       INPUT   u8 id (0 = A, 1 = B, 2 = CV), u8 level
+ *                       LED     u8 index, u8 r, u8 g, u8 b
+ *                       FSM     u8 state, u8 mode, u8 page, u8 in_menu
+ *   0x8A TIMING       u32 timestamp_ms, u32 ticks, u32 late_ticks,
+ *                     u32 max_late_us, u32 resyncs, u8 count,
+ *                     count x u32 lateness histogram (see SimTiming)
+ */
+
+#define SOCKET_BINARY_MAGIC "GKB1"
+#define SOCKET_BINARY_MAGIC_LEN 4
+#define SOCKET_BINARY_VERSION 1
+
+// Frame header size and largest payload accepted or sent
+#define SOCKET_FRAME_HEADER 4
+#define SOCKET_FRAME_MAX_PAYLOAD 4096
+
+// Time a silent client is given to send the magic before it gets NDJSON
+#define SOCKET_NEGOTIATE_MS 100
+
+// Command frame types
+enum {
+    SOCKET_CMD_BUTTON       = 0x01,
+    SOCKET_CMD_CV_MANUAL    = 0x02,
+    SOCKET_CMD_CV_LFO       = 0x03,
+    SOCKET_CMD_CV_ENVELOPE  = 0x04,
+    SOCKET_CMD_CV_GATE      = 0x05,
+    SOCKET_CMD_CV_TRIGGER   = 0x06,
+    SOCKET_CMD_RESET        = 0x07,
+    SOCKET_CMD_QUIT         = 0x08,
+    SOCKET_CMD_SUBSCRIBE    = 0x09,
+    SOCKET_CMD_CV_BLOCK     = 0x0A,
+    SOCKET_CMD_CV_FILE      = 0x0B
+};
+
+// Message frame types
+enum {
+    SOCKET_MSG_HELLO        = 0x80,
+    SOCKET_MSG_STATE        = 0x81,
+    SOCKET_MSG_EVENTS       = 0x82,
+    SOCKET_MSG_LEDS         = 0x83,
+    SOCKET_MSG_CV           = 0x84,
+    SOCKET_MSG_SUBSCRIBED   = 0x85,
+    SOCKET_MSG_ERROR        = 0x86,
+    SOCKET_MSG_DROPPED      = 0x87,
+    SOCKET_MSG_CV_STATUS    = 0x88,
+    SOCKET_MSG_CHANGES      = 0x89,
+    SOCKET_MSG_TIMING       = 0x8A
+};
+
+// CHANGES record kinds
+enum {
+    SOCKET_CHANGE_OUTPUT    = 0,
+    SOCKET_CHANGE_INPUT     = 1,
+    SOCKET_CHANGE_LED       = 2,
+    SOCKET_CHANGE_FSM       = 3
+};
+
+// STATE flags
+#define SOCKET_STATE_OUTPUT     0x01
+#define SOCKET_STATE_BUTTON_A   0x02
+#define SOCKET_STATE_BUTTON_B   0x04
+#define SOCKET_STATE_CV_IN      0x08
+#define SOCKET_STATE_IN_MENU    0x10
+
+// Little-endian field access
+static inline uint16_t sp_get_u16(const uint8_t *p) {
+    return (uint16_t)(p[0] | (p[1] << 8));
+}
+
+static inline uint32_t sp_get_u32(const uint8_t *p) {
+    return (uint32_t)p[0] | ((uint32_t)p[1] << 8) |
+           ((uint32_t)p[2] << 16) | ((uint32_t)p[3] << 24);
+}
+
+static inline void sp_put_u16(uint8_t *p, uint16_t v) {
+    p[0] = (uint8_t)v;
+    p[1] = (uint8_t)(v >> 8);
+}
+
+static inline void sp_put_u32(uint8_t *p, uint32_t v) {
+    p[0] = (uint8_t)v;
+    p[1] = (uint8_t)(v >> 8);
+    p[2] = (uint8_t)(v >> 16);
+    p[3] = (uint8_t)(v >> 24);
+}
+
+/**
+ * Write a frame header for a payload of len bytes.
+ */
+static inline void sp_put_header(uint8_t *p, uint8_t type, uint16_t len) {
+    p[0] = type;
+    p[1] = 0;
+    sp_put_u16(p + 2, len);
+}
+
+#endif /* GK_SIM_SOCKET_PROTOCOL_H */
@@ -0,0 +1,548 @@
+#include "socket_publisher.h"
+#include "socket_protocol.h"
+#include <string.h>
+
+/**
+ * @file socket_publisher.c
+ * @brief Socket topic message formatting
+ */
+
+// Topic indices into SocketPublisher.version
+enum {
+    IDX_STATE,
+    IDX_EVENTS,
+    IDX_LEDS,
+    IDX_CV,
+    IDX_CHANGES,
+    IDX_TIMING
+};
+
+void socket_publisher_init(SocketPublisher *pub) {
+    memset(pub, 0, sizeof(*pub));
+    jb_init(&pub->buf);
+}
+
+void socket_publisher_free(SocketPublisher *pub) {
+    jb_free(&pub->buf);
+}
+
+// =============================================================================
+// Binary frame building (in the same reusable buffer)
+// =============================================================================
+
+static void frame_begin(JsonBuf *jb, uint8_t type) {
+    uint8_t hdr[SOCKET_FRAME_HEADER];
+    sp_put_header(hdr, type, 0);
+    jb_reset(jb);
+    jb_append(jb, (const char*)hdr, sizeof(hdr));
+}
+
+// Fill in the payload length
+static void frame_end(JsonBuf *jb) {
+    if (jb->oom) return;
+    sp_put_u16((uint8_t*)jb->data + 2, (uint16_t)(jb->len - SOCKET_FRAME_HEADER));
+}
+
+static void frame_u8(JsonBuf *jb, uint8_t v) {
+    jb_char(jb, (char)v);
+}
+
+static void frame_u32(JsonBuf *jb, uint32_t v) {
+    uint8_t b[4];
+    sp_put_u32(b, v);
+    jb_append(jb, (const char*)b, sizeof(b));
+}
+
+// =============================================================================
+// Topics
+// =============================================================================
+
+static void capture(PublishedState *p, const SimState *state) {
+    p->top_state = state->top_state;
+    p->mode = state->mode;
+    p->page = state->page;
+    p->in_menu = state->in_menu;
+    p->button_a = state->button_a;
+    p->button_b = state->button_b;
+    p->cv_in = state->cv_in;
+    p->cv_voltage = state->cv_voltage;
+    p->signal_out = state->signal_out;
+    memcpy(p->leds, state->leds, sizeof(p->leds));
+    p->timing_ticks = state->timing.ticks;
+}
+
+static bool fsm_changed(const PublishedState *a, const PublishedState *b) {
+    return a->top_state != b->top_state || a->mode != b->mode ||
+           a->in_menu != b->in_menu || (a->in_menu && a->page != b->page);
+}
+
+// Bump topic versions for whatever changed since the last tick
+static void update_versions(SocketPublisher *pub, const PublishedState *now) {
+    const PublishedState *last = &pub->last;
+    if (!pub->have_last) {
+        pub->version[IDX_STATE]++;
+        pub->version[IDX_LEDS]++;
+        pub->version[IDX_CV]++;
+        pub->version[IDX_TIMING]++;
+    } else {
+        if (fsm_changed(now, last) ||
+            now->button_a != last->button_a || now->button_b != last->button_b ||
+            now->cv_in != last->cv_in || now->cv_voltage != last->cv_voltage ||
+            now->signal_out != last->signal_out) {
+            pub->version[IDX_STATE]++;
+        }
+        if (memcmp(now->leds, last->leds, sizeof(now->leds)) != 0) {
+            pub->version[IDX_LEDS]++;
+        }
+        if (now->cv_voltage != last->cv_voltage) {
+            pub->version[IDX_CV]++;
+        }
+        if (now->timing_ticks != last->timing_ticks) {
+            pub->version[IDX_TIMING]++;
+        }
+    }
+
+    pub->last = *now;
+    pub->have_last = true;
+}
+
+// =============================================================================
+// Change records (SOCKET_TOPIC_CHANGES)
+// =============================================================================
+
+static const char *input_names[] = { "a", "b", "cv" };
+
+static void add_output(JsonBuf *jb, SocketServer *server, SocketFormat format,
+                       uint32_t t, bool level) {
+    jb_reset(jb);
+    if (format == SOCKET_FORMAT_BINARY) {
+        frame_u32(jb, t);
+        frame_u8(jb, SOCKET_CHANGE_OUTPUT);
+        frame_u8(jb, level);
+    } else {
+        jb_lit(jb, "{\"t\":");
+        jb_u32(jb, t);
+        jb_lit(jb, ",\"output\":");
+        jb_bool(jb, level);
+        jb_char(jb, '}');
+    }
+    socket_server_batch_add(server, format, jb->data, jb->len);
+}
+
+static void add_input(JsonBuf *jb, SocketServer *server, SocketFormat format,
+                      uint32_t t, int id, bool level) {
+    jb_reset(jb);
+    if (format == SOCKET_FORMAT_BINARY) {
+        frame_u32(jb, t);
+        frame_u8(jb, SOCKET_CHANGE_INPUT);
+        frame_u8(jb, (uint8_t)id);
+        frame_u8(jb, level);
+    } else {
+        jb_lit(jb, "{\"t\":");
+        jb_u32(jb, t);
+        jb_lit(jb, ",\"input\":\"");
+        jb_str(jb, input_names[id]);
+        jb_lit(jb, "\",\"value\":");
+        jb_bool(jb, level);
+        jb_char(jb, '}');
+    }
+    socket_server_batch_add(server, format, jb->data, jb->len);
+}
+
+static void add_led(JsonBuf *jb, SocketServer *server, SocketFormat format,
+                    uint32_t t, int index, const SimLED *led) {
+    jb_reset(jb);
+    if (format == SOCKET_FORMAT_BINARY) {
+        frame_u32(jb, t);
+        frame_u8(jb, SOCKET_CHANGE_LED);
+        frame_u8(jb, (uint8_t)index);
+        frame_u8(jb, led->r);
+        frame_u8(jb, led->g);
+        frame_u8(jb, led->b);
+    } else {
+        jb_lit(jb, "{\"t\":");
+        jb_u32(jb, t);
+        jb_lit(jb, ",\"led\":");
+        jb_u32(jb, (uint32_t)index);
+        jb_lit(jb, ",\"rgb\":[");
+        jb_u32(jb, led->r);
+        jb_char(jb, ',');
+        jb_u32(jb, led->g);
+        jb_char(jb, ',');
+        jb_u32(jb, led->b);
+        jb_lit(jb, "]}");
+    }
+    socket_server_batch_add(server, format, jb->data, jb->len);
+}
+
+static void add_fsm(JsonBuf *jb, SocketServer *server, SocketFormat format,
+                    uint32_t t, const PublishedState *now) {
+    jb_reset(jb);
+    if (format == SOCKET_FORMAT_BINARY) {
+        frame_u32(jb, t);
+        frame_u8(jb, SOCKET_CHANGE_FSM);
+        frame_u8(jb, (uint8_t)now->top_state);
+        frame_u8(jb, (uint8_t)now->mode);
+        frame_u8(jb, (uint8_t)now->page);
+        frame_u8(jb, now->in_menu);
+    } else {
+        jb_lit(jb, "{\"t\":");
+        jb_u32(jb, t);
+        jb_lit(jb, ",\"state\":\"");
+        jb_str(jb, sim_top_state_str(now->top_state));
+        jb_lit(jb, "\",\"mode\":\"");
+        jb_str(jb, sim_mode_str(now->mode));
+        jb_lit(jb, "\",\"page\":");
+        if (now->in_menu) {
+            jb_char(jb, '"');
+            jb_str(jb, sim_page_str(now->page));
+            jb_char(jb, '"');
+        } else {
+            jb_lit(jb, "null");
+        }
+        jb_char(jb, '}');
+    }
+    socket_server_batch_add(server, format, jb->data, jb->len);
+}
+
+// Add a record for every change since the last tick to the client batches
+static void add_changes(SocketPublisher *pub, SocketServer *server, SocketFormat format,
+                        const PublishedState *now, uint32_t t) {
+    const PublishedState *last = &pub->last;
+    JsonBuf *jb = &pub->buf;
+
+    if (fsm_changed(now, last)) {
+        add_fsm(jb, server, format, t, now);
+    }
+    if (now->button_a != last->button_a) {
+        add_input(jb, server, format, t, 0, now->button_a);
+    }
+    if (now->button_b != last->button_b) {
+        add_input(jb, server, format, t, 1, now->button_b);
+    }
+    if (now->cv_in != last->cv_in) {
+        add_input(jb, server, format, t, 2, now->cv_in);
+    }
+    if (now->signal_out != last->signal_out) {
+        add_output(jb, server, format, t, now->signal_out);
+    }
+    for (int i = 0; i < SIM_NUM_LEDS; i++) {
+        if (memcmp(&now->leds[i], &last->leds[i], sizeof(SimLED)) != 0) {
+            add_led(jb, server, format, t, i, &now->leds[i]);
+        }
+    }
+}
+
+static void format_state_binary(JsonBuf *jb, const SimState *state) {
+    uint8_t flags = 0;
+    if (state->signal_out) flags |= SOCKET_STATE_OUTPUT;
+    if (state->button_a) flags |= SOCKET_STATE_BUTTON_A;
+    if (state->button_b) flags |= SOCKET_STATE_BUTTON_B;
+    if (state->cv_in) flags |= SOCKET_STATE_CV_IN;
+    if (state->in_menu) flags |= SOCKET_STATE_IN_MENU;
+
+    frame_begin(jb, SOCKET_MSG_STATE);
+    frame_u32(jb, state->timestamp_ms);
+    frame_u8(jb, (uint8_t)state->top_state);
+    frame_u8(jb, (uint8_t)state->mode);
+    frame_u8(jb, (uint8_t)state->page);
+    frame_u8(jb, state->cv_voltage);
+    frame_u8(jb, flags);
+    frame_end(jb);
+}
+
+static void format_state_json(JsonBuf *jb, const SimState *state) {
+    jb_reset(jb);
+    jb_lit(jb, "{\"topic\":\"state\",\"timestamp_ms\":");
+    jb_u32(jb, state->timestamp_ms);
+    jb_lit(jb, ",\"state\":\"");
+    jb_str(jb, sim_top_state_str(state->top_state));
+    jb_lit(jb, "\",\"mode\":\"");
+    jb_str(jb, sim_mode_str(state->mode));
+    jb_lit(jb, "\",\"page\":");
+    if (state->in_menu) {
+        jb_char(jb, '"');
+        jb_str(jb, sim_page_str(state->page));
+        jb_char(jb, '"');
+    } else {
+        jb_lit(jb, "null");
+    }
+    jb_lit(jb, ",\"cv_voltage\":");
+    jb_u32(jb, state->cv_voltage);
+    jb_lit(jb, ",\"output\":");
+    jb_bool(jb, state->signal_out);
+    jb_lit(jb, ",\"button_a\":");
+    jb_bool(jb, state->button_a);
+    jb_lit(jb, ",\"button_b\":");
+    jb_bool(jb, state->button_b);
+    jb_lit(jb, ",\"cv_in\":");
+    jb_bool(jb, state->cv_in);
+    jb_lit(jb, "}\n");
+}
+
+static void format_events_binary(JsonBuf *jb, const SimState *state,
+                                 int output_start, int new_events) {
+    frame_begin(jb, SOCKET_MSG_EVENTS);
+    frame_u8(jb, (uint8_t)new_events);
+    for (int i = 0; i < new_events; i++) {
+        const SimStateEvent *evt = &state->events[(output_start + i) % SIM_MAX_EVENTS];
+        size_t len = strnlen(evt->message, sizeof(evt->message));
+        if (len > 255) len = 255;
+        frame_u32(jb, evt->time_ms);
+        frame_u8(jb, (uint8_t)evt->type);
+        frame_u8(jb, (uint8_t)len);
+        jb_append(jb, evt->message, len);
+    }
+    frame_end(jb);
+}
+
+static void format_events_json(JsonBuf *jb, const SimState *state,
+                               int output_start, int new_events) {
+    jb_reset(jb);
+    jb_lit(jb, "{\"topic\":\"events\",\"events\":[");
+    for (int i = 0; i < new_events; i++) {
+        const SimStateEvent *evt = &state->events[(output_start + i) % SIM_MAX_EVENTS];
+        if (i > 0) jb_char(jb, ',');
+        jb_lit(jb, "{\"time_ms\":");
+        jb_u32(jb, evt->time_ms);
+        jb_lit(jb, ",\"type\":\"");
+        jb_str(jb, sim_event_type_str(evt->type));
+        jb_lit(jb, "\",\"message\":");
+        jb_quoted(jb, evt->message);
+        jb_char(jb, '}');
+    }
+    jb_lit(jb, "]}\n");
+}
+
+static void format_leds_binary(JsonBuf *jb, const SimState *state) {
+    frame_begin(jb, SOCKET_MSG_LEDS);
+    frame_u32(jb, state->timestamp_ms);
+    frame_u8(jb, SIM_NUM_LEDS);
+    for (int i = 0; i < SIM_NUM_LEDS; i++) {
+        frame_u8(jb, state->leds[i].r);
+        frame_u8(jb, state->leds[i].g);
+        frame_u8(jb, state->leds[i].b);
+    }
+    frame_end(jb);
+}
+
+static void format_leds_json(JsonBuf *jb, const SimState *state) {
+    jb_reset(jb);
+    jb_lit(jb, "{\"topic\":\"leds\",\"timestamp_ms\":");
+    jb_u32(jb, state->timestamp_ms);
+    jb_lit(jb, ",\"leds\":[");
+    for (int i = 0; i < SIM_NUM_LEDS; i++) {
+        if (i > 0) jb_char(jb, ',');
+        jb_char(jb, '[');
+        jb_u32(jb, state->leds[i].r);
+        jb_char(jb, ',');
+        jb_u32(jb, state->leds[i].g);
+        jb_char(jb, ',');
+        jb_u32(jb, state->leds[i].b);
+        jb_char(jb, ']');
+    }
+    jb_lit(jb, "]}\n");
+}
+
+static void format_cv_binary(JsonBuf *jb, const SimState *state) {
+    frame_begin(jb, SOCKET_MSG_CV);
+    frame_u32(jb, state->timestamp_ms);
+    frame_u8(jb, state->cv_voltage);
+    frame_end(jb);
+}
+
+static void format_cv_json(JsonBuf *jb, const SimState *state) {
+    jb_reset(jb);
+    jb_lit(jb, "{\"topic\":\"cv\",\"timestamp_ms\":");
+    jb_u32(jb, state->timestamp_ms);
+    jb_lit(jb, ",\"value\":");
+    jb_u32(jb, state->cv_voltage);
+    jb_lit(jb, "}\n");
+}
+
+static void format_timing_binary(JsonBuf *jb, const SimState *state) {
+    const SimTiming *t = &state->timing;
+    frame_begin(jb, SOCKET_MSG_TIMING);
+    frame_u32(jb, state->timestamp_ms);
+    frame_u32(jb, t->ticks);
+    frame_u32(jb, t->late_ticks);
+    frame_u32(jb, t->max_late_us);
+    frame_u32(jb, t->resyncs);
+    frame_u8(jb, SIM_TIMING_BUCKETS);
+    for (int i = 0; i < SIM_TIMING_BUCKETS; i++) {
+        frame_u32(jb, t->hist[i]);
+    }
+    frame_end(jb);
+}
+
+static void format_timing_json(JsonBuf *jb, const SimState *state) {
+    const SimTiming *t = &state->timing;
+    jb_reset(jb);
+    jb_lit(jb, "{\"topic\":\"timing\",\"timestamp_ms\":");
+    jb_u32(jb, state->timestamp_ms);
+    jb_lit(jb, ",\"ticks\":");
+    jb_u32(jb, t->ticks);
+    jb_lit(jb, ",\"late_ticks\":");
+    jb_u32(jb, t->late_ticks);
+    jb_lit(jb, ",\"max_late_us\":");
+    jb_u32(jb, t->max_late_us);
+    jb_lit(jb, ",\"resyncs\":");
+    jb_u32(jb, t->resyncs);
+    jb_lit(jb, ",\"lateness_hist\":[");
+    for (int i = 0; i < SIM_TIMING_BUCKETS; i++) {
+        if (i > 0) jb_char(jb, ',');
+        jb_u32(jb, t->hist[i]);
+    }
+    jb_lit(jb, "]}\n");
+}
+
+static void publish(SocketPublisher *pub, SocketServer *server, SocketTopic topic,
+                    SocketFormat format, uint32_t version, uint32_t now) {
+    if (pub->buf.oom) return;
+    socket_server_publish(server, topic, format, version, now, pub->buf.data, pub->buf.len);
+}
+
+static void publish_format(SocketPublisher *pub, SocketServer *server,
+                           SocketFormat format, const SimState *state) {
+    JsonBuf *jb = &pub->buf;
+    bool binary = (format == SOCKET_FORMAT_BINARY);
+    uint32_t now = state->timestamp_ms;
+
+    if (socket_server_wants(server, SOCKET_TOPIC_STATE, format, pub->version[IDX_STATE], now)) {
+        if (binary) {
+            format_state_binary(jb, state);
+        } else {
+            format_state_json(jb, state);
+        }
+        publish(pub, server, SOCKET_TOPIC_STATE, format, pub->version[IDX_STATE], now);
+    }
+
+    if (state->event_total != pub->last_event_total &&
+        socket_server_wants(server, SOCKET_TOPIC_EVENTS, format, state->event_total, now)) {
+        int start = (state->event_count < SIM_MAX_EVENTS) ? 0 : state->event_head;
+        int count = (state->event_count < SIM_MAX_EVENTS) ? state->event_count : SIM_MAX_EVENTS;
+        uint32_t unseen = state->event_total - pub->last_event_total;
+        int new_events = (unseen > (uint32_t)count) ? count : (int)unseen;
+        int output_start = (start + count - new_events) % SIM_MAX_EVENTS;
+
+        if (binary) {
+            format_events_binary(jb, state, output_start, new_events);
+        } else {
+            format_events_json(jb, state, output_start, new_events);
+        }
+        publish(pub, server, SOCKET_TOPIC_EVENTS, format, state->event_total, now);
+    }
+
+    if (socket_server_wants(server, SOCKET_TOPIC_LEDS, format, pub->version[IDX_LEDS], now)) {
+        if (binary) {
+            format_leds_binary(jb, state);
+        } else {
+            format_leds_json(jb, state);
+        }
+        publish(pub, server, SOCKET_TOPIC_LEDS, format, pub->version[IDX_LEDS], now);
+    }
+
+    if (socket_server_wants(server, SOCKET_TOPIC_CV, format, pub->version[IDX_CV], now)) {
+        if (binary) {
+            format_cv_binary(jb, state);
+        } else {
+            format_cv_json(jb, state);
+        }
+        publish(pub, server, SOCKET_TOPIC_CV, format, pub->version[IDX_CV], now);
+    }
+
+    if (socket_server_wants(server, SOCKET_TOPIC_TIMING, format, pub->version[IDX_TIMING], now)) {
+        if (binary) {
+            format_timing_binary(jb, state);
+        } else {
+            format_timing_json(jb, state);
+        }
+        publish(pub, server, SOCKET_TOPIC_TIMING, format, pub->version[IDX_TIMING], now);
+    }
+}
+
+void socket_publisher_tick(SocketPublisher *pub, SocketServer *server, const SimState *state) {
+    PublishedState now;
+    capture(&now, state);
+
+    // Every change of this tick, before pub->last moves on
+    if (pub->have_last) {
+        if (socket_server_subscribed(server, SOCKET_TOPIC_CHANGES, SOCKET_FORMAT_JSON)) {
+            add_changes(pub, server, SOCKET_FORMAT_JSON, &now, state->timestamp_ms);
+        }
+        if (socket_server_subscribed(server, SOCKET_TOPIC_CHANGES, SOCKET_FORMAT_BINARY)) {
+            add_changes(pub, server, SOCKET_FORMAT_BINARY, &now, state->timestamp_ms);
+        }
+    }
+    socket_server_batch_flush(server, state->timestamp_ms);
+
+    update_versions(pub, &now);
+
+    publish_format(pub, server, SOCKET_FORMAT_JSON, state);
+    publish_format(pub, server, SOCKET_FORMAT_BINARY, state);
+
+    // Events before a subscription aren't replayed to it
+    pub->last_event_total = state->event_total;
+}
+
+uint32_t socket_publisher_next_due(const SocketPublisher *pub, SocketServer *server,
+                                   uint32_t now_ms) {
+    // Versions are indexed like the topic bits
+    return socket_server_next_due(server, pub->version, now_ms);
+}
+
+bool socket_publisher_sends_cv(SocketServer *server) {
+    for (int f = 0; f < 2; f++) {
+        SocketFormat format = f ? SOCKET_FORMAT_BINARY : SOCKET_FORMAT_JSON;
+        if (socket_server_subscribed(server, SOCKET_TOPIC_STATE, format) ||
+            socket_server_subscribed(server, SOCKET_TOPIC_CV, format)) {
+            return true;
+        }
+    }
+    return false;
+}
+
+// =============================================================================
+// Command replies
+// =============================================================================
+
+void socket_publisher_reply(SocketPublisher *pub, SocketServer *server,
+                            const SocketRequest *req, const CommandResult *result,
+                            const CVSource *cv_source) {
+    JsonBuf *jb = &pub->buf;
+    bool binary = (req->format == SOCKET_FORMAT_BINARY);
+
+    if (!result->success) {
+        if (binary) {
+            frame_begin(jb, SOCKET_MSG_ERROR);
+            jb_str(jb, result->error);
+            frame_end(jb);
+        } else {
+            jb_reset(jb);
+            jb_lit(jb, "{\"topic\":\"error\",\"message\":");
+            jb_quoted(jb, result->error);
+            jb_lit(jb, "}\n");
+        }
+    } else if (result->type == CMD_SUBSCRIBE) {
+        if (binary) {
+            frame_begin(jb, SOCKET_MSG_SUBSCRIBED);
+            frame_end(jb);
+        } else {
+            jb_reset(jb);
+            jb_lit(jb, "{\"topic\":\"subscribed\"}\n");
+        }
+    } else if (result->type == CMD_CV_STREAM && binary &&
+               cv_source->type == CV_SOURCE_STREAM) {
+        frame_begin(jb, SOCKET_MSG_CV_STATUS);
+        frame_u32(jb, cv_source->stream.count);
+        frame_u32(jb, cv_source->stream.underruns);
+        frame_u32(jb, cv_source->stream.overflows);
+        frame_end(jb);
+    } else {
+        return;
+    }
+
+    if (!jb->oom) {
+        socket_server_send_to(server, req->client_id, jb->data, jb->len);
+    }
+}
@@ -0,0 +1,98 @@
+#ifndef GK_SIM_SOCKET_PUBLISHER_H
+#define GK_SIM_SOCKET_PUBLISHER_H
+
+#include "socket_server.h"
+#include "command_handler.h"
+#include "sim_state.h"
+#include "render/json_buf.h"
+
+/**
+ * @file socket_publisher.h
+ * @brief Turns simulator state into socket topic messages
+ *
+ * Tracks a version per topic that changes whenever the topic's content
+ * does, and only formats a message when some client wants it, once per
+ * wire format. Binary frames are described in socket_protocol.h; NDJSON
+ * messages are objects tagged with their topic:
+ *
+ *   {"topic":"state","timestamp_ms":1234,"state":"PERFORM","mode":"GATE",
+ *    "page":null,"cv_voltage":0,"output":true,"button_a":false,
+ *    "button_b":false,"cv_in":false}
+ *   {"topic":"events","events":[{"time_ms":1234,"type":"output","message":"Output -> HIGH"}]}
+ *   {"topic":"leds","timestamp_ms":1234,"leds":[[0,255,0],[255,255,255]]}
+ *   {"topic":"cv","timestamp_ms":1234,"value":128}
+ *   {"topic":"changes","changes":[{"t":1234,"output":true},
+ *    {"t":1235,"output":false},{"t":1235,"input":"a","value":true},
+ *    {"t":1236,"led":0,"rgb":[255,0,0]},
+ *    {"t":1240,"state":"MENU","mode":"GATE","page":"GATE_CV"}]}
+ *   {"topic":"timing","timestamp_ms":1234,"ticks":1234,"late_ticks":0,
+ *    "max_late_us":310,"resyncs":0,"lateness_hist":[1100,120,14,0,0,0,0,0]}
+ *
+ * The changes topic carries every change with the tick it happened on,
+ * batched per client interval. Subscribe to state as well to get the
+ * starting point. Timing only changes while running in realtime.
+ */
+
+/**
+ * Published fields, for change detection.
+ */
+typedef struct {
+    TopState top_state;
+    ModeState mode;
+    MenuPage page;
+    bool in_menu;
+    bool button_a;
+    bool button_b;
+    bool cv_in;
+    uint8_t cv_voltage;
+    bool signal_out;
+    SimLED leds[SIM_NUM_LEDS];
+    uint32_t timing_ticks;
+} PublishedState;
+
+typedef struct {
+    JsonBuf buf;                            // Reused for every message
+    uint32_t version[SOCKET_TOPIC_COUNT];   // Content version per topic
+    bool have_last;
+    PublishedState last;
+    uint32_t last_event_total;              // Events already published
+} SocketPublisher;
+
+/**
+ * Initialize publisher.
+ */
+void socket_publisher_init(SocketPublisher *pub);
+
+/**
+ * Free publisher buffers.
+ */
+void socket_publisher_free(SocketPublisher *pub);
+
+/**
+ * Publish changed topics to subscribed clients.
+ * Call once per main loop iteration, after the state is observed.
+ */
+void socket_publisher_tick(SocketPublisher *pub, SocketServer *server, const SimState *state);
+
+/**
+ * Get the earliest simulation time a message held back by a client's
+ * interval becomes due (see socket_server_next_due).
+ */
+uint32_t socket_publisher_next_due(const SocketPublisher *pub, SocketServer *server,
+                                   uint32_t now_ms);
+
+/**
+ * Check if any client follows the raw CV value (state or cv topic), so
+ * that every change of it is published.
+ */
+bool socket_publisher_sends_cv(SocketServer *server);
+
+/**
+ * Send the reply a command calls for (if any) to the client that sent it:
+ * errors, subscription acknowledgements and CV stream status.
+ */
+void socket_publisher_reply(SocketPublisher *pub, SocketServer *server,
+                            const SocketRequest *req, const CommandResult *result,
+                            const CVSource *cv_source);
+
+#endif /* GK_SIM_SOCKET_PUBLISHER_H */
@@ -1,4 +1,6 @@
 #include "socket_server.h"
+#include "socket_protocol.h"
+#include "render/json_buf.h"
 
 #include <stdio.h>
 #include <stdlib.h>
@@ -6,23 +8,94 @@
 #include <unistd.h>
 #include <fcntl.h>
 #include <errno.h>
+#include <time.h>
+#include <sys/epoll.h>
 #include <sys/socket.h>
+#include <sys/uio.h>
 #include <sys/un.h>
 
 /**
  * @file socket_server.c
  * @brief Unix domain socket server implementation
+ *
+ * One epoll instance watches the listening socket and all clients.
+ * socket_server_service() drains it without blocking; output is queued
+ * per client and written as far as the socket accepts, with EPOLLOUT
+ * armed only while a client has a backlog.
+ *
+ * A new client's format is settled by its first bytes: the binary magic
+ * switches it to frames, anything else (or silence for
+ * SOCKET_NEGOTIATE_MS) to NDJSON. Nothing is published to it before.
  */
 
-// Receive buffer size
-#define RECV_BUF_SIZE 4096
+// Receive ring size (per client, power of two); holds at least one maximal frame
+#define RECV_RING_SIZE 8192
+#define RECV_RING_MASK (RECV_RING_SIZE - 1)
+
+// Queued messages written per sendmsg() call
+#define SEND_IOV_MAX 16
+
+// epoll tag for the listening socket (clients use their index)
+#define LISTEN_TAG SOCKET_MAX_CLIENTS
+
+// Events handled per epoll_wait call
+#define MAX_EPOLL_EVENTS 32
+
+/**
+ * Queued outgoing message. Buffers are kept when the slot is reused.
+ */
+typedef struct {
+    char *data;
+    size_t len;
+    size_t cap;
+    uint32_t topic;             // SocketTopic, or 0 for replies/notices
+} QueuedMsg;
+
+typedef struct {
+    int fd;                     // Client socket (-1 if slot free)
+    SocketFormat format;
+    bool negotiated;            // Format settled
+    uint64_t connect_ms;        // Monotonic time of connect
+
+    // Receive ring; commands are handed out as slices into it
+    char rx_ring[RECV_RING_SIZE];
+    char rx_scratch[RECV_RING_SIZE];    // Linearized copy of a wrapped command
+    uint32_t rx_head;           // Absolute position of the first unread byte
+    uint32_t rx_tail;           // Absolute position past the last received byte
+    uint32_t rx_scanned;        // Bytes after rx_head known to hold no '\n'
+    bool rx_full;               // Ring filled up; read again when drained
+    bool rx_eof;                // Client closed its end
+    bool rx_done;               // ...and all its commands were served
+    bool discard_line;          // Dropping an over-long line up to '\n'
+
+    // Output queue (ring)
+    QueuedMsg queue[SOCKET_QUEUE_LEN];
+    int q_head;
+    int q_count;
+    size_t head_sent;           // Bytes of the head message already written
+    bool want_write;            // EPOLLOUT armed
+    uint32_t dropped;           // Messages dropped since last notice
+
+    // Subscription
+    uint32_t topics;
+    uint32_t interval_ms;
+    SocketPolicy policy;
+    bool sent[SOCKET_TOPIC_COUNT];          // Topic sent at least once
+    uint32_t last_version[SOCKET_TOPIC_COUNT];
+    uint32_t last_sent_ms[SOCKET_TOPIC_COUNT];
+
+    // Change records not sent yet (SOCKET_TOPIC_CHANGES)
+    JsonBuf batch;              // Message prefix + records so far
+    uint32_t batch_count;
+} Client;
 
 struct SocketServer {
     int listen_fd;              // Listening socket
-    int client_fd;              // Connected client (-1 if none)
+    int epoll_fd;               // epoll instance
     char path[108];             // Socket path (max for sun_path)
-    char recv_buf[RECV_BUF_SIZE];  // Receive buffer for line assembly
-    size_t recv_len;            // Current data in recv_buf
+    int num_clients;
+    int next_client;            // Round-robin position for socket_server_poll
+    Client clients[SOCKET_MAX_CLIENTS];
 };
 
 /**
@@ -34,12 +107,30 @@ static bool set_nonblocking(int fd) {
     return fcntl(fd, F_SETFL, flags | O_NONBLOCK) != -1;
 }
 
+static uint64_t monotonic_ms(void) {
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return (uint64_t)ts.tv_sec * 1000 + (uint64_t)ts.tv_nsec / 1000000;
+}
+
+static int topic_index(uint32_t topic) {
+    return __builtin_ctz(topic);
+}
+
+// Snapshots can be replaced by a newer one without losing information
+static bool topic_coalesces(uint32_t topic) {
+    return topic == SOCKET_TOPIC_STATE || topic == SOCKET_TOPIC_LEDS ||
+           topic == SOCKET_TOPIC_CV || topic == SOCKET_TOPIC_TIMING;
+}
+
 SocketServer* socket_server_create(const char *path) {
     SocketServer *server = calloc(1, sizeof(SocketServer));
     if (!server) return NULL;
 
-    server->client_fd = -1;
-    server->recv_len = 0;
+    for (int i = 0; i < SOCKET_MAX_CLIENTS; i++) {
+        server->clients[i].fd = -1;
+        jb_init(&server->clients[i].batch);
+    }
 
     // Use default path if none provided
     if (!path) path = SOCKET_DEFAULT_PATH;
@@ -77,7 +168,7 @@ SocketServer* socket_server_create(const char *path) {
     }
 
     // Listen for connections
-    if (listen(server->listen_fd, 1) < 0) {
+    if (listen(server->listen_fd, SOCKET_MAX_CLIENTS) < 0) {
         perror("socket_server: listen()");
         close(server->listen_fd);
         unlink(server->path);
@@ -85,6 +176,18 @@ SocketServer* socket_server_create(const char *path) {
         return NULL;
     }
 
+    server->epoll_fd = epoll_create1(0);
+    struct epoll_event ev = { .events = EPOLLIN, .data.u32 = LISTEN_TAG };
+    if (server->epoll_fd < 0 ||
+        epoll_ctl(server->epoll_fd, EPOLL_CTL_ADD, server->listen_fd, &ev) < 0) {
+        perror("socket_server: epoll");
+        if (server->epoll_fd >= 0) close(server->epoll_fd);
+        close(server->listen_fd);
+        unlink(server->path);
+        free(server);
+        return NULL;
+    }
+
     fprintf(stderr, "Socket server listening on: %s\n", server->path);
     return server;
 }
@@ -92,8 +195,18 @@ SocketServer* socket_server_create(const char *path) {
 void socket_server_destroy(SocketServer *server) {
     if (!server) return;
 
-    if (server->client_fd >= 0) {
-        close(server->client_fd);
+    for (int i = 0; i < SOCKET_MAX_CLIENTS; i++) {
+        Client *c = &server->clients[i];
+        if (c->fd >= 0) {
+            close(c->fd);
+        }
+        for (int j = 0; j < SOCKET_QUEUE_LEN; j++) {
+            free(c->queue[j].data);
+        }
+        jb_free(&c->batch);
+    }
+    if (server->epoll_fd >= 0) {
+        close(server->epoll_fd);
     }
     if (server->listen_fd >= 0) {
         close(server->listen_fd);
@@ -102,135 +215,738 @@ void socket_server_destroy(SocketServer *server) {
     free(server);
 }
 
+// =============================================================================
+// Connections
+// =============================================================================
+
 /**
- * Try to accept a new connection (non-blocking).
+ * Accept all pending connections (non-blocking).
  */
-static void try_accept(SocketServer *server) {
-    if (server->client_fd >= 0) return;  // Already have a client
+static void accept_clients(SocketServer *server) {
+    for (;;) {
+        int fd = accept(server->listen_fd, NULL, NULL);
+        if (fd < 0) {
+            if (errno != EAGAIN && errno != EWOULDBLOCK) {
+                perror("socket_server: accept()");
+            }
+            return;
+        }
 
-    int fd = accept(server->listen_fd, NULL, NULL);
-    if (fd < 0) {
-        if (errno != EAGAIN && errno != EWOULDBLOCK) {
-            perror("socket_server: accept()");
+        int slot = -1;
+        for (int i = 0; i < SOCKET_MAX_CLIENTS; i++) {
+            if (server->clients[i].fd < 0) {
+                slot = i;
+                break;
+            }
         }
-        return;
+        if (slot < 0) {
+            fprintf(stderr, "Socket client rejected: %d clients connected\n",
+                    SOCKET_MAX_CLIENTS);
+            close(fd);
+            continue;
+        }
+
+        // Set client socket to non-blocking
+        if (!set_nonblocking(fd)) {
+            perror("socket_server: fcntl() on client");
+            close(fd);
+            continue;
+        }
+
+        struct epoll_event ev = { .events = EPOLLIN, .data.u32 = (uint32_t)slot };
+        if (epoll_ctl(server->epoll_fd, EPOLL_CTL_ADD, fd, &ev) < 0) {
+            perror("socket_server: epoll_ctl() on client");
+            close(fd);
+            continue;
+        }
+
+        Client *c = &server->clients[slot];
+        c->fd = fd;
+        c->format = SOCKET_FORMAT_JSON;
+        c->negotiated = false;
+        c->connect_ms = monotonic_ms();
+        c->rx_head = 0;
+        c->rx_tail = 0;
+        c->rx_scanned = 0;
+        c->rx_full = false;
+        c->rx_eof = false;
+        c->rx_done = false;
+        c->discard_line = false;
+        c->q_head = 0;
+        c->q_count = 0;
+        c->head_sent = 0;
+        c->want_write = false;
+        c->dropped = 0;
+        c->topics = SOCKET_TOPICS_DEFAULT;
+        c->interval_ms = SOCKET_DEFAULT_INTERVAL_MS;
+        c->policy = SOCKET_POLICY_COALESCE;
+        memset(c->sent, 0, sizeof(c->sent));
+
+        server->num_clients++;
+        fprintf(stderr, "Socket client %d connected\n", slot);
     }
+}
 
-    // Set client socket to non-blocking
-    if (!set_nonblocking(fd)) {
-        perror("socket_server: fcntl() on client");
-        close(fd);
-        return;
+/**
+ * Close a client connection. Queued output is discarded.
+ */
+static void close_client(SocketServer *server, int id) {
+    Client *c = &server->clients[id];
+    if (c->fd < 0) return;
+
+    // Closing the fd removes it from the epoll set
+    close(c->fd);
+    c->fd = -1;
+    c->rx_head = c->rx_tail = 0;
+    c->q_count = 0;
+    c->batch_count = 0;
+    server->num_clients--;
+    fprintf(stderr, "Socket client %d disconnected\n", id);
+}
+
+// =============================================================================
+// Output queue
+// =============================================================================
+
+static bool msg_set(QueuedMsg *msg, SocketFormat format, uint32_t topic,
+                    const char *data, size_t len) {
+    bool needs_newline = format == SOCKET_FORMAT_JSON &&
+                         (len == 0 || data[len - 1] != '\n');
+    size_t total = len + (needs_newline ? 1 : 0);
+
+    if (total > msg->cap) {
+        char *buf = realloc(msg->data, total);
+        if (!buf) return false;
+        msg->data = buf;
+        msg->cap = total;
+    }
+    memcpy(msg->data, data, len);
+    if (needs_newline) msg->data[len] = '\n';
+    msg->len = total;
+    msg->topic = topic;
+    return true;
+}
+
+static void update_events(SocketServer *server, int id) {
+    Client *c = &server->clients[id];
+    struct epoll_event ev = {
+        .events = (c->rx_eof ? 0 : EPOLLIN) | (c->want_write ? EPOLLOUT : 0),
+        .data.u32 = (uint32_t)id
+    };
+    epoll_ctl(server->epoll_fd, EPOLL_CTL_MOD, c->fd, &ev);
+}
+
+static void set_want_write(SocketServer *server, int id, bool want) {
+    Client *c = &server->clients[id];
+    if (c->want_write == want) return;
+    c->want_write = want;
+    update_events(server, id);
+}
+
+static QueuedMsg* queue_slot(Client *c, int i) {
+    return &c->queue[(c->q_head + i) % SOCKET_QUEUE_LEN];
+}
+
+/**
+ * Queue a "dropped" notice if messages were dropped and the queue has
+ * room for it plus `reserve` more.
+ * @return true if a notice was queued
+ */
+static bool queue_drop_notice(Client *c, int reserve) {
+    if (c->dropped == 0 || c->q_count >= SOCKET_QUEUE_LEN - reserve) return false;
+
+    char notice[64];
+    int n;
+    if (c->format == SOCKET_FORMAT_BINARY) {
+        sp_put_header((uint8_t*)notice, SOCKET_MSG_DROPPED, 4);
+        sp_put_u32((uint8_t*)notice + SOCKET_FRAME_HEADER, c->dropped);
+        n = SOCKET_FRAME_HEADER + 4;
+    } else {
+        n = snprintf(notice, sizeof(notice),
+                     "{\"topic\":\"dropped\",\"count\":%lu}", (unsigned long)c->dropped);
     }
+    if (!msg_set(queue_slot(c, c->q_count), c->format, 0, notice, (size_t)n)) return false;
+    c->q_count++;
+    c->dropped = 0;
+    return true;
+}
 
-    server->client_fd = fd;
-    server->recv_len = 0;
-    fprintf(stderr, "Socket client connected\n");
+/**
+ * Write queued messages until the queue is empty or the socket is full.
+ * Several messages go out per call; a short write leaves the rest of the
+ * head message (head_sent) for next time.
+ */
+static void flush_client(SocketServer *server, int id) {
+    Client *c = &server->clients[id];
+
+    while (c->q_count > 0) {
+        struct iovec iov[SEND_IOV_MAX];
+        int n_iov = (c->q_count < SEND_IOV_MAX) ? c->q_count : SEND_IOV_MAX;
+        for (int i = 0; i < n_iov; i++) {
+            QueuedMsg *msg = &c->queue[(c->q_head + i) % SOCKET_QUEUE_LEN];
+            size_t skip = (i == 0) ? c->head_sent : 0;
+            iov[i].iov_base = msg->data + skip;
+            iov[i].iov_len = msg->len - skip;
+        }
+
+        struct msghdr mh = { .msg_iov = iov, .msg_iovlen = (size_t)n_iov };
+        ssize_t n = sendmsg(c->fd, &mh, MSG_NOSIGNAL);
+        if (n < 0) {
+            if (errno == EAGAIN || errno == EWOULDBLOCK) break;
+            if (errno == EINTR) continue;
+            if (errno != EPIPE && errno != ECONNRESET) {
+                perror("socket_server: send()");
+            }
+            close_client(server, id);
+            return;
+        }
+
+        // Retire fully written messages
+        size_t written = (size_t)n;
+        while (written > 0) {
+            QueuedMsg *msg = &c->queue[c->q_head];
+            size_t left = msg->len - c->head_sent;
+            if (written < left) {
+                c->head_sent += written;
+                break;
+            }
+            written -= left;
+            c->head_sent = 0;
+            c->q_head = (c->q_head + 1) % SOCKET_QUEUE_LEN;
+            c->q_count--;
+        }
+    }
+
+    set_want_write(server, id, c->q_count > 0);
 }
 
 /**
- * Close current client connection.
+ * Add a message to a client's queue, applying its full-queue policy.
+ * @return false if the message was dropped
  */
-static void close_client(SocketServer *server) {
-    if (server->client_fd >= 0) {
-        close(server->client_fd);
-        server->client_fd = -1;
-        server->recv_len = 0;
-        fprintf(stderr, "Socket client disconnected\n");
+static bool enqueue(Client *c, uint32_t topic, const char *data, size_t len) {
+    // Replace a stale snapshot that hasn't started going out yet
+    if (c->policy == SOCKET_POLICY_COALESCE && topic_coalesces(topic)) {
+        for (int i = (c->head_sent > 0) ? 1 : 0; i < c->q_count; i++) {
+            QueuedMsg *msg = queue_slot(c, i);
+            if (msg->topic == topic) {
+                return msg_set(msg, c->format, topic, data, len);
+            }
+        }
+    }
+
+    // Report earlier drops once there is room for the notice and the message
+    queue_drop_notice(c, 1);
+
+    if (c->q_count == SOCKET_QUEUE_LEN ||
+        !msg_set(queue_slot(c, c->q_count), c->format, topic, data, len)) {
+        c->dropped++;
+        return false;
+    }
+    c->q_count++;
+    return true;
+}
+
+// =============================================================================
+// Input
+// =============================================================================
+
+static uint32_t ring_used(const Client *c) {
+    return c->rx_tail - c->rx_head;
+}
+
+// Copy n bytes starting at ring offset pos (absolute) out of the ring
+static void ring_copy(const Client *c, uint32_t pos, char *dst, size_t n) {
+    size_t off = pos & RECV_RING_MASK;
+    size_t first = RECV_RING_SIZE - off;
+    if (first > n) first = n;
+    memcpy(dst, c->rx_ring + off, first);
+    memcpy(dst + first, c->rx_ring, n - first);
+}
+
+// View of n bytes at the ring head: in place, or via scratch if it wraps
+static const char* ring_slice(Client *c, uint32_t pos, size_t n) {
+    size_t off = pos & RECV_RING_MASK;
+    if (off + n <= RECV_RING_SIZE) {
+        return c->rx_ring + off;
     }
+    ring_copy(c, pos, c->rx_scratch, n);
+    return c->rx_scratch;
 }
 
-bool socket_server_poll(SocketServer *server, char *cmd_buf, size_t buf_size) {
-    if (!server || !cmd_buf || buf_size == 0) return false;
+/**
+ * Settle a new client's format from its first bytes.
+ */
+static void negotiate(SocketServer *server, int id) {
+    Client *c = &server->clients[id];
+
+    // The first bytes are at the start of the ring
+    size_t used = ring_used(c);
+    size_t n = (used < SOCKET_BINARY_MAGIC_LEN) ? used : SOCKET_BINARY_MAGIC_LEN;
+    if (memcmp(c->rx_ring, SOCKET_BINARY_MAGIC, n) != 0) {
+        c->negotiated = true;
+        return;
+    }
+    if (n < SOCKET_BINARY_MAGIC_LEN) return;    // Wait for the rest
+
+    c->format = SOCKET_FORMAT_BINARY;
+    c->negotiated = true;
+    c->rx_head += SOCKET_BINARY_MAGIC_LEN;
 
-    // Try to accept new connection if no client
-    try_accept(server);
+    uint8_t hello[SOCKET_FRAME_HEADER + 4];
+    sp_put_header(hello, SOCKET_MSG_HELLO, 4);
+    hello[SOCKET_FRAME_HEADER] = SOCKET_BINARY_VERSION;
+    hello[SOCKET_FRAME_HEADER + 1] = 0;
+    sp_put_u16(hello + SOCKET_FRAME_HEADER + 2, SOCKET_FRAME_MAX_PAYLOAD);
+    enqueue(c, 0, (const char*)hello, sizeof(hello));
+    flush_client(server, id);
 
-    if (server->client_fd < 0) return false;
+    fprintf(stderr, "Socket client %d using binary frames\n", id);
+}
 
-    // Read available data
-    size_t space = RECV_BUF_SIZE - server->recv_len - 1;
-    if (space > 0) {
-        ssize_t n = read(server->client_fd,
-                         server->recv_buf + server->recv_len,
-                         space);
+/**
+ * Read everything the client has sent, as far as the ring has room.
+ * Only called when no slices into the ring are outstanding.
+ */
+static void read_client(SocketServer *server, int id) {
+    Client *c = &server->clients[id];
+    c->rx_full = false;
+
+    while (!c->rx_eof) {
+        uint32_t used = ring_used(c);
+        if (used == RECV_RING_SIZE) {
+            // Read the rest once socket_server_poll() has made room
+            c->rx_full = true;
+            break;
+        }
+
+        size_t off = c->rx_tail & RECV_RING_MASK;
+        size_t space = RECV_RING_SIZE - used;
+        size_t first = RECV_RING_SIZE - off;
+        if (first > space) first = space;
+        struct iovec iov[2] = {
+            { c->rx_ring + off, first },
+            { c->rx_ring, space - first }
+        };
+
+        ssize_t n = readv(c->fd, iov, iov[1].iov_len ? 2 : 1);
         if (n > 0) {
-            server->recv_len += n;
-            server->recv_buf[server->recv_len] = '\0';
+            c->rx_tail += (uint32_t)n;
         } else if (n == 0) {
-            // Client disconnected
-            close_client(server);
-            return false;
-        } else if (errno != EAGAIN && errno != EWOULDBLOCK) {
+            // Client closed its end; finish its buffered commands first
+            if (ring_used(c) == 0) {
+                close_client(server, id);
+                return;
+            }
+            c->rx_eof = true;
+            c->negotiated = true;
+            update_events(server, id);
+        } else if (errno == EAGAIN || errno == EWOULDBLOCK) {
+            break;
+        } else if (errno != EINTR) {
             // Real error
             perror("socket_server: read()");
-            close_client(server);
-            return false;
+            close_client(server, id);
+            return;
         }
     }
 
-    // Look for complete line (newline-terminated)
-    char *newline = strchr(server->recv_buf, '\n');
-    if (!newline) return false;
+    if (!c->negotiated && ring_used(c) > 0) {
+        negotiate(server, id);
+    }
+}
+
+void socket_server_service(SocketServer *server) {
+    if (!server) return;
+
+    struct epoll_event events[MAX_EPOLL_EVENTS];
+    int n = epoll_wait(server->epoll_fd, events, MAX_EPOLL_EVENTS, 0);
 
-    // Extract line
-    size_t line_len = newline - server->recv_buf;
-    if (line_len >= buf_size) {
-        // Line too long for buffer - truncate
-        line_len = buf_size - 1;
+    for (int i = 0; i < n; i++) {
+        uint32_t tag = events[i].data.u32;
+        if (tag == LISTEN_TAG) {
+            accept_clients(server);
+            continue;
+        }
+
+        int id = (int)tag;
+        if (server->clients[id].fd < 0) continue;  // Closed earlier in this batch
+
+        if (events[i].events & EPOLLOUT) {
+            flush_client(server, id);
+        }
+        if (server->clients[id].fd >= 0 &&
+            (events[i].events & (EPOLLIN | EPOLLHUP | EPOLLERR))) {
+            read_client(server, id);
+        }
+    }
+
+    // Silent clients default to NDJSON
+    uint64_t now = monotonic_ms();
+    for (int i = 0; i < SOCKET_MAX_CLIENTS; i++) {
+        Client *c = &server->clients[i];
+        if (c->fd >= 0 && !c->negotiated && ring_used(c) == 0 &&
+            now - c->connect_ms >= SOCKET_NEGOTIATE_MS) {
+            c->negotiated = true;
+        }
     }
-    memcpy(cmd_buf, server->recv_buf, line_len);
-    cmd_buf[line_len] = '\0';
 
-    // Remove line from buffer (including newline)
-    size_t consumed = (newline - server->recv_buf) + 1;
-    if (consumed > server->recv_len) {
-        // Shouldn't happen, but protect against buffer corruption
-        server->recv_len = 0;
-        server->recv_buf[0] = '\0';
+    // Clients that hung up get their replies and final drop count, then close
+    for (int i = 0; i < SOCKET_MAX_CLIENTS; i++) {
+        Client *c = &server->clients[i];
+        if (c->fd < 0 || !c->rx_done) continue;
+        queue_drop_notice(c, 0);
+        flush_client(server, i);
+        if (c->fd >= 0 && c->q_count == 0 && c->dropped == 0) {
+            close_client(server, i);
+        }
+    }
+}
+
+/**
+ * Take the next complete line from an NDJSON client.
+ */
+static bool next_line(Client *c, SocketRequest *req) {
+    for (;;) {
+        uint32_t used = ring_used(c);
+
+        // Find the newline, resuming where the last search stopped
+        bool found = false;
+        while (c->rx_scanned < used) {
+            uint32_t pos = c->rx_head + c->rx_scanned;
+            size_t off = pos & RECV_RING_MASK;
+            size_t seg = RECV_RING_SIZE - off;
+            if (seg > used - c->rx_scanned) seg = used - c->rx_scanned;
+
+            const char *newline = memchr(c->rx_ring + off, '\n', seg);
+            if (newline) {
+                c->rx_scanned += (uint32_t)(newline - (c->rx_ring + off));
+                found = true;
+                break;
+            }
+            c->rx_scanned += (uint32_t)seg;
+        }
+
+        if (!found) {
+            // A full ring without a newline can never complete: drop that line
+            if (used == RECV_RING_SIZE) {
+                if (!c->discard_line) {
+                    fprintf(stderr, "Socket client: command too long, discarded\n");
+                }
+                c->rx_head = c->rx_tail;
+                c->rx_scanned = 0;
+                c->discard_line = true;
+            }
+            return false;
+        }
+
+        size_t line_len = c->rx_scanned;
+        uint32_t start = c->rx_head;
+        c->rx_head += (uint32_t)line_len + 1;
+        c->rx_scanned = 0;
+
+        // Skip the remainder of a discarded line
+        if (c->discard_line) {
+            c->discard_line = false;
+            continue;
+        }
+
+        req->type = 0;
+        req->data = ring_slice(c, start, line_len);
+        req->len = line_len;
         return true;
     }
-    size_t remaining = server->recv_len - consumed;
-    if (remaining > 0) {
-        memmove(server->recv_buf, newline + 1, remaining);
+}
+
+/**
+ * Take the next complete frame from a binary client.
+ */
+static bool next_frame(SocketServer *server, int id, SocketRequest *req) {
+    Client *c = &server->clients[id];
+    uint32_t used = ring_used(c);
+    if (used < SOCKET_FRAME_HEADER) return false;
+
+    uint8_t hdr[SOCKET_FRAME_HEADER];
+    ring_copy(c, c->rx_head, (char*)hdr, sizeof(hdr));
+    size_t len = sp_get_u16(hdr + 2);
+    if (len > SOCKET_FRAME_MAX_PAYLOAD) {
+        fprintf(stderr, "Socket client %d: frame of %lu bytes exceeds limit\n",
+                id, (unsigned long)len);
+        close_client(server, id);
+        return false;
     }
-    server->recv_len = remaining;
-    server->recv_buf[server->recv_len] = '\0';  // Re-null-terminate
+    if (used < SOCKET_FRAME_HEADER + len) return false;
 
+    req->type = hdr[0];
+    req->data = ring_slice(c, c->rx_head + SOCKET_FRAME_HEADER, len);
+    req->len = len;
+    c->rx_head += (uint32_t)(SOCKET_FRAME_HEADER + len);
     return true;
 }
 
-bool socket_server_send(SocketServer *server, const char *data) {
-    if (!server || !data || server->client_fd < 0) return false;
+int socket_server_poll(SocketServer *server, SocketRequest *reqs, int max) {
+    if (!server || !reqs || max <= 0) return 0;
 
-    size_t len = strlen(data);
-    bool needs_newline = (len == 0 || data[len - 1] != '\n');
+    // Slices from the previous call are done with: refill rings that were full
+    for (int id = 0; id < SOCKET_MAX_CLIENTS; id++) {
+        if (server->clients[id].fd >= 0 && server->clients[id].rx_full) {
+            read_client(server, id);
+        }
+    }
+
+    // One command per client per round, until all are drained or max is hit.
+    // Nothing is read during the loop, so a client's data can wrap around
+    // the end of its ring (and need the scratch buffer) at most once.
+    int count = 0;
+    bool progress = true;
+    while (progress && count < max) {
+        progress = false;
+        for (int k = 0; k < SOCKET_MAX_CLIENTS && count < max; k++) {
+            int id = (server->next_client + k) % SOCKET_MAX_CLIENTS;
+            Client *c = &server->clients[id];
+            if (c->fd < 0 || !c->negotiated) continue;
+
+            SocketRequest *req = &reqs[count];
+            bool found = (c->format == SOCKET_FORMAT_BINARY)
+                ? next_frame(server, id, req)
+                : next_line(c, req);
+            if (!found) {
+                // Hung up and nothing complete left: close once replies are out
+                if (c->rx_eof) c->rx_done = true;
+                continue;
+            }
+
+            req->client_id = id;
+            req->format = c->format;
+            count++;
+            progress = true;
+        }
+    }
+
+    if (count > 0) {
+        server->next_client = (reqs[count - 1].client_id + 1) % SOCKET_MAX_CLIENTS;
+    }
+    return count;
+}
 
-    // Write data
-    ssize_t written = write(server->client_fd, data, len);
-    if (written < 0) {
-        if (errno != EAGAIN && errno != EWOULDBLOCK) {
-            perror("socket_server: write()");
-            close_client(server);
+bool socket_server_has_input(SocketServer *server) {
+    if (!server) return false;
+    socket_server_service(server);
+
+    for (int id = 0; id < SOCKET_MAX_CLIENTS; id++) {
+        const Client *c = &server->clients[id];
+        if (c->fd < 0) continue;
+        if (c->rx_full || (c->rx_eof && !c->rx_done)) return true;
+
+        uint32_t used = ring_used(c);
+        if (!c->negotiated || c->format == SOCKET_FORMAT_JSON) {
+            // NDJSON: bytes not searched for a newline yet
+            if (used > c->rx_scanned) return true;
+        } else if (used >= SOCKET_FRAME_HEADER) {
+            uint8_t hdr[SOCKET_FRAME_HEADER];
+            ring_copy(c, c->rx_head, (char*)hdr, sizeof(hdr));
+            uint32_t len = sp_get_u16(hdr + 2);
+            if (len > SOCKET_FRAME_MAX_PAYLOAD || used >= SOCKET_FRAME_HEADER + len) return true;
         }
+    }
+    return false;
+}
+
+// =============================================================================
+// Publishing
+// =============================================================================
+
+void socket_server_subscribe(SocketServer *server, int client_id, uint32_t topics,
+                             uint32_t interval_ms, SocketPolicy policy) {
+    if (!server || client_id < 0 || client_id >= SOCKET_MAX_CLIENTS) return;
+
+    Client *c = &server->clients[client_id];
+    c->topics = topics;
+    c->interval_ms = interval_ms;
+    c->policy = policy;
+    c->batch_count = 0;
+
+    // New subscribers get the current snapshots right away
+    memset(c->sent, 0, sizeof(c->sent));
+}
+
+static bool client_wants(const Client *c, uint32_t topic, SocketFormat format,
+                         uint32_t version, uint32_t now_ms) {
+    if (c->fd < 0 || !c->negotiated || c->format != format || !(c->topics & topic)) {
         return false;
     }
 
-    // Write newline if needed
-    if (needs_newline) {
-        if (write(server->client_fd, "\n", 1) < 0) {
-            if (errno != EAGAIN && errno != EWOULDBLOCK) {
-                close_client(server);
+    int idx = topic_index(topic);
+    if (!c->sent[idx]) return true;
+    if (c->last_version[idx] == version) return false;
+
+    // Events go out as they happen; snapshots are rate limited
+    return topic == SOCKET_TOPIC_EVENTS ||
+           (now_ms - c->last_sent_ms[idx]) >= c->interval_ms;
+}
+
+bool socket_server_wants(SocketServer *server, SocketTopic topic, SocketFormat format,
+                         uint32_t version, uint32_t now_ms) {
+    if (!server || server->num_clients == 0) return false;
+
+    for (int i = 0; i < SOCKET_MAX_CLIENTS; i++) {
+        if (client_wants(&server->clients[i], topic, format, version, now_ms)) {
+            return true;
+        }
+    }
+    return false;
+}
+
+void socket_server_publish(SocketServer *server, SocketTopic topic, SocketFormat format,
+                           uint32_t version, uint32_t now_ms, const char *data, size_t len) {
+    if (!server || !data) return;
+
+    int idx = topic_index(topic);
+    for (int i = 0; i < SOCKET_MAX_CLIENTS; i++) {
+        Client *c = &server->clients[i];
+        if (!client_wants(c, topic, format, version, now_ms)) continue;
+
+        c->sent[idx] = true;
+        c->last_version[idx] = version;
+        c->last_sent_ms[idx] = now_ms;
+
+        enqueue(c, topic, data, len);
+        flush_client(server, i);
+    }
+}
+
+uint32_t socket_server_next_due(SocketServer *server, const uint32_t *versions, uint32_t now_ms) {
+    uint32_t due = UINT32_MAX;
+    if (!server) return due;
+
+    for (int i = 0; i < SOCKET_MAX_CLIENTS; i++) {
+        const Client *c = &server->clients[i];
+        if (c->fd < 0 || !c->negotiated) continue;
+
+        for (int idx = 0; idx < SOCKET_TOPIC_COUNT; idx++) {
+            uint32_t topic = 1u << idx;
+            if (!(c->topics & topic) || topic == SOCKET_TOPIC_EVENTS) continue;
+            if (topic == SOCKET_TOPIC_CHANGES) {
+                if (c->batch_count == 0) continue;
+            } else if (c->sent[idx] && c->last_version[idx] == versions[idx]) {
+                continue;
             }
-            return false;
+
+            uint32_t t = c->sent[idx] ? c->last_sent_ms[idx] + c->interval_ms : now_ms;
+            if (t < due) due = t;
         }
     }
+    return due;
+}
 
-    return true;
+bool socket_server_subscribed(SocketServer *server, SocketTopic topic, SocketFormat format) {
+    if (!server || server->num_clients == 0) return false;
+
+    for (int i = 0; i < SOCKET_MAX_CLIENTS; i++) {
+        const Client *c = &server->clients[i];
+        if (c->fd >= 0 && c->negotiated && c->format == format && (c->topics & topic)) {
+            return true;
+        }
+    }
+    return false;
+}
+
+// =============================================================================
+// Change batches
+// =============================================================================
+
+// JSON batch: {"topic":"changes","changes":[<record>,<record>]}
+// Binary batch: CHANGES frame, u16 count, records
+#define BATCH_JSON_PREFIX "{\"topic\":\"changes\",\"changes\":["
+#define BATCH_BINARY_PREFIX (SOCKET_FRAME_HEADER + 2)
+
+void socket_server_batch_add(SocketServer *server, SocketFormat format,
+                             const char *record, size_t len) {
+    if (!server || !record) return;
+
+    for (int i = 0; i < SOCKET_MAX_CLIENTS; i++) {
+        Client *c = &server->clients[i];
+        if (c->fd < 0 || !c->negotiated || c->format != format ||
+            !(c->topics & SOCKET_TOPIC_CHANGES)) {
+            continue;
+        }
+
+        JsonBuf *jb = &c->batch;
+        if (c->batch_count == 0) {
+            jb_reset(jb);
+            if (format == SOCKET_FORMAT_BINARY) {
+                uint8_t prefix[BATCH_BINARY_PREFIX] = {0};
+                jb_append(jb, (const char*)prefix, sizeof(prefix));
+            } else {
+                jb_lit(jb, BATCH_JSON_PREFIX);
+            }
+        } else if (format == SOCKET_FORMAT_JSON) {
+            jb_char(jb, ',');
+        }
+        jb_append(jb, record, len);
+        c->batch_count++;
+    }
+}
+
+void socket_server_batch_flush(SocketServer *server, uint32_t now_ms) {
+    if (!server) return;
+
+    int idx = topic_index(SOCKET_TOPIC_CHANGES);
+    for (int i = 0; i < SOCKET_MAX_CLIENTS; i++) {
+        Client *c = &server->clients[i];
+        if (c->fd < 0 || c->batch_count == 0) continue;
+
+        JsonBuf *jb = &c->batch;
+        bool due = !c->sent[idx] || (now_ms - c->last_sent_ms[idx]) >= c->interval_ms;
+        if (!due && jb->len < SOCKET_BATCH_MAX_BYTES) continue;
+
+        if (c->format == SOCKET_FORMAT_BINARY) {
+            if (!jb->oom) {
+                sp_put_header((uint8_t*)jb->data, SOCKET_MSG_CHANGES,
+                              (uint16_t)(jb->len - SOCKET_FRAME_HEADER));
+                sp_put_u16((uint8_t*)jb->data + SOCKET_FRAME_HEADER, (uint16_t)c->batch_count);
+            }
+        } else {
+            jb_lit(jb, "]}\n");
+        }
+
+        c->sent[idx] = true;
+        c->last_sent_ms[idx] = now_ms;
+        c->batch_count = 0;
+
+        if (jb->oom) {
+            c->dropped++;
+        } else {
+            enqueue(c, SOCKET_TOPIC_CHANGES, jb->data, jb->len);
+        }
+        flush_client(server, i);
+    }
+}
+
+bool socket_server_send_to(SocketServer *server, int client_id, const char *data, size_t len) {
+    if (!server || !data || client_id < 0 || client_id >= SOCKET_MAX_CLIENTS) return false;
+
+    Client *c = &server->clients[client_id];
+    if (c->fd < 0) return false;
+
+    bool ok = enqueue(c, 0, data, len);
+    flush_client(server, client_id);
+    return ok;
+}
+
+SocketFormat socket_server_client_format(SocketServer *server, int client_id) {
+    if (!server || client_id < 0 || client_id >= SOCKET_MAX_CLIENTS) {
+        return SOCKET_FORMAT_JSON;
+    }
+    return server->clients[client_id].format;
 }
 
 bool socket_server_connected(SocketServer *server) {
-    return server && server->client_fd >= 0;
+    return server && server->num_clients > 0;
+}
+
+int socket_server_client_count(SocketServer *server) {
+    return server ? server->num_clients : 0;
 }
 
 const char* socket_server_get_path(SocketServer *server) {
@@ -3,19 +3,96 @@
 
 #include <stdbool.h>
 #include <stddef.h>
+#include <stdint.h>
 
 /**
  * @file socket_server.h
  * @brief Unix domain socket server for simulator remote control
  *
- * Provides a simple socket server that accepts one client at a time.
- * Commands are received as NDJSON (one JSON object per line).
- * State updates are sent back as NDJSON.
+ * Serves up to SOCKET_MAX_CLIENTS clients from one epoll loop, so a
+ * frontend, a logger and a test harness can attach at the same time.
+ * Commands are received as NDJSON (one JSON object per line), or as
+ * binary frames if the client asks for them at connect time (see
+ * socket_protocol.h).
+ *
+ * State goes out as topic messages (see SocketTopic). Each client has a
+ * subscription (topics + minimum interval) and its own bounded output
+ * queue, so a slow client never blocks the simulation or other clients:
+ * - coalesce policy: a queued, unsent snapshot (state, LEDs, CV) is
+ *   replaced by the newer one; other messages are dropped when full
+ * - drop policy: new messages are dropped while the queue is full
+ * Dropped messages are reported to the client with a "dropped" message.
+ *
+ * The changes topic is lossless: every per-tick change record is added to
+ * each subscriber's batch, and the batch goes out as one message per
+ * interval, so edges shorter than the interval still reach the client.
  */
 
 // Default socket path
 #define SOCKET_DEFAULT_PATH "/tmp/gatekeeper-sim.sock"
 
+// Maximum simultaneous clients
+#define SOCKET_MAX_CLIENTS 16
+
+// Per-client output queue length (messages)
+#define SOCKET_QUEUE_LEN 64
+
+// Default interval between snapshot messages (~60Hz)
+#define SOCKET_DEFAULT_INTERVAL_MS 16
+
+// Longest accepted interval (longer requests are clamped)
+#define SOCKET_MAX_INTERVAL_MS 60000
+
+/**
+ * Published topics (bit mask for subscriptions).
+ */
+typedef enum {
+    SOCKET_TOPIC_STATE  = 1 << 0,   // FSM, inputs, output (snapshot)
+    SOCKET_TOPIC_EVENTS = 1 << 1,   // New simulator events (every tick)
+    SOCKET_TOPIC_LEDS   = 1 << 2,   // LED colors (snapshot)
+    SOCKET_TOPIC_CV     = 1 << 3,   // Raw CV ADC value (snapshot)
+    SOCKET_TOPIC_CHANGES = 1 << 4,  // Every change, timestamped (batched)
+    SOCKET_TOPIC_TIMING = 1 << 5,   // Realtime pacing statistics (snapshot)
+} SocketTopic;
+
+#define SOCKET_TOPIC_COUNT 6
+
+// A batch is sent early once it reaches this size (bytes)
+#define SOCKET_BATCH_MAX_BYTES 3072
+
+// Subscription of newly connected clients (matches the old status push)
+#define SOCKET_TOPICS_DEFAULT SOCKET_TOPIC_STATE
+
+/**
+ * Behavior when a client's output queue is full.
+ */
+typedef enum {
+    SOCKET_POLICY_COALESCE,         // Replace stale snapshots, drop the rest
+    SOCKET_POLICY_DROP              // Drop new messages
+} SocketPolicy;
+
+/**
+ * Wire format of a client, chosen when it connects.
+ */
+typedef enum {
+    SOCKET_FORMAT_JSON,             // NDJSON lines
+    SOCKET_FORMAT_BINARY            // Length-prefixed frames
+} SocketFormat;
+
+/**
+ * A received command, as returned by socket_server_poll().
+ * data points into the server's receive buffers (not NUL-terminated) and
+ * stays valid until the next socket_server_poll() or
+ * socket_server_service() call.
+ */
+typedef struct {
+    int client_id;                  // Sending client
+    SocketFormat format;
+    uint8_t type;                   // Frame type (binary only)
+    const char *data;               // NDJSON line (without newline) or frame payload
+    size_t len;                     // Line or payload length
+} SocketRequest;
+
 // Opaque server handle
 typedef struct SocketServer SocketServer;
 
@@ -33,32 +110,123 @@ SocketServer* socket_server_create(const char *path);
 void socket_server_destroy(SocketServer *server);
 
 /**
- * Poll for incoming commands (non-blocking).
- * Accepts new connections if none active.
- * Reads available data from connected client.
- *
- * @param server    Server handle
- * @param cmd_buf   Buffer to receive command (one line)
- * @param buf_size  Size of buffer
- * @return true if a complete command was received, false otherwise
+ * Handle pending socket I/O (non-blocking).
+ * Accepts new clients, reads all available input and writes queued output.
+ * Call once per main loop iteration, before socket_server_poll().
  */
-bool socket_server_poll(SocketServer *server, char *cmd_buf, size_t buf_size);
+void socket_server_service(SocketServer *server);
 
 /**
- * Send data to connected client.
- * Appends newline if not present.
+ * Get the complete commands received so far, without copying.
+ * Clients are served round-robin, one command each in turn. Call until it
+ * returns 0: input that didn't fit the receive buffer is read on the next
+ * call, once the returned slices are done with.
  *
  * @param server  Server handle
- * @param data    Data to send (typically JSON)
- * @return true on success, false if no client or error
+ * @param reqs    Receives commands (slices into the receive buffers)
+ * @param max     Size of reqs
+ * @return Number of commands returned
+ */
+int socket_server_poll(SocketServer *server, SocketRequest *reqs, int max);
+
+/**
+ * Check for client input that socket_server_poll() would hand out, or
+ * that needs a call to it (a full receive ring, a hang-up). Services
+ * pending I/O first, like socket_server_service().
+ */
+bool socket_server_has_input(SocketServer *server);
+
+/**
+ * Set a client's subscription.
+ *
+ * @param topics       SocketTopic mask
+ * @param interval_ms  Minimum time between snapshot messages of one topic
+ * @param policy       Full-queue behavior
+ */
+void socket_server_subscribe(SocketServer *server, int client_id, uint32_t topics,
+                             uint32_t interval_ms, SocketPolicy policy);
+
+/**
+ * Check if any client using a format wants a new message for a topic.
+ * Use to skip formatting messages nobody will receive.
+ *
+ * @param topic    Topic to check
+ * @param format   Wire format of the message
+ * @param version  Version of the topic's current content (changes when it does)
+ * @param now_ms   Current simulation time
+ */
+bool socket_server_wants(SocketServer *server, SocketTopic topic, SocketFormat format,
+                         uint32_t version, uint32_t now_ms);
+
+/**
+ * Queue a topic message for every client of that format that wants it.
+ * NDJSON messages get a newline appended if not present.
+ *
+ * @param topic    Topic of the message
+ * @param format   Wire format of the message
+ * @param version  Version of the content (see socket_server_wants)
+ * @param now_ms   Current simulation time
+ * @param data     Message (JSON line or binary frame)
+ * @param len      Message length
+ */
+void socket_server_publish(SocketServer *server, SocketTopic topic, SocketFormat format,
+                           uint32_t version, uint32_t now_ms, const char *data, size_t len);
+
+/**
+ * Get the earliest time a message held back by a client's interval
+ * becomes due: a snapshot topic whose content changed since it was last
+ * sent, or a batch of changes. Events go out as they happen.
+ *
+ * @param versions  Current content version per topic, indexed by topic bit
+ * @param now_ms    Current simulation time (returned if something is due)
+ * @return Simulation time in ms, or UINT32_MAX if nothing is held back
+ */
+uint32_t socket_server_next_due(SocketServer *server, const uint32_t *versions, uint32_t now_ms);
+
+/**
+ * Check if any client using a format subscribes to a topic.
+ */
+bool socket_server_subscribed(SocketServer *server, SocketTopic topic, SocketFormat format);
+
+/**
+ * Add one change record to the batch of every client subscribed to
+ * SOCKET_TOPIC_CHANGES in that format.
+ *
+ * @param format   Wire format of the record
+ * @param record   One JSON object, or one binary record (socket_protocol.h)
+ * @param len      Record length
+ */
+void socket_server_batch_add(SocketServer *server, SocketFormat format,
+                             const char *record, size_t len);
+
+/**
+ * Send every batch whose client interval has passed (or that is full).
+ * Call once per tick, after the tick's records are added.
  */
-bool socket_server_send(SocketServer *server, const char *data);
+void socket_server_batch_flush(SocketServer *server, uint32_t now_ms);
 
 /**
- * Check if a client is currently connected.
+ * Queue a message for one client (e.g. a command reply).
+ * The message must be in the client's format.
+ * @return false if the client is gone or its queue is full
+ */
+bool socket_server_send_to(SocketServer *server, int client_id, const char *data, size_t len);
+
+/**
+ * Get a client's wire format.
+ */
+SocketFormat socket_server_client_format(SocketServer *server, int client_id);
+
+/**
+ * Check if any client is currently connected.
  */
 bool socket_server_connected(SocketServer *server);
 
+/**
+ * Get the number of connected clients.
+ */
+int socket_server_client_count(SocketServer *server);
+
 /**
  * Get the socket path being used.
  */
@@ -0,0 +1,203 @@
+#include "state_space.h"
+#include "sim_schedule.h"
+#include "config/mode_config.h"
+#include "utility/status.h"
+#include <string.h>
+
+/**
+ * @file state_space.c
+ * @brief Abstract application states implementation
+ *
+ * Key bytes of the mode handler state (StateKey.handler), by mode:
+ *   [0] output, [1] last input (trigger, toggle, divide), [2] divide
+ *   counter, [3..4] pulse length, divisor or cycle period, [5] pulse or
+ *   half-period timer: 0 idle, 1 running, 2 due at the next tick.
+ */
+
+static const uint32_t step_ms[STEP_COUNT] = {
+    [STEP_TICK]    = 1,
+    [STEP_TAP]     = EP_TAP_THRESHOLD_MS,
+    [STEP_HOLD]    = EP_HOLD_THRESHOLD_MS + 1,
+    [STEP_TIMEOUT] = MENU_TIMEOUT_MS + 1,
+};
+
+uint32_t state_step_ms(StateStep step) {
+    return (step < STEP_COUNT) ? step_ms[step] : 1;
+}
+
+// =============================================================================
+// Running the Application
+// =============================================================================
+
+void state_space_boot(SimInstance *inst, Snapshot *root) {
+    // Mirrors sim_instance_start() up to the main loop
+    app_init_run(&inst->settings);
+    coordinator_init(&inst->coordinator, &inst->settings);
+    if (inst->settings.mode < MODE_COUNT) {
+        coordinator_set_mode(&inst->coordinator, (ModeState)inst->settings.mode);
+    }
+    coordinator_start(&inst->coordinator);
+
+    memset(root, 0, sizeof(*root));
+    root->coord = inst->coordinator;
+    root->coord.settings = NULL;
+    root->settings = inst->settings;
+    root->now = p_hal->millis();
+    root->inputs = 0;
+}
+
+void state_space_apply(SimInstance *inst, const Snapshot *from, uint8_t inputs,
+                       uint32_t hold_ms, Snapshot *to) {
+    Coordinator *coord = &inst->coordinator;
+
+    inst->settings = from->settings;
+    *coord = from->coord;
+    coord->settings = &inst->settings;
+    inst->hw.time_ms = from->now;
+
+    sim_set_button_a(inputs & INPUT_A);
+    sim_set_button_b(inputs & INPUT_B);
+    sim_set_cv_voltage((inputs & INPUT_CV) ? 255 : 0);
+
+    // Inputs are constant from here on: update at the action's tick,
+    // then only at the deadlines (exactly what ticking every ms does)
+    uint32_t end = from->now + hold_ms;
+    for (;;) {
+        coordinator_update(coord);
+        uint32_t next = sim_schedule_next_state_change(coord, inst->hw.time_ms);
+        if (next >= end) break;
+        inst->hw.time_ms = next;
+    }
+
+    to->coord = *coord;
+    to->coord.settings = NULL;
+    to->settings = inst->settings;
+    to->now = end;
+    to->inputs = inputs;
+}
+
+void state_space_apply_action(SimInstance *inst, const Snapshot *from, uint8_t action,
+                              Snapshot *to) {
+    state_space_apply(inst, from, ACTION_INPUTS(action),
+                      state_step_ms(ACTION_STEP(action)), to);
+}
+
+// =============================================================================
+// Keys
+// =============================================================================
+
+static uint8_t age_class(uint32_t age) {
+    if (age < EP_TAP_THRESHOLD_MS) return AGE_BELOW_TAP;
+    if (age < EP_HOLD_THRESHOLD_MS) return AGE_BELOW_HOLD;
+    if (age < MENU_TIMEOUT_MS) return AGE_BELOW_TIMEOUT;
+    return AGE_PAST_TIMEOUT;
+}
+
+// Age class of a press still short of hold (hold flag not set yet)
+static uint8_t press_age(const EventProcessor *ep, uint8_t pressed, uint8_t hold,
+                         uint32_t press_time, uint32_t now) {
+    if (!STATUS_ANY(ep->status, pressed) || STATUS_ANY(ep->status, hold)) {
+        return AGE_NONE;
+    }
+    return age_class(now - press_time);
+}
+
+static uint8_t timer_class(bool running, uint32_t start, uint32_t length, uint32_t now) {
+    if (!running) return 0;
+    return (now - start >= length) ? 2 : 1;
+}
+
+static void handler_key(ModeState mode, const ModeContext *ctx, uint32_t now, uint8_t *h) {
+    uint16_t param = 0;
+
+    switch (mode) {
+        case MODE_GATE:
+            h[0] = ctx->gate.output_state;
+            break;
+        case MODE_TRIGGER:
+            h[0] = ctx->trigger.output_state;
+            h[1] = ctx->trigger.last_input;
+            param = ctx->trigger.pulse_duration_ms;
+            h[5] = timer_class(ctx->trigger.output_state, ctx->trigger.pulse_start,
+                               ctx->trigger.pulse_duration_ms, now);
+            break;
+        case MODE_TOGGLE:
+            h[0] = ctx->toggle.output_state;
+            h[1] = ctx->toggle.last_input;
+            break;
+        case MODE_DIVIDE:
+            h[0] = ctx->divide.output_state;
+            h[1] = ctx->divide.last_input;
+            h[2] = ctx->divide.counter;
+            param = ctx->divide.divisor;
+            h[5] = timer_class(ctx->divide.output_state, ctx->divide.pulse_start,
+                               OUTPUT_PULSE_MS, now);
+            break;
+        case MODE_CYCLE:
+            h[0] = ctx->cycle.output_state;
+            h[1] = ctx->cycle.running;
+            param = ctx->cycle.period_ms;
+            h[5] = timer_class(ctx->cycle.running, ctx->cycle.last_toggle,
+                               ctx->cycle.period_ms / 2, now);
+            break;
+        default:
+            break;
+    }
+    h[3] = (uint8_t)(param & 0xFF);
+    h[4] = (uint8_t)(param >> 8);
+}
+
+void state_space_key(const Snapshot *snap, StateKey *key) {
+    const Coordinator *coord = &snap->coord;
+    const EventProcessor *ep = &coord->events;
+    uint32_t now = snap->now;
+
+    memset(key, 0, sizeof(*key));
+    key->top = (uint8_t)coordinator_get_top_state(coord);
+    key->mode = (uint8_t)coordinator_get_mode(coord);
+    key->page = (uint8_t)coordinator_get_page(coord);
+
+    key->gate_a_mode = snap->settings.gate_a_mode;
+    key->trigger_pulse_idx = snap->settings.trigger_pulse_idx;
+    key->divide_divisor_idx = snap->settings.divide_divisor_idx;
+    key->cycle_tempo_idx = snap->settings.cycle_tempo_idx;
+
+    key->ep_status = ep->status;
+    key->ep_ext_status = ep->ext_status;
+    key->a_age = press_age(ep, EP_A_PRESSED, EP_A_HOLD, ep->a_press_time, now);
+    key->b_age = press_age(ep, EP_B_PRESSED, EP_B_HOLD, ep->b_press_time, now);
+    if (STATUS_ALL(ep->status, EP_A_PRESSED | EP_B_PRESSED) &&
+        ep->a_press_time != ep->b_press_time) {
+        key->press_order = (ep->a_press_time < ep->b_press_time) ? 1 : 2;
+    }
+
+    key->cv_state = coordinator_get_cv_state(coord);
+    if (coordinator_in_menu(coord)) {
+        key->menu_age = age_class(now - coord->last_activity);
+    }
+    key->output = coordinator_get_output(coord);
+    handler_key(coordinator_get_mode(coord), &coord->mode_ctx, now, key->handler);
+}
+
+uint64_t state_key_hash(const StateKey *key) {
+    const uint8_t *bytes = (const uint8_t*)key;
+    uint64_t h = 0xcbf29ce484222325ull;
+    for (size_t i = 0; i < sizeof(*key); i++) {
+        h = (h ^ bytes[i]) * 0x100000001b3ull;
+    }
+    return h;
+}
+
+bool state_space_in_range(const Snapshot *snap) {
+    const AppSettings *s = &snap->settings;
+
+    return coordinator_get_top_state(&snap->coord) < TOP_STATE_COUNT &&
+           coordinator_get_mode(&snap->coord) < MODE_COUNT &&
+           coordinator_get_page(&snap->coord) < PAGE_COUNT &&
+           s->gate_a_mode < GATE_A_MODE_COUNT &&
+           s->trigger_edge < TRIGGER_EDGE_COUNT &&
+           s->trigger_pulse_idx < TRIGGER_PULSE_COUNT &&
+           s->toggle_edge < TOGGLE_EDGE_COUNT &&
+           s->divide_divisor_idx < DIVIDE_DIVISOR_COUNT &&
+           s->cycle_tempo_idx < CYCLE_TEMPO_COUNT;
+}
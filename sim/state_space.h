@@ -0,0 +1,146 @@
+#ifndef GK_SIM_STATE_SPACE_H
+#define GK_SIM_STATE_SPACE_H
+
+#include "sim_instance.h"
+#include <stdbool.h>
+#include <stdint.h>
+
+/**
+ * @file state_space.h
+ * @brief Abstract application states for the state-space explorer
+ *
+ * A Snapshot is the concrete application state between two user
+ * actions: the coordinator, the settings it points at, the inputs held
+ * since the last action and the time of the next tick. An action sets
+ * the buttons and CV at that tick and holds them for one of four time
+ * steps, one per threshold class of the gesture and menu logic:
+ *
+ *   STEP_TICK     1 ms      below the tap threshold
+ *   STEP_TAP      300 ms    between tap and hold
+ *   STEP_HOLD     501 ms    past hold (the hold fires within the step)
+ *   STEP_TIMEOUT  60001 ms  past the menu timeout
+ *
+ * The real coordinator runs on the calling thread's SimInstance, once
+ * at the action's tick and then at every deadline where its state can
+ * change (sim_schedule_next_state_change), so a step costs a handful of
+ * updates whatever its length and matches ticking every millisecond.
+ *
+ * The explorer dedups snapshots on their StateKey, which keeps
+ * everything the control path reads again, with timestamps turned into
+ * age classes (the same four thresholds) and the A/B press order.
+ * Left out, because nothing but the LEDs or the next boot reads them:
+ * the trigger and toggle edge settings, settings.mode, the menu entry
+ * mode and time, the cycle LED phase and the last raw CV reading.
+ * Snapshots that share a key are explored once, from the first one
+ * found, so the explorer covers one concrete timeline per key.
+ */
+
+// Input bits held by an action
+#define INPUT_A     (1 << 0)
+#define INPUT_B     (1 << 1)
+#define INPUT_CV    (1 << 2)    // CV at 5 V (else 0 V)
+#define INPUT_COMBOS 8
+
+// Time steps an action holds its inputs for
+typedef enum {
+    STEP_TICK = 0,
+    STEP_TAP,
+    STEP_HOLD,
+    STEP_TIMEOUT,
+    STEP_COUNT
+} StateStep;
+
+// Action encoding: input bits, then the step
+#define ACTION(inputs, step)    ((uint8_t)((inputs) | ((step) << 3)))
+#define ACTION_INPUTS(action)   ((uint8_t)((action) & 0x07))
+#define ACTION_STEP(action)     ((StateStep)((action) >> 3))
+#define ACTION_COUNT            (INPUT_COMBOS * STEP_COUNT)
+
+/**
+ * Concrete state between actions.
+ */
+typedef struct {
+    Coordinator coord;      // Settings pointer is fixed up when restored
+    AppSettings settings;
+    uint32_t now;           // Time of the next tick
+    uint8_t inputs;         // Inputs held since the last action
+} Snapshot;
+
+// Age classes of a timestamp, relative to the next tick
+typedef enum {
+    AGE_NONE = 0,           // Timer not running
+    AGE_BELOW_TAP,
+    AGE_BELOW_HOLD,
+    AGE_BELOW_TIMEOUT,
+    AGE_PAST_TIMEOUT
+} AgeClass;
+
+/**
+ * Dedup key of a snapshot. Bytes only, so keys compare and hash
+ * with memcmp and no padding.
+ */
+typedef struct {
+    uint8_t top;
+    uint8_t mode;
+    uint8_t page;
+    uint8_t gate_a_mode;
+    uint8_t trigger_pulse_idx;
+    uint8_t divide_divisor_idx;
+    uint8_t cycle_tempo_idx;
+    uint8_t ep_status;          // EP_* flags
+    uint8_t ep_ext_status;      // EP_COMPOUND_* flags
+    uint8_t a_age;              // AgeClass of a held A press below hold
+    uint8_t b_age;              // Same for B
+    uint8_t press_order;        // Both pressed: 1 = A first, 2 = B first, 0 = same tick
+    uint8_t cv_state;
+    uint8_t menu_age;           // AgeClass of the last menu activity
+    uint8_t output;
+    uint8_t handler[6];         // Current mode handler's state (see state_space.c)
+} StateKey;
+
+/**
+ * Get the length of a time step in ms.
+ */
+uint32_t state_step_ms(StateStep step);
+
+/**
+ * Boot the application on a bound, freshly initialized instance and
+ * take the first snapshot. Mirrors sim_instance_start(): blank EEPROM,
+ * default settings, buttons released and CV at 0 V.
+ */
+void state_space_boot(SimInstance *inst, Snapshot *root);
+
+/**
+ * Set inputs at the next tick of `from` and hold them for `hold_ms`.
+ *
+ * @param inst     Instance bound to the calling thread (scratch)
+ * @param from     Snapshot to start from
+ * @param inputs   INPUT_* bits
+ * @param hold_ms  Time until the next action (>= 1)
+ * @param to       Resulting snapshot (may not alias `from`)
+ */
+void state_space_apply(SimInstance *inst, const Snapshot *from, uint8_t inputs,
+                       uint32_t hold_ms, Snapshot *to);
+
+/**
+ * Apply an encoded action (ACTION()).
+ */
+void state_space_apply_action(SimInstance *inst, const Snapshot *from, uint8_t action,
+                              Snapshot *to);
+
+/**
+ * Compute the dedup key of a snapshot.
+ */
+void state_space_key(const Snapshot *snap, StateKey *key);
+
+/**
+ * Hash a key (FNV-1a).
+ */
+uint64_t state_key_hash(const StateKey *key);
+
+/**
+ * Check that FSM states and settings are within their enums.
+ */
+bool state_space_in_range(const Snapshot *snap);
+
+#endif /* GK_SIM_STATE_SPACE_H */
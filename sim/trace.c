@@ -0,0 +1,409 @@
+#include "trace.h"
+#include <fcntl.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+/**
+ * @file trace.c
+ * @brief Binary trace writer and reader
+ *
+ * The writer collects records in a large buffer and hands it to the OS in
+ * big chunks, so recording adds almost nothing per tick. The reader maps
+ * the whole file and decodes records in place.
+ */
+
+// Writer buffer size (flushed when full)
+#define TRACE_BUFFER_SIZE (1u << 20)
+
+// Header size before the settings/EEPROM blobs
+#define TRACE_HEADER_SIZE 36
+
+// Offset of the ADC model in the header
+#define TRACE_ADC_OFFSET 14
+
+struct TraceWriter {
+    FILE *file;
+    uint8_t *buf;
+    size_t used;
+    uint64_t flushed;       // Bytes already handed to the file
+    bool error;
+    bool started;           // First record written (forces full snapshot)
+    uint32_t last_ms;       // Time of previous record
+    TraceFrame last;        // Last written values
+};
+
+struct TraceReader {
+    const uint8_t *data;
+    size_t size;
+    size_t pos;
+    uint16_t eeprom_size;
+    uint16_t settings_size;
+    uint32_t start_ms;
+    AdcModelConfig adc;
+    const uint8_t *eeprom;
+    const uint8_t *settings;
+    bool corrupt;
+};
+
+// =============================================================================
+// Writer
+// =============================================================================
+
+static void writer_flush(TraceWriter *w) {
+    if (w->used == 0) return;
+    if (fwrite(w->buf, 1, w->used, w->file) != w->used) {
+        w->error = true;
+    }
+    w->flushed += w->used;
+    w->used = 0;
+}
+
+static void writer_put(TraceWriter *w, const void *data, size_t len) {
+    if (w->used + len > TRACE_BUFFER_SIZE) {
+        writer_flush(w);
+    }
+    memcpy(w->buf + w->used, data, len);
+    w->used += len;
+}
+
+static void writer_u8(TraceWriter *w, uint8_t v) {
+    if (w->used + 1 > TRACE_BUFFER_SIZE) {
+        writer_flush(w);
+    }
+    w->buf[w->used++] = v;
+}
+
+static void writer_u16(TraceWriter *w, uint16_t v) {
+    uint8_t b[2] = { v & 0xFF, v >> 8 };
+    writer_put(w, b, sizeof(b));
+}
+
+static void writer_u32(TraceWriter *w, uint32_t v) {
+    uint8_t b[4] = { v & 0xFF, (v >> 8) & 0xFF, (v >> 16) & 0xFF, v >> 24 };
+    writer_put(w, b, sizeof(b));
+}
+
+// Floats as their bit pattern, so replays rebuild the exact model
+static void writer_f32(TraceWriter *w, float v) {
+    uint32_t bits;
+    memcpy(&bits, &v, sizeof(bits));
+    writer_u32(w, bits);
+}
+
+// Unsigned LEB128: 7 bits per byte, high bit = more bytes follow
+static void writer_varint(TraceWriter *w, uint32_t v) {
+    uint8_t b[5];
+    int n = 0;
+    do {
+        uint8_t byte = v & 0x7F;
+        v >>= 7;
+        b[n++] = v ? (byte | 0x80) : byte;
+    } while (v);
+    writer_put(w, b, n);
+}
+
+TraceWriter* trace_writer_create(const char *path) {
+    TraceWriter *w = calloc(1, sizeof(TraceWriter));
+    if (!w) return NULL;
+
+    w->buf = malloc(TRACE_BUFFER_SIZE);
+    w->file = fopen(path, "wb");
+    if (!w->buf || !w->file) {
+        fprintf(stderr, "Error: Cannot create trace file: %s\n", path);
+        if (w->file) fclose(w->file);
+        free(w->buf);
+        free(w);
+        return NULL;
+    }
+
+    // We do our own buffering
+    setvbuf(w->file, NULL, _IONBF, 0);
+    return w;
+}
+
+void trace_writer_begin(TraceWriter *w, const uint8_t *eeprom, uint16_t eeprom_size,
+                        const AppSettings *settings, const AdcModelConfig *adc,
+                        uint32_t start_ms) {
+    writer_put(w, TRACE_MAGIC, 4);
+    writer_u8(w, TRACE_VERSION);
+    writer_u8(w, SIM_NUM_LEDS);
+    writer_u16(w, sizeof(AppSettings));
+    writer_u16(w, eeprom_size);
+    writer_u32(w, start_ms);
+    writer_f32(w, adc->noise_mv);
+    writer_u8(w, (uint8_t)adc->color);
+    writer_u32(w, adc->rc_us);
+    writer_f32(w, adc->coupling_mv);
+    writer_u32(w, adc->coupling_us);
+    writer_u8(w, adc->delay_ms);
+    writer_u32(w, adc->seed);
+    writer_put(w, settings, sizeof(AppSettings));
+    writer_put(w, eeprom, eeprom_size);
+    w->last_ms = start_ms;
+}
+
+void trace_writer_tick(TraceWriter *w, const SimState *state) {
+    TraceFrame *last = &w->last;
+    uint8_t flags = 0;
+
+    uint8_t buttons = (state->button_a ? 0x01 : 0) | (state->button_b ? 0x02 : 0);
+    uint8_t outputs = (state->signal_out ? 0x01 : 0) | (state->cv_in ? 0x02 : 0);
+    uint8_t last_buttons = (last->button_a ? 0x01 : 0) | (last->button_b ? 0x02 : 0);
+    uint8_t last_outputs = (last->signal_out ? 0x01 : 0) | (last->cv_in ? 0x02 : 0);
+
+    if (!w->started || buttons != last_buttons) flags |= TRACE_F_BUTTONS;
+    if (!w->started || state->cv_voltage != last->cv_voltage) flags |= TRACE_F_CV;
+    if (!w->started || outputs != last_outputs) flags |= TRACE_F_OUTPUTS;
+    if (!w->started ||
+        state->top_state != last->top_state || state->mode != last->mode ||
+        state->page != last->page || state->in_menu != last->in_menu) {
+        flags |= TRACE_F_STATE;
+    }
+    if (!w->started || memcmp(state->leds, last->leds, sizeof(state->leds)) != 0) {
+        flags |= TRACE_F_LEDS;
+    }
+
+    if (!flags) return;
+
+    writer_varint(w, state->timestamp_ms - w->last_ms);
+    writer_u8(w, flags);
+
+    if (flags & TRACE_F_BUTTONS) {
+        writer_u8(w, buttons);
+        last->button_a = state->button_a;
+        last->button_b = state->button_b;
+    }
+    if (flags & TRACE_F_CV) {
+        writer_u8(w, state->cv_voltage);
+        last->cv_voltage = state->cv_voltage;
+    }
+    if (flags & TRACE_F_OUTPUTS) {
+        writer_u8(w, outputs);
+        last->signal_out = state->signal_out;
+        last->cv_in = state->cv_in;
+    }
+    if (flags & TRACE_F_STATE) {
+        uint8_t b[4] = { state->top_state, state->mode, state->page, state->in_menu };
+        writer_put(w, b, sizeof(b));
+        last->top_state = state->top_state;
+        last->mode = state->mode;
+        last->page = state->page;
+        last->in_menu = state->in_menu;
+    }
+    if (flags & TRACE_F_LEDS) {
+        for (int i = 0; i < SIM_NUM_LEDS; i++) {
+            uint8_t b[3] = { state->leds[i].r, state->leds[i].g, state->leds[i].b };
+            writer_put(w, b, sizeof(b));
+        }
+        memcpy(last->leds, state->leds, sizeof(last->leds));
+    }
+
+    w->last_ms = state->timestamp_ms;
+    w->started = true;
+}
+
+bool trace_writer_close(TraceWriter *w, uint32_t end_ms, uint64_t *total_bytes) {
+    if (!w) return false;
+
+    writer_varint(w, end_ms - w->last_ms);
+    writer_u8(w, TRACE_F_END);
+    writer_flush(w);
+
+    if (total_bytes) *total_bytes = w->flushed;
+
+    bool ok = !w->error;
+    if (fclose(w->file) != 0) ok = false;
+    free(w->buf);
+    free(w);
+    return ok;
+}
+
+// =============================================================================
+// Reader
+// =============================================================================
+
+static uint16_t read_u16(const uint8_t *p) {
+    return p[0] | ((uint16_t)p[1] << 8);
+}
+
+static uint32_t read_u32(const uint8_t *p) {
+    return p[0] | ((uint32_t)p[1] << 8) | ((uint32_t)p[2] << 16) | ((uint32_t)p[3] << 24);
+}
+
+static float read_f32(const uint8_t *p) {
+    uint32_t bits = read_u32(p);
+    float v;
+    memcpy(&v, &bits, sizeof(v));
+    return v;
+}
+
+static void read_adc(const uint8_t *p, AdcModelConfig *adc) {
+    adc->noise_mv = read_f32(p);
+    adc->color = (p[4] == ADC_NOISE_PINK) ? ADC_NOISE_PINK : ADC_NOISE_WHITE;
+    adc->rc_us = read_u32(p + 5);
+    adc->coupling_mv = read_f32(p + 9);
+    adc->coupling_us = read_u32(p + 13);
+    adc->delay_ms = p[17];
+    adc->seed = read_u32(p + 18);
+}
+
+TraceReader* trace_reader_open(const char *path) {
+    int fd = open(path, O_RDONLY);
+    if (fd < 0) {
+        fprintf(stderr, "Error: Cannot open trace file: %s\n", path);
+        return NULL;
+    }
+
+    struct stat st;
+    if (fstat(fd, &st) != 0 || st.st_size < TRACE_HEADER_SIZE) {
+        fprintf(stderr, "Error: Not a trace file: %s\n", path);
+        close(fd);
+        return NULL;
+    }
+
+    void *data = mmap(NULL, st.st_size, PROT_READ, MAP_PRIVATE, fd, 0);
+    close(fd);
+    if (data == MAP_FAILED) {
+        fprintf(stderr, "Error: Cannot map trace file: %s\n", path);
+        return NULL;
+    }
+    madvise(data, st.st_size, MADV_SEQUENTIAL);
+
+    TraceReader *r = calloc(1, sizeof(TraceReader));
+    if (!r) {
+        munmap(data, st.st_size);
+        return NULL;
+    }
+    r->data = data;
+    r->size = st.st_size;
+
+    const uint8_t *h = r->data;
+    if (memcmp(h, TRACE_MAGIC, 4) != 0 || h[4] != TRACE_VERSION || h[5] != SIM_NUM_LEDS) {
+        fprintf(stderr, "Error: Unsupported trace file: %s\n", path);
+        trace_reader_close(r);
+        return NULL;
+    }
+
+    r->settings_size = read_u16(h + 6);
+    r->eeprom_size = read_u16(h + 8);
+    r->start_ms = read_u32(h + 10);
+    read_adc(h + TRACE_ADC_OFFSET, &r->adc);
+    size_t body = TRACE_HEADER_SIZE + (size_t)r->settings_size + r->eeprom_size;
+    if (body > r->size) {
+        fprintf(stderr, "Error: Truncated trace file: %s\n", path);
+        trace_reader_close(r);
+        return NULL;
+    }
+
+    r->settings = h + TRACE_HEADER_SIZE;
+    r->eeprom = r->settings + r->settings_size;
+    r->pos = body;
+    return r;
+}
+
+void trace_reader_close(TraceReader *r) {
+    if (!r) return;
+    munmap((void*)r->data, r->size);
+    free(r);
+}
+
+const uint8_t* trace_reader_eeprom(const TraceReader *r, uint16_t *size) {
+    *size = r->eeprom_size;
+    return r->eeprom;
+}
+
+uint32_t trace_reader_start_time(const TraceReader *r) {
+    return r->start_ms;
+}
+
+const AdcModelConfig* trace_reader_adc(const TraceReader *r) {
+    return &r->adc;
+}
+
+const AppSettings* trace_reader_settings(const TraceReader *r) {
+    if (r->settings_size != sizeof(AppSettings)) return NULL;
+    return (const AppSettings*)r->settings;
+}
+
+// Record field sizes, in flag order
+static size_t field_bytes(uint8_t flags) {
+    size_t n = 0;
+    if (flags & TRACE_F_BUTTONS) n += 1;
+    if (flags & TRACE_F_CV) n += 1;
+    if (flags & TRACE_F_OUTPUTS) n += 1;
+    if (flags & TRACE_F_STATE) n += 4;
+    if (flags & TRACE_F_LEDS) n += 3 * SIM_NUM_LEDS;
+    return n;
+}
+
+bool trace_reader_next(TraceReader *r, TraceFrame *frame) {
+    if (r->corrupt || r->pos >= r->size) return false;
+
+    // Time delta (varint, at most 5 bytes)
+    uint32_t delta = 0;
+    int shift = 0;
+    for (;;) {
+        if (r->pos >= r->size || shift > 28) {
+            r->corrupt = true;
+            return false;
+        }
+        uint8_t byte = r->data[r->pos++];
+        delta |= (uint32_t)(byte & 0x7F) << shift;
+        if (!(byte & 0x80)) break;
+        shift += 7;
+    }
+
+    if (r->pos >= r->size) {
+        r->corrupt = true;
+        return false;
+    }
+    uint8_t flags = r->data[r->pos++];
+    if (r->pos + field_bytes(flags) > r->size) {
+        r->corrupt = true;
+        return false;
+    }
+
+    const uint8_t *p = r->data + r->pos;
+    r->pos += field_bytes(flags);
+
+    frame->time_ms += delta;
+    frame->flags = flags;
+
+    if (flags & TRACE_F_BUTTONS) {
+        frame->button_a = (*p & 0x01) != 0;
+        frame->button_b = (*p & 0x02) != 0;
+        p++;
+    }
+    if (flags & TRACE_F_CV) {
+        frame->cv_voltage = *p++;
+    }
+    if (flags & TRACE_F_OUTPUTS) {
+        frame->signal_out = (*p & 0x01) != 0;
+        frame->cv_in = (*p & 0x02) != 0;
+        p++;
+    }
+    if (flags & TRACE_F_STATE) {
+        frame->top_state = p[0];
+        frame->mode = p[1];
+        frame->page = p[2];
+        frame->in_menu = p[3] != 0;
+        p += 4;
+    }
+    if (flags & TRACE_F_LEDS) {
+        for (int i = 0; i < SIM_NUM_LEDS; i++) {
+            frame->leds[i].r = *p++;
+            frame->leds[i].g = *p++;
+            frame->leds[i].b = *p++;
+        }
+    }
+
+    return true;
+}
+
+bool trace_reader_corrupt(const TraceReader *r) {
+    return r->corrupt;
+}
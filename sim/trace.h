@@ -0,0 +1,166 @@
+#ifndef GK_SIM_TRACE_H
+#define GK_SIM_TRACE_H
+
+#include "sim_state.h"
+#include "app_init.h"
+#include "adc_model.h"
+#include <stdbool.h>
+#include <stddef.h>
+#include <stdint.h>
+
+/**
+ * @file trace.h
+ * @brief Compact binary trace recording and reading
+ *
+ * A trace captures everything needed to replay and verify a run: the
+ * EEPROM image the app booted from and the ADC front end model, then one
+ * record for every tick where an input or output changed. Idle ticks cost
+ * nothing, so long soak runs stay small.
+ *
+ * File layout (all integers little-endian):
+ *
+ *   Header
+ *     char[4]  magic "GKTR"
+ *     u8       version (TRACE_VERSION)
+ *     u8       number of LEDs
+ *     u16      settings size
+ *     u16      EEPROM size
+ *     u32      start time (ms)
+ *     ADC model (AdcModelConfig, all zero = ideal):
+ *       u32    noise_mv (IEEE 754 single)
+ *       u8     noise color
+ *       u32    rc_us
+ *       u32    coupling_mv (IEEE 754 single)
+ *       u32    coupling_us
+ *       u8     delay_ms
+ *       u32    seed
+ *     u8[]     AppSettings after app_init (informational)
+ *     u8[]     EEPROM image before app_init
+ *
+ *   Records
+ *     varint   time since previous record (ms)
+ *     u8       field flags (TRACE_F_*)
+ *     fields in flag order, only those that changed:
+ *       BUTTONS  u8   bit0 = A pressed, bit1 = B pressed
+ *       CV       u8   CV source value (ADC input, before the ADC model)
+ *       OUTPUTS  u8   bit0 = signal out, bit1 = CV digital state
+ *       STATE    u8 x4  top state, mode, page, in menu
+ *       LEDS     u8 x3 per LED (RGB)
+ *
+ *   A record with only TRACE_F_END marks the end time of the run.
+ */
+
+#define TRACE_MAGIC         "GKTR"
+#define TRACE_VERSION       2
+
+// Record field flags
+#define TRACE_F_BUTTONS     0x01
+#define TRACE_F_CV          0x02
+#define TRACE_F_OUTPUTS     0x04
+#define TRACE_F_STATE       0x08
+#define TRACE_F_LEDS        0x10
+#define TRACE_F_END         0x80
+
+// Fields that are inputs to the app (replayed); the rest are verified
+#define TRACE_INPUT_FIELDS  (TRACE_F_BUTTONS | TRACE_F_CV)
+
+/**
+ * Snapshot of all traced signals.
+ * Reading a record updates the changed fields in place.
+ */
+typedef struct {
+    uint32_t time_ms;
+    uint8_t flags;          // Fields changed by the last record
+    bool button_a;
+    bool button_b;
+    uint8_t cv_voltage;
+    bool signal_out;
+    bool cv_in;
+    uint8_t top_state;
+    uint8_t mode;
+    uint8_t page;
+    bool in_menu;
+    SimLED leds[SIM_NUM_LEDS];
+} TraceFrame;
+
+// Opaque handles
+typedef struct TraceWriter TraceWriter;
+typedef struct TraceReader TraceReader;
+
+/**
+ * Open a trace file for writing.
+ * @return Writer, or NULL on error (message printed)
+ */
+TraceWriter* trace_writer_create(const char *path);
+
+/**
+ * Write the trace header. Call once, after app_init.
+ * @param eeprom       EEPROM image from before app_init
+ * @param eeprom_size  Image size in bytes
+ * @param settings     Settings loaded by app_init
+ * @param adc          ADC front end model the run uses
+ * @param start_ms     Simulation time at start
+ */
+void trace_writer_begin(TraceWriter *w, const uint8_t *eeprom, uint16_t eeprom_size,
+                        const AppSettings *settings, const AdcModelConfig *adc,
+                        uint32_t start_ms);
+
+/**
+ * Record a tick. Writes nothing if no traced signal changed.
+ * @param state  Observed state after the application update
+ */
+void trace_writer_tick(TraceWriter *w, const SimState *state);
+
+/**
+ * Write the end record, flush and close.
+ * @param end_ms       Simulation time the run stopped at
+ * @param total_bytes  Receives the file size (can be NULL)
+ * @return false if any write failed
+ */
+bool trace_writer_close(TraceWriter *w, uint32_t end_ms, uint64_t *total_bytes);
+
+/**
+ * Open a trace file for reading (memory-mapped).
+ * @return Reader, or NULL on error (message printed)
+ */
+TraceReader* trace_reader_open(const char *path);
+
+/**
+ * Close reader and unmap the file.
+ */
+void trace_reader_close(TraceReader *r);
+
+/**
+ * Get the EEPROM image stored in the header.
+ */
+const uint8_t* trace_reader_eeprom(const TraceReader *r, uint16_t *size);
+
+/**
+ * Get the start time stored in the header.
+ * Record times are relative to this.
+ */
+uint32_t trace_reader_start_time(const TraceReader *r);
+
+/**
+ * Get the ADC front end model stored in the header.
+ * Replays must run with it for the recorded CV to read the same.
+ */
+const AdcModelConfig* trace_reader_adc(const TraceReader *r);
+
+/**
+ * Get the settings stored in the header (NULL if the size doesn't match).
+ */
+const AppSettings* trace_reader_settings(const TraceReader *r);
+
+/**
+ * Read the next record into frame (updates changed fields and time).
+ * @return false at end of file or on a corrupt record
+ */
+bool trace_reader_next(TraceReader *r, TraceFrame *frame);
+
+/**
+ * Check if the reader stopped on a corrupt record.
+ */
+bool trace_reader_corrupt(const TraceReader *r);
+
+#endif /* GK_SIM_TRACE_H */
@@ -0,0 +1,249 @@
+#include "vcd.h"
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+/**
+ * @file vcd.c
+ * @brief VCD waveform writer
+ *
+ * Each tick the observed state is sampled into a flat array of signal
+ * values and compared with the previous sample; changed signals are
+ * formatted by hand into a large buffer that is written out in chunks.
+ */
+
+// Writer buffer size (flushed when full)
+#define VCD_BUFFER_SIZE (256u * 1024u)
+
+// Longest line we format: "#18446744073709551615\n" or "b11111111 !\n"
+#define VCD_MAX_LINE 24
+
+typedef struct {
+    const char *name;
+    uint8_t width;      // Bits (1 = scalar)
+} VcdSignal;
+
+enum {
+    SIG_BUTTON_A,
+    SIG_BUTTON_B,
+    SIG_CV_VOLTAGE,
+    SIG_CV_DIGITAL,
+    SIG_SIGNAL_OUT,
+    SIG_TOP_STATE,
+    SIG_MODE,
+    SIG_PAGE,
+    SIG_IN_MENU,
+    SIG_LEDS,           // SIM_NUM_LEDS x (r, g, b)
+    VCD_NUM_SIGNALS = SIG_LEDS + SIM_NUM_LEDS * 3
+};
+
+static const VcdSignal fixed_signals[SIG_LEDS] = {
+    [SIG_BUTTON_A]   = { "button_a",   1 },
+    [SIG_BUTTON_B]   = { "button_b",   1 },
+    [SIG_CV_VOLTAGE] = { "cv_voltage", 8 },
+    [SIG_CV_DIGITAL] = { "cv_digital", 1 },
+    [SIG_SIGNAL_OUT] = { "signal_out", 1 },
+    [SIG_TOP_STATE]  = { "top_state",  8 },
+    [SIG_MODE]       = { "mode",       8 },
+    [SIG_PAGE]       = { "page",       8 },
+    [SIG_IN_MENU]    = { "in_menu",    1 },
+};
+
+struct VcdWriter {
+    FILE *file;
+    char *buf;
+    size_t used;
+    bool error;
+    uint64_t last_time;         // Last timestamp written
+    uint8_t last[VCD_NUM_SIGNALS];
+};
+
+// =============================================================================
+// Output buffer
+// =============================================================================
+
+static void vcd_flush(VcdWriter *w) {
+    if (w->used == 0) return;
+    if (fwrite(w->buf, 1, w->used, w->file) != w->used) {
+        w->error = true;
+    }
+    w->used = 0;
+}
+
+// Make room for one formatted line
+static char* vcd_reserve(VcdWriter *w) {
+    if (w->used + VCD_MAX_LINE > VCD_BUFFER_SIZE) {
+        vcd_flush(w);
+    }
+    return w->buf + w->used;
+}
+
+// Header text (short lines only)
+static void vcd_puts(VcdWriter *w, const char *s) {
+    size_t len = strlen(s);
+    if (w->used + len > VCD_BUFFER_SIZE) {
+        vcd_flush(w);
+    }
+    memcpy(w->buf + w->used, s, len);
+    w->used += len;
+}
+
+// =============================================================================
+// Formatting
+// =============================================================================
+
+// Signal identifier: one printable character per signal
+static char vcd_id(int signal) {
+    return (char)('!' + signal);
+}
+
+static void vcd_timestamp(VcdWriter *w, uint64_t time) {
+    char *p = vcd_reserve(w);
+    char digits[20];
+    int n = 0;
+    do {
+        digits[n++] = (char)('0' + time % 10);
+        time /= 10;
+    } while (time);
+
+    *p++ = '#';
+    while (n) *p++ = digits[--n];
+    *p++ = '\n';
+    w->used = p - w->buf;
+}
+
+static void vcd_value(VcdWriter *w, int signal, uint8_t value) {
+    char *p = vcd_reserve(w);
+    uint8_t width = (signal < SIG_LEDS) ? fixed_signals[signal].width : 8;
+
+    if (width == 1) {
+        *p++ = value ? '1' : '0';
+    } else {
+        // Leading zeros may be dropped (left-extended with 0)
+        *p++ = 'b';
+        int bit = 7;
+        while (bit > 0 && !(value & (1u << bit))) bit--;
+        for (; bit >= 0; bit--) {
+            *p++ = (value & (1u << bit)) ? '1' : '0';
+        }
+        *p++ = ' ';
+    }
+    *p++ = vcd_id(signal);
+    *p++ = '\n';
+    w->used = p - w->buf;
+}
+
+static void vcd_sample(const SimState *state, uint8_t vals[VCD_NUM_SIGNALS]) {
+    vals[SIG_BUTTON_A] = state->button_a;
+    vals[SIG_BUTTON_B] = state->button_b;
+    vals[SIG_CV_VOLTAGE] = state->cv_voltage;
+    vals[SIG_CV_DIGITAL] = state->cv_in;
+    vals[SIG_SIGNAL_OUT] = state->signal_out;
+    vals[SIG_TOP_STATE] = (uint8_t)state->top_state;
+    vals[SIG_MODE] = (uint8_t)state->mode;
+    vals[SIG_PAGE] = (uint8_t)state->page;
+    vals[SIG_IN_MENU] = state->in_menu;
+    for (int i = 0; i < SIM_NUM_LEDS; i++) {
+        vals[SIG_LEDS + i * 3 + 0] = state->leds[i].r;
+        vals[SIG_LEDS + i * 3 + 1] = state->leds[i].g;
+        vals[SIG_LEDS + i * 3 + 2] = state->leds[i].b;
+    }
+}
+
+// =============================================================================
+// Public API
+// =============================================================================
+
+VcdWriter* vcd_writer_create(const char *path) {
+    VcdWriter *w = calloc(1, sizeof(VcdWriter));
+    if (!w) return NULL;
+
+    w->buf = malloc(VCD_BUFFER_SIZE);
+    w->file = fopen(path, "w");
+    if (!w->buf || !w->file) {
+        fprintf(stderr, "Error: Cannot create VCD file: %s\n", path);
+        if (w->file) fclose(w->file);
+        free(w->buf);
+        free(w);
+        return NULL;
+    }
+
+    // We do our own buffering
+    setvbuf(w->file, NULL, _IONBF, 0);
+    return w;
+}
+
+void vcd_writer_begin(VcdWriter *w, const SimState *state, bool us, uint64_t time) {
+    char line[96];
+
+    vcd_puts(w, "$comment Gatekeeper simulator $end\n");
+    vcd_puts(w, us ? "$timescale 1 us $end\n" : "$timescale 1 ms $end\n");
+    vcd_puts(w, "$scope module gatekeeper $end\n");
+
+    for (int i = 0; i < VCD_NUM_SIGNALS; i++) {
+        if (i < SIG_LEDS) {
+            const VcdSignal *sig = &fixed_signals[i];
+            if (sig->width == 1) {
+                snprintf(line, sizeof(line), "$var wire 1 %c %s $end\n",
+                         vcd_id(i), sig->name);
+            } else {
+                snprintf(line, sizeof(line), "$var wire %u %c %s [%u:0] $end\n",
+                         sig->width, vcd_id(i), sig->name, sig->width - 1);
+            }
+        } else {
+            int led = (i - SIG_LEDS) / 3;
+            char channel = "rgb"[(i - SIG_LEDS) % 3];
+            snprintf(line, sizeof(line), "$var wire 8 %c led%d_%c [7:0] $end\n",
+                     vcd_id(i), led, channel);
+        }
+        vcd_puts(w, line);
+    }
+
+    vcd_puts(w, "$upscope $end\n");
+    vcd_puts(w, "$enddefinitions $end\n");
+
+    // Initial values
+    vcd_sample(state, w->last);
+    w->last_time = time;
+    vcd_timestamp(w, w->last_time);
+    vcd_puts(w, "$dumpvars\n");
+    for (int i = 0; i < VCD_NUM_SIGNALS; i++) {
+        vcd_value(w, i, w->last[i]);
+    }
+    vcd_puts(w, "$end\n");
+}
+
+void vcd_writer_tick(VcdWriter *w, const SimState *state, uint64_t time) {
+    uint8_t vals[VCD_NUM_SIGNALS];
+    vcd_sample(state, vals);
+
+    if (memcmp(vals, w->last, sizeof(vals)) == 0) return;
+
+    if (time != w->last_time) {
+        vcd_timestamp(w, time);
+        w->last_time = time;
+    }
+
+    for (int i = 0; i < VCD_NUM_SIGNALS; i++) {
+        if (vals[i] != w->last[i]) {
+            vcd_value(w, i, vals[i]);
+            w->last[i] = vals[i];
+        }
+    }
+}
+
+bool vcd_writer_close(VcdWriter *w, uint64_t end) {
+    if (!w) return false;
+
+    // Mark the end so viewers show the final values up to it
+    if (end > w->last_time) {
+        vcd_timestamp(w, end);
+    }
+    vcd_flush(w);
+
+    bool ok = !w->error;
+    if (fclose(w->file) != 0) ok = false;
+    free(w->buf);
+    free(w);
+    return ok;
+}
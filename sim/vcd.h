@@ -0,0 +1,59 @@
+#ifndef GK_SIM_VCD_H
+#define GK_SIM_VCD_H
+
+#include "sim_state.h"
+#include <stdbool.h>
+#include <stdint.h>
+
+/**
+ * @file vcd.h
+ * @brief Value Change Dump (IEEE 1364) waveform export
+ *
+ * Writes pins and internal signals as a VCD file for GTKWave and other
+ * waveform viewers. The timescale is 1 ms, the simulator's tick, or 1 us
+ * on the microsecond clock (--tick-us), where signals are sampled after
+ * every loop pass. Only value changes are written; unchanged samples cost
+ * one comparison.
+ *
+ * Signals (scope "gatekeeper"):
+ *   button_a, button_b    1 bit   Pressed = 1
+ *   cv_voltage            8 bit   ADC value (0-255 = 0-5V)
+ *   cv_digital            1 bit   CV state after hysteresis
+ *   signal_out            1 bit   Output jack
+ *   top_state, mode, page 8 bit   FSM enums (TopState, ModeState, MenuPage)
+ *   in_menu               1 bit
+ *   led<n>_r/g/b          8 bit   LED channels
+ */
+
+// Opaque handle
+typedef struct VcdWriter VcdWriter;
+
+/**
+ * Open a VCD file for writing.
+ * @return Writer, or NULL on error (message printed)
+ */
+VcdWriter* vcd_writer_create(const char *path);
+
+/**
+ * Write the header and initial values ($dumpvars).
+ * @param state  Observed state at start
+ * @param us     Microsecond timescale (else 1 ms)
+ * @param time   Start time in timescale units
+ */
+void vcd_writer_begin(VcdWriter *w, const SimState *state, bool us, uint64_t time);
+
+/**
+ * Write the signals that changed since the last call.
+ * @param state  Observed state after the application update
+ * @param time   Sample time in timescale units
+ */
+void vcd_writer_tick(VcdWriter *w, const SimState *state, uint64_t time);
+
+/**
+ * Write a final timestamp, flush and close.
+ * @param end  Time the run stopped at, in timescale units
+ * @return false if any write failed
+ */
+bool vcd_writer_close(VcdWriter *w, uint64_t end);
+
+#endif /* GK_SIM_VCD_H */
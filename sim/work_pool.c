@@ -0,0 +1,204 @@
+#include "work_pool.h"
+#include <pthread.h>
+#include <stdlib.h>
+#include <unistd.h>
+
+/**
+ * @file work_pool.c
+ * @brief Work-stealing thread pool implementation
+ *
+ * Simulator tasks run for milliseconds to seconds, so a mutex per deque
+ * is cheap enough; contention only happens while stealing.
+ */
+
+typedef struct {
+    WorkPoolTask fn;
+    void *arg;
+} WorkItem;
+
+// Deque of tasks: owner takes from tail, thieves take from head
+typedef struct {
+    pthread_mutex_t lock;
+    WorkItem *items;
+    int head;
+    int tail;
+    int capacity;
+} WorkDeque;
+
+typedef struct {
+    WorkPool *pool;
+    int index;
+    uint32_t rng;           // Victim selection (xorshift32)
+    uint32_t steals;
+} Worker;
+
+struct WorkPool {
+    int num_workers;
+    int next_submit;
+    WorkDeque *deques;
+    Worker *workers;
+};
+
+static bool deque_push(WorkDeque *dq, WorkItem item) {
+    if (dq->tail >= dq->capacity) {
+        int capacity = dq->capacity ? dq->capacity * 2 : 16;
+        WorkItem *items = realloc(dq->items, capacity * sizeof(WorkItem));
+        if (!items) return false;
+        dq->items = items;
+        dq->capacity = capacity;
+    }
+    dq->items[dq->tail++] = item;
+    return true;
+}
+
+static bool deque_pop_tail(WorkDeque *dq, WorkItem *out) {
+    bool found = false;
+    pthread_mutex_lock(&dq->lock);
+    if (dq->head < dq->tail) {
+        *out = dq->items[--dq->tail];
+        found = true;
+    }
+    pthread_mutex_unlock(&dq->lock);
+    return found;
+}
+
+static bool deque_steal_head(WorkDeque *dq, WorkItem *out) {
+    bool found = false;
+    pthread_mutex_lock(&dq->lock);
+    if (dq->head < dq->tail) {
+        *out = dq->items[dq->head++];
+        found = true;
+    }
+    pthread_mutex_unlock(&dq->lock);
+    return found;
+}
+
+static uint32_t xorshift32(uint32_t *state) {
+    uint32_t x = *state;
+    x ^= x << 13;
+    x ^= x >> 17;
+    x ^= x << 5;
+    *state = x;
+    return x;
+}
+
+// Try every other deque once, starting at a random victim
+static bool worker_steal(Worker *w, WorkItem *out) {
+    WorkPool *pool = w->pool;
+    int n = pool->num_workers;
+    if (n < 2) return false;
+
+    int start = (int)(xorshift32(&w->rng) % (uint32_t)n);
+    for (int i = 0; i < n; i++) {
+        int victim = (start + i) % n;
+        if (victim == w->index) continue;
+        if (deque_steal_head(&pool->deques[victim], out)) {
+            w->steals++;
+            return true;
+        }
+    }
+    return false;
+}
+
+static void* worker_main(void *arg) {
+    Worker *w = (Worker*)arg;
+    WorkDeque *own = &w->pool->deques[w->index];
+    WorkItem item;
+
+    // No task submits new work, so once every deque is empty we're done
+    for (;;) {
+        if (deque_pop_tail(own, &item) || worker_steal(w, &item)) {
+            item.fn(item.arg);
+        } else {
+            break;
+        }
+    }
+    return NULL;
+}
+
+WorkPool* work_pool_create(int num_workers) {
+    if (num_workers <= 0) {
+        long cpus = sysconf(_SC_NPROCESSORS_ONLN);
+        num_workers = (cpus > 0) ? (int)cpus : 1;
+    }
+
+    WorkPool *pool = calloc(1, sizeof(WorkPool));
+    if (!pool) return NULL;
+
+    pool->deques = calloc(num_workers, sizeof(WorkDeque));
+    pool->workers = calloc(num_workers, sizeof(Worker));
+    if (!pool->deques || !pool->workers) {
+        free(pool->deques);
+        free(pool->workers);
+        free(pool);
+        return NULL;
+    }
+
+    pool->num_workers = num_workers;
+    for (int i = 0; i < num_workers; i++) {
+        pthread_mutex_init(&pool->deques[i].lock, NULL);
+        pool->workers[i].pool = pool;
+        pool->workers[i].index = i;
+        pool->workers[i].rng = 0x9E3779B9u ^ (uint32_t)(i + 1) * 0x85EBCA6Bu;
+    }
+
+    return pool;
+}
+
+void work_pool_destroy(WorkPool *pool) {
+    if (!pool) return;
+    for (int i = 0; i < pool->num_workers; i++) {
+        pthread_mutex_destroy(&pool->deques[i].lock);
+        free(pool->deques[i].items);
+    }
+    free(pool->deques);
+    free(pool->workers);
+    free(pool);
+}
+
+bool work_pool_submit(WorkPool *pool, WorkPoolTask fn, void *arg) {
+    WorkItem item = { fn, arg };
+    WorkDeque *dq = &pool->deques[pool->next_submit];
+    if (!deque_push(dq, item)) return false;
+    pool->next_submit = (pool->next_submit + 1) % pool->num_workers;
+    return true;
+}
+
+bool work_pool_run(WorkPool *pool) {
+    pthread_t *threads = calloc(pool->num_workers, sizeof(pthread_t));
+    if (!threads) return false;
+
+    for (int i = 0; i < pool->num_workers; i++) {
+        pool->workers[i].steals = 0;
+    }
+
+    // Worker 0 runs on the calling thread
+    int started = 0;
+    for (int i = 1; i < pool->num_workers; i++) {
+        if (pthread_create(&threads[i], NULL, worker_main, &pool->workers[i]) != 0) {
+            break;
+        }
+        started = i;
+    }
+    worker_main(&pool->workers[0]);
+
+    for (int i = 1; i <= started; i++) {
+        pthread_join(threads[i], NULL);
+    }
+    free(threads);
+
+    // Workers that failed to start had their deques drained by stealing
+    return true;
+}
+
+int work_pool_num_workers(const WorkPool *pool) {
+    return pool->num_workers;
+}
+
+uint32_t work_pool_steals(const WorkPool *pool) {
+    uint32_t total = 0;
+    for (int i = 0; i < pool->num_workers; i++) {
+        total += pool->workers[i].steals;
+    }
+    return total;
+}
@@ -0,0 +1,65 @@
+#ifndef GK_SIM_WORK_POOL_H
+#define GK_SIM_WORK_POOL_H
+
+#include <stdbool.h>
+#include <stdint.h>
+
+/**
+ * @file work_pool.h
+ * @brief Work-stealing thread pool for batch simulator runs
+ *
+ * Each worker owns a deque. Tasks are dealt round-robin to the deques up
+ * front; a worker pops its own deque from the back and, once empty,
+ * steals from the front of another worker's deque. Long tasks that land
+ * on one worker don't hold back the tasks queued behind them.
+ *
+ * Tasks run to completion on one thread, so a task can bind a
+ * SimInstance to its thread for its whole duration.
+ */
+
+// Opaque pool handle
+typedef struct WorkPool WorkPool;
+
+/**
+ * Task function, called on a worker thread.
+ */
+typedef void (*WorkPoolTask)(void *arg);
+
+/**
+ * Create a pool.
+ * @param num_workers  Worker threads (<= 0 = number of online CPUs)
+ * @return Pool handle, or NULL on error
+ */
+WorkPool* work_pool_create(int num_workers);
+
+/**
+ * Destroy a pool. Tasks not yet run are dropped.
+ */
+void work_pool_destroy(WorkPool *pool);
+
+/**
+ * Queue a task. Only valid before work_pool_run().
+ * @return false on allocation failure
+ */
+bool work_pool_submit(WorkPool *pool, WorkPoolTask fn, void *arg);
+
+/**
+ * Run all queued tasks and wait for them to finish.
+ * The calling thread acts as worker 0. If some threads can't be
+ * started, the remaining workers steal their tasks.
+ * @return false on allocation failure (no tasks run)
+ */
+bool work_pool_run(WorkPool *pool);
+
+/**
+ * Get the number of worker threads.
+ */
+int work_pool_num_workers(const WorkPool *pool);
+
+/**
+ * Get the number of tasks taken from another worker's deque
+ * during the last run.
+ */
+uint32_t work_pool_steals(const WorkPool *pool);
+
+#endif /* GK_SIM_WORK_POOL_H */
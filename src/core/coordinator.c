@@ -24,7 +24,8 @@ static void action_next_page(void);
 static void action_cycle_value(void);
 
 // Global pointer for action functions (set during update)
-static Coordinator *g_coord = NULL;
+// Per-thread alongside p_hal so simulated devices on other threads don't race
+static GK_THREAD_LOCAL Coordinator *g_coord = NULL;
 
 // =============================================================================
 // State definitions
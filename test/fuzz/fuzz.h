@@ -0,0 +1,27 @@
+#ifndef GK_TEST_FUZZ_FUZZ_H
+#define GK_TEST_FUZZ_FUZZ_H
+
+#include <stddef.h>
+#include <stdint.h>
+
+/**
+ * @file fuzz.h
+ * @brief Coordinator fuzz target
+ *
+ * The target follows the libFuzzer interface, so the same source links
+ * against libFuzzer (clang) or against the standalone driver in
+ * fuzz_main.c (gcc). An input is a timeline of button and CV states
+ * played into the mock HAL around the main loop; the input format and
+ * the checked invariants are described in fuzz_coordinator.c. A broken
+ * invariant prints a message and aborts.
+ */
+
+#define FUZZ_HEADER_SIZE    3   // Settings and boot options
+#define FUZZ_RECORD_SIZE    2   // One input state and its passes
+
+/**
+ * Run one input from a fresh boot. Returns 0.
+ */
+int LLVMFuzzerTestOneInput(const uint8_t *data, size_t size);
+
+#endif /* GK_TEST_FUZZ_FUZZ_H */
@@ -0,0 +1,451 @@
+#include "fuzz.h"
+#include "app_init.h"
+#include "config/mode_config.h"
+#include "core/coordinator.h"
+#include "mocks/mock_hal.h"
+
+#include <stdarg.h>
+#include <stdbool.h>
+#include <stdio.h>
+#include <stdlib.h>
+
+/**
+ * @file fuzz_coordinator.c
+ * @brief Coordinator fuzz target
+ *
+ * Input format:
+ *
+ *   byte 0   bits 0-2 mode (mod 5), bit 3 gate A mode, bit 4 toggle edge,
+ *            bits 5-6 trigger pulse index
+ *   byte 1   bits 0-1 divide divisor index, bits 2-4 cycle tempo index
+ *            (mod 5), bits 5-6 trigger edge (mod 3)
+ *   byte 2   bit 7 boot through app_init_run() from an EEPROM image of
+ *            these settings, damaged per bits 5-6 (0 intact, 1 flip a
+ *            bit, 2 write 0xFF and fix the checksum) at address bits 0-4
+ *            (mod 0x12); otherwise start straight from the settings
+ *
+ * then records of two bytes, until the input ends:
+ *
+ *   byte 0   bit 0 button A pressed, bit 1 button B pressed,
+ *            bits 2-7 CV ADC value (byte & 0xFC)
+ *   byte 1   bits 0-3 gap between loop passes (pass_gap_ms[]),
+ *            bits 4-7 number of passes - 1
+ *
+ * Each pass mirrors the main loop in main.c (watchdog, coordinator,
+ * output pin; LEDs are left out). Gaps longer than 1 ms stand for
+ * passes that saw no input change, as the simulator's idle skipping
+ * does: the firmware fed the watchdog in them, and the output checks
+ * allow for the firmware acting at the first pass after a deadline.
+ *
+ * Invariants, checked after every pass:
+ * - FSM states and settings in range
+ * - Saved settings in EEPROM load back (magic, schema, checksum,
+ *   ranges) and match the settings in RAM
+ * - A pass blocks for less than the 250 ms watchdog timeout, counting
+ *   3.4 ms per EEPROM byte written
+ * - An intact image boots to its settings, a damaged one to valid ones
+ * - In perform mode (the menu holds the output), per mode:
+ *   gate     output follows the mode input
+ *   trigger  a rising input edge starts a pulse; pulses last the
+ *            configured width from the last edge, no more, no less
+ *   toggle   the output flips on rising input edges only
+ *   divide   pulses of OUTPUT_PULSE_MS start on input edges, every
+ *            divisor edges (a multiple of it when pulses overlap)
+ *   cycle    the output flips every half period, no sooner or later
+ *
+ * The mode input is button B, or B or A in gate mode with gate A mode
+ * manual. After a mode change or a menu visit the handler may have been
+ * re-initialized, so the checks restart from what they can prove: an
+ * edge they cannot be sure of counts as possible, widening the bounds.
+ * The edge settings are not checked: the handlers use rising edges.
+ */
+
+#define PASS_GAP_CODES      16
+#define EEPROM_WRITE_US     3400
+#define WDT_TIMEOUT_MS      250
+#define EEPROM_IMAGE_SIZE   (EEPROM_CHECKSUM_ADDR + 2)
+
+static const uint16_t pass_gap_ms[PASS_GAP_CODES] = {
+    1, 1, 1, 1, 1, 1, 2, 3, 5, 10, 20, 50, 100, 250, 1000, 5000
+};
+
+static Coordinator coord;
+static AppSettings settings;
+
+// What the checks know of the mode handler
+typedef struct {
+    uint32_t pass;
+    uint32_t now;
+    bool last_out;          // Output after the previous pass
+
+    bool fresh;             // Handler may have been re-initialized
+    uint32_t fresh_time;
+
+    bool in_known;          // last_in matches the handler's last input
+    bool last_in;
+
+    bool rise_valid;        // Possible input rising edge since mode entry
+    uint32_t last_rise;
+    bool high_valid;        // Output rising edge seen since fresh
+    uint32_t high_since;
+
+    bool count_valid;       // Divide: rise count since last output edge
+    uint32_t rises;
+
+    bool toggle_valid;      // Cycle: output change seen since fresh
+    uint32_t toggle_time;
+} Model;
+
+static Model model;
+
+static void fail(const char *fmt, ...) __attribute__((format(printf, 1, 2), noreturn));
+
+static void fail(const char *fmt, ...) {
+    va_list args;
+    fprintf(stderr, "Invariant violated at pass %lu (%lu ms, %s, mode %u, page %u): ",
+            (unsigned long)model.pass, (unsigned long)model.now,
+            coordinator_in_menu(&coord) ? "menu" : "perform",
+            (unsigned)coordinator_get_mode(&coord), (unsigned)coordinator_get_page(&coord));
+    va_start(args, fmt);
+    vfprintf(stderr, fmt, args);
+    va_end(args);
+    fprintf(stderr, "\n");
+    abort();
+}
+
+// =============================================================================
+// Settings
+// =============================================================================
+
+static bool settings_in_range(const AppSettings *s) {
+    return s->mode < MODE_COUNT &&
+           s->trigger_pulse_idx < TRIGGER_PULSE_COUNT &&
+           s->trigger_edge < TRIGGER_EDGE_COUNT &&
+           s->divide_divisor_idx < DIVIDE_DIVISOR_COUNT &&
+           s->cycle_tempo_idx < CYCLE_TEMPO_COUNT &&
+           s->toggle_edge < TOGGLE_EDGE_COUNT &&
+           s->gate_a_mode < GATE_A_MODE_COUNT;
+}
+
+static uint8_t settings_checksum(const AppSettings *s) {
+    const uint8_t *data = (const uint8_t *)s;
+    uint8_t checksum = 0;
+    for (uint8_t i = 0; i < sizeof(AppSettings); i++) {
+        checksum ^= data[i];
+    }
+    return checksum;
+}
+
+static void decode_settings(const uint8_t *header, AppSettings *s) {
+    app_init_get_defaults(s);
+    s->mode = (header[0] & 0x07) % MODE_COUNT;
+    s->gate_a_mode = (header[0] >> 3) & 0x01;
+    s->toggle_edge = (header[0] >> 4) & 0x01;
+    s->trigger_pulse_idx = (header[0] >> 5) & 0x03;
+    s->divide_divisor_idx = header[1] & 0x03;
+    s->cycle_tempo_idx = ((header[1] >> 2) & 0x07) % CYCLE_TEMPO_COUNT;
+    s->trigger_edge = ((header[1] >> 5) & 0x03) % TRIGGER_EDGE_COUNT;
+}
+
+// Saved settings must load back and match RAM
+static void check_eeprom(void) {
+    if (mock_eeprom_read_word(EEPROM_MAGIC_ADDR) != EEPROM_MAGIC_VALUE) {
+        fail("EEPROM written without the magic number");
+    }
+    if (mock_eeprom_read_byte(EEPROM_SCHEMA_ADDR) != SETTINGS_SCHEMA_VERSION) {
+        fail("EEPROM schema %u", (unsigned)mock_eeprom_read_byte(EEPROM_SCHEMA_ADDR));
+    }
+    AppSettings stored;
+    uint8_t *data = (uint8_t *)&stored;
+    for (uint8_t i = 0; i < sizeof(AppSettings); i++) {
+        data[i] = mock_eeprom_read_byte(EEPROM_SETTINGS_ADDR + i);
+    }
+    if (mock_eeprom_read_byte(EEPROM_CHECKSUM_ADDR) != settings_checksum(&stored)) {
+        fail("EEPROM checksum mismatch");
+    }
+    if (!settings_in_range(&stored)) {
+        fail("EEPROM settings out of range");
+    }
+    for (uint8_t i = 0; i < sizeof(AppSettings); i++) {
+        if (data[i] != ((const uint8_t *)&settings)[i]) {
+            fail("EEPROM settings byte %u is %u, RAM has %u", (unsigned)i, (unsigned)data[i],
+                 (unsigned)((const uint8_t *)&settings)[i]);
+        }
+    }
+}
+
+// =============================================================================
+// Boot
+// =============================================================================
+
+static void set_inputs(uint8_t record) {
+    // Buttons are active-low
+    if (record & 0x01) mock_clear_pin(p_hal->button_a_pin); else mock_set_pin(p_hal->button_a_pin);
+    if (record & 0x02) mock_clear_pin(p_hal->button_b_pin); else mock_set_pin(p_hal->button_b_pin);
+    mock_adc_set_value(CV_ADC_CHANNEL, record & 0xFC);
+}
+
+// Boot from a saved, possibly damaged, EEPROM image (as main.c does)
+static void boot_from_eeprom(const AppSettings *image, uint8_t damage) {
+    app_init_save_settings(image);
+    uint8_t saved[EEPROM_IMAGE_SIZE];
+    for (uint8_t i = 0; i < EEPROM_IMAGE_SIZE; i++) {
+        saved[i] = mock_eeprom_read_byte(i);
+    }
+
+    uint8_t addr = (damage & 0x1F) % EEPROM_IMAGE_SIZE;
+    uint8_t kind = (damage >> 5) & 0x03;
+    if (kind == 1) {
+        mock_eeprom_write_byte(addr, saved[addr] ^ (uint8_t)(1u << (addr & 7)));
+    } else if (kind == 2) {
+        // Out-of-range value that passes the checksum
+        mock_eeprom_write_byte(addr, 0xFF);
+        if (addr >= EEPROM_SETTINGS_ADDR && addr < EEPROM_CHECKSUM_ADDR) {
+            AppSettings damaged;
+            uint8_t *data = (uint8_t *)&damaged;
+            for (uint8_t i = 0; i < sizeof(AppSettings); i++) {
+                data[i] = mock_eeprom_read_byte(EEPROM_SETTINGS_ADDR + i);
+            }
+            mock_eeprom_write_byte(EEPROM_CHECKSUM_ADDR, settings_checksum(&damaged));
+        }
+    }
+    bool intact = true;
+    for (uint8_t i = 0; i <= EEPROM_CHECKSUM_ADDR; i++) {
+        intact = intact && mock_eeprom_read_byte(i) == saved[i];
+    }
+
+    AppInitResult result = app_init_run(&settings);
+    if (!settings_in_range(&settings)) {
+        fail("boot loaded settings out of range (result %d)", (int)result);
+    }
+    if (intact && result == APP_INIT_OK_DEFAULTS) {
+        fail("intact EEPROM image rejected");
+    }
+    if (intact && result == APP_INIT_OK) {
+        for (uint8_t i = 0; i < sizeof(AppSettings); i++) {
+            if (((const uint8_t *)&settings)[i] != ((const uint8_t *)image)[i]) {
+                fail("intact EEPROM image booted with different settings");
+            }
+        }
+    }
+}
+
+static void boot(const uint8_t *header, uint8_t first_record) {
+    model = (Model){ 0 };
+    mock_hal_init();
+    AppSettings image;
+    decode_settings(header, &image);
+
+    if (header[2] & 0x80) {
+        // Both buttons held at power-up request a factory reset
+        set_inputs(first_record);
+        boot_from_eeprom(&image, header[2]);
+    } else {
+        settings = image;
+    }
+
+    coordinator_init(&coord, &settings);
+    if (settings.mode < MODE_COUNT) {
+        coordinator_set_mode(&coord, (ModeState)settings.mode);
+    }
+    coordinator_start(&coord);
+    p_hal->wdt_enable();
+
+    model.fresh = true;
+    model.fresh_time = mock_millis();
+}
+
+// =============================================================================
+// Output checks
+// =============================================================================
+
+static bool mode_input(ModeState mode) {
+    bool in = !mock_read_pin(p_hal->button_b_pin);
+    if (mode == MODE_GATE && settings.gate_a_mode == GATE_A_MODE_MANUAL) {
+        in = in || !mock_read_pin(p_hal->button_a_pin);
+    }
+    return in;
+}
+
+// Trigger and divide: pulses of width ms
+static void check_pulse(ModeState mode, bool out, bool rise, bool certain_rise, uint32_t width) {
+    Model *m = &model;
+    uint32_t now = m->now;
+
+    if (rise) {
+        m->last_rise = now;
+        m->rise_valid = true;
+    }
+    if (mode == MODE_TRIGGER && certain_rise && !out) {
+        fail("trigger: input edge without a pulse");
+    }
+    if (out && (!m->rise_valid || now - m->last_rise >= width)) {
+        fail("%s: output high %lu ms after the last input edge (width %lu ms)",
+             mode == MODE_TRIGGER ? "trigger" : "divide",
+             m->rise_valid ? (unsigned long)(now - m->last_rise) : 0ul, (unsigned long)width);
+    }
+    if (m->fresh) return;
+
+    if (out && !m->last_out) {
+        if (!rise) fail("pulse started without an input edge");
+        if (mode == MODE_DIVIDE && m->count_valid) {
+            uint8_t divisor = DIVIDE_DIVISOR_VALUES[settings.divide_divisor_idx];
+            uint32_t rises = m->rises + 1;
+            if (rises % divisor != 0) {
+                fail("divide: pulse after %lu input edges (divisor %u)",
+                     (unsigned long)rises, (unsigned)divisor);
+            }
+        }
+        m->high_valid = true;
+        m->high_since = now;
+        m->count_valid = true;
+        m->rises = 0;
+        return;
+    }
+    if (!out && m->last_out && m->high_valid && now - m->high_since < width) {
+        fail("pulse of %lu ms, shorter than %lu ms", (unsigned long)(now - m->high_since),
+             (unsigned long)width);
+    }
+    if (rise) {
+        if (certain_rise) m->rises++; else m->count_valid = false;
+    }
+}
+
+static void check_output(ModeState mode, bool out) {
+    Model *m = &model;
+    uint32_t now = m->now;
+    bool in = mode_input(mode);
+    bool certain_rise = m->in_known && in && !m->last_in;
+    bool rise = m->in_known ? certain_rise : in;
+
+    switch (mode) {
+        case MODE_GATE:
+            if (out != in) fail("gate: output %d, input %d", out, in);
+            break;
+
+        case MODE_TRIGGER:
+            check_pulse(mode, out, rise, certain_rise,
+                        TRIGGER_PULSE_VALUES[settings.trigger_pulse_idx]);
+            break;
+
+        case MODE_DIVIDE:
+            check_pulse(mode, out, rise, certain_rise, OUTPUT_PULSE_MS);
+            break;
+
+        case MODE_TOGGLE:
+            if (m->fresh) break;
+            if (out != m->last_out && !rise) fail("toggle: flipped without an input edge");
+            if (out == m->last_out && certain_rise) fail("toggle: input edge did not flip");
+            break;
+
+        case MODE_CYCLE: {
+            uint32_t half = CYCLE_PERIOD_VALUES[settings.cycle_tempo_idx] / 2;
+            if (m->fresh) break;
+            if (out != m->last_out) {
+                if (m->toggle_valid && now - m->toggle_time < half) {
+                    fail("cycle: flipped after %lu ms, half period %lu ms",
+                         (unsigned long)(now - m->toggle_time), (unsigned long)half);
+                }
+                m->toggle_valid = true;
+                m->toggle_time = now;
+            } else if (m->toggle_valid ? now - m->toggle_time >= half
+                                       : now - m->fresh_time >= half) {
+                fail("cycle: output stuck for %lu ms, half period %lu ms",
+                     (unsigned long)(now - (m->toggle_valid ? m->toggle_time : m->fresh_time)),
+                     (unsigned long)half);
+            }
+            break;
+        }
+
+        default:
+            break;
+    }
+
+    m->last_in = in;
+    m->in_known = true;
+    m->fresh = false;
+}
+
+// =============================================================================
+// Main loop
+// =============================================================================
+
+static void run_pass(void) {
+    Model *m = &model;
+    m->now = mock_millis();
+    uint32_t writes = mock_eeprom_write_count();
+    bool was_menu = coordinator_in_menu(&coord);
+    ModeState was_mode = coordinator_get_mode(&coord);
+
+    // Mirrors main.c
+    p_hal->wdt_reset();
+    coordinator_update(&coord);
+    bool out = coordinator_get_output(&coord);
+    if (out) {
+        p_hal->set_pin(p_hal->sig_out_pin);
+    } else {
+        p_hal->clear_pin(p_hal->sig_out_pin);
+    }
+
+    // The watchdog is fed once per pass
+    writes = mock_eeprom_write_count() - writes;
+    uint64_t blocked_us = (uint64_t)(mock_millis() - m->now) * 1000 +
+                          (uint64_t)writes * EEPROM_WRITE_US;
+    if (blocked_us >= (uint64_t)WDT_TIMEOUT_MS * 1000) {
+        fail("pass blocked %lu us, watchdog fires at %d ms", (unsigned long)blocked_us,
+             WDT_TIMEOUT_MS);
+    }
+
+    TopState top = coordinator_get_top_state(&coord);
+    ModeState mode = coordinator_get_mode(&coord);
+    if (top >= TOP_STATE_COUNT || mode >= MODE_COUNT || coordinator_get_page(&coord) >= PAGE_COUNT) {
+        fail("state out of range: top %u", (unsigned)top);
+    }
+    if (!settings_in_range(&settings)) {
+        fail("settings out of range");
+    }
+    if (writes) {
+        check_eeprom();
+    }
+
+    if (top == TOP_MENU) {
+        // Output held; the handler may be re-initialized before exit
+        m->fresh = true;
+        m->in_known = false;
+    } else {
+        if (was_menu || mode != was_mode) {
+            m->fresh = true;
+            m->fresh_time = m->now;
+            m->in_known = false;
+            m->high_valid = false;
+            m->count_valid = false;
+            m->toggle_valid = false;
+        }
+        if (mode != was_mode) {
+            m->rise_valid = false;
+        }
+        check_output(mode, out);
+    }
+    m->last_out = out;
+    m->pass++;
+}
+
+int LLVMFuzzerTestOneInput(const uint8_t *data, size_t size) {
+    if (size < FUZZ_HEADER_SIZE) return 0;
+    const uint8_t *records = data + FUZZ_HEADER_SIZE;
+    size_t num_records = (size - FUZZ_HEADER_SIZE) / FUZZ_RECORD_SIZE;
+
+    use_mock_hal();
+    boot(data, num_records ? records[0] : 0);
+
+    for (size_t r = 0; r < num_records; r++) {
+        const uint8_t *rec = records + r * FUZZ_RECORD_SIZE;
+        set_inputs(rec[0]);
+        uint32_t gap = pass_gap_ms[rec[1] & 0x0F];
+        for (int pass = 0; pass <= rec[1] >> 4; pass++) {
+            run_pass();
+            advance_mock_time(gap);
+        }
+    }
+    return 0;
+}
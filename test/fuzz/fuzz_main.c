@@ -0,0 +1,254 @@
+#include "fuzz.h"
+
+#include <dirent.h>
+#include <fcntl.h>
+#include <signal.h>
+#include <stdbool.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <sys/stat.h>
+#include <time.h>
+#include <unistd.h>
+
+/**
+ * @file fuzz_main.c
+ * @brief Standalone driver for the fuzz target (builds without libFuzzer)
+ *
+ * Takes the libFuzzer flags it can honour, so scripts and CI run either
+ * build the same way. File arguments are replayed (directories: every
+ * file in them). Without files, or with -runs / -max_total_time, random
+ * inputs follow: mostly short timelines, with some long ones to reach
+ * holds and the menu timeout. No coverage feedback; for that, build
+ * with clang to get libFuzzer.
+ *
+ * A failing input aborts the target; the driver's SIGABRT handler saves
+ * it as crash-<hash> in the working directory, as libFuzzer does.
+ */
+
+#define DEFAULT_RUNS        1000000
+#define DEFAULT_MAX_LEN     64
+#define MAX_LEN_LIMIT       4096
+#define LONG_INPUT_ODDS     16      // 1 in n random inputs uses max_len
+
+static const uint8_t *current_input;
+static size_t current_size;
+
+// =============================================================================
+// Crash Files
+// =============================================================================
+
+static uint64_t input_hash(const uint8_t *data, size_t size) {
+    uint64_t h = 0xcbf29ce484222325ull;     // FNV-1a
+    for (size_t i = 0; i < size; i++) {
+        h = (h ^ data[i]) * 0x100000001b3ull;
+    }
+    return h;
+}
+
+// Async-signal-safe: only open/write/close
+static void save_crash(int sig) {
+    char name[32] = "crash-";
+    uint64_t h = input_hash(current_input, current_size);
+    for (int i = 0; i < 16; i++) {
+        name[6 + i] = "0123456789abcdef"[(h >> (60 - 4 * i)) & 0xF];
+    }
+    name[22] = '\0';
+
+    int fd = current_input ? open(name, O_WRONLY | O_CREAT | O_TRUNC, 0644) : -1;
+    if (fd >= 0) {
+        ssize_t written = write(fd, current_input, current_size);
+        close(fd);
+        if (written == (ssize_t)current_size) {
+            static const char msg[] = "Input saved to ";
+            (void)!write(STDERR_FILENO, msg, sizeof(msg) - 1);
+            (void)!write(STDERR_FILENO, name, strlen(name));
+            (void)!write(STDERR_FILENO, "\n", 1);
+        }
+    }
+    signal(sig, SIG_DFL);
+    raise(sig);
+}
+
+static void run_input(const uint8_t *data, size_t size) {
+    current_input = data;
+    current_size = size;
+    LLVMFuzzerTestOneInput(data, size);
+    current_input = NULL;
+}
+
+// =============================================================================
+// Replay
+// =============================================================================
+
+static bool replay_file(const char *path) {
+    FILE *f = fopen(path, "rb");
+    if (!f) {
+        perror(path);
+        return false;
+    }
+    static uint8_t buf[1 << 20];
+    size_t size = fread(buf, 1, sizeof(buf), f);
+    fclose(f);
+    run_input(buf, size);
+    return true;
+}
+
+// Returns the number of inputs run, -1 on error
+static long replay_path(const char *path) {
+    struct stat st;
+    if (stat(path, &st) != 0) {
+        perror(path);
+        return -1;
+    }
+    if (!S_ISDIR(st.st_mode)) {
+        return replay_file(path) ? 1 : -1;
+    }
+
+    DIR *dir = opendir(path);
+    if (!dir) {
+        perror(path);
+        return -1;
+    }
+    long count = 0;
+    struct dirent *entry;
+    while ((entry = readdir(dir)) != NULL) {
+        if (entry->d_name[0] == '.') continue;
+        char file[4096];
+        snprintf(file, sizeof(file), "%s/%s", path, entry->d_name);
+        if (stat(file, &st) == 0 && S_ISREG(st.st_mode) && replay_file(file)) {
+            count++;
+        }
+    }
+    closedir(dir);
+    return count;
+}
+
+// =============================================================================
+// Random Inputs
+// =============================================================================
+
+static uint64_t rng_state;
+
+static uint32_t rng_next(void) {
+    // xorshift64*
+    rng_state ^= rng_state >> 12;
+    rng_state ^= rng_state << 25;
+    rng_state ^= rng_state >> 27;
+    return (uint32_t)((rng_state * 0x2545F4914F6CDD1Dull) >> 32);
+}
+
+static double elapsed_s(const struct timespec *start) {
+    struct timespec now;
+    clock_gettime(CLOCK_MONOTONIC, &now);
+    return (double)(now.tv_sec - start->tv_sec) + (now.tv_nsec - start->tv_nsec) / 1e9;
+}
+
+static void run_random(unsigned long runs, unsigned long max_time, size_t max_len) {
+    static uint8_t buf[MAX_LEN_LIMIT];
+    struct timespec start;
+    clock_gettime(CLOCK_MONOTONIC, &start);
+
+    unsigned long done = 0;
+    uint64_t bytes = 0;
+    for (; done < runs; done++) {
+        if ((done & 0xFFF) == 0 && max_time && elapsed_s(&start) >= (double)max_time) {
+            break;
+        }
+        size_t len = (rng_next() % LONG_INPUT_ODDS == 0) ? max_len
+                                                         : rng_next() % (max_len / 4 + 1);
+        len = FUZZ_HEADER_SIZE + (len / FUZZ_RECORD_SIZE) * FUZZ_RECORD_SIZE;
+        if (len > max_len) len = max_len;
+        for (size_t i = 0; i < len; i += 4) {
+            uint32_t r = rng_next();
+            memcpy(buf + i, &r, (len - i < 4) ? len - i : 4);
+        }
+        run_input(buf, len);
+        bytes += len;
+    }
+
+    double secs = elapsed_s(&start);
+    printf("Done %lu runs in %.1f s: %.0f exec/s, %.1f bytes/input\n", done, secs,
+           secs > 0 ? done / secs : 0.0, done ? (double)bytes / done : 0.0);
+}
+
+// =============================================================================
+// Main
+// =============================================================================
+
+static void print_usage(const char *progname) {
+    printf("Gatekeeper coordinator fuzz target (standalone driver)\n\n");
+    printf("Usage: %s [options] [file|dir ...]\n\n", progname);
+    printf("Files and directories are replayed; random inputs run when none are\n");
+    printf("given or when -runs or -max_total_time is.\n\n");
+    printf("Options (libFuzzer syntax):\n");
+    printf("  -runs=<n>            Random inputs to run (default: %d)\n", DEFAULT_RUNS);
+    printf("  -max_total_time=<s>  Stop random inputs after s seconds\n");
+    printf("  -seed=<n>            Random seed (default: time)\n");
+    printf("  -max_len=<n>         Longest input in bytes (default: %d, max %d)\n",
+           DEFAULT_MAX_LEN, MAX_LEN_LIMIT);
+    printf("  -help=1              Show this help message\n");
+}
+
+static bool parse_flag(const char *arg, const char *name, unsigned long *value) {
+    size_t len = strlen(name);
+    if (strncmp(arg, name, len) != 0 || arg[len] != '=') return false;
+    *value = strtoul(arg + len + 1, NULL, 10);
+    return true;
+}
+
+int main(int argc, char **argv) {
+    unsigned long runs = DEFAULT_RUNS;
+    unsigned long max_time = 0;
+    unsigned long seed = 0;
+    unsigned long max_len = DEFAULT_MAX_LEN;
+    unsigned long help = 0;
+    bool random_inputs = true;
+    bool random_flag = false;
+
+    for (int i = 1; i < argc; i++) {
+        if (parse_flag(argv[i], "-runs", &runs) ||
+            parse_flag(argv[i], "-max_total_time", &max_time)) {
+            random_flag = true;
+        } else if (parse_flag(argv[i], "-seed", &seed) ||
+                   parse_flag(argv[i], "-max_len", &max_len)) {
+            // Parsed
+        } else if (parse_flag(argv[i], "-help", &help) ||
+                   strcmp(argv[i], "--help") == 0 || strcmp(argv[i], "-h") == 0) {
+            print_usage(argv[0]);
+            return 0;
+        } else if (argv[i][0] == '-') {
+            fprintf(stderr, "Unknown option: %s\n", argv[i]);
+            print_usage(argv[0]);
+            return 1;
+        } else {
+            random_inputs = false;
+        }
+    }
+    if (max_len < FUZZ_HEADER_SIZE || max_len > MAX_LEN_LIMIT) {
+        print_usage(argv[0]);
+        return 1;
+    }
+    if (max_time && runs == DEFAULT_RUNS) {
+        runs = (unsigned long)-1;
+    }
+
+    signal(SIGABRT, save_crash);
+
+    long replayed = 0;
+    for (int i = 1; i < argc; i++) {
+        if (argv[i][0] == '-') continue;
+        long n = replay_path(argv[i]);
+        if (n < 0) return 1;
+        replayed += n;
+    }
+    if (!random_inputs) {
+        printf("Replayed %ld inputs\n", replayed);
+        if (!random_flag) return 0;
+    }
+
+    rng_state = (seed ? seed : (uint64_t)time(NULL)) | 1;
+    printf("Seed: %llu\n", (unsigned long long)rng_state);
+    run_random(runs, max_time, max_len);
+    return 0;
+}
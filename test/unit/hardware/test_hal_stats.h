@@ -0,0 +1,163 @@
+#ifndef GK_TEST_HARDWARE_HAL_STATS_H
+#define GK_TEST_HARDWARE_HAL_STATS_H
+
+#include "unity.h"
+#include "unity_fixture.h"
+#include "hardware/hal_interface.h"
+#include "mocks/mock_hal.h"
+#include "hal_stats.h"
+
+static HalStats hal_stats;
+
+// 40 HAL calls from 40 distinct call sites
+#define HAL_STATS_CALLS_5   p_hal->millis(); p_hal->millis(); p_hal->millis(); \
+                            p_hal->millis(); p_hal->millis();
+#define HAL_STATS_SITES     40
+
+static void hal_stats_call_distinct_sites(void) {
+    HAL_STATS_CALLS_5 HAL_STATS_CALLS_5 HAL_STATS_CALLS_5 HAL_STATS_CALLS_5
+    HAL_STATS_CALLS_5 HAL_STATS_CALLS_5 HAL_STATS_CALLS_5 HAL_STATS_CALLS_5
+}
+
+static uint32_t hal_stats_used_sites(void) {
+    uint32_t used = 0;
+    for (int i = 0; i < HAL_STATS_MAX_SITES; i++) {
+        if (hal_stats.sites[i].addr) used++;
+    }
+    return used;
+}
+
+TEST_GROUP(HalStatsTests);
+
+TEST_SETUP(HalStatsTests) {
+    p_hal->init();
+    hal_stats_init(&hal_stats);
+    mock_hal_set_stats(&hal_stats);
+}
+
+TEST_TEAR_DOWN(HalStatsTests) {
+    mock_hal_set_stats(NULL);
+    p_hal->reset_time();
+}
+
+TEST(HalStatsTests, TestCountsPerFunction) {
+    p_hal->millis();
+    p_hal->millis();
+    p_hal->read_pin(p_hal->button_a_pin);
+    p_hal->set_pin(p_hal->sig_out_pin);
+    p_hal->eeprom_write_byte(0, 0x42);
+
+    TEST_ASSERT_EQUAL_UINT64(2, hal_stats_calls(&hal_stats, HAL_FN_MILLIS));
+    TEST_ASSERT_EQUAL_UINT64(1, hal_stats_calls(&hal_stats, HAL_FN_READ_PIN));
+    TEST_ASSERT_EQUAL_UINT64(1, hal_stats_calls(&hal_stats, HAL_FN_SET_PIN));
+    TEST_ASSERT_EQUAL_UINT64(1, hal_stats_calls(&hal_stats, HAL_FN_EEPROM_WRITE_BYTE));
+    TEST_ASSERT_EQUAL_UINT64(0, hal_stats_calls(&hal_stats, HAL_FN_CLEAR_PIN));
+}
+
+TEST(HalStatsTests, TestDirectHelpersNotCounted) {
+    mock_millis();
+    mock_set_pin(1);
+    TEST_ASSERT_EQUAL_UINT64(0, hal_stats_calls(&hal_stats, HAL_FN_MILLIS));
+    TEST_ASSERT_EQUAL_UINT64(0, hal_stats_calls(&hal_stats, HAL_FN_SET_PIN));
+}
+
+TEST(HalStatsTests, TestStopCounting) {
+    p_hal->millis();
+    mock_hal_set_stats(NULL);
+    p_hal->millis();
+    TEST_ASSERT_EQUAL_UINT64(1, hal_stats_calls(&hal_stats, HAL_FN_MILLIS));
+}
+
+TEST(HalStatsTests, TestCallsFromOneSite) {
+    for (int i = 0; i < 5; i++) {
+        p_hal->millis();
+    }
+    TEST_ASSERT_EQUAL_UINT32(1, hal_stats_used_sites());
+    for (int i = 0; i < HAL_STATS_MAX_SITES; i++) {
+        if (!hal_stats.sites[i].addr) continue;
+        TEST_ASSERT_EQUAL_UINT8(HAL_FN_MILLIS, hal_stats.sites[i].fn);
+        TEST_ASSERT_EQUAL_UINT32(5, hal_stats.sites[i].calls);
+    }
+}
+
+TEST(HalStatsTests, TestPerTickMax) {
+    p_hal->millis();
+    p_hal->read_pin(p_hal->button_a_pin);
+    hal_stats_end_tick(&hal_stats);
+
+    p_hal->millis();
+    p_hal->millis();
+    p_hal->millis();
+    hal_stats_end_tick(&hal_stats);
+
+    p_hal->read_pin(p_hal->button_a_pin);
+    p_hal->read_pin(p_hal->button_a_pin);
+    hal_stats_end_tick(&hal_stats);
+
+    TEST_ASSERT_EQUAL_UINT32(3, hal_stats.max_tick_calls[HAL_FN_MILLIS]);
+    TEST_ASSERT_EQUAL_UINT32(2, hal_stats.max_tick_calls[HAL_FN_READ_PIN]);
+    TEST_ASSERT_EQUAL_UINT32(3, hal_stats.max_tick_total);
+    TEST_ASSERT_EQUAL_UINT32(3, hal_stats.ticks[0]);
+    TEST_ASSERT_EQUAL_UINT32(0, hal_stats.tick_calls[HAL_FN_MILLIS]);
+}
+
+TEST(HalStatsTests, TestTagSwitching) {
+    p_hal->millis();
+    hal_stats_end_tick(&hal_stats);
+
+    hal_stats_set_tag(&hal_stats, 2);
+    p_hal->millis();
+    p_hal->millis();
+    hal_stats_end_tick(&hal_stats);
+    hal_stats_end_tick(&hal_stats);
+
+    TEST_ASSERT_EQUAL_UINT64(1, hal_stats.calls[0][HAL_FN_MILLIS]);
+    TEST_ASSERT_EQUAL_UINT64(2, hal_stats.calls[2][HAL_FN_MILLIS]);
+    TEST_ASSERT_EQUAL_UINT64(3, hal_stats_calls(&hal_stats, HAL_FN_MILLIS));
+    TEST_ASSERT_EQUAL_UINT32(1, hal_stats.ticks[0]);
+    TEST_ASSERT_EQUAL_UINT32(2, hal_stats.ticks[2]);
+
+    // Out-of-range tags fall into the last one
+    hal_stats_set_tag(&hal_stats, HAL_STATS_MAX_TAGS + 3);
+    TEST_ASSERT_EQUAL_UINT8(HAL_STATS_MAX_TAGS - 1, hal_stats.tag);
+}
+
+TEST(HalStatsTests, TestSitesPerTag) {
+    // One site called under two tags takes two entries
+    for (int tag = 0; tag < 2; tag++) {
+        hal_stats_set_tag(&hal_stats, (uint8_t)tag);
+        p_hal->millis();
+    }
+    TEST_ASSERT_EQUAL_UINT32(2, hal_stats_used_sites());
+    TEST_ASSERT_EQUAL_UINT32(0, hal_stats.sites_dropped);
+}
+
+TEST(HalStatsTests, TestSiteTableOverflow) {
+    // HAL_STATS_SITES sites under every tag: more pairs than table entries
+    for (int tag = 0; tag < HAL_STATS_MAX_TAGS; tag++) {
+        hal_stats_set_tag(&hal_stats, (uint8_t)tag);
+        hal_stats_call_distinct_sites();
+    }
+
+    uint32_t pairs = HAL_STATS_SITES * HAL_STATS_MAX_TAGS;
+    TEST_ASSERT_EQUAL_UINT64(pairs, hal_stats_calls(&hal_stats, HAL_FN_MILLIS));
+    TEST_ASSERT_EQUAL_UINT32(HAL_STATS_MAX_SITES, hal_stats_used_sites());
+    TEST_ASSERT_EQUAL_UINT32(pairs - HAL_STATS_MAX_SITES, hal_stats.sites_dropped);
+}
+
+TEST_GROUP_RUNNER(HalStatsTests) {
+    RUN_TEST_CASE(HalStatsTests, TestCountsPerFunction);
+    RUN_TEST_CASE(HalStatsTests, TestDirectHelpersNotCounted);
+    RUN_TEST_CASE(HalStatsTests, TestStopCounting);
+    RUN_TEST_CASE(HalStatsTests, TestCallsFromOneSite);
+    RUN_TEST_CASE(HalStatsTests, TestPerTickMax);
+    RUN_TEST_CASE(HalStatsTests, TestTagSwitching);
+    RUN_TEST_CASE(HalStatsTests, TestSitesPerTag);
+    RUN_TEST_CASE(HalStatsTests, TestSiteTableOverflow);
+}
+
+void RunAllHalStatsTests() {
+    RUN_TEST_GROUP(HalStatsTests);
+}
+
+#endif /* GK_TEST_HARDWARE_HAL_STATS_H */
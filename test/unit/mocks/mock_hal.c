@@ -9,11 +9,55 @@ static uint32_t vmock_millis = 0;
 // Mock EEPROM (512 bytes, matching ATtiny85)
 #define MOCK_EEPROM_SIZE 512
 static uint8_t mock_eeprom[MOCK_EEPROM_SIZE];
+static uint32_t mock_eeprom_writes = 0;    // Bytes written since clear
 
 // Mock ADC values (4 channels on ATtiny85)
 #define MOCK_ADC_CHANNELS 4
 static uint8_t mock_adc_values[MOCK_ADC_CHANNELS] = {0};
 
+// Call counting (see mock_hal_set_stats)
+static HalStats *mock_stats = NULL;
+
+#define MOCK_HAL_STAT(fn) \
+    if (mock_stats) hal_stats_record(mock_stats, fn, HAL_STATS_CALLER())
+
+// HAL entry points: count the call, then act like the helper of the same
+// name. Tests calling the helpers directly are not counted.
+static void hal_init(void)                      { MOCK_HAL_STAT(HAL_FN_INIT); mock_hal_init(); }
+static void hal_set_pin(uint8_t pin)            { MOCK_HAL_STAT(HAL_FN_SET_PIN); mock_set_pin(pin); }
+static void hal_clear_pin(uint8_t pin)          { MOCK_HAL_STAT(HAL_FN_CLEAR_PIN); mock_clear_pin(pin); }
+static void hal_toggle_pin(uint8_t pin)         { MOCK_HAL_STAT(HAL_FN_TOGGLE_PIN); mock_toggle_pin(pin); }
+static uint8_t hal_read_pin(uint8_t pin)        { MOCK_HAL_STAT(HAL_FN_READ_PIN); return mock_read_pin(pin); }
+static void hal_init_timer(void)                { MOCK_HAL_STAT(HAL_FN_INIT_TIMER); mock_init_timer0(); }
+static uint32_t hal_millis(void)                { MOCK_HAL_STAT(HAL_FN_MILLIS); return mock_millis(); }
+static void hal_delay_ms(uint32_t ms)           { MOCK_HAL_STAT(HAL_FN_DELAY_MS); mock_delay_ms(ms); }
+static void hal_advance_time(uint32_t ms)       { MOCK_HAL_STAT(HAL_FN_ADVANCE_TIME); advance_mock_time(ms); }
+static void hal_reset_time(void)                { MOCK_HAL_STAT(HAL_FN_RESET_TIME); reset_mock_time(); }
+static uint8_t hal_adc_read(uint8_t channel)    { MOCK_HAL_STAT(HAL_FN_ADC_READ); return mock_adc_read(channel); }
+static void hal_wdt_enable(void)                { MOCK_HAL_STAT(HAL_FN_WDT_ENABLE); mock_wdt_enable(); }
+static void hal_wdt_reset(void)                 { MOCK_HAL_STAT(HAL_FN_WDT_RESET); mock_wdt_reset(); }
+static void hal_wdt_disable(void)               { MOCK_HAL_STAT(HAL_FN_WDT_DISABLE); mock_wdt_disable(); }
+
+static uint8_t hal_eeprom_read_byte(uint16_t addr) {
+    MOCK_HAL_STAT(HAL_FN_EEPROM_READ_BYTE);
+    return mock_eeprom_read_byte(addr);
+}
+
+static void hal_eeprom_write_byte(uint16_t addr, uint8_t value) {
+    MOCK_HAL_STAT(HAL_FN_EEPROM_WRITE_BYTE);
+    mock_eeprom_write_byte(addr, value);
+}
+
+static uint16_t hal_eeprom_read_word(uint16_t addr) {
+    MOCK_HAL_STAT(HAL_FN_EEPROM_READ_WORD);
+    return mock_eeprom_read_word(addr);
+}
+
+static void hal_eeprom_write_word(uint16_t addr, uint16_t value) {
+    MOCK_HAL_STAT(HAL_FN_EEPROM_WRITE_WORD);
+    mock_eeprom_write_word(addr, value);
+}
+
 // The mock interface instance
 // Note: Neopixels are controlled via mock_neopixel.c, not GPIO
 static HalInterface mock_hal = {
@@ -21,24 +65,24 @@ static HalInterface mock_hal = {
     .button_a_pin       = 2,  // PB2 in Rev2
     .button_b_pin       = 4,  // PB4 in Rev2
     .sig_out_pin        = 1,  // PB1 in Rev2 (also drives output LED via buffer)
-    .init               = mock_hal_init,
-    .set_pin            = mock_set_pin,
-    .clear_pin          = mock_clear_pin,
-    .toggle_pin         = mock_toggle_pin,
-    .read_pin           = mock_read_pin,
-    .init_timer         = mock_init_timer0,
-    .millis             = mock_millis,
-    .delay_ms           = mock_delay_ms,
-    .advance_time       = advance_mock_time,
-    .reset_time         = reset_mock_time,
-    .eeprom_read_byte   = mock_eeprom_read_byte,
-    .eeprom_write_byte  = mock_eeprom_write_byte,
-    .eeprom_read_word   = mock_eeprom_read_word,
-    .eeprom_write_word  = mock_eeprom_write_word,
-    .adc_read           = mock_adc_read,
-    .wdt_enable         = mock_wdt_enable,
-    .wdt_reset          = mock_wdt_reset,
-    .wdt_disable        = mock_wdt_disable,
+    .init               = hal_init,
+    .set_pin            = hal_set_pin,
+    .clear_pin          = hal_clear_pin,
+    .toggle_pin         = hal_toggle_pin,
+    .read_pin           = hal_read_pin,
+    .init_timer         = hal_init_timer,
+    .millis             = hal_millis,
+    .delay_ms           = hal_delay_ms,
+    .advance_time       = hal_advance_time,
+    .reset_time         = hal_reset_time,
+    .eeprom_read_byte   = hal_eeprom_read_byte,
+    .eeprom_write_byte  = hal_eeprom_write_byte,
+    .eeprom_read_word   = hal_eeprom_read_word,
+    .eeprom_write_word  = hal_eeprom_write_word,
+    .adc_read           = hal_adc_read,
+    .wdt_enable         = hal_wdt_enable,
+    .wdt_reset          = hal_wdt_reset,
+    .wdt_disable        = hal_wdt_disable,
 };
 
 HalInterface *p_hal = &mock_hal;
@@ -47,6 +91,10 @@ void use_mock_hal(void) {
     p_hal = &mock_hal;
 }
 
+void mock_hal_set_stats(HalStats *stats) {
+    mock_stats = stats;
+}
+
 void mock_hal_init(void) {
     for (int i = 0; i < MOCK_NUM_PINS; i++) {
         mock_pin_states[i] = 0;
@@ -59,6 +107,7 @@ void mock_hal_init(void) {
     vmock_millis = 0;
     // Initialize EEPROM to 0xFF (erased state)
     memset(mock_eeprom, 0xFF, MOCK_EEPROM_SIZE);
+    mock_eeprom_writes = 0;
     // Clear ADC values
     memset(mock_adc_values, 0, MOCK_ADC_CHANNELS);
 }
@@ -120,6 +169,7 @@ uint8_t mock_eeprom_read_byte(uint16_t addr) {
 void mock_eeprom_write_byte(uint16_t addr, uint8_t value) {
     if (addr < MOCK_EEPROM_SIZE) {
         mock_eeprom[addr] = value;
+        mock_eeprom_writes++;
     }
 }
 
@@ -136,11 +186,17 @@ void mock_eeprom_write_word(uint16_t addr, uint16_t value) {
         // Little-endian (AVR native byte order)
         mock_eeprom[addr] = value & 0xFF;
         mock_eeprom[addr + 1] = (value >> 8) & 0xFF;
+        mock_eeprom_writes += 2;
     }
 }
 
 void mock_eeprom_clear(void) {
     memset(mock_eeprom, 0xFF, MOCK_EEPROM_SIZE);
+    mock_eeprom_writes = 0;
+}
+
+uint32_t mock_eeprom_write_count(void) {
+    return mock_eeprom_writes;
 }
 
 uint16_t mock_eeprom_size(void) {
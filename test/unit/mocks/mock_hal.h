@@ -2,6 +2,7 @@
 #define GK_TEST_MOCKS_MOCK_HAL_H
 
 #include "hardware/hal_interface.h"
+#include "hal_stats.h"
 #include <stdint.h>
 #include <stdbool.h>
 
@@ -61,6 +62,15 @@ void mock_delay_ms(uint32_t ms);
  */
 void use_mock_hal(void);
 
+/**
+ * @brief Counts calls made through p_hal into stats (NULL stops counting)
+ * @param stats Statistics to record into, already initialized
+ *
+ * Only calls through the HAL interface are counted, with the caller's
+ * address as call site; the mock_* helpers called directly are not.
+ */
+void mock_hal_set_stats(HalStats *stats);
+
 /**
  * @brief Advances the mock system time by the specified number of milliseconds
  * @param ms Number of milliseconds to advance
@@ -105,6 +115,14 @@ void mock_eeprom_write_word(uint16_t addr, uint16_t value);
  */
 void mock_eeprom_clear(void);
 
+/**
+ * @brief Counts bytes written to the mock EEPROM since init or clear
+ * @return Number of byte writes (a word write counts two)
+ *
+ * Each byte write takes 3.4 ms on the ATtiny85.
+ */
+uint32_t mock_eeprom_write_count(void);
+
 /**
  * @brief Gets the size of the mock EEPROM
  * @return Size of mock EEPROM in bytes
@@ -0,0 +1,27 @@
+#include "mocks/mock_sim_hal.h"
+#include "sim_hal.h"
+
+/**
+ * @file mock_sim_hal.c
+ * @brief Recording stand-ins for the simulator HAL (see mock_sim_hal.h)
+ */
+
+MockSimHal mock_sim_hal = { -1, -1, 0 };
+
+void mock_sim_hal_reset(void) {
+    mock_sim_hal.button_a = -1;
+    mock_sim_hal.button_b = -1;
+    mock_sim_hal.time_resets = 0;
+}
+
+void sim_set_button_a(bool pressed) {
+    mock_sim_hal.button_a = pressed;
+}
+
+void sim_set_button_b(bool pressed) {
+    mock_sim_hal.button_b = pressed;
+}
+
+void sim_reset_time(void) {
+    mock_sim_hal.time_resets++;
+}
@@ -0,0 +1,29 @@
+#ifndef GK_MOCK_SIM_HAL_H
+#define GK_MOCK_SIM_HAL_H
+
+#include <stdbool.h>
+#include <stdint.h>
+
+/**
+ * @file mock_sim_hal.h
+ * @brief Stand-ins for the simulator HAL calls of the command handler
+ *
+ * sim/command_handler.c presses buttons and resets time through sim_hal.h.
+ * The unit tests run on the mock HAL instead, so these record the calls
+ * for inspection.
+ */
+
+typedef struct {
+    int button_a;           // Last state set (-1: never set)
+    int button_b;
+    uint32_t time_resets;
+} MockSimHal;
+
+extern MockSimHal mock_sim_hal;
+
+/**
+ * Forget recorded calls.
+ */
+void mock_sim_hal_reset(void);
+
+#endif /* GK_MOCK_SIM_HAL_H */
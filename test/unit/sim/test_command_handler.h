@@ -0,0 +1,407 @@
+#ifndef GK_TEST_SIM_COMMAND_HANDLER_H
+#define GK_TEST_SIM_COMMAND_HANDLER_H
+
+#include "unity.h"
+#include "unity_fixture.h"
+#include "command_handler.h"
+#include "socket_protocol.h"
+#include "mocks/mock_sim_hal.h"
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <unistd.h>
+
+/**
+ * @file test_command_handler.h
+ * @brief Unit tests for the socket command decoders (JSON and binary)
+ *
+ * The JSON decoder indexes the top-level fields as views into the line,
+ * so lines are passed with an explicit length and truncated lines are
+ * copied into buffers of exactly that size.
+ */
+
+static CVSource cmd_cv;
+static char cmd_file_path[32];
+
+static CommandResult run_json(const char *line) {
+    return command_handler_execute(line, strlen(line), &cmd_cv);
+}
+
+static CommandResult run_binary(uint8_t type, const uint8_t *payload, size_t len) {
+    return command_handler_execute_binary(type, payload, len, &cmd_cv);
+}
+
+static uint8_t cmd_cv_value(void) {
+    return cv_source_tick(&cmd_cv, 1);
+}
+
+// Raw unsigned 8-bit file of constant samples, removed in tear down
+static void make_cv_file(uint8_t value) {
+    uint8_t samples[16];
+    memset(samples, value, sizeof(samples));
+    strcpy(cmd_file_path, "/tmp/gk_cmd_XXXXXX");
+    int fd = mkstemp(cmd_file_path);
+    TEST_ASSERT_TRUE(fd >= 0);
+    TEST_ASSERT_EQUAL(sizeof(samples), write(fd, samples, sizeof(samples)));
+    close(fd);
+}
+
+// Minimum payload length of every binary command with one
+static const struct {
+    uint8_t type;
+    size_t len;
+} cmd_payload_lens[] = {
+    { SOCKET_CMD_BUTTON, 2 },
+    { SOCKET_CMD_CV_MANUAL, 1 },
+    { SOCKET_CMD_CV_LFO, 7 },
+    { SOCKET_CMD_CV_ENVELOPE, 7 },
+    { SOCKET_CMD_CV_GATE, 1 },
+    { SOCKET_CMD_SUBSCRIBE, 4 },
+    { SOCKET_CMD_CV_BLOCK, 4 },
+    { SOCKET_CMD_CV_FILE, 7 },
+};
+
+TEST_GROUP(CommandHandlerTests);
+
+TEST_SETUP(CommandHandlerTests) {
+    cv_source_init(&cmd_cv);
+    mock_sim_hal_reset();
+    cmd_file_path[0] = '\0';
+}
+
+TEST_TEAR_DOWN(CommandHandlerTests) {
+    cv_source_cleanup(&cmd_cv);
+    if (cmd_file_path[0]) {
+        unlink(cmd_file_path);
+    }
+}
+
+// =============================================================================
+// JSON
+// =============================================================================
+
+TEST(CommandHandlerTests, TestJsonEveryCommand) {
+    static const struct {
+        const char *line;
+        CommandType type;
+    } cases[] = {
+        { "{\"cmd\":\"button\",\"id\":\"b\",\"state\":true}", CMD_BUTTON },
+        { "{\"cmd\":\"cv_manual\",\"value\":300}", CMD_CV_MANUAL },
+        { "{\"cmd\":\"cv_lfo\",\"freq_hz\":2,\"shape\":\"square\",\"min\":10,\"max\":20}", CMD_CV_LFO },
+        { "{\"cmd\":\"cv_envelope\",\"attack_ms\":5,\"sustain\":100}", CMD_CV_ENVELOPE },
+        { "{\"cmd\":\"cv_gate\",\"state\":true}", CMD_CV_GATE },
+        { "{\"cmd\":\"cv_trigger\"}", CMD_CV_TRIGGER },
+        { "{\"cmd\":\"cv_wavetable\",\"samples\":[0,128,255],\"freq_hz\":5}", CMD_CV_WAVETABLE },
+        { "{\"cmd\":\"cv_graph\",\"nodes\":[{\"type\":\"manual\",\"value\":77}]}", CMD_CV_GRAPH },
+        { "{\"cmd\":\"subscribe\",\"topics\":[\"state\",\"cv\"],\"interval_ms\":5}", CMD_SUBSCRIBE },
+        { "{\"cmd\":\"reset\"}", CMD_RESET },
+        { "{\"cmd\":\"quit\"}", CMD_QUIT },
+    };
+
+    for (size_t i = 0; i < sizeof(cases) / sizeof(cases[0]); i++) {
+        CommandResult r = run_json(cases[i].line);
+        TEST_ASSERT_TRUE_MESSAGE(r.success, cases[i].line);
+        TEST_ASSERT_EQUAL_MESSAGE(cases[i].type, r.type, cases[i].line);
+        TEST_ASSERT_EQUAL_MESSAGE(cases[i].type == CMD_QUIT, r.should_quit, cases[i].line);
+    }
+
+    TEST_ASSERT_EQUAL(1, mock_sim_hal.button_b);
+    TEST_ASSERT_EQUAL(-1, mock_sim_hal.button_a);
+    TEST_ASSERT_EQUAL_UINT32(1, mock_sim_hal.time_resets);
+}
+
+TEST(CommandHandlerTests, TestJsonCommandNames) {
+    // Every name dispatches to its type, even when its fields are missing
+    char line[64];
+    for (int t = CMD_BUTTON; t <= CMD_CV_GRAPH; t++) {
+        if (t == CMD_CV_STREAM) continue;   // Binary frames only
+        snprintf(line, sizeof(line), "{\"cmd\":\"%s\"}", command_type_str((CommandType)t));
+        CommandResult r = run_json(line);
+        TEST_ASSERT_EQUAL_MESSAGE(t, r.type, line);
+    }
+}
+
+TEST(CommandHandlerTests, TestJsonUnknownCommands) {
+    static const char *names[] = {
+        "", "q", "quiz", "buttons", "cv_lfo2", "CV_LFO", "cv_stream", "subscribe_",
+    };
+    char line[64];
+    for (size_t i = 0; i < sizeof(names) / sizeof(names[0]); i++) {
+        snprintf(line, sizeof(line), "{\"cmd\":\"%s\"}", names[i]);
+        CommandResult r = run_json(line);
+        TEST_ASSERT_FALSE_MESSAGE(r.success, line);
+        TEST_ASSERT_EQUAL_MESSAGE(CMD_UNKNOWN, r.type, line);
+        TEST_ASSERT_NOT_NULL(strstr(r.error, "unknown command"));
+    }
+
+    CommandResult r = run_json("{\"id\":\"a\"}");
+    TEST_ASSERT_EQUAL_STRING("missing 'cmd' field", r.error);
+    r = run_json("{\"cmd\":5}");
+    TEST_ASSERT_EQUAL_STRING("missing 'cmd' field", r.error);
+}
+
+TEST(CommandHandlerTests, TestJsonEscapedStrings) {
+    // Escaped quotes and brackets inside other fields don't end them
+    CommandResult r = run_json("{\"note\":\"a \\\"quoted\\\" }, and \\\\\",\"cmd\":\"quit\"}");
+    TEST_ASSERT_TRUE(r.success);
+    TEST_ASSERT_EQUAL(CMD_QUIT, r.type);
+
+    // Paths resolve \" \\ and \/
+    r = run_json("{\"cmd\":\"cv_file\",\"path\":\"\\/no\\/such\\\\dir\\/a\\\"b.wav\"}");
+    TEST_ASSERT_FALSE(r.success);
+    TEST_ASSERT_EQUAL(CMD_CV_FILE, r.type);
+    TEST_ASSERT_NOT_NULL(strstr(r.error, "/no/such\\dir/a\"b.wav"));
+
+    // Other escapes are refused in paths
+    r = run_json("{\"cmd\":\"cv_file\",\"path\":\"a\\nb\"}");
+    TEST_ASSERT_EQUAL_STRING("invalid 'path'", r.error);
+
+    // Escapes in names are not resolved
+    r = run_json("{\"cmd\":\"qu\\u0069t\"}");
+    TEST_ASSERT_EQUAL(CMD_UNKNOWN, r.type);
+    TEST_ASSERT_FALSE(r.should_quit);
+}
+
+TEST(CommandHandlerTests, TestJsonDuplicateKeys) {
+    // First occurrence wins
+    CommandResult r = run_json("{\"cmd\":\"cv_manual\",\"value\":10,\"value\":200}");
+    TEST_ASSERT_TRUE(r.success);
+    TEST_ASSERT_EQUAL_UINT8(10, cmd_cv_value());
+
+    r = run_json("{\"cmd\":\"quit\",\"cmd\":\"reset\"}");
+    TEST_ASSERT_EQUAL(CMD_QUIT, r.type);
+    TEST_ASSERT_EQUAL_UINT32(0, mock_sim_hal.time_resets);
+}
+
+TEST(CommandHandlerTests, TestJsonUnknownKeys) {
+    CommandResult r = run_json("{\"x\":null,\"cmd\":\"cv_manual\",\"nested\":{\"value\":99,\"a\":[\"}\"]},"
+                               "\"list\":[1,[2,3]],\"value\":42,\"flag\":false}");
+    TEST_ASSERT_TRUE(r.success);
+    TEST_ASSERT_EQUAL_UINT8(42, cmd_cv_value());
+}
+
+TEST(CommandHandlerTests, TestJsonFieldLimit) {
+    char line[512];
+    int n;
+
+    // Fields past the 16th are skipped, but still have to parse
+    n = snprintf(line, sizeof(line), "{\"cmd\":\"cv_manual\",\"value\":5");
+    for (int i = 0; i < 20; i++) {
+        n += snprintf(line + n, sizeof(line) - n, ",\"k%d\":%d", i, i);
+    }
+    snprintf(line + n, sizeof(line) - n, "}");
+    CommandResult r = run_json(line);
+    TEST_ASSERT_TRUE(r.success);
+    TEST_ASSERT_EQUAL_UINT8(5, cmd_cv_value());
+
+    snprintf(line + n, sizeof(line) - n, ",\"bad\":}");
+    r = run_json(line);
+    TEST_ASSERT_EQUAL_STRING("malformed JSON object", r.error);
+
+    n = snprintf(line, sizeof(line), "{");
+    for (int i = 0; i < 16; i++) {
+        n += snprintf(line + n, sizeof(line) - n, "\"k%d\":%d,", i, i);
+    }
+    snprintf(line + n, sizeof(line) - n, "\"cmd\":\"quit\"}");
+    r = run_json(line);
+    TEST_ASSERT_FALSE(r.success);
+    TEST_ASSERT_EQUAL_STRING("missing 'cmd' field", r.error);
+}
+
+TEST(CommandHandlerTests, TestJsonTruncated) {
+    static const char line[] =
+        "{\"cmd\":\"cv_graph\",\"nodes\":[{\"type\":\"lfo\",\"freq_hz\":1,\"shape\":\"tri\"},"
+        "{\"type\":\"offset\",\"in\":[0],\"value\":-20}],\"out\":1,\"note\":\"a \\\"}\\\"\"}";
+    size_t len = sizeof(line) - 1;
+
+    CommandResult r = run_json(line);
+    TEST_ASSERT_TRUE(r.success);
+
+    // Every prefix, in a buffer of its exact size
+    for (size_t n = 0; n < len; n++) {
+        char *buf = malloc(n ? n : 1);
+        TEST_ASSERT_NOT_NULL(buf);
+        memcpy(buf, line, n);
+        r = command_handler_execute(buf, n, &cmd_cv);
+        free(buf);
+        TEST_ASSERT_FALSE(r.success);
+        TEST_ASSERT_EQUAL_STRING("malformed JSON object", r.error);
+    }
+}
+
+TEST(CommandHandlerTests, TestJsonSubscribeClamp) {
+    CommandResult r = run_json("{\"cmd\":\"subscribe\",\"topics\":[\"leds\"],\"interval_ms\":90000,"
+                               "\"policy\":\"drop\"}");
+    TEST_ASSERT_TRUE(r.success);
+    TEST_ASSERT_EQUAL_UINT32(SOCKET_TOPIC_LEDS, r.topics);
+    TEST_ASSERT_EQUAL_UINT32(SOCKET_MAX_INTERVAL_MS, r.interval_ms);
+    TEST_ASSERT_EQUAL(SOCKET_POLICY_DROP, r.policy);
+
+    r = run_json("{\"cmd\":\"subscribe\",\"topics\":[\"nope\"]}");
+    TEST_ASSERT_FALSE(r.success);
+}
+
+TEST(CommandHandlerTests, TestJsonCvFile) {
+    make_cv_file(180);
+    char line[128];
+    snprintf(line, sizeof(line),
+             "{\"cmd\":\"cv_file\",\"path\":\"%s\",\"format\":\"u8\",\"rate_hz\":1000,\"loop\":false}",
+             cmd_file_path);
+    CommandResult r = run_json(line);
+    TEST_ASSERT_TRUE_MESSAGE(r.success, r.error);
+    TEST_ASSERT_EQUAL_UINT8(180, cmd_cv_value());
+
+    snprintf(line, sizeof(line), "{\"cmd\":\"cv_file\",\"path\":\"%s\",\"format\":\"u24\"}",
+             cmd_file_path);
+    r = run_json(line);
+    TEST_ASSERT_FALSE(r.success);
+    TEST_ASSERT_NOT_NULL(strstr(r.error, "invalid format"));
+}
+
+// =============================================================================
+// Binary
+// =============================================================================
+
+TEST(CommandHandlerTests, TestBinaryEveryCommand) {
+    uint8_t lfo[7], env[7], block[7];
+    sp_put_u32(lfo, 2000);
+    lfo[4] = LFO_SQUARE;
+    lfo[5] = 10;
+    lfo[6] = 20;
+    sp_put_u16(env, 5);
+    sp_put_u16(env + 2, 50);
+    env[4] = 100;
+    sp_put_u16(env + 5, 80);
+    sp_put_u32(block, 1000);
+    block[4] = block[5] = block[6] = 90;
+
+    static const uint8_t button[] = { 1, 1 };
+    static const uint8_t manual[] = { 200 };
+    static const uint8_t gate[] = { 1 };
+    static const uint8_t subscribe[] = { SOCKET_TOPIC_STATE | SOCKET_TOPIC_CV, 0, 16, 0 };
+
+    const struct {
+        uint8_t type;
+        const uint8_t *payload;
+        size_t len;
+        CommandType cmd;
+    } cases[] = {
+        { SOCKET_CMD_BUTTON, button, sizeof(button), CMD_BUTTON },
+        { SOCKET_CMD_CV_MANUAL, manual, sizeof(manual), CMD_CV_MANUAL },
+        { SOCKET_CMD_CV_LFO, lfo, sizeof(lfo), CMD_CV_LFO },
+        { SOCKET_CMD_CV_ENVELOPE, env, sizeof(env), CMD_CV_ENVELOPE },
+        { SOCKET_CMD_CV_GATE, gate, sizeof(gate), CMD_CV_GATE },
+        { SOCKET_CMD_CV_TRIGGER, NULL, 0, CMD_CV_TRIGGER },
+        { SOCKET_CMD_SUBSCRIBE, subscribe, sizeof(subscribe), CMD_SUBSCRIBE },
+        { SOCKET_CMD_CV_BLOCK, block, sizeof(block), CMD_CV_STREAM },
+        { SOCKET_CMD_RESET, NULL, 0, CMD_RESET },
+        { SOCKET_CMD_QUIT, NULL, 0, CMD_QUIT },
+    };
+
+    for (size_t i = 0; i < sizeof(cases) / sizeof(cases[0]); i++) {
+        CommandResult r = run_binary(cases[i].type, cases[i].payload, cases[i].len);
+        TEST_ASSERT_TRUE_MESSAGE(r.success, command_type_str(cases[i].cmd));
+        TEST_ASSERT_EQUAL_MESSAGE(cases[i].cmd, r.type, command_type_str(cases[i].cmd));
+        TEST_ASSERT_EQUAL(cases[i].cmd == CMD_QUIT, r.should_quit);
+    }
+
+    TEST_ASSERT_EQUAL(1, mock_sim_hal.button_b);
+    TEST_ASSERT_EQUAL_UINT32(1, mock_sim_hal.time_resets);
+
+    CommandResult r = run_binary(SOCKET_CMD_CV_MANUAL, manual, sizeof(manual));
+    TEST_ASSERT_TRUE(r.success);
+    TEST_ASSERT_EQUAL_UINT8(200, cmd_cv_value());
+}
+
+TEST(CommandHandlerTests, TestBinaryTruncated) {
+    uint8_t payload[8] = { 0 };
+    for (size_t i = 0; i < sizeof(cmd_payload_lens) / sizeof(cmd_payload_lens[0]); i++) {
+        for (size_t len = 0; len < cmd_payload_lens[i].len; len++) {
+            CommandResult r = run_binary(cmd_payload_lens[i].type, len ? payload : NULL, len);
+            TEST_ASSERT_FALSE(r.success);
+            TEST_ASSERT_EQUAL(CMD_UNKNOWN, r.type);
+            TEST_ASSERT_NOT_NULL(strstr(r.error, "payload too short"));
+        }
+    }
+}
+
+TEST(CommandHandlerTests, TestBinaryUnknownTypes) {
+    static const uint8_t types[] = { 0x00, SOCKET_CMD_CV_FILE + 1, 0x7F, 0xFF };
+    uint8_t payload[8] = { 0 };
+    for (size_t i = 0; i < sizeof(types); i++) {
+        CommandResult r = run_binary(types[i], payload, sizeof(payload));
+        TEST_ASSERT_FALSE(r.success);
+        TEST_ASSERT_EQUAL(CMD_UNKNOWN, r.type);
+        TEST_ASSERT_NOT_NULL(strstr(r.error, "unknown frame type"));
+    }
+}
+
+TEST(CommandHandlerTests, TestBinaryInvalidFields) {
+    static const uint8_t button[] = { 2, 1 };
+    CommandResult r = run_binary(SOCKET_CMD_BUTTON, button, sizeof(button));
+    TEST_ASSERT_FALSE(r.success);
+    TEST_ASSERT_EQUAL(-1, mock_sim_hal.button_a);
+    TEST_ASSERT_EQUAL(-1, mock_sim_hal.button_b);
+
+    static const uint8_t policy[] = { SOCKET_TOPIC_STATE, SOCKET_POLICY_DROP + 1, 16, 0 };
+    r = run_binary(SOCKET_CMD_SUBSCRIBE, policy, sizeof(policy));
+    TEST_ASSERT_FALSE(r.success);
+
+    static const uint8_t nul_path[] = { 0, CV_FILE_U8, 0xE8, 0x03, 0, 0, 'a', '\0', 'b' };
+    r = run_binary(SOCKET_CMD_CV_FILE, nul_path, sizeof(nul_path));
+    TEST_ASSERT_EQUAL_STRING("invalid path", r.error);
+
+    uint8_t long_path[6 + CV_FILE_PATH_MAX];
+    memset(long_path, 'a', sizeof(long_path));
+    r = run_binary(SOCKET_CMD_CV_FILE, long_path, sizeof(long_path));
+    TEST_ASSERT_EQUAL_STRING("invalid path", r.error);
+}
+
+TEST(CommandHandlerTests, TestBinarySubscribeClamp) {
+    static const uint8_t subscribe[] = { 0xFF, SOCKET_POLICY_DROP, 0xFF, 0xFF };
+    CommandResult r = run_binary(SOCKET_CMD_SUBSCRIBE, subscribe, sizeof(subscribe));
+    TEST_ASSERT_TRUE(r.success);
+    TEST_ASSERT_EQUAL_UINT32((1u << SOCKET_TOPIC_COUNT) - 1, r.topics);
+    TEST_ASSERT_EQUAL_UINT32(SOCKET_MAX_INTERVAL_MS, r.interval_ms);
+    TEST_ASSERT_EQUAL(SOCKET_POLICY_DROP, r.policy);
+}
+
+TEST(CommandHandlerTests, TestBinaryCvFile) {
+    make_cv_file(60);
+    uint8_t frame[6 + sizeof(cmd_file_path)];
+    size_t path_len = strlen(cmd_file_path);
+    frame[0] = 0;
+    frame[1] = CV_FILE_U8;
+    sp_put_u32(frame + 2, 1000);
+    memcpy(frame + 6, cmd_file_path, path_len);
+
+    CommandResult r = run_binary(SOCKET_CMD_CV_FILE, frame, 6 + path_len);
+    TEST_ASSERT_TRUE_MESSAGE(r.success, r.error);
+    TEST_ASSERT_EQUAL(CMD_CV_FILE, r.type);
+    TEST_ASSERT_EQUAL_UINT8(60, cmd_cv_value());
+}
+
+TEST_GROUP_RUNNER(CommandHandlerTests) {
+    RUN_TEST_CASE(CommandHandlerTests, TestJsonEveryCommand);
+    RUN_TEST_CASE(CommandHandlerTests, TestJsonCommandNames);
+    RUN_TEST_CASE(CommandHandlerTests, TestJsonUnknownCommands);
+    RUN_TEST_CASE(CommandHandlerTests, TestJsonEscapedStrings);
+    RUN_TEST_CASE(CommandHandlerTests, TestJsonDuplicateKeys);
+    RUN_TEST_CASE(CommandHandlerTests, TestJsonUnknownKeys);
+    RUN_TEST_CASE(CommandHandlerTests, TestJsonFieldLimit);
+    RUN_TEST_CASE(CommandHandlerTests, TestJsonTruncated);
+    RUN_TEST_CASE(CommandHandlerTests, TestJsonSubscribeClamp);
+    RUN_TEST_CASE(CommandHandlerTests, TestJsonCvFile);
+    RUN_TEST_CASE(CommandHandlerTests, TestBinaryEveryCommand);
+    RUN_TEST_CASE(CommandHandlerTests, TestBinaryTruncated);
+    RUN_TEST_CASE(CommandHandlerTests, TestBinaryUnknownTypes);
+    RUN_TEST_CASE(CommandHandlerTests, TestBinaryInvalidFields);
+    RUN_TEST_CASE(CommandHandlerTests, TestBinarySubscribeClamp);
+    RUN_TEST_CASE(CommandHandlerTests, TestBinaryCvFile);
+}
+
+void RunAllCommandHandlerTests() {
+    RUN_TEST_GROUP(CommandHandlerTests);
+}
+
+#endif /* GK_TEST_SIM_COMMAND_HANDLER_H */
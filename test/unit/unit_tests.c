@@ -14,6 +14,8 @@
 #include "fsm/test_events.h"
 #include "fsm/test_mode_handlers.h"
 #include "core/test_coordinator.h"
+#include "hardware/test_hal_stats.h"
+#include "sim/test_command_handler.h"
 
 void run_all_tests(void);
 
@@ -44,6 +46,8 @@ void run_all_tests(void) {
     RunAllEventProcessorTests();
     RUN_TEST_GROUP(ModeHandlersTests);
     RunAllCoordinatorTests();
+    RunAllHalStatsTests();
+    RunAllCommandHandlerTests();
 }
 
 /**